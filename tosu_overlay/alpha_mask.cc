@@ -0,0 +1,143 @@
+#include <tosu_overlay/alpha_mask.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+// 1024 x 1024 tiles is enough for 8K at 8 px tiles, larger frames get
+// larger tiles instead of a larger grid.
+constexpr int32_t max_grid = 1024;
+constexpr uint32_t min_tile_shift = 3;
+constexpr size_t word_count = max_grid * max_grid / 64;
+
+std::atomic<uint64_t> words[word_count];
+
+// tiles_x | tiles_y << 16 | tile_shift << 32, published in one store so the
+// readers always see a consistent layout
+std::atomic<uint64_t> layout = 0;
+
+struct Layout {
+  uint32_t tiles_x;
+  uint32_t tiles_y;
+  uint32_t tile_shift;
+};
+
+Layout unpack(uint64_t packed) {
+  return {static_cast<uint32_t>(packed & 0xFFFF),
+          static_cast<uint32_t>((packed >> 16) & 0xFFFF),
+          static_cast<uint32_t>(packed >> 32)};
+}
+
+uint64_t pack(const Layout& l) {
+  return static_cast<uint64_t>(l.tiles_x) |
+         (static_cast<uint64_t>(l.tiles_y) << 16) |
+         (static_cast<uint64_t>(l.tile_shift) << 32);
+}
+
+bool tile_is_opaque(const uint8_t* frame,
+                    int32_t width,
+                    int32_t left,
+                    int32_t top,
+                    int32_t right,
+                    int32_t bottom) {
+  const size_t stride = static_cast<size_t>(width) * frame::bytes_per_pixel;
+
+  for (int32_t y = top; y < bottom; ++y) {
+    // BGRA, alpha is the fourth byte of every pixel
+    const auto row = frame + y * stride + 3;
+    for (int32_t x = left; x < right; ++x) {
+      if (row[x * frame::bytes_per_pixel] >= alpha_mask::opaque_alpha) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+}  // namespace
+
+void alpha_mask::resize(int32_t width, int32_t height) {
+  Layout l{0, 0, min_tile_shift};
+  while (((width + (1 << l.tile_shift) - 1) >> l.tile_shift) > max_grid ||
+         ((height + (1 << l.tile_shift) - 1) >> l.tile_shift) > max_grid) {
+    ++l.tile_shift;
+  }
+
+  l.tiles_x = (std::max(width, 0) + (1 << l.tile_shift) - 1) >> l.tile_shift;
+  l.tiles_y = (std::max(height, 0) + (1 << l.tile_shift) - 1) >> l.tile_shift;
+
+  // hide everything while the bits are cleared, then publish the new layout
+  layout.store(0, std::memory_order_release);
+  for (auto& word : words) {
+    word.store(0, std::memory_order_relaxed);
+  }
+  layout.store(pack(l), std::memory_order_release);
+}
+
+void alpha_mask::update(const uint8_t* frame,
+                        int32_t width,
+                        int32_t height,
+                        const frame::RectList& rects) {
+  const auto l = unpack(layout.load(std::memory_order_acquire));
+  if (l.tiles_x == 0 || l.tiles_y == 0) {
+    return;
+  }
+
+  const int32_t tile_size = 1 << l.tile_shift;
+
+  for (const auto& dirty : rects) {
+    const auto r = frame::clip(dirty, width, height);
+    if (r.empty()) {
+      continue;
+    }
+
+    const auto first_x = r.x >> l.tile_shift;
+    const auto first_y = r.y >> l.tile_shift;
+    const auto last_x = std::min<int32_t>((r.x + r.width - 1) >> l.tile_shift,
+                                          l.tiles_x - 1);
+    const auto last_y = std::min<int32_t>((r.y + r.height - 1) >> l.tile_shift,
+                                          l.tiles_y - 1);
+
+    for (int32_t ty = first_y; ty <= last_y; ++ty) {
+      const auto top = ty * tile_size;
+      const auto bottom = std::min(top + tile_size, height);
+
+      for (int32_t tx = first_x; tx <= last_x; ++tx) {
+        const auto left = tx * tile_size;
+        const auto right = std::min(left + tile_size, width);
+
+        const auto index = static_cast<size_t>(ty) * l.tiles_x + tx;
+        const auto bit = uint64_t{1} << (index % 64);
+        auto& word = words[index / 64];
+
+        // single writer, a plain read-modify-write is enough
+        auto value = word.load(std::memory_order_relaxed);
+        if (tile_is_opaque(frame, width, left, top, right, bottom)) {
+          value |= bit;
+        } else {
+          value &= ~bit;
+        }
+        word.store(value, std::memory_order_release);
+      }
+    }
+  }
+}
+
+bool alpha_mask::hit(int32_t x, int32_t y) {
+  const auto l = unpack(layout.load(std::memory_order_acquire));
+  if (x < 0 || y < 0) {
+    return false;
+  }
+
+  const auto tx = static_cast<uint32_t>(x) >> l.tile_shift;
+  const auto ty = static_cast<uint32_t>(y) >> l.tile_shift;
+  if (tx >= l.tiles_x || ty >= l.tiles_y) {
+    return false;
+  }
+
+  const auto index = static_cast<size_t>(ty) * l.tiles_x + tx;
+  return (words[index / 64].load(std::memory_order_acquire) >>
+          (index % 64)) & 1;
+}
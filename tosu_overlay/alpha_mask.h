@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+#include <tosu_overlay/frame.h>
+
+// Coarse per-tile opacity of the last uploaded frame. Written by the upload
+// path, read lock-free by the input hooks so they never touch the frame.
+namespace alpha_mask {
+
+// Alpha at or above this counts as visible, matches the discard in the
+// fragment shader.
+constexpr uint8_t opaque_alpha = 1;
+
+// Clears the mask for a new frame size, everything is transparent.
+void resize(int32_t width, int32_t height);
+
+// Recomputes the tiles touched by |rects| from the full BGRA |frame|.
+void update(const uint8_t* frame,
+            int32_t width,
+            int32_t height,
+            const frame::RectList& rects);
+
+// True when the tile under (x, y) has any visible pixel. Safe from any
+// thread, out-of-frame points are transparent.
+bool hit(int32_t x, int32_t y);
+
+}  // namespace alpha_mask
@@ -0,0 +1,418 @@
+#include <tosu_overlay/asset_cache.h>
+#include <tosu_overlay/http_probe.h>
+
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+
+asset_cache::Cache global_cache;
+
+// "TOSUPAK1", the index size as 4 bytes little-endian, the index as JSON,
+// then the bodies. Blob offsets count from the end of the index.
+constexpr char pack_magic[] = "TOSUPAK1";
+constexpr size_t magic_size = sizeof(pack_magic) - 1;
+constexpr size_t header_size = magic_size + 4;
+
+const char* const uncached_prefixes[] = {
+    "/json",
+    "/websocket",
+    "/ws",
+    "/tokens",
+    "/files/beatmap/",
+};
+
+std::string hash_key(uint64_t hash) {
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016llx",
+                static_cast<unsigned long long>(hash));
+  return key;
+}
+
+}  // namespace
+
+bool asset_cache::cacheable_path(std::string_view path) {
+  for (const auto prefix : uncached_prefixes) {
+    if (path.substr(0, std::strlen(prefix)) == prefix) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+uint64_t asset_cache::content_hash(std::string_view data) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const auto c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+bool asset_cache::Cache::open(const std::filesystem::path& dir,
+                              uint64_t max_bytes) {
+  std::lock_guard lock(lock_);
+
+  dir_ = dir;
+  max_bytes_ = max_bytes;
+
+  std::error_code error;
+  std::filesystem::create_directories(dir, error);
+
+  // nothing maps the old pack yet, so it can be replaced now
+  const auto next = dir / "assets.pack.new";
+  if (std::filesystem::exists(next, error)) {
+    std::filesystem::rename(next, pack_path(), error);
+  }
+
+  load(map_file(pack_path()));
+
+  open_ = true;
+  return true;
+}
+
+bool asset_cache::Cache::is_open() const {
+  std::lock_guard lock(lock_);
+  return open_;
+}
+
+void asset_cache::Cache::load(std::string_view pack) {
+  if (pack.size() < header_size ||
+      pack.substr(0, magic_size) != std::string_view(pack_magic, magic_size)) {
+    return;
+  }
+
+  uint32_t index_size = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    index_size |= uint32_t{static_cast<uint8_t>(pack[magic_size + i])}
+                  << (8 * i);
+  }
+  if (pack.size() - header_size < index_size) {
+    return;
+  }
+
+  const auto index = nlohmann::json::parse(
+      pack.substr(header_size, index_size), nullptr, false);
+  if (!index.is_object()) {
+    return;
+  }
+
+  const auto bodies = pack.substr(header_size + index_size);
+
+  const auto blobs = index.value("blobs", nlohmann::json::object());
+  for (const auto& [key, range] : blobs.items()) {
+    if (!range.is_array() || range.size() != 2 ||
+        !range[0].is_number_unsigned() || !range[1].is_number_unsigned()) {
+      continue;
+    }
+
+    const auto offset = range[0].get<uint64_t>();
+    const auto size = range[1].get<uint64_t>();
+    if (offset > bodies.size() || bodies.size() - offset < size) {
+      continue;
+    }
+
+    const auto hash = std::strtoull(key.c_str(), nullptr, 16);
+    blobs_[hash] = {bodies.substr(offset, size), nullptr};
+  }
+
+  const auto assets = index.value("assets", nlohmann::json::object());
+  for (const auto& [url, entry] : assets.items()) {
+    if (!entry.is_object()) {
+      continue;
+    }
+
+    Record record;
+    record.validators.etag = entry.value("etag", std::string());
+    record.validators.last_modified =
+        entry.value("last_modified", std::string());
+    record.mime_type = entry.value("mime_type", std::string());
+    record.charset = entry.value("charset", std::string());
+    record.hash =
+        std::strtoull(entry.value("hash", std::string()).c_str(), nullptr, 16);
+    record.validated = false;
+
+    const auto blob = blobs_.find(record.hash);
+    if (blob != blobs_.end() && !record.validators.empty()) {
+      ++blob->second.refs;
+      records_[url] = std::move(record);
+    }
+  }
+
+  // bodies whose every URL was dropped
+  for (auto it = blobs_.begin(); it != blobs_.end();) {
+    it = it->second.refs == 0 ? blobs_.erase(it) : std::next(it);
+  }
+}
+
+std::optional<asset_cache::Asset> asset_cache::Cache::lookup(
+    const std::string& url) {
+  std::lock_guard lock(lock_);
+
+  const auto record = records_.find(url);
+  if (record == records_.end() || !record->second.validated) {
+    ++stats_.misses;
+    return std::nullopt;
+  }
+
+  const auto& blob = blobs_.at(record->second.hash);
+
+  ++stats_.hits;
+  stats_.bytes_served += blob.data.size();
+
+  return Asset{record->second.mime_type, record->second.charset,
+               record->second.validators, blob.data, blob.owner};
+}
+
+void asset_cache::Cache::store(const std::string& url,
+                               const Validators& validators,
+                               const std::string& mime_type,
+                               const std::string& charset,
+                               std::string body) {
+  if (validators.empty() || body.size() > max_asset_bytes()) {
+    return;
+  }
+
+  std::lock_guard lock(lock_);
+  if (!open_) {
+    return;
+  }
+
+  put(url, {validators, mime_type, charset, 0, true}, std::move(body));
+  ++stats_.stored;
+}
+
+void asset_cache::Cache::put(const std::string& url,
+                             Record record,
+                             std::string body) {
+  record.hash = content_hash(body);
+  const auto hash = record.hash;
+
+  // the same body under another URL, or unchanged under this one
+  auto blob = blobs_.find(hash);
+  if (blob == blobs_.end()) {
+    auto owner = std::make_shared<const std::string>(std::move(body));
+    owned_bytes_ += owner->size();
+    blob = blobs_.emplace(hash, Blob{*owner, owner, 0, next_stored_++}).first;
+  }
+  ++blob->second.refs;
+
+  // a replaced version goes once no other URL has it
+  auto [entry, inserted] = records_.try_emplace(url);
+  if (!inserted) {
+    release(entry->second.hash);
+  }
+  entry->second = std::move(record);
+  dirty_ = true;
+
+  trim(hash);
+}
+
+void asset_cache::Cache::erase(
+    std::unordered_map<std::string, Record>::iterator record) {
+  const auto hash = record->second.hash;
+  records_.erase(record);
+  release(hash);
+  dirty_ = true;
+}
+
+void asset_cache::Cache::release(uint64_t hash) {
+  const auto blob = blobs_.find(hash);
+  if (blob == blobs_.end() || --blob->second.refs != 0) {
+    return;
+  }
+
+  // lookup() callers share the owner, the body lives on until they're done
+  if (blob->second.owner) {
+    owned_bytes_ -= blob->second.data.size();
+  }
+  blobs_.erase(blob);
+}
+
+void asset_cache::Cache::trim(uint64_t keep) {
+  while (owned_bytes_ > max_bytes_) {
+    auto oldest = blobs_.end();
+    for (auto it = blobs_.begin(); it != blobs_.end(); ++it) {
+      if (it->second.owner && it->first != keep &&
+          (oldest == blobs_.end() ||
+           it->second.stored < oldest->second.stored)) {
+        oldest = it;
+      }
+    }
+    if (oldest == blobs_.end()) {
+      return;
+    }
+
+    // erasing the last record on it releases the blob
+    const auto hash = oldest->first;
+    for (auto it = records_.begin(); it != records_.end();) {
+      it = it->second.hash == hash ? records_.erase(it) : std::next(it);
+    }
+    owned_bytes_ -= oldest->second.data.size();
+    blobs_.erase(oldest);
+    dirty_ = true;
+  }
+}
+
+bool asset_cache::Cache::revalidate(const std::string& host,
+                                    const std::string& port,
+                                    int timeout_ms) {
+  const auto origin = "http://" + host + ":" + port + "/";
+
+  std::vector<std::pair<std::string, Validators>> pending;
+  {
+    std::lock_guard lock(lock_);
+    for (const auto& [url, record] : records_) {
+      if (!record.validated && url.rfind(origin, 0) == 0) {
+        pending.emplace_back(url, record.validators);
+      }
+    }
+  }
+
+  for (const auto& [url, validators] : pending) {
+    http_probe::Headers headers;
+    if (!validators.etag.empty()) {
+      headers.emplace_back("If-None-Match", validators.etag);
+    }
+    if (!validators.last_modified.empty()) {
+      headers.emplace_back("If-Modified-Since", validators.last_modified);
+    }
+
+    const auto path = url.substr(origin.size() - 1);
+    auto response =
+        http_probe::fetch(host, port, path, headers, timeout_ms);
+    if (response.status == 0) {
+      return false;
+    }
+
+    std::lock_guard lock(lock_);
+
+    const auto record = records_.find(url);
+    if (record == records_.end() || record->second.validated) {
+      // fetched by the page meanwhile
+      continue;
+    }
+
+    if (response.status == 304) {
+      record->second.validated = true;
+      ++stats_.revalidated;
+      continue;
+    }
+
+    const Validators fresh{response.header("etag"),
+                           response.header("last-modified")};
+    if (response.status != 200 || fresh.empty() ||
+        response.body.size() > max_asset_bytes()) {
+      erase(record);
+      continue;
+    }
+
+    auto mime_type = response.header("content-type");
+    std::string charset;
+    if (const auto semicolon = mime_type.find(';');
+        semicolon != std::string::npos) {
+      const auto parameter = mime_type.find("charset=", semicolon);
+      if (parameter != std::string::npos) {
+        charset = mime_type.substr(parameter + 8);
+      }
+      mime_type.resize(semicolon);
+    }
+
+    put(url, {fresh, mime_type, charset, 0, true}, std::move(response.body));
+    ++stats_.replaced;
+  }
+
+  std::lock_guard lock(lock_);
+  revalidated_ = true;
+  return true;
+}
+
+bool asset_cache::Cache::needs_revalidation() const {
+  std::lock_guard lock(lock_);
+  return open_ && !revalidated_;
+}
+
+void asset_cache::Cache::expire() {
+  std::lock_guard lock(lock_);
+
+  for (auto& [url, record] : records_) {
+    record.validated = false;
+  }
+  revalidated_ = false;
+}
+
+bool asset_cache::Cache::save() {
+  nlohmann::json assets = nlohmann::json::object();
+  nlohmann::json blobs = nlohmann::json::object();
+  std::vector<Blob> bodies;
+
+  {
+    std::lock_guard lock(lock_);
+    if (!open_ || !dirty_) {
+      return true;
+    }
+
+    uint64_t total = 0;
+    for (const auto& [url, record] : records_) {
+      const auto key = hash_key(record.hash);
+
+      if (!blobs.contains(key)) {
+        const auto& blob = blobs_.at(record.hash);
+        if (total + blob.data.size() > max_bytes_) {
+          continue;
+        }
+
+        blobs[key] = {total, blob.data.size()};
+        bodies.push_back(blob);
+        total += blob.data.size();
+      }
+
+      assets[url] = {{"etag", record.validators.etag},
+                     {"last_modified", record.validators.last_modified},
+                     {"mime_type", record.mime_type},
+                     {"charset", record.charset},
+                     {"hash", key}};
+    }
+
+    dirty_ = false;
+  }
+
+  const auto index =
+      nlohmann::json{{"assets", assets}, {"blobs", blobs}}.dump();
+
+  // the mapped pack stays as it is, open() swaps this one in next time
+  std::ofstream file(dir_ / "assets.pack.new",
+                     std::ios_base::binary | std::ios_base::trunc);
+
+  char size[4];
+  for (size_t i = 0; i < 4; ++i) {
+    size[i] = static_cast<char>((index.size() >> (8 * i)) & 0xff);
+  }
+
+  file.write(pack_magic, magic_size);
+  file.write(size, sizeof(size));
+  file.write(index.data(), index.size());
+  for (const auto& blob : bodies) {
+    file.write(blob.data.data(), blob.data.size());
+  }
+
+  return file.good();
+}
+
+asset_cache::Stats asset_cache::Cache::stats() const {
+  std::lock_guard lock(lock_);
+  return stats_;
+}
+
+asset_cache::Cache& asset_cache::cache() {
+  return global_cache;
+}
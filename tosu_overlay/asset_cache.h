@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// The counter's own files (HTML, scripts, styles, fonts, images) from tosu,
+// kept between sessions so the page loads without waiting on tosu:
+//
+//   "asset_cache": {
+//     "enabled": true,
+//     "max_mb": 64
+//   }
+//
+// Everything lives in one pack file, bodies stored once per content hash
+// however many URLs point at them. The pack is memory-mapped and never
+// written while mapped, changes go to a new pack that replaces it on the
+// next start. Only responses with an ETag or Last-Modified are kept, and an
+// entry is only served once tosu confirmed it this session, through
+// revalidate() or by sending it again.
+namespace asset_cache {
+
+struct Stats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t bytes_served;
+  uint64_t stored;
+  // answered 304 by revalidate()
+  uint64_t revalidated;
+  // changed on tosu's side since they were stored
+  uint64_t replaced;
+};
+
+struct Validators {
+  std::string etag;
+  std::string last_modified;
+
+  bool empty() const { return etag.empty() && last_modified.empty(); }
+};
+
+// A cached response ready to serve, data stays valid while it's held.
+struct Asset {
+  std::string mime_type;
+  std::string charset;
+  Validators validators;
+  std::string_view data;
+  std::shared_ptr<const std::string> owner;
+};
+
+// Responses that are never cached: tosu's API and websockets, and beatmap
+// files, which change with every map.
+bool cacheable_path(std::string_view path);
+
+// FNV-1a, the content address of a body.
+uint64_t content_hash(std::string_view data);
+
+// Thread-safe, requests come in on CEF's IO thread while revalidate() and
+// save() run on others.
+class Cache {
+ public:
+  // Maps dir/assets.pack, after moving the pack the last session wrote into
+  // place. Starts empty when there is none or it doesn't parse.
+  bool open(const std::filesystem::path& dir, uint64_t max_bytes);
+  bool is_open() const;
+
+  // Counts a hit or a miss.
+  std::optional<Asset> lookup(const std::string& url);
+
+  void store(const std::string& url,
+             const Validators& validators,
+             const std::string& mime_type,
+             const std::string& charset,
+             std::string body);
+
+  // Bodies larger than this aren't stored.
+  uint64_t max_asset_bytes() const { return max_bytes_ / 4; }
+
+  // Conditional GETs for every entry from host:port not confirmed yet this
+  // session. Blocks, returns false when tosu stopped answering.
+  bool revalidate(const std::string& host,
+                  const std::string& port,
+                  int timeout_ms);
+  bool needs_revalidation() const;
+
+  // Entries have to be confirmed again, e.g. after tosu went away.
+  void expire();
+
+  // Writes the next pack when something changed. Blocks.
+  bool save();
+
+  Stats stats() const;
+
+  std::filesystem::path pack_path() const { return dir_ / "assets.pack"; }
+
+ private:
+  struct Record {
+    Validators validators;
+    std::string mime_type;
+    std::string charset;
+    uint64_t hash;
+    bool validated;
+  };
+
+  struct Blob {
+    std::string_view data;
+    // null for blobs in the mapped pack
+    std::shared_ptr<const std::string> owner;
+    // records pointing at it, it goes with the last
+    uint64_t refs = 0;
+    // order owned blobs were stored in, the oldest is evicted first
+    uint64_t stored = 0;
+  };
+
+  void load(std::string_view pack);
+  void put(const std::string& url, Record record, std::string body);
+  // Drops the record and its blob if no other record shares it.
+  void erase(std::unordered_map<std::string, Record>::iterator record);
+  void release(uint64_t hash);
+  // Evicts the oldest owned bodies, and the records on them, until the ones
+  // held in memory fit max_bytes_ again. keep is the blob just stored.
+  void trim(uint64_t keep);
+
+  mutable std::mutex lock_;
+
+  std::filesystem::path dir_;
+  uint64_t max_bytes_ = 0;
+  bool open_ = false;
+  bool dirty_ = false;
+  bool revalidated_ = false;
+
+  std::unordered_map<std::string, Record> records_;
+  std::unordered_map<uint64_t, Blob> blobs_;
+  // bodies held in memory, the mapped pack's aside
+  uint64_t owned_bytes_ = 0;
+  uint64_t next_stored_ = 0;
+
+  Stats stats_{};
+};
+
+Cache& cache();
+
+// Platform layer, asset_cache_win.cc and asset_cache_posix.cc: the whole
+// file mapped read-only for the rest of the process, empty when it can't
+// be.
+std::string_view map_file(const std::filesystem::path& path);
+
+}  // namespace asset_cache
@@ -0,0 +1,29 @@
+#include <tosu_overlay/asset_cache.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string_view asset_cache::map_file(const std::filesystem::path& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return {};
+  }
+
+  struct stat info {};
+  void* data = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0) {
+    data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                MAP_PRIVATE, fd, 0);
+  }
+
+  // the mapping keeps the file
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    return {};
+  }
+
+  return {static_cast<const char*>(data), static_cast<size_t>(info.st_size)};
+}
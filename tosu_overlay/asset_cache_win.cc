@@ -0,0 +1,34 @@
+#include <tosu_overlay/asset_cache.h>
+
+#include <windows.h>
+
+std::string_view asset_cache::map_file(const std::filesystem::path& path) {
+  // FILE_SHARE_DELETE so the next start can rename the new pack over it
+  const auto file = CreateFileW(
+      path.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return {};
+  }
+
+  LARGE_INTEGER size{};
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  }
+
+  const void* data = nullptr;
+  if (mapping) {
+    data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    // the view keeps the mapping and the file
+    CloseHandle(mapping);
+  }
+  CloseHandle(file);
+
+  if (!data) {
+    return {};
+  }
+
+  return {static_cast<const char*>(data), static_cast<size_t>(size.QuadPart)};
+}
@@ -0,0 +1,204 @@
+#include "tosu_overlay/asset_request_handler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "include/cef_resource_handler.h"
+#include "include/cef_response_filter.h"
+#include "include/wrapper/cef_helpers.h"
+#include "tosu_overlay/asset_cache.h"
+#include "tosu_overlay/state.h"
+
+namespace {
+
+// Hands out a cached body straight from the pack mapping.
+class CachedAssetHandler : public CefResourceHandler {
+ public:
+  explicit CachedAssetHandler(asset_cache::Asset asset)
+      : asset_(std::move(asset)) {}
+
+  bool Open(CefRefPtr<CefRequest> request,
+            bool& handle_request,
+            CefRefPtr<CefCallback> callback) override {
+    handle_request = true;
+    return true;
+  }
+
+  void GetResponseHeaders(CefRefPtr<CefResponse> response,
+                          int64_t& response_length,
+                          CefString& redirectUrl) override {
+    response->SetStatus(200);
+    response->SetStatusText("OK");
+    response->SetMimeType(asset_.mime_type);
+    if (!asset_.charset.empty()) {
+      response->SetCharset(asset_.charset);
+    }
+    if (!asset_.validators.etag.empty()) {
+      response->SetHeaderByName("ETag", asset_.validators.etag, true);
+    }
+    if (!asset_.validators.last_modified.empty()) {
+      response->SetHeaderByName("Last-Modified",
+                                asset_.validators.last_modified, true);
+    }
+
+    response_length = static_cast<int64_t>(asset_.data.size());
+  }
+
+  bool Skip(int64_t bytes_to_skip,
+            int64_t& bytes_skipped,
+            CefRefPtr<CefResourceSkipCallback> callback) override {
+    const auto left = asset_.data.size() - offset_;
+    const auto skipped = std::min(static_cast<size_t>(bytes_to_skip), left);
+    offset_ += skipped;
+    bytes_skipped = static_cast<int64_t>(skipped);
+    return true;
+  }
+
+  bool Read(void* data_out,
+            int bytes_to_read,
+            int& bytes_read,
+            CefRefPtr<CefResourceReadCallback> callback) override {
+    const auto left = asset_.data.size() - offset_;
+    const auto size = std::min(static_cast<size_t>(bytes_to_read), left);
+
+    std::memcpy(data_out, asset_.data.data() + offset_, size);
+    offset_ += size;
+    bytes_read = static_cast<int>(size);
+
+    // false with nothing read ends the response
+    return size > 0;
+  }
+
+  void Cancel() override {}
+
+ private:
+  asset_cache::Asset asset_;
+  size_t offset_ = 0;
+
+  IMPLEMENT_REFCOUNTING(CachedAssetHandler);
+};
+
+}  // namespace
+
+// Passes the body through unchanged and keeps a copy for the cache.
+class AssetRequestHandler::CaptureFilter : public CefResponseFilter {
+ public:
+  explicit CaptureFilter(uint64_t limit) : limit_(limit) {}
+
+  bool InitFilter() override { return true; }
+
+  FilterStatus Filter(void* data_in,
+                      size_t data_in_size,
+                      size_t& data_in_read,
+                      void* data_out,
+                      size_t data_out_size,
+                      size_t& data_out_written) override {
+    const auto size = std::min(data_in_size, data_out_size);
+    if (size > 0) {
+      std::memcpy(data_out, data_in, size);
+    }
+    data_in_read = size;
+    data_out_written = size;
+
+    if (!overflowed_) {
+      if (body_.size() + size > limit_) {
+        overflowed_ = true;
+        body_.clear();
+        body_.shrink_to_fit();
+      } else {
+        body_.append(static_cast<const char*>(data_in), size);
+      }
+    }
+
+    // the rest of the input comes again with the next call
+    return size < data_in_size ? RESPONSE_FILTER_NEED_MORE_DATA
+                               : RESPONSE_FILTER_DONE;
+  }
+
+  bool overflowed() const { return overflowed_; }
+  std::string take_body() { return std::move(body_); }
+
+ private:
+  uint64_t limit_;
+  bool overflowed_ = false;
+  std::string body_;
+
+  IMPLEMENT_REFCOUNTING(CaptureFilter);
+};
+
+bool AssetRequestHandler::Handles(CefRefPtr<CefRequest> request) {
+  if (request->GetMethod() != "GET") {
+    return false;
+  }
+
+  const auto origin = "http://" + state::host + ":" + state::port + "/";
+  const auto url = request->GetURL().ToString();
+  if (url.rfind(origin, 0) != 0) {
+    return false;
+  }
+
+  return asset_cache::cacheable_path(
+      std::string_view(url).substr(origin.size() - 1));
+}
+
+CefRefPtr<CefResourceHandler> AssetRequestHandler::GetResourceHandler(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request) {
+  CEF_REQUIRE_IO_THREAD();
+
+  // a reload that skips the cache skips this one too, and refreshes it
+  if (request->GetFlags() & UR_FLAG_SKIP_CACHE) {
+    return nullptr;
+  }
+
+  auto asset = asset_cache::cache().lookup(url_);
+  if (!asset) {
+    return nullptr;
+  }
+
+  served_from_cache_ = true;
+  return new CachedAssetHandler(std::move(*asset));
+}
+
+CefRefPtr<CefResponseFilter> AssetRequestHandler::GetResourceResponseFilter(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request,
+    CefRefPtr<CefResponse> response) {
+  CEF_REQUIRE_IO_THREAD();
+
+  if (served_from_cache_ || response->GetStatus() != 200) {
+    return nullptr;
+  }
+
+  if (response->GetHeaderByName("ETag").empty() &&
+      response->GetHeaderByName("Last-Modified").empty()) {
+    return nullptr;
+  }
+
+  capture_ = new CaptureFilter(asset_cache::cache().max_asset_bytes());
+  return capture_;
+}
+
+void AssetRequestHandler::OnResourceLoadComplete(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request,
+    CefRefPtr<CefResponse> response,
+    URLRequestStatus status,
+    int64_t received_content_length) {
+  CEF_REQUIRE_IO_THREAD();
+
+  if (!capture_ || status != UR_SUCCESS || capture_->overflowed()) {
+    return;
+  }
+
+  asset_cache::cache().store(
+      url_,
+      {response->GetHeaderByName("ETag").ToString(),
+       response->GetHeaderByName("Last-Modified").ToString()},
+      response->GetMimeType().ToString(), response->GetCharset().ToString(),
+      capture_->take_body());
+}
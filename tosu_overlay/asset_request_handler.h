@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "include/cef_resource_request_handler.h"
+
+// Requests for tosu's counter files (see asset_cache.h). Serves them from
+// the cache when it has them confirmed, otherwise lets the request go to
+// tosu and stores what comes back. Created per request on the IO thread by
+// SimpleHandler::GetResourceRequestHandler.
+class AssetRequestHandler : public CefResourceRequestHandler {
+ public:
+  explicit AssetRequestHandler(std::string url) : url_(std::move(url)) {}
+
+  // Whether a request should go through the cache at all: a GET to tosu
+  // for something other than its API.
+  static bool Handles(CefRefPtr<CefRequest> request);
+
+  // CefResourceRequestHandler methods:
+  CefRefPtr<CefResourceHandler> GetResourceHandler(
+      CefRefPtr<CefBrowser> browser,
+      CefRefPtr<CefFrame> frame,
+      CefRefPtr<CefRequest> request) override;
+  CefRefPtr<CefResponseFilter> GetResourceResponseFilter(
+      CefRefPtr<CefBrowser> browser,
+      CefRefPtr<CefFrame> frame,
+      CefRefPtr<CefRequest> request,
+      CefRefPtr<CefResponse> response) override;
+  void OnResourceLoadComplete(CefRefPtr<CefBrowser> browser,
+                              CefRefPtr<CefFrame> frame,
+                              CefRefPtr<CefRequest> request,
+                              CefRefPtr<CefResponse> response,
+                              URLRequestStatus status,
+                              int64_t received_content_length) override;
+
+ private:
+  class CaptureFilter;
+
+  std::string url_;
+  bool served_from_cache_ = false;
+  CefRefPtr<CaptureFilter> capture_;
+
+  IMPLEMENT_REFCOUNTING(AssetRequestHandler);
+};
@@ -0,0 +1,199 @@
+#include "tosu_overlay/beatmap_image_handler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "include/base/cef_callback.h"
+#include "include/cef_resource_handler.h"
+#include "include/cef_task.h"
+#include "include/wrapper/cef_closure_task.h"
+#include "tosu_overlay/beatmap_images.h"
+#include "tosu_overlay/http_probe.h"
+#include "tosu_overlay/state.h"
+
+namespace {
+
+constexpr int fetch_timeout_ms = 5000;
+
+std::string tosu_origin() {
+  return "http://" + state::host + ":" + state::port;
+}
+
+// Serves an image from beatmap_images::cache(), loading it first when it
+// isn't there.
+class BeatmapImageHandler : public CefResourceHandler {
+ public:
+  explicit BeatmapImageHandler(std::string url) : url_(std::move(url)) {}
+
+  bool Open(CefRefPtr<CefRequest> request,
+            bool& handle_request,
+            CefRefPtr<CefCallback> callback) override {
+    // the same URL is the same file, scaled or not
+    if (beatmap_images::stable_path(path(url_))) {
+      image_ = beatmap_images::cache().get(url_);
+      if (image_) {
+        handle_request = true;
+        return true;
+      }
+    }
+
+    handle_request = false;
+    CefPostTask(TID_FILE_USER_VISIBLE,
+                base::BindOnce(&BeatmapImageHandler::Load, this, callback));
+    return true;
+  }
+
+  void GetResponseHeaders(CefRefPtr<CefResponse> response,
+                          int64_t& response_length,
+                          CefString& redirectUrl) override {
+    if (!image_) {
+      response->SetStatus(status_);
+      response_length = 0;
+      return;
+    }
+
+    response->SetStatus(200);
+    response->SetStatusText("OK");
+    response->SetMimeType(image_->mime_type);
+    response_length = static_cast<int64_t>(image_->data.size());
+  }
+
+  bool Skip(int64_t bytes_to_skip,
+            int64_t& bytes_skipped,
+            CefRefPtr<CefResourceSkipCallback> callback) override {
+    const auto left = image_ ? image_->data.size() - offset_ : 0;
+    const auto skipped = std::min(static_cast<size_t>(bytes_to_skip), left);
+    offset_ += skipped;
+    bytes_skipped = static_cast<int64_t>(skipped);
+    return true;
+  }
+
+  bool Read(void* data_out,
+            int bytes_to_read,
+            int& bytes_read,
+            CefRefPtr<CefResourceReadCallback> callback) override {
+    const auto left = image_ ? image_->data.size() - offset_ : 0;
+    const auto size = std::min(static_cast<size_t>(bytes_to_read), left);
+
+    if (size > 0) {
+      std::memcpy(data_out, image_->data.data() + offset_, size);
+    }
+    offset_ += size;
+    bytes_read = static_cast<int>(size);
+
+    return size > 0;
+  }
+
+  void Cancel() override {}
+
+ private:
+  static std::string path(const std::string& url) {
+    return url.substr(tosu_origin().size());
+  }
+
+  void Load(CefRefPtr<CefCallback> callback) {
+    image_ = Fetch();
+    callback->Continue();
+  }
+
+  std::shared_ptr<const beatmap_images::Image> Fetch() {
+    auto& images = beatmap_images::cache();
+
+    const bool stable = beatmap_images::stable_path(path(url_));
+    const auto source_url = beatmap_images::source_url(url_);
+    const auto bounds = beatmap_images::requested_size(url_);
+
+    // Open already counted the request's miss
+    std::shared_ptr<const beatmap_images::Image> source;
+    if (stable && bounds) {
+      source = images.find(source_url);
+    }
+
+    if (!source) {
+      auto response = http_probe::fetch(state::host, state::port,
+                                        path(source_url), {},
+                                        fetch_timeout_ms);
+      if (response.status != 200) {
+        status_ = response.status != 0 ? response.status : 502;
+        return nullptr;
+      }
+
+      auto mime_type = response.header("content-type");
+      if (mime_type.empty()) {
+        mime_type = "image/jpeg";
+      }
+
+      source = std::make_shared<const beatmap_images::Image>(
+          beatmap_images::Image{mime_type, std::move(response.body)});
+      if (stable) {
+        images.put(source_url, source);
+      }
+    }
+
+    if (!bounds) {
+      return source;
+    }
+
+    // the current background is cached by what it is, not where it is
+    const auto key =
+        stable ? url_ : beatmap_images::scaled_key(source->data, *bounds);
+    if (!stable) {
+      if (auto image = images.get(key)) {
+        return image;
+      }
+    }
+
+    auto scaled = beatmap_images::scale(*source, *bounds);
+    if (!scaled) {
+      // can't be decoded or already small enough
+      images.put(key, source);
+      return source;
+    }
+
+    images.count_scaled();
+    auto image =
+        std::make_shared<const beatmap_images::Image>(std::move(*scaled));
+    images.put(key, image);
+    return image;
+  }
+
+  std::string url_;
+  std::shared_ptr<const beatmap_images::Image> image_;
+  int status_ = 502;
+  size_t offset_ = 0;
+
+  IMPLEMENT_REFCOUNTING(BeatmapImageHandler);
+};
+
+}  // namespace
+
+bool BeatmapImageRequestHandler::Handles(CefRefPtr<CefRequest> request) {
+  if (request->GetMethod() != "GET") {
+    return false;
+  }
+
+  const auto origin = tosu_origin() + "/";
+  const auto url = request->GetURL().ToString();
+  if (url.rfind(origin, 0) != 0) {
+    return false;
+  }
+
+  const auto path = std::string_view(url).substr(origin.size() - 1);
+  if (!beatmap_images::handles_path(path)) {
+    return false;
+  }
+
+  // nothing to gain for the current background at full size
+  return beatmap_images::stable_path(path) ||
+         beatmap_images::requested_size(url).has_value();
+}
+
+CefRefPtr<CefResourceHandler> BeatmapImageRequestHandler::GetResourceHandler(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request) {
+  return new BeatmapImageHandler(request->GetURL().ToString());
+}
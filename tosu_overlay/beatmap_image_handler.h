@@ -0,0 +1,23 @@
+#pragma once
+
+#include "include/cef_resource_request_handler.h"
+
+// Requests for beatmap images (see beatmap_images.h). Cached images are
+// answered right away, anything else is fetched from tosu and scaled on
+// TID_FILE_USER_VISIBLE while the request waits. Created per request on
+// the IO thread by SimpleHandler::GetResourceRequestHandler.
+class BeatmapImageRequestHandler : public CefResourceRequestHandler {
+ public:
+  // A GET to tosu for a beatmap image, with a size for the current map's
+  // background (which isn't cached otherwise).
+  static bool Handles(CefRefPtr<CefRequest> request);
+
+  // CefResourceRequestHandler methods:
+  CefRefPtr<CefResourceHandler> GetResourceHandler(
+      CefRefPtr<CefBrowser> browser,
+      CefRefPtr<CefFrame> frame,
+      CefRefPtr<CefRequest> request) override;
+
+ private:
+  IMPLEMENT_REFCOUNTING(BeatmapImageRequestHandler);
+};
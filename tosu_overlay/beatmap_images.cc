@@ -0,0 +1,267 @@
+#include <tosu_overlay/asset_cache.h>
+#include <tosu_overlay/beatmap_images.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+beatmap_images::Cache global_cache;
+
+constexpr std::string_view beatmap_prefix = "/files/beatmap/";
+constexpr std::string_view current_background = "/files/beatmap/background";
+
+constexpr int min_side = 16;
+constexpr int max_side = 4096;
+
+bool ends_with(std::string_view text, std::string_view suffix) {
+  if (text.size() < suffix.size()) {
+    return false;
+  }
+
+  const auto tail = text.substr(text.size() - suffix.size());
+  return std::equal(tail.begin(), tail.end(), suffix.begin(),
+                    [](char a, char b) {
+                      return std::tolower(static_cast<unsigned char>(a)) == b;
+                    });
+}
+
+// Calls parameter(name, value) for each name=value of url's query.
+template <typename Callback>
+void for_each_parameter(std::string_view url, Callback parameter) {
+  const auto question = url.find('?');
+  if (question == std::string_view::npos) {
+    return;
+  }
+
+  auto query = url.substr(question + 1);
+  while (!query.empty()) {
+    const auto amp = query.find('&');
+    const auto item = query.substr(0, amp);
+    query = amp == std::string_view::npos ? std::string_view()
+                                          : query.substr(amp + 1);
+
+    const auto equals = item.find('=');
+    parameter(item.substr(0, equals),
+              equals == std::string_view::npos ? std::string_view()
+                                               : item.substr(equals + 1));
+  }
+}
+
+bool is_size_parameter(std::string_view name) {
+  return name == "w" || name == "h";
+}
+
+}  // namespace
+
+bool beatmap_images::handles_path(std::string_view path) {
+  path = path.substr(0, path.find('?'));
+  if (path.substr(0, beatmap_prefix.size()) != beatmap_prefix) {
+    return false;
+  }
+
+  return path == current_background || ends_with(path, ".jpg") ||
+         ends_with(path, ".jpeg") || ends_with(path, ".png");
+}
+
+bool beatmap_images::stable_path(std::string_view path) {
+  return path.substr(0, path.find('?')) != current_background;
+}
+
+std::optional<beatmap_images::Size> beatmap_images::requested_size(
+    std::string_view url) {
+  Size size{0, 0};
+
+  for_each_parameter(url, [&](std::string_view name, std::string_view value) {
+    if (!is_size_parameter(name)) {
+      return;
+    }
+
+    const auto number = std::clamp(
+        std::atoi(std::string(value).c_str()), min_side, max_side);
+    (name == "w" ? size.width : size.height) = number;
+  });
+
+  if (size.width == 0 && size.height == 0) {
+    return std::nullopt;
+  }
+  return size;
+}
+
+std::string beatmap_images::source_url(std::string_view url) {
+  std::string result(url.substr(0, url.find('?')));
+
+  char separator = '?';
+  for_each_parameter(url, [&](std::string_view name, std::string_view value) {
+    if (is_size_parameter(name)) {
+      return;
+    }
+
+    result += separator;
+    result += name;
+    if (!value.empty()) {
+      result += '=';
+      result += value;
+    }
+    separator = '&';
+  });
+
+  return result;
+}
+
+beatmap_images::Size beatmap_images::fit(Size source, Size bounds) {
+  if (source.width <= 0 || source.height <= 0) {
+    return {0, 0};
+  }
+
+  // scale = min(bounds / source) over the constrained sides, at most 1
+  double scale = 1.0;
+  if (bounds.width > 0) {
+    scale = std::min(scale, static_cast<double>(bounds.width) / source.width);
+  }
+  if (bounds.height > 0) {
+    scale =
+        std::min(scale, static_cast<double>(bounds.height) / source.height);
+  }
+
+  return {std::max(1, static_cast<int>(source.width * scale + 0.5)),
+          std::max(1, static_cast<int>(source.height * scale + 0.5))};
+}
+
+void beatmap_images::downscale(const uint8_t* src,
+                               Size src_size,
+                               int src_stride,
+                               uint8_t* dst,
+                               Size dst_size) {
+  const auto dst_width = static_cast<size_t>(dst_size.width);
+
+  // source columns [column_start[x], column_start[x + 1]) make up column x
+  std::vector<int> column_start(dst_width + 1);
+  for (size_t x = 0; x <= dst_width; ++x) {
+    column_start[x] = static_cast<int>(x * src_size.width / dst_width);
+  }
+
+  std::vector<uint64_t> sums(dst_width * 4);
+
+  for (int y = 0; y < dst_size.height; ++y) {
+    const int row_start = y * src_size.height / dst_size.height;
+    const int row_end =
+        std::max((y + 1) * src_size.height / dst_size.height, row_start + 1);
+
+    std::fill(sums.begin(), sums.end(), 0);
+
+    // each source row is read once, summed into the columns it belongs to
+    for (int row = row_start; row < row_end; ++row) {
+      const auto* pixel = src + static_cast<size_t>(row) * src_stride;
+      for (size_t x = 0; x < dst_width; ++x) {
+        auto* sum = &sums[x * 4];
+        const int end = std::max(column_start[x + 1], column_start[x] + 1);
+        for (int column = column_start[x]; column < end; ++column) {
+          const auto* p = pixel + column * 4;
+          sum[0] += p[0];
+          sum[1] += p[1];
+          sum[2] += p[2];
+          sum[3] += p[3];
+        }
+      }
+    }
+
+    auto* out = dst + static_cast<size_t>(y) * dst_width * 4;
+    for (size_t x = 0; x < dst_width; ++x) {
+      const uint64_t count =
+          static_cast<uint64_t>(row_end - row_start) *
+          std::max(column_start[x + 1] - column_start[x], 1);
+      for (size_t c = 0; c < 4; ++c) {
+        out[x * 4 + c] =
+            static_cast<uint8_t>((sums[x * 4 + c] + count / 2) / count);
+      }
+    }
+  }
+}
+
+std::string beatmap_images::scaled_key(std::string_view source, Size bounds) {
+  char key[48];
+  std::snprintf(key, sizeof(key), "%016llx@%dx%d",
+                static_cast<unsigned long long>(
+                    asset_cache::content_hash(source)),
+                bounds.width, bounds.height);
+  return key;
+}
+
+void beatmap_images::Cache::set_budget(uint64_t max_bytes) {
+  std::lock_guard lock(lock_);
+  max_bytes_ = max_bytes;
+}
+
+std::shared_ptr<const beatmap_images::Image> beatmap_images::Cache::get(
+    const std::string& key) {
+  std::lock_guard lock(lock_);
+
+  auto image = touch(key);
+  if (image) {
+    ++stats_.hits;
+  } else {
+    ++stats_.misses;
+  }
+  return image;
+}
+
+std::shared_ptr<const beatmap_images::Image> beatmap_images::Cache::find(
+    const std::string& key) {
+  std::lock_guard lock(lock_);
+  return touch(key);
+}
+
+std::shared_ptr<const beatmap_images::Image> beatmap_images::Cache::touch(
+    const std::string& key) {
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void beatmap_images::Cache::put(const std::string& key,
+                                std::shared_ptr<const Image> image) {
+  std::lock_guard lock(lock_);
+
+  if (image->data.size() > max_bytes_) {
+    return;
+  }
+
+  if (const auto it = index_.find(key); it != index_.end()) {
+    stats_.bytes -= it->second->second->data.size();
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+
+  entries_.emplace_front(key, std::move(image));
+  index_[key] = entries_.begin();
+  stats_.bytes += entries_.front().second->data.size();
+
+  while (stats_.bytes > max_bytes_) {
+    const auto& oldest = entries_.back();
+    stats_.bytes -= oldest.second->data.size();
+    index_.erase(oldest.first);
+    entries_.pop_back();
+  }
+}
+
+void beatmap_images::Cache::count_scaled() {
+  std::lock_guard lock(lock_);
+  ++stats_.scaled;
+}
+
+beatmap_images::Stats beatmap_images::Cache::stats() const {
+  std::lock_guard lock(lock_);
+  return stats_;
+}
+
+beatmap_images::Cache& beatmap_images::cache() {
+  return global_cache;
+}
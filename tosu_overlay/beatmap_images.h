@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Beatmap backgrounds from tosu's /files/beatmap/, kept in memory and
+// optionally shrunk to the size a counter shows them at:
+//
+//   "beatmap_images": {
+//     "enabled": true,
+//     "cache_mb": 64
+//   }
+//
+// A w and/or h query parameter (/files/beatmap/background?w=480) gets the
+// image scaled down to fit, keeping its aspect ratio, decoded and scaled
+// on a CEF file thread instead of the renderer decoding the full image.
+// Files addressed by folder and name are cached by URL. The current map's
+// /files/beatmap/background changes with the map, so it's fetched every
+// time and only its scaled versions are cached, by content.
+namespace beatmap_images {
+
+// 0 leaves that side unconstrained.
+struct Size {
+  int width;
+  int height;
+};
+
+struct Image {
+  std::string mime_type;
+  std::string data;
+};
+
+struct Stats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t bytes;
+  uint64_t scaled;
+};
+
+// Whether a path is a beatmap image this cache deals with.
+bool handles_path(std::string_view path);
+
+// Whether the same path always means the same file.
+bool stable_path(std::string_view path);
+
+// w and h from the query, nullopt when neither is set.
+std::optional<Size> requested_size(std::string_view url);
+
+// url without w and h, what tosu is asked for.
+std::string source_url(std::string_view url);
+
+// The largest size within bounds keeping source's aspect ratio, never
+// larger than source.
+Size fit(Size source, Size bounds);
+
+// Area-averaging downscale of 4 bytes per pixel images, dst no larger
+// than src.
+void downscale(const uint8_t* src,
+               Size src_size,
+               int src_stride,
+               uint8_t* dst,
+               Size dst_size);
+
+// Key for a scaled version of a source image.
+std::string scaled_key(std::string_view source, Size bounds);
+
+// Least recently used images go first once the cache is over its budget.
+// Thread-safe.
+class Cache {
+ public:
+  void set_budget(uint64_t max_bytes);
+
+  // Counts a hit or a miss, once per request.
+  std::shared_ptr<const Image> get(const std::string& key);
+  // The same without counting, for further lookups of a counted request.
+  std::shared_ptr<const Image> find(const std::string& key);
+  void put(const std::string& key, std::shared_ptr<const Image> image);
+
+  void count_scaled();
+  Stats stats() const;
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<const Image>>;
+
+  // Moves the entry to the front, lock_ held.
+  std::shared_ptr<const Image> touch(const std::string& key);
+
+  mutable std::mutex lock_;
+  uint64_t max_bytes_ = 0;
+  // most recently used first
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  Stats stats_{};
+};
+
+Cache& cache();
+
+// Platform layer, beatmap_images_win.cc (WIC) and beatmap_images_linux.cc:
+// decodes source, scales it down to fit bounds with downscale() and encodes
+// it again, as PNG when it was one and JPEG otherwise. nullopt when it
+// can't be decoded or already fits.
+std::optional<Image> scale(const Image& source, Size bounds);
+
+}  // namespace beatmap_images
@@ -0,0 +1,6 @@
+#include <tosu_overlay/beatmap_images.h>
+
+// No image codec without adding a dependency, counters get the original.
+std::optional<beatmap_images::Image> beatmap_images::scale(const Image&, Size) {
+  return std::nullopt;
+}
@@ -0,0 +1,180 @@
+#include <tosu_overlay/beatmap_images.h>
+
+#include <windows.h>
+
+#include <wincodec.h>
+#include <wrl/client.h>
+
+#include <vector>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+
+// JPEG quality of scaled backgrounds.
+constexpr float jpeg_quality = 0.9f;
+
+// COM for the calling thread, CEF's file threads may have it already.
+class ComScope {
+ public:
+  ComScope() : result_(CoInitializeEx(nullptr, COINIT_MULTITHREADED)) {}
+  ~ComScope() {
+    if (SUCCEEDED(result_)) {
+      CoUninitialize();
+    }
+  }
+
+ private:
+  HRESULT result_;
+};
+
+std::optional<std::string> encode(IWICImagingFactory* factory,
+                                  IWICBitmapSource* source,
+                                  bool png) {
+  ComPtr<IStream> stream;
+  if (FAILED(CreateStreamOnHGlobal(nullptr, TRUE, &stream))) {
+    return std::nullopt;
+  }
+
+  ComPtr<IWICBitmapEncoder> encoder;
+  if (FAILED(factory->CreateEncoder(
+          png ? GUID_ContainerFormatPng : GUID_ContainerFormatJpeg, nullptr,
+          &encoder)) ||
+      FAILED(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache))) {
+    return std::nullopt;
+  }
+
+  ComPtr<IWICBitmapFrameEncode> frame;
+  ComPtr<IPropertyBag2> options;
+  if (FAILED(encoder->CreateNewFrame(&frame, &options))) {
+    return std::nullopt;
+  }
+
+  if (!png) {
+    PROPBAG2 option{};
+    option.pstrName = const_cast<LPOLESTR>(L"ImageQuality");
+    VARIANT value;
+    VariantInit(&value);
+    value.vt = VT_R4;
+    value.fltVal = jpeg_quality;
+    options->Write(1, &option, &value);
+  }
+
+  UINT width = 0;
+  UINT height = 0;
+  source->GetSize(&width, &height);
+
+  // the encoder picks the closest format it supports (24bpp for JPEG)
+  WICPixelFormatGUID format = GUID_WICPixelFormat32bppBGRA;
+  if (FAILED(frame->Initialize(options.Get())) ||
+      FAILED(frame->SetSize(width, height)) ||
+      FAILED(frame->SetPixelFormat(&format))) {
+    return std::nullopt;
+  }
+
+  ComPtr<IWICFormatConverter> converter;
+  if (FAILED(factory->CreateFormatConverter(&converter)) ||
+      FAILED(converter->Initialize(source, format, WICBitmapDitherTypeNone,
+                                   nullptr, 0.0,
+                                   WICBitmapPaletteTypeCustom)) ||
+      FAILED(frame->WriteSource(converter.Get(), nullptr)) ||
+      FAILED(frame->Commit()) || FAILED(encoder->Commit())) {
+    return std::nullopt;
+  }
+
+  STATSTG stat{};
+  HGLOBAL memory = nullptr;
+  if (FAILED(stream->Stat(&stat, STATFLAG_NONAME)) ||
+      FAILED(GetHGlobalFromStream(stream.Get(), &memory))) {
+    return std::nullopt;
+  }
+
+  const auto* data = static_cast<const char*>(GlobalLock(memory));
+  std::string encoded(data, static_cast<size_t>(stat.cbSize.QuadPart));
+  GlobalUnlock(memory);
+
+  return encoded;
+}
+
+}  // namespace
+
+std::optional<beatmap_images::Image> beatmap_images::scale(
+    const Image& source,
+    Size bounds) {
+  ComScope com;
+
+  ComPtr<IWICImagingFactory> factory;
+  if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr,
+                              CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory)))) {
+    return std::nullopt;
+  }
+
+  ComPtr<IWICStream> stream;
+  if (FAILED(factory->CreateStream(&stream)) ||
+      FAILED(stream->InitializeFromMemory(
+          reinterpret_cast<BYTE*>(const_cast<char*>(source.data.data())),
+          static_cast<DWORD>(source.data.size())))) {
+    return std::nullopt;
+  }
+
+  ComPtr<IWICBitmapDecoder> decoder;
+  ComPtr<IWICBitmapFrameDecode> frame;
+  if (FAILED(factory->CreateDecoderFromStream(
+          stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, &decoder)) ||
+      FAILED(decoder->GetFrame(0, &frame))) {
+    return std::nullopt;
+  }
+
+  UINT width = 0;
+  UINT height = 0;
+  frame->GetSize(&width, &height);
+
+  const Size source_size{static_cast<int>(width), static_cast<int>(height)};
+  const auto target = fit(source_size, bounds);
+  if (target.width >= source_size.width &&
+      target.height >= source_size.height) {
+    return std::nullopt;
+  }
+
+  ComPtr<IWICFormatConverter> converter;
+  if (FAILED(factory->CreateFormatConverter(&converter)) ||
+      FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppBGRA,
+                                   WICBitmapDitherTypeNone, nullptr, 0.0,
+                                   WICBitmapPaletteTypeCustom))) {
+    return std::nullopt;
+  }
+
+  const auto stride = width * 4;
+  std::vector<uint8_t> pixels(static_cast<size_t>(stride) * height);
+  if (FAILED(converter->CopyPixels(nullptr, stride,
+                                   static_cast<UINT>(pixels.size()),
+                                   pixels.data()))) {
+    return std::nullopt;
+  }
+
+  std::vector<uint8_t> scaled(static_cast<size_t>(target.width) *
+                              target.height * 4);
+  downscale(pixels.data(), source_size, static_cast<int>(stride),
+            scaled.data(), target);
+
+  ComPtr<IWICBitmap> bitmap;
+  if (FAILED(factory->CreateBitmapFromMemory(
+          target.width, target.height, GUID_WICPixelFormat32bppBGRA,
+          target.width * 4, static_cast<UINT>(scaled.size()), scaled.data(),
+          &bitmap))) {
+    return std::nullopt;
+  }
+
+  GUID container{};
+  decoder->GetContainerFormat(&container);
+  const bool png = container == GUID_ContainerFormatPng;
+
+  auto encoded = encode(factory.Get(), bitmap.Get(), png);
+  if (!encoded) {
+    return std::nullopt;
+  }
+
+  return Image{png ? "image/png" : "image/jpeg", std::move(*encoded)};
+}
@@ -0,0 +1,130 @@
+// Counter assets from tosu against asset_cache: fetching a body from a
+// stand-in tosu server over localhost (what every start did before) versus
+// a hit in a pack written and mapped the way the overlay does it. Then the
+// startup prefetch, conditional GETs answered 304 for every entry. POSIX
+// only, like the stand-in server.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <tosu_overlay/asset_cache.h>
+#include <tosu_overlay/http_probe.h>
+
+#include "stand_in_server.h"
+
+namespace {
+
+constexpr int timeout_ms = 1000;
+constexpr uint64_t max_bytes = uint64_t{64} << 20;
+
+// "GET /asset/<size> ..." gets <size> bytes with an ETag, and a 304 when
+// the request already carries it.
+std::string respond(const std::string& request) {
+  if (request.find("If-None-Match:") != std::string::npos) {
+    return "HTTP/1.1 304 Not Modified\r\nETag: \"1\"\r\n"
+           "Connection: close\r\n\r\n";
+  }
+
+  const auto path = request.find("/asset/");
+  const auto size =
+      path == std::string::npos
+          ? 0
+          : std::strtoull(request.c_str() + path + 7, nullptr, 10);
+
+  return "HTTP/1.1 200 OK\r\nContent-Type: text/javascript\r\n"
+         "ETag: \"1\"\r\nContent-Length: " +
+         std::to_string(size) + "\r\nConnection: close\r\n\r\n" +
+         std::string(size, 'x');
+}
+
+std::string asset_url(const std::string& port, size_t index, size_t size) {
+  return "http://127.0.0.1:" + port + "/asset/" + std::to_string(size) +
+         "?" + std::to_string(index);
+}
+
+// A pack of count assets of size bytes, each with a distinct body, written
+// by one session and opened by the next.
+std::filesystem::path write_pack(const std::string& port,
+                                 size_t count,
+                                 size_t size) {
+  const auto dir = std::filesystem::temp_directory_path() /
+                   ("tosu_asset_bench_" + std::to_string(count) + "_" +
+                    std::to_string(size));
+  std::filesystem::remove_all(dir);
+
+  asset_cache::Cache writer;
+  writer.open(dir, max_bytes);
+  for (size_t i = 0; i < count; ++i) {
+    auto body = std::string(size, 'x');
+    std::memcpy(body.data(), &i, std::min(sizeof(i), size));
+    writer.store(asset_url(port, i, size), {"\"1\"", ""}, "text/javascript",
+                 "", std::move(body));
+  }
+  writer.save();
+
+  return dir;
+}
+
+void BM_AssetFetch(benchmark::State& state) {
+  const auto size = static_cast<size_t>(state.range(0));
+  StandInServer server(respond);
+  const auto path = "/asset/" + std::to_string(size);
+
+  for (auto _ : state) {
+    const auto response =
+        http_probe::fetch("127.0.0.1", server.port(), path, {}, timeout_ms);
+    benchmark::DoNotOptimize(response.body.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_AssetFetch)->Arg(16 << 10)->Arg(256 << 10)->UseRealTime();
+
+void BM_AssetCacheHit(benchmark::State& state) {
+  const auto size = static_cast<size_t>(state.range(0));
+  StandInServer server(respond);
+
+  asset_cache::Cache cache;
+  cache.open(write_pack(server.port(), 1, size), max_bytes);
+  cache.revalidate("127.0.0.1", server.port(), timeout_ms);
+
+  const auto url = asset_url(server.port(), 0, size);
+  std::vector<char> out(size);
+
+  for (auto _ : state) {
+    // what CachedAssetHandler does: look up, copy out of the mapping
+    const auto asset = cache.lookup(url);
+    std::memcpy(out.data(), asset->data.data(), asset->data.size());
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_AssetCacheHit)->Arg(16 << 10)->Arg(256 << 10)->UseRealTime();
+
+// The startup prefetch for a counter with range(0) files.
+void BM_AssetRevalidate(benchmark::State& state) {
+  const auto count = static_cast<size_t>(state.range(0));
+  StandInServer server(respond);
+
+  asset_cache::Cache cache;
+  cache.open(write_pack(server.port(), count, 16 << 10), max_bytes);
+
+  for (auto _ : state) {
+    cache.expire();
+    cache.revalidate("127.0.0.1", server.port(), timeout_ms);
+  }
+
+  state.counters["revalidated"] = benchmark::Counter(
+      static_cast<double>(cache.stats().revalidated),
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_AssetRevalidate)->Arg(10)->Arg(40)->UseRealTime();
+
+}  // namespace
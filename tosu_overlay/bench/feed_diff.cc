@@ -0,0 +1,148 @@
+// What the feed does with every tosu message: a parse into a fresh DOM
+// (formats "object" and "msgpack") against json_diff streaming the text over
+// the last state (format "patch"). Reports the bytes a page would get either
+// way and how many fields change per message.
+//
+// Set TOSU_FEED_RECORD to a recording made through "feed_record_path" in
+// config.json to also run them on real messages.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <tosu_overlay/json_diff.h>
+#include <tosu_overlay/tosu_feed.h>
+
+#include "tosu_state_sample.h"
+
+namespace {
+
+std::vector<std::string> sample_stream() {
+  std::vector<std::string> messages;
+  for (int tick = 0; tick < 600; ++tick) {
+    messages.push_back(tosu_state_sample(tick).dump());
+  }
+  return messages;
+}
+
+size_t total_size(const std::vector<std::string>& messages) {
+  size_t size = 0;
+  for (const auto& message : messages) {
+    size += message.size();
+  }
+  return size;
+}
+
+void parse_stream(benchmark::State& state,
+                  const std::vector<std::string>& messages) {
+  for (auto _ : state) {
+    for (const auto& message : messages) {
+      benchmark::DoNotOptimize(
+          nlohmann::json::parse(message, nullptr, false));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * messages.size());
+  state.SetBytesProcessed(state.iterations() * total_size(messages));
+  state.counters["page_bytes"] = benchmark::Counter(
+      static_cast<double>(total_size(messages)) / messages.size());
+}
+
+void diff_stream(benchmark::State& state,
+                 const std::vector<std::string>& messages) {
+  size_t patch_bytes = 0;
+  size_t changes = 0;
+  size_t patches = 0;
+
+  for (auto _ : state) {
+    json_diff::Differ differ;
+    for (const auto& message : messages) {
+      const auto patch = differ.update(message);
+      benchmark::DoNotOptimize(patch);
+
+      // once, outside the timing
+      if (patches < messages.size()) {
+        state.PauseTiming();
+        patch_bytes += patch ? patch->dump().size() : 0;
+        changes += patch ? patch->at("set").size() + patch->at("remove").size()
+                         : 0;
+        ++patches;
+        state.ResumeTiming();
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * messages.size());
+  state.SetBytesProcessed(state.iterations() * total_size(messages));
+  state.counters["page_bytes"] = benchmark::Counter(
+      static_cast<double>(patch_bytes) / messages.size());
+  state.counters["changes"] =
+      benchmark::Counter(static_cast<double>(changes) / messages.size());
+}
+
+void BM_FeedParse(benchmark::State& state) {
+  static const auto messages = sample_stream();
+  parse_stream(state, messages);
+}
+BENCHMARK(BM_FeedParse)->Unit(benchmark::kMillisecond);
+
+void BM_FeedDiff(benchmark::State& state) {
+  static const auto messages = sample_stream();
+  diff_stream(state, messages);
+}
+BENCHMARK(BM_FeedDiff)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+void register_recorded_feed() {
+  const auto path = std::getenv("TOSU_FEED_RECORD");
+  if (!path) {
+    return;
+  }
+
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    std::fprintf(stderr, "Could not open feed recording %s\n", path);
+    return;
+  }
+
+  // the busiest endpoint, patches only make sense within one
+  static std::vector<std::string> messages;
+  {
+    const auto records = tosu_feed::read_records(in);
+    std::string endpoint;
+    size_t most = 0;
+    for (const auto& [name, message] : records) {
+      size_t count = 0;
+      for (const auto& other : records) {
+        count += other.first == name;
+      }
+      if (count > most) {
+        most = count;
+        endpoint = name;
+      }
+    }
+    for (const auto& [name, message] : records) {
+      if (name == endpoint) {
+        messages.push_back(message);
+      }
+    }
+  }
+
+  if (messages.empty()) {
+    return;
+  }
+
+  benchmark::RegisterBenchmark(
+      "BM_FeedRecordedParse",
+      [](benchmark::State& state) { parse_stream(state, messages); })
+      ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark(
+      "BM_FeedRecordedDiff",
+      [](benchmark::State& state) { diff_stream(state, messages); })
+      ->Unit(benchmark::kMillisecond);
+}
@@ -0,0 +1,156 @@
+// tosu's /websocket/v2 stream to several pages against a stand-in server on
+// localhost. Today every page holds its own connection and parses every
+// message (native parsing standing in for JSON.parse). With tosu_feed, one
+// connection is parsed once and the result handed to each page. Plus the
+// frame decoder on its own. POSIX only, like the stand-in server.
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tosu_overlay/tosu_feed.h>
+#include <tosu_overlay/websocket.h>
+
+#include "stand_in_websocket.h"
+#include "tosu_state_sample.h"
+
+namespace {
+
+constexpr int message_count = 200;
+constexpr int timeout_ms = 5000;
+
+std::vector<std::string> sample_messages() {
+  std::vector<std::string> messages;
+  for (int tick = 0; tick < message_count; ++tick) {
+    messages.push_back(tosu_state_sample(tick).dump());
+  }
+  return messages;
+}
+
+size_t total_size(const std::vector<std::string>& messages) {
+  size_t size = 0;
+  for (const auto& message : messages) {
+    size += message.size();
+  }
+  return size;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Each page connects and parses on its own thread, like separate renderers.
+// Returns the seconds until every page had every message.
+double receive_per_page(const std::string& port, int pages) {
+  const auto start = Clock::now();
+
+  std::vector<std::thread> threads;
+  for (int page = 0; page < pages; ++page) {
+    threads.emplace_back([&] {
+      websocket::Client client;
+      if (!client.connect("127.0.0.1", port, "/websocket/v2", timeout_ms)) {
+        return;
+      }
+      for (int received = 0; received < message_count;) {
+        const auto message = client.receive(timeout_ms);
+        if (!message) {
+          break;
+        }
+        benchmark::DoNotOptimize(
+            nlohmann::json::parse(message->payload, nullptr, false));
+        ++received;
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Not counting the feed's shutdown, which waits out a receive.
+double receive_shared(const std::string& port, int pages) {
+  const auto start = Clock::now();
+
+  std::mutex lock;
+  std::condition_variable done;
+  int delivered = 0;
+  std::vector<tosu_feed::Message> latest(static_cast<size_t>(pages));
+
+  tosu_feed::Feed feed(
+      "127.0.0.1", port, {},
+      [&](const std::string&, tosu_feed::Update update) {
+        std::lock_guard guard(lock);
+        // what the router does per page short of the process message
+        for (auto& page : latest) {
+          page = update.state;
+        }
+        if (++delivered == message_count) {
+          done.notify_one();
+        }
+      });
+  feed.subscribe("/websocket/v2", tosu_feed::Format::object);
+
+  std::unique_lock guard(lock);
+  done.wait_for(guard, std::chrono::milliseconds(timeout_ms),
+                [&] { return delivered == message_count; });
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void BM_FeedFanout(benchmark::State& state) {
+  const auto pages = static_cast<int>(state.range(0));
+  const bool shared = state.range(1) != 0;
+
+  const auto messages = sample_messages();
+  StandInWebSocket server(messages);
+
+  for (auto _ : state) {
+    state.SetIterationTime(shared ? receive_shared(server.port(), pages)
+                                  : receive_per_page(server.port(), pages));
+  }
+
+  state.SetLabel(shared ? "tosu_feed" : "socket per page");
+  state.SetItemsProcessed(state.iterations() * message_count);
+  state.counters["parses"] = benchmark::Counter(
+      static_cast<double>(shared ? message_count : message_count * pages));
+  state.counters["bytes_received"] = benchmark::Counter(static_cast<double>(
+      total_size(messages) * (shared ? 1 : static_cast<size_t>(pages))));
+}
+BENCHMARK(BM_FeedFanout)
+    ->ArgsProduct({{1, 4, 8}, {0, 1}})
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
+void BM_WebSocketDecode(benchmark::State& state) {
+  const auto messages = sample_messages();
+
+  std::string stream;
+  for (const auto& message : messages) {
+    // server frames aren't masked, strip what encode_frame adds
+    auto frame =
+        websocket::encode_frame(websocket::Opcode::text, message, 0);
+    frame[1] = static_cast<char>(frame[1] & 0x7f);
+    frame.erase(frame.size() - message.size() - 4, 4);
+    stream += frame;
+  }
+
+  for (auto _ : state) {
+    websocket::Decoder decoder;
+    decoder.feed(stream);
+    int decoded = 0;
+    while (auto message = decoder.next()) {
+      benchmark::DoNotOptimize(message->payload.data());
+      ++decoded;
+    }
+    benchmark::DoNotOptimize(decoded);
+  }
+
+  state.SetBytesProcessed(state.iterations() * stream.size());
+}
+BENCHMARK(BM_WebSocketDecode);
+
+}  // namespace
@@ -0,0 +1,140 @@
+// Unit tests for http_probe's response parsing, and the probes themselves
+// against the stand-in tosu server where there is one.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <tosu_overlay/http_probe.h>
+
+#ifndef _WIN32
+#include "stand_in_server.h"
+#endif
+
+namespace {
+
+using http_probe::parse_response;
+
+TEST(HttpProbeTest, ParsesStatusLines) {
+  EXPECT_EQ(http_probe::parse_status_line("HTTP/1.1 200 OK"), 200);
+  EXPECT_EQ(http_probe::parse_status_line("HTTP/1.0 404 Not Found"), 404);
+  EXPECT_EQ(http_probe::parse_status_line("HTTP/1.1 20"), 0);
+  EXPECT_EQ(http_probe::parse_status_line("HTTP/1.1 2x0 OK"), 0);
+  EXPECT_EQ(http_probe::parse_status_line("SSH-2.0-OpenSSH_9.6"), 0);
+}
+
+TEST(HttpProbeTest, ParsesSizedResponse) {
+  const auto response = parse_response(
+      "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\n"
+      "Content-Length: 5\r\nETag:  \"abc\" \r\n\r\nhello",
+      false);
+
+  ASSERT_TRUE(response);
+  EXPECT_EQ(response->status, 200);
+  EXPECT_EQ(response->body, "hello");
+  // names lower-cased, values trimmed
+  EXPECT_EQ(response->header("content-type"), "text/html");
+  EXPECT_EQ(response->header("etag"), "\"abc\"");
+  EXPECT_EQ(response->header("missing"), "");
+}
+
+TEST(HttpProbeTest, DecodesChunkedResponse) {
+  const auto response = parse_response(
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+      "5\r\nhello\r\n7\r\n, tosu!\r\n0\r\n\r\n",
+      false);
+
+  ASSERT_TRUE(response);
+  EXPECT_EQ(response->body, "hello, tosu!");
+}
+
+TEST(HttpProbeTest, WaitsForTruncatedResponses) {
+  // head not finished
+  EXPECT_FALSE(parse_response("HTTP/1.1 200 OK\r\nContent-Len", false));
+  EXPECT_FALSE(parse_response("HTTP/1.1 200 OK\r\nContent-Len", true));
+
+  // body shorter than its length
+  EXPECT_FALSE(parse_response(
+      "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nhello", false));
+
+  // last chunk missing
+  EXPECT_FALSE(parse_response(
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n",
+      false));
+  EXPECT_FALSE(parse_response(
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhel",
+      false));
+}
+
+TEST(HttpProbeTest, BodyWithoutLengthEndsWithTheConnection) {
+  constexpr std::string_view raw = "HTTP/1.1 200 OK\r\n\r\npartial";
+
+  EXPECT_FALSE(parse_response(raw, false));
+
+  const auto response = parse_response(raw, true);
+  ASSERT_TRUE(response);
+  EXPECT_EQ(response->body, "partial");
+}
+
+TEST(HttpProbeTest, ParsesNonOkResponses) {
+  const auto not_found = parse_response(
+      "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nnot found", false);
+  ASSERT_TRUE(not_found);
+  EXPECT_EQ(not_found->status, 404);
+  EXPECT_EQ(not_found->body, "not found");
+
+  // no body whatever the headers say
+  const auto not_modified = parse_response(
+      "HTTP/1.1 304 Not Modified\r\nContent-Length: 100\r\n\r\n", false);
+  ASSERT_TRUE(not_modified);
+  EXPECT_EQ(not_modified->status, 304);
+  EXPECT_TRUE(not_modified->body.empty());
+
+  // not HTTP at all
+  EXPECT_FALSE(parse_response("SSH-2.0-OpenSSH_9.6\r\n\r\n", true));
+}
+
+#ifndef _WIN32
+
+TEST(HttpProbeTest, ProbesTheStandInServer) {
+  StandInServer server;
+
+  const auto result =
+      http_probe::get("127.0.0.1", server.port(), "/api/ingame", 1000);
+  EXPECT_EQ(result.status, 200);
+  EXPECT_GE(result.elapsed_us, 0);
+}
+
+TEST(HttpProbeTest, FetchesFromTheStandInServer) {
+  std::string request;
+  StandInServer server([&](const std::string& received) {
+    request = received;
+    return std::string(
+        "HTTP/1.1 503 Service Unavailable\r\nTransfer-Encoding: chunked\r\n"
+        "\r\n4\r\nbusy\r\n0\r\n\r\n");
+  });
+
+  const auto response = http_probe::fetch(
+      "127.0.0.1", server.port(), "/files/beatmap/bg.jpg",
+      {{"If-None-Match", "\"abc\""}}, 1000);
+
+  EXPECT_EQ(response.status, 503);
+  EXPECT_EQ(response.body, "busy");
+  EXPECT_EQ(request.rfind("GET /files/beatmap/bg.jpg HTTP/1.1\r\n", 0), 0u);
+  EXPECT_NE(request.find("\r\nIf-None-Match: \"abc\"\r\n"), std::string::npos);
+}
+
+TEST(HttpProbeTest, UnreachableServerIsStatusZero) {
+  std::string port;
+  {
+    // a port that was just free
+    StandInServer server;
+    port = server.port();
+  }
+
+  EXPECT_EQ(http_probe::get("127.0.0.1", port, "/api/ingame", 500).status, 0);
+}
+
+#endif
+
+}  // namespace
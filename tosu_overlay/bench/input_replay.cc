@@ -0,0 +1,231 @@
+// Replays keyboard/mouse messages through the overlay's edit-mode input path
+// (modifiers::Tracker -> input::Translator -> input::Dispatcher) into a mock
+// browser host, so per-event cost and the number of CefBrowserHost calls
+// can be measured off Windows. Recorded sessions come from
+// "input_record_path" in config.json via TOSU_INPUT_RECORD.
+
+#include <benchmark/benchmark.h>
+
+#include <Windows.h>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <tosu_overlay/input_dispatcher.h>
+#include <tosu_overlay/input_record.h>
+#include <tosu_overlay/input_translator.h>
+#include <tosu_overlay/modifiers.h>
+
+#include "include/internal/cef_types.h"
+
+void register_recorded_input();
+
+namespace {
+
+// Window lookups for a 1920x1080 window at the screen origin.
+class ShimSystem : public input::System {
+ public:
+  POINT screen_to_client(POINT point) override { return point; }
+  POINT cursor_position() override { return {960, 540}; }
+  bool is_window_at(POINT) override { return true; }
+  bool is_altgr_char(WPARAM) override { return false; }
+};
+
+// Stands in for CefBrowserHost behind BrowserSink, counting the Send*Event
+// calls it would get and when (in replayed message time).
+class MockBrowserHost : public input::EventSink {
+ public:
+  enum Call {
+    send_mouse_move,
+    send_mouse_click,
+    send_mouse_wheel,
+    send_key,
+    send_touch,
+    call_count,
+  };
+
+  void send(const input::Event& event) override {
+    switch (event.type) {
+      case input::Event::Type::mouse_move:
+      case input::Event::Type::mouse_leave:
+        ++calls[send_mouse_move];
+        break;
+      case input::Event::Type::mouse_click:
+        ++calls[send_mouse_click];
+        break;
+      case input::Event::Type::mouse_wheel:
+        ++calls[send_mouse_wheel];
+        break;
+      case input::Event::Type::key:
+        ++calls[send_key];
+        break;
+      case input::Event::Type::touch:
+        ++calls[send_touch];
+        break;
+    }
+
+    call_times_us.push_back(now_us);
+  }
+
+  void reset() {
+    calls = {};
+    call_times_us.clear();
+  }
+
+  int64_t now_us = 0;
+  std::array<uint64_t, call_count> calls = {};
+  std::vector<int64_t> call_times_us;
+};
+
+struct Replayer {
+  Replayer() : translator(&system, &modifier_state), dispatcher(&host) {
+    translator.set_double_click(4, 4, 500);
+  }
+
+  // Feeds every message through the hook path, draining after each one
+  // (the UI thread keeping up) and flushing motion at 60 fps of message time.
+  void run(const std::vector<input::RawMessage>& messages) {
+    constexpr int64_t frame_us = 1'000'000 / 60;
+
+    host.reset();
+    modifier_state.release_all();
+
+    int64_t next_flush_us = 0;
+    input::Event event;
+    for (const auto& m : messages) {
+      const auto now = static_cast<int64_t>(m.time) * 1000;
+      host.now_us = now;
+
+      bool translated = false;
+      if (m.msg >= WM_KEYDOWN && m.msg <= WM_SYSCHAR) {
+        modifier_state.on_key_message(m.msg, m.wparam, m.lparam);
+        translated = translator.key(m.msg, m.wparam, m.lparam, event);
+      } else {
+        translated =
+            translator.mouse(m.msg, m.wparam, m.lparam, m.time, event);
+      }
+
+      if (translated) {
+        event.timestamp_us = now;
+        dispatcher.push(event);
+        dispatcher.drain(now);
+      }
+
+      if (now >= next_flush_us) {
+        dispatcher.flush_motion(now);
+        next_flush_us = now + frame_us;
+      }
+    }
+
+    dispatcher.flush_motion(host.now_us);
+    dispatcher.take_stats();
+  }
+
+  ShimSystem system;
+  modifiers::Tracker modifier_state;
+  input::Translator translator;
+  MockBrowserHost host;
+  input::Dispatcher dispatcher;
+};
+
+LPARAM point(int x, int y) {
+  return static_cast<LPARAM>((static_cast<uint32_t>(y & 0xFFFF) << 16) |
+                             static_cast<uint32_t>(x & 0xFFFF));
+}
+
+// A one second drag sampled at `rate` Hz.
+std::vector<input::RawMessage> drag(int rate) {
+  std::vector<input::RawMessage> messages;
+  messages.push_back({WM_LBUTTONDOWN, MK_LBUTTON, point(100, 100), 0});
+  for (int i = 0; i < rate; ++i) {
+    const auto time = static_cast<LONG>(i * 1000 / rate);
+    const auto position = point(100 + i % 1700, 100 + i % 900);
+    messages.push_back({WM_MOUSEMOVE, MK_LBUTTON, position, time});
+  }
+  messages.push_back({WM_LBUTTONUP, 0, point(800, 500), 1000});
+  return messages;
+}
+
+// Typing a 100 character sentence at 10 keys a second with Shift held for
+// the first letter of each word.
+std::vector<input::RawMessage> typing() {
+  std::vector<input::RawMessage> messages;
+  LONG time = 0;
+  for (int i = 0; i < 100; ++i, time += 100) {
+    const bool word_start = i % 6 == 0;
+    const WPARAM key = 'A' + i % 26;
+    const LPARAM scan = 0x001E0001;
+
+    if (word_start) {
+      messages.push_back({WM_KEYDOWN, VK_SHIFT, 0x002A0001, time});
+    }
+    messages.push_back({WM_KEYDOWN, key, scan, time});
+    messages.push_back(
+        {WM_CHAR, static_cast<WPARAM>(word_start ? key : key + 32), scan,
+         time});
+    messages.push_back({WM_KEYUP, key, scan | 0xC0000000, time + 40});
+    if (word_start) {
+      messages.push_back({WM_KEYUP, VK_SHIFT, 0xC02A0001, time + 50});
+    }
+  }
+  return messages;
+}
+
+void replay(benchmark::State& state,
+            const std::vector<input::RawMessage>& messages) {
+  static auto replayer = std::make_unique<Replayer>();
+
+  for (auto _ : state) {
+    replayer->run(messages);
+  }
+
+  const auto& calls = replayer->host.calls;
+  state.SetItemsProcessed(state.iterations() * messages.size());
+  state.counters["messages"] = static_cast<double>(messages.size());
+  state.counters["SendMouseMoveEvent"] =
+      static_cast<double>(calls[MockBrowserHost::send_mouse_move]);
+  state.counters["SendMouseClickEvent"] =
+      static_cast<double>(calls[MockBrowserHost::send_mouse_click]);
+  state.counters["SendMouseWheelEvent"] =
+      static_cast<double>(calls[MockBrowserHost::send_mouse_wheel]);
+  state.counters["SendKeyEvent"] =
+      static_cast<double>(calls[MockBrowserHost::send_key]);
+}
+
+// How many SendMouseMoveEvent calls a one second 8 kHz drag turns into.
+void BM_InputReplayDrag(benchmark::State& state) {
+  static const auto messages = drag(8000);
+  replay(state, messages);
+}
+BENCHMARK(BM_InputReplayDrag);
+
+void BM_InputReplayTyping(benchmark::State& state) {
+  static const auto messages = typing();
+  replay(state, messages);
+}
+BENCHMARK(BM_InputReplayTyping);
+
+}  // namespace
+
+void register_recorded_input() {
+  const auto path = std::getenv("TOSU_INPUT_RECORD");
+  if (!path) {
+    return;
+  }
+
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    std::fprintf(stderr, "Could not open input record %s\n", path);
+    return;
+  }
+
+  static const auto messages = input::read_records(in);
+
+  benchmark::RegisterBenchmark(
+      "BM_InputReplayRecorded",
+      [](benchmark::State& state) { replay(state, messages); });
+}
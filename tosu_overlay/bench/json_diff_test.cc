@@ -0,0 +1,263 @@
+// Unit tests for json_diff::Differ: applying the patches it returns to the
+// previous message has to give the new one, which is what the overlay API
+// does to the page's copy of the state.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <tosu_overlay/json_diff.h>
+
+namespace {
+
+using nlohmann::json;
+
+// What overlay_api.cc does with a patch, on nlohmann values.
+void apply(json& target, const json& patch) {
+  for (const auto& [pointer, value] : patch.at("set").items()) {
+    if (pointer.empty()) {
+      target = value;
+    } else {
+      target[json::json_pointer(pointer)] = value;
+    }
+  }
+
+  for (const auto& pointer : patch.at("remove")) {
+    const json::json_pointer removed(pointer.get<std::string>());
+    auto& parent = target[removed.parent_pointer()];
+    if (parent.is_object()) {
+      parent.erase(removed.back());
+    }
+  }
+}
+
+// Feeds value to the differ and checks that the patch takes previous to it.
+json round_trip(json_diff::Differ& differ, json& previous, const json& value) {
+  const auto patch = differ.update(value.dump());
+  EXPECT_TRUE(patch);
+  if (!patch) {
+    return json();
+  }
+
+  apply(previous, *patch);
+  EXPECT_EQ(previous, value);
+  EXPECT_EQ(differ.state(), value);
+  return *patch;
+}
+
+TEST(JsonDiffTest, FirstMessageSetsTheWholeState) {
+  json_diff::Differ differ;
+  json mirror;
+
+  const auto value = json::parse(R"({"play": {"pp": {"current": 1}}})");
+  const auto patch = round_trip(differ, mirror, value);
+
+  EXPECT_EQ(patch["set"], (json{{"", value}}));
+  EXPECT_TRUE(patch["remove"].empty());
+}
+
+TEST(JsonDiffTest, SetsOnlyChangedFields) {
+  json_diff::Differ differ;
+  json mirror;
+
+  round_trip(differ, mirror,
+             json::parse(R"({"play": {"pp": 1, "hits": {"300": 4}}, "a": 2})"));
+  const auto patch = round_trip(
+      differ, mirror,
+      json::parse(R"({"play": {"pp": 1.5, "hits": {"300": 5}}, "a": 2})"));
+
+  EXPECT_EQ(patch["set"],
+            (json{{"/play/pp", 1.5}, {"/play/hits/300", 5}}));
+  EXPECT_TRUE(patch["remove"].empty());
+
+  const auto unchanged = round_trip(
+      differ, mirror,
+      json::parse(R"({"play": {"pp": 1.5, "hits": {"300": 5}}, "a": 2})"));
+  EXPECT_TRUE(json_diff::empty(unchanged));
+}
+
+TEST(JsonDiffTest, SetsArraysWholeWhenTheirLengthChanges) {
+  json_diff::Differ differ;
+  json mirror;
+
+  round_trip(differ, mirror, json::parse(R"({"list": [1, 2, 3], "n": 0})"));
+
+  const auto grown =
+      round_trip(differ, mirror, json::parse(R"({"list": [1, 9, 3, 4]})"));
+  EXPECT_EQ(grown["set"], (json{{"/list", {1, 9, 3, 4}}}));
+
+  const auto shrunk =
+      round_trip(differ, mirror, json::parse(R"({"list": [7]})"));
+  EXPECT_EQ(shrunk["set"], (json{{"/list", {7}}}));
+
+  // same length, element by element
+  const auto same = round_trip(differ, mirror, json::parse(R"({"list": [8]})"));
+  EXPECT_EQ(same["set"], (json{{"/list/0", 8}}));
+
+  round_trip(differ, mirror, json::parse(R"({"list": []})"));
+}
+
+TEST(JsonDiffTest, RemovesKeysThatAreGone) {
+  json_diff::Differ differ;
+  json mirror;
+
+  round_trip(differ, mirror,
+             json::parse(R"({"a": 1, "tourney": {"x": 1}, "b": {"c": 2}})"));
+  const auto patch =
+      round_trip(differ, mirror, json::parse(R"({"a": 1, "b": {}})"));
+
+  EXPECT_TRUE(patch["set"].empty());
+  // inner objects close first
+  EXPECT_EQ(patch["remove"], (json{"/b/c", "/tourney"}));
+}
+
+TEST(JsonDiffTest, EscapesKeysInPointers) {
+  json_diff::Differ differ;
+  json mirror;
+
+  round_trip(differ, mirror, json::parse(R"({"a/b": 1, "c~d": 1})"));
+  const auto patch =
+      round_trip(differ, mirror, json::parse(R"({"a/b": 2})"));
+
+  EXPECT_EQ(patch["set"], (json{{"/a~1b", 2}}));
+  EXPECT_EQ(patch["remove"], (json{"/c~0d"}));
+  EXPECT_EQ(json_diff::split_pointer("/a~1b/c~0d"),
+            (std::vector<std::string>{"a/b", "c~d"}));
+}
+
+TEST(JsonDiffTest, SetsValuesWholeWhenTheirTypeChanges) {
+  json_diff::Differ differ;
+  json mirror;
+
+  round_trip(differ, mirror,
+             json::parse(R"({"a": 1, "b": {"x": 1}, "c": [1], "d": "s"})"));
+  const auto patch = round_trip(
+      differ, mirror,
+      json::parse(R"({"a": {"y": 2}, "b": [1, 2], "c": {"0": 1}, "d": null})"));
+
+  EXPECT_EQ(patch["set"], (json{{"/a", {{"y", 2}}},
+                                {"/b", {1, 2}},
+                                {"/c", {{"0", 1}}},
+                                {"/d", nullptr}}));
+  EXPECT_TRUE(patch["remove"].empty());
+
+  round_trip(differ, mirror, json::parse("[1, 2]"));
+  round_trip(differ, mirror, json::parse("3"));
+  round_trip(differ, mirror, json::parse(R"({"a": 1})"));
+}
+
+TEST(JsonDiffTest, BrokenMessageDropsTheState) {
+  json_diff::Differ differ;
+  json mirror;
+
+  round_trip(differ, mirror, json::parse(R"({"a": 1})"));
+  EXPECT_FALSE(differ.update(R"({"a": )"));
+
+  // the next message starts over with the whole state
+  const auto value = json::parse(R"({"a": 1})");
+  const auto patch = round_trip(differ, mirror, value);
+  EXPECT_EQ(patch["set"], (json{{"", value}}));
+}
+
+// Random documents with a few keys each, so consecutive ones share most of
+// their structure like tosu's messages do.
+class Generator {
+ public:
+  explicit Generator(uint32_t seed) : random_(seed) {}
+
+  json value(int depth) {
+    switch (pick(depth > 0 ? 7 : 5)) {
+      case 0:
+        return nullptr;
+      case 1:
+        return pick(2) == 1;
+      case 2:
+        return static_cast<int>(pick(200)) - 100;
+      case 3:
+        return static_cast<double>(pick(400)) / 4.0;
+      case 4:
+        return keys[pick(std::size(keys))];
+      case 5: {
+        auto array = json::array();
+        for (size_t i = pick(4); i > 0; --i) {
+          array.push_back(value(depth - 1));
+        }
+        return array;
+      }
+      default: {
+        auto object = json::object();
+        for (size_t i = pick(5); i > 0; --i) {
+          object[keys[pick(std::size(keys))]] = value(depth - 1);
+        }
+        return object;
+      }
+    }
+  }
+
+  // Changes, adds or removes one value somewhere in target.
+  void mutate(json& target, int depth) {
+    if (!target.empty() && target.is_structured() && pick(3) != 0) {
+      auto it = target.begin();
+      std::advance(it, pick(target.size()));
+      mutate(*it, depth - 1);
+      return;
+    }
+
+    switch (pick(3)) {
+      case 0:
+        if (target.is_object()) {
+          target[keys[pick(std::size(keys))]] = value(depth);
+          return;
+        }
+        if (target.is_array()) {
+          target.push_back(value(depth));
+          return;
+        }
+        break;
+      case 1:
+        if (target.is_object() && !target.empty()) {
+          target.erase(target.begin());
+          return;
+        }
+        if (target.is_array() && !target.empty()) {
+          target.erase(target.end() - 1);
+          return;
+        }
+        break;
+    }
+
+    target = value(depth);
+  }
+
+ private:
+  size_t pick(size_t count) {
+    return std::uniform_int_distribution<size_t>(0, count - 1)(random_);
+  }
+
+  static constexpr const char* keys[] = {"a", "b", "pp", "300", "a/b", "~"};
+
+  std::mt19937 random_;
+};
+
+TEST(JsonDiffTest, RandomPatchesRoundTrip) {
+  Generator generator(20240611);
+  json_diff::Differ differ;
+  json mirror;
+
+  auto value = generator.value(4);
+  for (int i = 0; i < 20'000; ++i) {
+    round_trip(differ, mirror, value);
+    if (HasFailure()) {
+      FAIL() << "after message " << i << ": " << value.dump();
+    }
+
+    generator.mutate(value, 4);
+  }
+}
+
+}  // namespace
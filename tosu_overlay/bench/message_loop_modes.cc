@@ -0,0 +1,186 @@
+// Compares how a CEF-like task stream is delivered by a blocking message loop
+// (what CefRunMessageLoop and multi_threaded_message_loop amount to: a
+// thread that sleeps until a task is posted) and by message_loop::
+// ExternalPump driving a CefDoMessageLoopWork stand-in. One second of a
+// 60 fps page: a 300 us paint task per frame and 8 small IPC tasks between
+// frames. Reports paint delivery jitter, loop thread CPU and wakeups; the
+// overlay logs the same numbers for the real loop (see README).
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/message_loop.h>
+#include <tosu_overlay/scheduling.h>
+
+namespace {
+
+constexpr int64_t frame_us = 1'000'000 / 60;
+constexpr int ipc_per_frame = 8;
+constexpr int64_t paint_cost_us = 300;
+constexpr int64_t ipc_cost_us = 30;
+
+void spin_for(int64_t us) {
+  const auto until = latency::now_us() + us;
+  while (latency::now_us() < until) {
+  }
+}
+
+struct Task {
+  bool paint;
+};
+
+// Shared by both loops: the posted tasks and what running them measured.
+class TaskQueue {
+ public:
+  void post(Task task) {
+    std::lock_guard lock(lock_);
+    tasks_.push_back(task);
+  }
+
+  // Runs everything posted so far, returns how many tasks ran.
+  size_t run_pending() {
+    std::deque<Task> tasks;
+    {
+      std::lock_guard lock(lock_);
+      tasks.swap(tasks_);
+    }
+
+    for (const auto& task : tasks) {
+      if (task.paint) {
+        spin_for(paint_cost_us);
+        jitter.record(latency::now_us());
+      } else {
+        spin_for(ipc_cost_us);
+      }
+    }
+
+    return tasks.size();
+  }
+
+  bool empty() {
+    std::lock_guard lock(lock_);
+    return tasks_.empty();
+  }
+
+  message_loop::PaintJitter jitter;
+
+ private:
+  std::mutex lock_;
+  std::deque<Task> tasks_;
+};
+
+// Posts one second of tasks at their times, calling notify after each.
+void produce(TaskQueue& queue, const std::function<void()>& notify) {
+  const auto start = latency::now_us();
+  for (int frame = 0; frame < 60; ++frame) {
+    const auto frame_start = start + frame * frame_us;
+    for (int i = 0; i < ipc_per_frame; ++i) {
+      std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+          std::chrono::microseconds(frame_start +
+                                    i * frame_us / (ipc_per_frame + 1))));
+      queue.post({i == 0});
+      notify();
+    }
+  }
+}
+
+struct LoopResult {
+  uint64_t wakeups;
+  int64_t cpu_us;
+};
+
+LoopResult run_blocking_loop(TaskQueue& queue) {
+  std::mutex lock;
+  std::condition_variable posted;
+  bool done = false;
+  uint64_t wakeups = 0;
+  std::atomic<int64_t> cpu_us = 0;
+
+  std::thread loop([&] {
+    const auto cpu_start = scheduling::thread_cpu_us();
+    std::unique_lock guard(lock);
+    while (true) {
+      posted.wait(guard, [&] { return done || !queue.empty(); });
+      if (done && queue.empty()) {
+        break;
+      }
+
+      ++wakeups;
+      guard.unlock();
+      queue.run_pending();
+      guard.lock();
+    }
+    cpu_us = scheduling::thread_cpu_us() - cpu_start;
+  });
+
+  produce(queue, [&] {
+    std::lock_guard guard(lock);
+    posted.notify_one();
+  });
+
+  {
+    std::lock_guard guard(lock);
+    done = true;
+  }
+  posted.notify_one();
+  loop.join();
+
+  return {wakeups, cpu_us};
+}
+
+LoopResult run_external_pump(TaskQueue& queue) {
+  message_loop::ExternalPump pump;
+  pump.configure(4000, 33000);
+  std::atomic<int64_t> cpu_us = 0;
+
+  std::thread loop([&] {
+    const auto cpu_start = scheduling::thread_cpu_us();
+    pump.run([&] { queue.run_pending(); });
+    cpu_us = scheduling::thread_cpu_us() - cpu_start;
+  });
+
+  // CEF asks for immediate work whenever a task is posted to the UI thread
+  produce(queue, [&] { pump.schedule(0); });
+
+  while (!queue.empty()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pump.quit();
+  loop.join();
+
+  return {pump.take_stats().wakeups, cpu_us};
+}
+
+void BM_MessageLoopModes(benchmark::State& state) {
+  const bool external = state.range(0) != 0;
+
+  LoopResult result{};
+  latency::Histogram::Summary jitter{};
+  for (auto _ : state) {
+    TaskQueue queue;
+    result = external ? run_external_pump(queue) : run_blocking_loop(queue);
+    jitter = queue.jitter.histogram().summary();
+  }
+
+  state.SetLabel(external ? "external_pump" : "dedicated/multi_threaded");
+  state.counters["wakeups"] = static_cast<double>(result.wakeups);
+  state.counters["loop_cpu_ms"] = static_cast<double>(result.cpu_us) / 1000.0;
+  state.counters["jitter_p50_us"] = static_cast<double>(jitter.p50_us);
+  state.counters["jitter_p95_us"] = static_cast<double>(jitter.p95_us);
+  state.counters["jitter_max_us"] = static_cast<double>(jitter.max_us);
+}
+BENCHMARK(BM_MessageLoopModes)
+    ->Arg(0)
+    ->Arg(1)
+    ->Iterations(1)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
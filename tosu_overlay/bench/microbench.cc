@@ -0,0 +1,887 @@
+// Micro-benchmarks for the overlay code that runs per frame or per event.
+//
+// Results are machine-readable through Google Benchmark's own flags:
+//   --benchmark_out=out.json --benchmark_out_format=json
+//
+// Set TOSU_DAMAGE_STREAM to a stream recorded through "damage_stream_path" in
+// config.json to also replay real OnPaint damage.
+
+#include <benchmark/benchmark.h>
+
+#include <Windows.h>
+
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include <tosu_overlay/alpha_mask.h>
+#include <tosu_overlay/frame.h>
+#include <tosu_overlay/frame_clock.h>
+#include <tosu_overlay/hotkeys.h>
+#include <tosu_overlay/input_dispatcher.h>
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/logger.h>
+#include <tosu_overlay/modifiers.h>
+#include <tosu_overlay/motion.h>
+#include <tosu_overlay/overlay_stats.h>
+#include <tosu_overlay/pointer.h>
+#include <tosu_overlay/region.h>
+#include <tosu_overlay/scheduling.h>
+#include <tosu_overlay/spsc_queue.h>
+
+#include "include/internal/cef_types.h"
+
+namespace {
+
+constexpr int32_t frame_width = 1920;
+constexpr int32_t frame_height = 1080;
+
+std::vector<uint8_t> make_frame(uint32_t seed) {
+  std::vector<uint8_t> data(static_cast<size_t>(frame_width) * frame_height *
+                            frame::bytes_per_pixel);
+
+  std::mt19937 rng(seed);
+  for (auto& byte : data) {
+    byte = static_cast<uint8_t>(rng());
+  }
+
+  return data;
+}
+
+// A handful of small rects, roughly what a pp/hit counter repaints per tick.
+frame::RectList counter_damage() {
+  return {
+      {64, 900, 180, 48},
+      {64, 960, 120, 32},
+      {1600, 40, 240, 64},
+      {1600, 110, 96, 24},
+  };
+}
+
+frame::RectList scattered_damage(size_t count) {
+  std::mt19937 rng(1337);
+  std::uniform_int_distribution<int32_t> x(0, frame_width - 64);
+  std::uniform_int_distribution<int32_t> y(0, frame_height - 64);
+  std::uniform_int_distribution<int32_t> size(8, 64);
+
+  frame::RectList rects;
+  for (size_t i = 0; i < count; ++i) {
+    rects.push_back({x(rng), y(rng), size(rng), size(rng)});
+  }
+
+  return rects;
+}
+
+void BM_FrameCopyFull(benchmark::State& state) {
+  const auto src = make_frame(1);
+  std::vector<uint8_t> dst(src.size());
+
+  for (auto _ : state) {
+    frame::copy_full(dst.data(), src.data(), frame_width, frame_height);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * src.size());
+}
+BENCHMARK(BM_FrameCopyFull);
+
+void BM_FrameCopyRectsCounter(benchmark::State& state) {
+  const auto src = make_frame(1);
+  std::vector<uint8_t> dst(src.size());
+  const auto rects = counter_damage();
+
+  int64_t bytes = 0;
+  for (const auto& r : rects) {
+    bytes += r.area() * frame::bytes_per_pixel;
+  }
+
+  for (auto _ : state) {
+    frame::copy_rects(dst.data(), src.data(), frame_width, frame_height,
+                      rects);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_FrameCopyRectsCounter);
+
+void BM_FrameCopyRectsFullFrame(benchmark::State& state) {
+  const auto src = make_frame(1);
+  std::vector<uint8_t> dst(src.size());
+  const frame::RectList rects = {{0, 0, frame_width, frame_height}};
+
+  for (auto _ : state) {
+    frame::copy_rects(dst.data(), src.data(), frame_width, frame_height,
+                      rects);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * src.size());
+}
+BENCHMARK(BM_FrameCopyRectsFullFrame);
+
+void BM_DirtyRegionUnion(benchmark::State& state) {
+  const auto rects = scattered_damage(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(frame::union_rects(rects));
+  }
+
+  state.SetItemsProcessed(state.iterations() * rects.size());
+}
+BENCHMARK(BM_DirtyRegionUnion)->Arg(1)->Arg(4)->Arg(32)->Arg(256);
+
+void BM_TileDiff(benchmark::State& state) {
+  const auto previous = make_frame(1);
+  auto current = previous;
+
+  // touch the counter areas so a realistic share of tiles differ
+  for (const auto& r : counter_damage()) {
+    for (int32_t y = r.y; y < r.y + r.height; ++y) {
+      current[(static_cast<size_t>(y) * frame_width + r.x) *
+              frame::bytes_per_pixel] ^= 0xFF;
+    }
+  }
+
+  std::vector<uint8_t> changed;
+  const auto tile_size = static_cast<int32_t>(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(frame::diff_tiles(previous.data(), current.data(),
+                                               frame_width, frame_height,
+                                               tile_size, changed));
+  }
+
+  state.SetBytesProcessed(state.iterations() * previous.size() * 2);
+}
+BENCHMARK(BM_TileDiff)->Arg(16)->Arg(64)->Arg(256);
+
+// Per-upload cost of keeping the edit-mode hit-test mask current.
+void BM_AlphaMaskUpdate(benchmark::State& state) {
+  const auto src = make_frame(1);
+  const auto rects = state.range(0)
+                         ? frame::RectList{{0, 0, frame_width, frame_height}}
+                         : counter_damage();
+
+  alpha_mask::resize(frame_width, frame_height);
+
+  for (auto _ : state) {
+    alpha_mask::update(src.data(), frame_width, frame_height, rects);
+  }
+}
+BENCHMARK(BM_AlphaMaskUpdate)->Arg(0)->Arg(1);
+
+// What the WndProc hook pays per mouse message.
+void BM_AlphaMaskHit(benchmark::State& state) {
+  alpha_mask::resize(frame_width, frame_height);
+
+  int32_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        alpha_mask::hit((i * 7) % frame_width, (i * 13) % frame_height));
+    ++i;
+  }
+}
+BENCHMARK(BM_AlphaMaskHit);
+
+void BM_MouseModifiers(benchmark::State& state) {
+  shim::reset_key_state();
+  shim::set_key_state(VK_MENU, static_cast<SHORT>(0x8000));
+  shim::set_key_state(VK_NUMLOCK, 1);
+
+  WPARAM wparam = MK_LBUTTON | MK_SHIFT;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(modifiers::GetCefMouseModifiers(wparam));
+    benchmark::DoNotOptimize(wparam);
+  }
+}
+BENCHMARK(BM_MouseModifiers);
+
+void BM_KeyboardModifiers(benchmark::State& state) {
+  shim::reset_key_state();
+  shim::set_key_state(VK_SHIFT, static_cast<SHORT>(0x8000));
+  shim::set_key_state(VK_LSHIFT, static_cast<SHORT>(0x8000));
+  shim::set_key_state(VK_CAPITAL, 1);
+
+  const WPARAM keys[] = {'A', VK_SHIFT, VK_RETURN, VK_NUMPAD5, VK_LEFT};
+  const LPARAM lparam = 0x001E0001;
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        modifiers::GetCefKeyboardModifiers(keys[i++ % 5], lparam));
+  }
+}
+BENCHMARK(BM_KeyboardModifiers);
+
+// Same translations as above, from the state the hooks track themselves.
+void BM_TrackerMouseModifiers(benchmark::State& state) {
+  modifiers::Tracker tracker;
+  tracker.on_key_message(WM_SYSKEYDOWN, VK_MENU, 0x20380001);
+
+  WPARAM wparam = MK_LBUTTON | MK_SHIFT;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tracker.mouse(wparam));
+    benchmark::DoNotOptimize(wparam);
+  }
+}
+BENCHMARK(BM_TrackerMouseModifiers);
+
+void BM_TrackerKeyboardModifiers(benchmark::State& state) {
+  modifiers::Tracker tracker;
+  tracker.on_key_message(WM_KEYDOWN, VK_SHIFT, 0x002A0001);
+  tracker.on_key_message(WM_KEYDOWN, VK_CAPITAL, 0x003A0001);
+
+  const WPARAM keys[] = {'A', VK_SHIFT, VK_RETURN, VK_NUMPAD5, VK_LEFT};
+  const LPARAM lparam = 0x001E0001;
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tracker.keyboard(keys[i++ % 5], lparam));
+  }
+}
+BENCHMARK(BM_TrackerKeyboardModifiers);
+
+// Cost the hooks pay per keyboard message to watch for hotkey chords.
+void BM_HotkeyKeyMessage(benchmark::State& state) {
+  modifiers::Tracker tracker;
+  hotkeys::Bindings bindings(&tracker);
+  bindings.bind(hotkeys::Action::toggle_edit_mode,
+                *hotkeys::parse_chord("LCtrl+LShift+Space"));
+  bindings.bind(hotkeys::Action::reload, *hotkeys::parse_chord("Ctrl+F5"));
+
+  struct Message {
+    UINT msg;
+    WPARAM wparam;
+    LPARAM lparam;
+  };
+
+  const Message messages[] = {
+      {WM_KEYDOWN, VK_CONTROL, 0x001D0001}, {WM_KEYDOWN, VK_SHIFT, 0x002A0001},
+      {WM_KEYDOWN, VK_SPACE, 0x00390001},   {WM_KEYUP, VK_SPACE, 0xC0390001},
+      {WM_KEYUP, VK_SHIFT, 0xC02A0001},     {WM_KEYUP, VK_CONTROL, 0xC01D0001},
+      {WM_KEYDOWN, 'Z', 0x002C0001},        {WM_KEYUP, 'Z', 0xC02C0001},
+  };
+
+  size_t triggered = 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    const auto& m = messages[i++ % std::size(messages)];
+    tracker.on_key_message(m.msg, m.wparam, m.lparam);
+    if (bindings.on_key_message(m.msg, m.wparam, m.lparam)) {
+      ++triggered;
+    }
+  }
+
+  benchmark::DoNotOptimize(triggered);
+}
+BENCHMARK(BM_HotkeyKeyMessage);
+
+// One second of an 8 kHz mouse drag with a wheel tick every 10 ms, flushed
+// at 60 fps. Reports how many events would reach CEF.
+void BM_MotionCoalesce(benchmark::State& state) {
+  constexpr int rate = 8000;
+  constexpr int flush_every = rate / 60;
+
+  motion::Stats stats;
+  for (auto _ : state) {
+    motion::Coalescer coalescer;
+    int sent = 0;
+
+    for (int i = 0; i < rate; ++i) {
+      coalescer.move(
+          {i % 1920, (i / 4) % 1080, EVENTFLAG_LEFT_MOUSE_BUTTON});
+      if (i % 80 == 0) {
+        coalescer.wheel({i % 1920, (i / 4) % 1080, 0, 0, 120});
+      }
+
+      if (i % flush_every == 0) {
+        coalescer.flush([&](const motion::Move&) { ++sent; },
+                        [&](const motion::Wheel&) { ++sent; });
+      }
+    }
+
+    benchmark::DoNotOptimize(sent);
+    stats = coalescer.stats();
+  }
+
+  state.SetItemsProcessed(state.iterations() * rate);
+  state.counters["moves_out"] = static_cast<double>(stats.moves_out);
+  state.counters["wheels_out"] = static_cast<double>(stats.wheels_out);
+}
+BENCHMARK(BM_MotionCoalesce);
+
+// Round trip through the hook -> UI thread queue, both ends on one thread.
+void BM_SpscPushPop(benchmark::State& state) {
+  static SpscQueue<input::Event, input::Dispatcher::capacity> queue;
+
+  input::Event event{};
+  input::Event out;
+  for (auto _ : state) {
+    queue.push(event);
+    benchmark::DoNotOptimize(queue.pop(out));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpscPushPop);
+
+// Same as above with the consumer on its own thread, as in the overlay.
+void BM_SpscCrossThread(benchmark::State& state) {
+  static SpscQueue<input::Event, input::Dispatcher::capacity> queue;
+  constexpr int batch = 1024;
+
+  for (auto _ : state) {
+    std::thread consumer([] {
+      input::Event out;
+      for (int received = 0; received < batch;) {
+        if (queue.pop(out)) {
+          ++received;
+        }
+      }
+    });
+
+    input::Event event{};
+    for (int i = 0; i < batch;) {
+      if (queue.push(event)) {
+        ++i;
+      }
+    }
+
+    consumer.join();
+  }
+
+  state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_SpscCrossThread)->UseRealTime();
+
+struct CountingSink : input::EventSink {
+  void send(const input::Event&) override { ++sent; }
+
+  size_t sent = 0;
+};
+
+// One 60 fps frame worth of 8 kHz mouse input plus a click, pushed by the
+// hook, drained in one batch and flushed. Reports how many events reach the
+// sink and the deepest the queue got.
+void BM_DispatcherFrame(benchmark::State& state) {
+  constexpr int moves = 8000 / 60;
+
+  static CountingSink sink;
+  static input::Dispatcher dispatcher(&sink);
+
+  input::DispatchStats stats;
+  int64_t now = 0;
+  for (auto _ : state) {
+    sink.sent = 0;
+
+    for (int i = 0; i < moves; ++i) {
+      input::Event event{};
+      event.type = input::Event::Type::mouse_move;
+      event.x = i;
+      event.y = i / 2;
+      event.timestamp_us = now++;
+      dispatcher.push(event);
+    }
+
+    input::Event click{};
+    click.type = input::Event::Type::mouse_click;
+    click.click_count = 1;
+    click.timestamp_us = now;
+    dispatcher.push(click);
+
+    dispatcher.drain(now);
+    dispatcher.flush_motion(now);
+
+    stats = dispatcher.take_stats();
+  }
+
+  state.SetItemsProcessed(state.iterations() * (moves + 1));
+  state.counters["sent"] = static_cast<double>(sink.sent);
+  state.counters["max_depth"] = static_cast<double>(stats.max_depth);
+}
+BENCHMARK(BM_DispatcherFrame);
+
+// Per-sample cost of the latency histograms, run on every probe stage.
+void BM_LatencyHistogramRecord(benchmark::State& state) {
+  static latency::Histogram histogram;
+
+  std::mt19937 rng(7);
+  std::lognormal_distribution<double> frame_times(std::log(8000.0), 0.6);
+  std::vector<int64_t> samples(4096);
+  for (auto& sample : samples) {
+    sample = static_cast<int64_t>(frame_times(rng));
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    histogram.record(samples[i++ % samples.size()]);
+  }
+
+  const auto summary = histogram.summary();
+  state.counters["p50_us"] = static_cast<double>(summary.p50_us);
+  state.counters["p99_us"] = static_cast<double>(summary.p99_us);
+  histogram.reset();
+}
+BENCHMARK(BM_LatencyHistogramRecord);
+
+// What the SwapBuffers hook pays to feed tosuOverlay.frameClock().
+void BM_FrameClockPresent(benchmark::State& state) {
+  int64_t us = 0;
+  for (auto _ : state) {
+    frame_clock::presented(us += 4167);
+  }
+  frame_clock::take(us);
+}
+BENCHMARK(BM_FrameClockPresent);
+
+// One overlay frame's update at 60 fps while the game presents at 240 fps
+// with jitter. Reports the estimated fps and how far off the predicted
+// next present was.
+void BM_FrameClockUpdate(benchmark::State& state) {
+  constexpr int64_t interval_us = 4167;
+  constexpr int64_t overlay_frame_us = 16667;
+
+  std::mt19937 rng(7);
+  std::normal_distribution<double> jitter(0.0, 300.0);
+
+  frame_clock::Estimator estimator;
+  int64_t present_us = 1'000'000;
+  int64_t now_us = present_us;
+  double fps = 0.0;
+  int64_t error_us = 0;
+  int64_t predictions = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    const auto predicted = estimator.snapshot(now_us).next_present_us;
+    now_us += overlay_frame_us;
+    std::vector<int64_t> presents;
+    while (present_us + interval_us <= now_us) {
+      present_us += interval_us;
+      presents.push_back(present_us + static_cast<int64_t>(jitter(rng)));
+    }
+    if (predicted != 0 && !presents.empty()) {
+      // the first present after the prediction was made
+      error_us += std::abs(presents.front() - predicted);
+      ++predictions;
+    }
+    state.ResumeTiming();
+
+    for (const auto present : presents) {
+      estimator.add(present);
+    }
+    const auto snapshot = estimator.snapshot(now_us);
+    benchmark::DoNotOptimize(snapshot);
+    fps = snapshot.fps;
+  }
+
+  state.counters["fps"] = fps;
+  state.counters["next_error_us"] =
+      predictions ? static_cast<double>(error_us) / predictions : 0.0;
+}
+BENCHMARK(BM_FrameClockUpdate);
+
+// What the SwapBuffers hook and the texture upload pay per game frame for
+// tosuOverlay.stats().
+void BM_OverlayStatsHooked(benchmark::State& state) {
+  int64_t us = 0;
+  for (auto _ : state) {
+    overlay_stats::hooked(us++ % 400);
+    overlay_stats::uploaded(64 * 1024);
+  }
+}
+BENCHMARK(BM_OverlayStatsHooked);
+
+// One second of a 240 fps game and a 60 fps page turned into a stats update.
+// Reports the hook percentiles and dropped frames it found.
+void BM_OverlayStatsTake(benchmark::State& state) {
+  std::mt19937 rng(7);
+  std::lognormal_distribution<double> hook_us(4.0, 0.5);
+
+  overlay_stats::Sampler sampler;
+  int64_t now_us = latency::now_us();
+  overlay_stats::Window window{};
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int frame = 0; frame < 240; ++frame) {
+      if (frame % 4 == 0) {
+        overlay_stats::painted(300 * 120);
+      }
+      // every sixth paint lands twice before the next upload
+      if (frame % 24 == 1) {
+        overlay_stats::painted(300 * 120);
+      }
+      if (frame % 4 == 2) {
+        overlay_stats::uploaded(300 * 120 * 4);
+      }
+      overlay_stats::hooked(static_cast<int64_t>(hook_us(rng)));
+    }
+    now_us += 1'000'000;
+    state.ResumeTiming();
+
+    window = sampler.take(now_us);
+    benchmark::DoNotOptimize(window);
+  }
+
+  state.counters["paint_rate"] = window.paint_rate;
+  state.counters["hook_p50_us"] = static_cast<double>(window.hook_p50_us);
+  state.counters["hook_p99_us"] = static_cast<double>(window.hook_p99_us);
+  state.counters["dropped"] = static_cast<double>(window.dropped_frames);
+}
+BENCHMARK(BM_OverlayStatsTake);
+
+// Stands in for GetPointerPenInfoHistory: a pen stroke where every message
+// carries `batch` frames, newest first.
+class StrokeSource : public pointer::Source {
+ public:
+  explicit StrokeSource(size_t batch) : batch_(batch) {}
+
+  size_t read(uint32_t pointer_id, pointer::Sample* out, size_t max) override {
+    const auto count = std::min(batch_, max);
+    for (size_t i = 0; i < count; ++i) {
+      const auto frame = frame_ + count - 1 - i;
+
+      auto& sample = out[i];
+      sample = {};
+      sample.id = pointer_id;
+      sample.kind = pointer::Kind::pen;
+      sample.flags = pointer::in_range | pointer::in_contact;
+      if (frame == 0) {
+        sample.flags |= pointer::down;
+      }
+      sample.x = static_cast<int32_t>(frame % 1920);
+      sample.y = static_cast<int32_t>((frame / 2) % 1080);
+      sample.pressure = 0.5f;
+    }
+
+    frame_ += count;
+    return count;
+  }
+
+ private:
+  size_t batch_;
+  uint64_t frame_ = 0;
+};
+
+// One second of a 1 kHz pen stroke arriving `batch` frames per message,
+// translated, dispatched and flushed at 60 fps. Reports how many events
+// reach the sink.
+void BM_PenStroke(benchmark::State& state) {
+  constexpr int rate = 1000;
+  const auto batch = static_cast<size_t>(state.range(0));
+
+  static CountingSink sink;
+  static input::Dispatcher dispatcher(&sink);
+  pointer::Translator translator;
+
+  size_t sent = 0;
+  for (auto _ : state) {
+    StrokeSource source(batch);
+    sink.sent = 0;
+
+    int64_t now = 0;
+    int64_t next_flush = 0;
+    for (int frame = 0; frame < rate; frame += static_cast<int>(batch)) {
+      translator.translate(source, 1, 1.0f, 0,
+                           [&](const input::Event& event) {
+                             auto queued = event;
+                             queued.timestamp_us = now;
+                             dispatcher.push(queued);
+                           });
+
+      now += static_cast<int64_t>(batch) * 1000;
+      dispatcher.drain(now);
+      if (now >= next_flush) {
+        dispatcher.flush_motion(now);
+        next_flush = now + 16666;
+      }
+    }
+
+    dispatcher.flush_motion(now);
+    sent = sink.sent;
+  }
+
+  state.SetItemsProcessed(state.iterations() * rate);
+  state.counters["sent"] = static_cast<double>(sent);
+}
+BENCHMARK(BM_PenStroke)->Arg(1)->Arg(8);
+
+void BM_LoggerFormat(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(logger::_format(
+        "Input parameters: %x %x %x", 0x1234, 0x5678, 0x9abc));
+  }
+}
+BENCHMARK(BM_LoggerFormat);
+
+void BM_LoggerFormatString(benchmark::State& state) {
+  const std::string path = "C:\\Users\\player\\AppData\\Local\\osu!\\tosu";
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        logger::_format("Config file located at %s", path.c_str()));
+  }
+}
+BENCHMARK(BM_LoggerFormatString);
+
+// Shaped like the default config.json, built in memory so the benchmark never
+// reads or writes a config file.
+const nlohmann::json& bench_config() {
+  static const nlohmann::json config = {
+      {"cef_debugging_enabled", false},
+      {"cef_fps", 60},
+      {"edit_mode_passthrough", true},
+      {"pointer_input", true},
+      {"switches",
+       {{"profile", "default"},
+        {"add", nlohmann::json::object()},
+        {"remove", nlohmann::json::array()}}},
+      {"memory",
+       {{"js_heap_mb", 0},
+        {"disk_cache_mb", 0},
+        {"sample_seconds", 60},
+        {"growth_warning_mb", 128},
+        {"recycle_mb", 0}}},
+      {"message_loop",
+       {{"mode", "dedicated"}, {"slice_budget_ms", 4}, {"max_delay_ms", 33}}},
+      {"tosu_feed",
+       {{"enabled", true},
+        {"reconnect_ms", 1000},
+        {"shared_memory", false},
+        {"poll_ms", 2}}},
+  };
+
+  return config;
+}
+
+// What OnContextInitialized / OnBeforeCommandLineProcessing do today: copy
+// the whole document, then look keys up through operator[].
+void BM_ConfigCopyAccess(benchmark::State& state) {
+  const auto& config = bench_config();
+
+  for (auto _ : state) {
+    auto json_data = config;
+    benchmark::DoNotOptimize(static_cast<uint32_t>(json_data["cef_fps"]));
+    benchmark::DoNotOptimize(
+        static_cast<bool>(json_data["cef_debugging_enabled"]));
+  }
+}
+BENCHMARK(BM_ConfigCopyAccess);
+
+void BM_ConfigRefAccess(benchmark::State& state) {
+  const auto& config = bench_config();
+
+  for (auto _ : state) {
+    const auto& json_data = config;
+    benchmark::DoNotOptimize(json_data.value("cef_fps", 60u));
+    benchmark::DoNotOptimize(json_data.value("cef_debugging_enabled", false));
+  }
+}
+BENCHMARK(BM_ConfigRefAccess);
+
+void BM_RegionCoalesce(benchmark::State& state) {
+  const auto rects = scattered_damage(static_cast<size_t>(state.range(0)));
+
+  for (auto _ : state) {
+    region::Region damage;
+    damage.add(rects);
+    benchmark::DoNotOptimize(damage.upload_rects(8, 0.6f));
+  }
+
+  state.SetItemsProcessed(state.iterations() * rects.size());
+}
+BENCHMARK(BM_RegionCoalesce)->Arg(4)->Arg(32)->Arg(256);
+
+// A "game" thread pinned to core 0 doing fixed work while one busy thread
+// per core stands in for CEF. Arg 1 applies the default scheduling policy
+// to them with core 0 avoided, Arg 0 leaves them alone.
+void BM_GameThreadUnderCefLoad(benchmark::State& state) {
+  const auto cores = scheduling::core_count();
+  const auto policy = scheduling::parse_policy(
+      {{"avoid_cores", {0}}, {"background_thread_priority", "idle"}}, cores);
+  const bool apply = state.range(0) != 0;
+
+  std::atomic<bool> running = true;
+  std::vector<std::thread> competitors;
+  for (unsigned i = 0; i < cores; ++i) {
+    competitors.emplace_back([&] {
+      if (apply) {
+        scheduling::apply_to_thread(policy.background_thread_priority,
+                                    policy.affinity);
+      }
+
+      uint64_t x = 0;
+      while (running.load(std::memory_order_relaxed)) {
+        benchmark::DoNotOptimize(x += 1);
+      }
+    });
+  }
+
+  const auto previous = scheduling::thread_affinity();
+  scheduling::set_thread_affinity(1);
+
+  for (auto _ : state) {
+    uint64_t x = 0;
+    for (int i = 0; i < 100'000; ++i) {
+      benchmark::DoNotOptimize(x += i);
+    }
+  }
+
+  running = false;
+  for (auto& thread : competitors) {
+    thread.join();
+  }
+
+  if (previous != 0) {
+    scheduling::set_thread_affinity(previous);
+  }
+
+  // avoiding core 0 leaves nothing on a single core machine, affinity stays
+  state.counters["cef_cores"] =
+      static_cast<double>(apply && policy.affinity != 0
+                              ? std::popcount(policy.affinity)
+                              : static_cast<int>(cores));
+}
+BENCHMARK(BM_GameThreadUnderCefLoad)->Arg(0)->Arg(1)->UseRealTime();
+
+// Synthetic streams shaped like what counters produce.
+std::vector<frame::RectList> counter_stream() {
+  std::vector<frame::RectList> frames;
+  for (int32_t i = 0; i < 600; ++i) {
+    auto damage = counter_damage();
+    // digits change width as numbers grow
+    damage[0].width = 120 + (i % 7) * 10;
+    if (i % 3 != 0) {
+      damage.pop_back();
+    }
+    frames.push_back(damage);
+  }
+
+  return frames;
+}
+
+std::vector<frame::RectList> graph_stream() {
+  std::vector<frame::RectList> frames;
+  for (int32_t i = 0; i < 600; ++i) {
+    frames.push_back({{200 + (i % 1400), 980, 4, 80}, {64, 900, 180, 48}});
+  }
+
+  return frames;
+}
+
+std::vector<frame::RectList> animated_stream() {
+  std::vector<frame::RectList> frames;
+  for (int32_t i = 0; i < 600; ++i) {
+    if (i % 30 == 0) {
+      frames.push_back({{0, 0, frame_width, frame_height}});
+    } else {
+      frames.push_back(scattered_damage(12));
+    }
+  }
+
+  return frames;
+}
+
+// Replays |frames| with |paints_per_swap| OnPaint calls between two game
+// swaps, the way canvas consumes them.
+void replay_damage(benchmark::State& state,
+                   const std::vector<frame::RectList>& frames) {
+  const auto paints_per_swap = static_cast<size_t>(state.range(0));
+
+  int64_t uploaded = 0;
+  int64_t swaps = 0;
+
+  for (auto _ : state) {
+    region::DamageHistory history(1, 8);
+    history.reset({0, 0, frame_width, frame_height});
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+      history.push(frames[i]);
+
+      if ((i + 1) % paints_per_swap == 0) {
+        for (const auto& r : history.collect(0).upload_rects(8, 0.6f)) {
+          uploaded += r.area();
+        }
+        ++swaps;
+      }
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * frames.size());
+  state.counters["upload_px_per_swap"] =
+      static_cast<double>(uploaded) / std::max<int64_t>(swaps, 1);
+}
+
+void BM_DamageCounterStream(benchmark::State& state) {
+  static const auto frames = counter_stream();
+  replay_damage(state, frames);
+}
+BENCHMARK(BM_DamageCounterStream)->Arg(1)->Arg(2)->Arg(4);
+
+void BM_DamageGraphStream(benchmark::State& state) {
+  static const auto frames = graph_stream();
+  replay_damage(state, frames);
+}
+BENCHMARK(BM_DamageGraphStream)->Arg(1)->Arg(2)->Arg(4);
+
+void BM_DamageAnimatedStream(benchmark::State& state) {
+  static const auto frames = animated_stream();
+  replay_damage(state, frames);
+}
+BENCHMARK(BM_DamageAnimatedStream)->Arg(1)->Arg(2)->Arg(4);
+
+void register_recorded_stream() {
+  const auto path = std::getenv("TOSU_DAMAGE_STREAM");
+  if (!path) {
+    return;
+  }
+
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    std::fprintf(stderr, "Could not open damage stream %s\n", path);
+    return;
+  }
+
+  static const auto frames = region::read_stream(in);
+
+  benchmark::RegisterBenchmark("BM_DamageRecordedStream",
+                               [](benchmark::State& state) {
+                                 replay_damage(state, frames);
+                               })
+      ->Arg(1)
+      ->Arg(2)
+      ->Arg(4);
+}
+
+}  // namespace
+
+// bench/input_replay.cc
+void register_recorded_input();
+
+// bench/feed_diff.cc
+void register_recorded_feed();
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  register_recorded_stream();
+  register_recorded_input();
+  register_recorded_feed();
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  return 0;
+}
@@ -0,0 +1,155 @@
+// Summarizes a Chromium trace recorded with "raster_trace_path" (see README)
+// into raster time per frame and CPU use, for comparing raster settings on
+// the same overlay page:
+//
+//   tosu_raster_report trace.json
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+// cc worker-thread raster tasks, the name changed over Chromium versions.
+const char* const raster_events[] = {
+    "RasterizerTaskImpl::RunOnWorkerThread",
+    "RasterTaskImpl::RunOnWorkerThread",
+};
+
+// One per frame the renderer's compositor draws.
+constexpr char frame_event[] = "LayerTreeHostImpl::DrawLayers";
+
+// Top-level task runs, their thread time adds up to a process's CPU time.
+constexpr char toplevel_category[] = "toplevel";
+
+struct Event {
+  int64_t ts;
+  int64_t dur;
+  // thread (CPU) time, falls back to wall time when not recorded
+  int64_t tdur;
+};
+
+bool is_raster_event(const std::string& name) {
+  return std::any_of(std::begin(raster_events), std::end(raster_events),
+                     [&](const char* raster) { return name == raster; });
+}
+
+int64_t percentile(std::vector<int64_t> values, double fraction) {
+  if (values.empty()) {
+    return 0;
+  }
+
+  // nearest rank
+  std::sort(values.begin(), values.end());
+  const auto rank = static_cast<size_t>(std::ceil(fraction * values.size()));
+  return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <trace.json>\n", argv[0]);
+    return 1;
+  }
+
+  std::ifstream in(argv[1]);
+  if (!in.is_open()) {
+    std::fprintf(stderr, "Could not open %s\n", argv[1]);
+    return 1;
+  }
+
+  const auto trace = nlohmann::json::parse(in, nullptr, false);
+  if (trace.is_discarded()) {
+    std::fprintf(stderr, "%s is not valid JSON\n", argv[1]);
+    return 1;
+  }
+
+  const auto events = trace.is_object()
+                          ? trace.value("traceEvents", nlohmann::json::array())
+                          : trace;
+
+  std::vector<Event> rasters;
+  std::vector<int64_t> frames;
+  std::map<int64_t, int64_t> cpu_by_pid;
+  int64_t first_ts = INT64_MAX;
+  int64_t last_ts = 0;
+
+  for (const auto& event : events) {
+    if (event.value("ph", std::string()) != "X") {
+      continue;
+    }
+
+    const auto name = event.value("name", std::string());
+    const auto category = event.value("cat", std::string());
+    const auto ts = event.value("ts", int64_t{0});
+    const auto dur = event.value("dur", int64_t{0});
+    const auto tdur = event.value("tdur", dur);
+
+    first_ts = std::min(first_ts, ts);
+    last_ts = std::max(last_ts, ts + dur);
+
+    if (is_raster_event(name)) {
+      rasters.push_back({ts, dur, tdur});
+    } else if (name == frame_event) {
+      frames.push_back(ts + dur);
+    }
+
+    if (category == toplevel_category) {
+      cpu_by_pid[event.value("pid", int64_t{0})] += tdur;
+    }
+  }
+
+  if (frames.empty()) {
+    std::fprintf(stderr, "No %s events, was the trace recorded with cc?\n",
+                 frame_event);
+    return 1;
+  }
+
+  std::sort(frames.begin(), frames.end());
+
+  // raster work is charged to the first frame drawn after it finished
+  std::vector<int64_t> raster_per_frame(frames.size(), 0);
+  int64_t raster_cpu = 0;
+  for (const auto& raster : rasters) {
+    raster_cpu += raster.tdur;
+
+    const auto frame =
+        std::lower_bound(frames.begin(), frames.end(), raster.ts + raster.dur);
+    if (frame != frames.end()) {
+      raster_per_frame[frame - frames.begin()] += raster.dur;
+    }
+  }
+
+  const auto wall = std::max<int64_t>(last_ts - first_ts, 1);
+  const auto seconds = static_cast<double>(wall) / 1e6;
+
+  int64_t raster_total = 0;
+  for (const auto value : raster_per_frame) {
+    raster_total += value;
+  }
+
+  std::printf("trace: %.1f s, %zu frames (%.1f fps), %zu raster tasks\n",
+              seconds, frames.size(), frames.size() / seconds, rasters.size());
+  std::printf(
+      "raster per frame: mean %.2f ms, p50 %.2f ms, p95 %.2f ms, max %.2f ms\n",
+      raster_total / 1000.0 / frames.size(),
+      percentile(raster_per_frame, 0.5) / 1000.0,
+      percentile(raster_per_frame, 0.95) / 1000.0,
+      percentile(raster_per_frame, 1.0) / 1000.0);
+  std::printf("raster CPU: %.1f%% of one core\n", 100.0 * raster_cpu / wall);
+
+  for (const auto& [pid, cpu] : cpu_by_pid) {
+    std::printf("process %lld CPU: %.1f%% of one core\n",
+                static_cast<long long>(pid), 100.0 * cpu / wall);
+  }
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+// Unit tests for region::Region and region::DamageHistory, the damage
+// tracking that decides what reaches the GPU each frame.
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include <tosu_overlay/frame.h>
+#include <tosu_overlay/region.h>
+
+namespace frame {
+
+bool operator==(const Rect& a, const Rect& b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width &&
+         a.height == b.height;
+}
+
+void PrintTo(const Rect& rect, std::ostream* out) {
+  *out << '{' << rect.x << ',' << rect.y << ',' << rect.width << ','
+       << rect.height << '}';
+}
+
+}  // namespace frame
+
+namespace {
+
+using frame::Rect;
+using frame::RectList;
+using region::DamageHistory;
+using region::Region;
+
+constexpr Rect view{0, 0, 100, 50};
+
+TEST(RegionTest, CoalescesTouchingRects) {
+  Region region;
+  region.add(Rect{0, 0, 10, 10});
+  region.add(Rect{10, 0, 10, 10});
+
+  EXPECT_EQ(region.rects(), (RectList{{0, 0, 20, 10}}));
+}
+
+TEST(RegionTest, DropsContainedAndEmptyRects) {
+  Region region;
+  region.add(Rect{0, 0, 20, 20});
+  region.add(Rect{5, 5, 5, 5});
+  region.add(Rect{30, 30, 0, 10});
+
+  EXPECT_EQ(region.rects(), (RectList{{0, 0, 20, 20}}));
+}
+
+TEST(RegionTest, MergesUpToAQuarterWaste) {
+  // bounding box 200 px, 50 of them not damaged: exactly 25%
+  Region merged;
+  merged.add(Rect{0, 0, 10, 10});
+  merged.add(Rect{10, 0, 10, 5});
+  EXPECT_EQ(merged.rects(), (RectList{{0, 0, 20, 10}}));
+
+  // 60 of 200 px wasted, 30%
+  Region kept;
+  kept.add(Rect{0, 0, 10, 10});
+  kept.add(Rect{10, 0, 10, 4});
+  EXPECT_EQ(kept.rects(), (RectList{{0, 0, 10, 10}, {10, 0, 10, 4}}));
+  EXPECT_EQ(kept.area(), 140);
+}
+
+TEST(RegionTest, MergeFoldsInRectsItNowOverlaps) {
+  Region region;
+  region.add(Rect{0, 0, 10, 10});
+  region.add(Rect{20, 0, 10, 10});
+  // bridges the two, after merging with one it overlaps the other
+  region.add(Rect{8, 0, 14, 10});
+
+  EXPECT_EQ(region.rects(), (RectList{{0, 0, 30, 10}}));
+}
+
+TEST(RegionTest, CollapsesToBoundsPastMaxRects) {
+  // 1x1 rects 10 px apart never merge on their own
+  Region region;
+  for (int32_t i = 0; i < static_cast<int32_t>(Region::max_rects); ++i) {
+    region.add(Rect{i * 10, 0, 1, 1});
+  }
+  EXPECT_EQ(region.rects().size(), Region::max_rects);
+
+  region.add(Rect{0, 40, 1, 1});
+  EXPECT_EQ(region.rects(), (RectList{{0, 0, 151, 41}}));
+}
+
+TEST(RegionTest, UploadsBoundsWhenFragmentedOrCovered) {
+  Region sparse;
+  sparse.add(Rect{0, 0, 1, 1});
+  sparse.add(Rect{50, 0, 1, 1});
+  sparse.add(Rect{90, 0, 1, 1});
+
+  EXPECT_EQ(sparse.upload_rects(8, 0.6f), sparse.rects());
+  EXPECT_EQ(sparse.upload_rects(2, 0.6f), (RectList{{0, 0, 91, 1}}));
+
+  Region dense;
+  dense.add(Rect{0, 0, 10, 10});
+  dense.add(Rect{10, 0, 10, 4});
+  // 140 of 200 px
+  EXPECT_EQ(dense.upload_rects(8, 0.6f), (RectList{{0, 0, 20, 10}}));
+  EXPECT_EQ(dense.upload_rects(8, 0.8f), dense.rects());
+}
+
+TEST(RegionTest, ClipsToTheFrame) {
+  EXPECT_EQ(frame::clip({-5, -5, 20, 20}, 10, 10), (Rect{0, 0, 10, 10}));
+  EXPECT_EQ(frame::clip({95, 45, 10, 10}, 100, 50), (Rect{95, 45, 5, 5}));
+  EXPECT_TRUE(frame::clip({100, 0, 10, 10}, 100, 50).empty());
+  EXPECT_TRUE(frame::clip({-20, 0, 10, 10}, 100, 50).empty());
+}
+
+TEST(DamageHistoryTest, NeverWrittenSlotGetsFullBounds) {
+  DamageHistory history(2, 4);
+  history.reset(view);
+  history.push({{1, 1, 2, 2}});
+
+  EXPECT_TRUE(history.pending(0));
+  EXPECT_EQ(history.collect(0).rects(), (RectList{view}));
+  EXPECT_FALSE(history.pending(0));
+
+  // the other slot is still behind from the start
+  EXPECT_EQ(history.collect(1).rects(), (RectList{view}));
+}
+
+TEST(DamageHistoryTest, CurrentSlotGetsOnlyNewDamage) {
+  DamageHistory history(2, 4);
+  history.reset(view);
+  history.collect(0);
+
+  history.push({{1, 1, 2, 2}});
+  history.push({{40, 20, 5, 5}});
+
+  EXPECT_EQ(history.age(0), 2u);
+  EXPECT_EQ(history.collect(0).rects(),
+            (RectList{{1, 1, 2, 2}, {40, 20, 5, 5}}));
+  EXPECT_TRUE(history.collect(0).empty());
+}
+
+TEST(DamageHistoryTest, SlotOlderThanDepthGetsFullBounds) {
+  DamageHistory history(2, 3);
+  history.reset(view);
+  history.collect(0);
+  history.collect(1);
+
+  for (int32_t i = 0; i < 3; ++i) {
+    history.push({{i * 20, 0, 2, 2}});
+  }
+  // still within the remembered frames
+  EXPECT_EQ(history.collect(0).rects(),
+            (RectList{{0, 0, 2, 2}, {20, 0, 2, 2}, {40, 0, 2, 2}}));
+
+  history.push({{60, 0, 2, 2}});
+  EXPECT_EQ(history.age(1), 4u);
+  EXPECT_EQ(history.collect(1).rects(), (RectList{view}));
+}
+
+TEST(DamageHistoryTest, ResetForgetsEverySlot) {
+  DamageHistory history(1, 4);
+  history.reset(view);
+  history.collect(0);
+
+  history.reset({0, 0, 200, 100});
+  EXPECT_EQ(history.collect(0).rects(), (RectList{{0, 0, 200, 100}}));
+}
+
+TEST(DamageStreamTest, RoundTrips) {
+  const std::vector<RectList> frames = {
+      {{0, 0, 100, 50}},
+      {},
+      {{1, 2, 3, 4}, {-5, 6, 7, 8}},
+  };
+
+  std::stringstream stream;
+  for (const auto& damage : frames) {
+    region::write_stream_frame(stream, damage);
+  }
+
+  EXPECT_EQ(region::read_stream(stream), frames);
+}
+
+}  // namespace
@@ -0,0 +1,21 @@
+#include <Windows.h>
+
+#include <array>
+
+namespace {
+
+std::array<SHORT, 256> key_state{};
+
+}  // namespace
+
+SHORT GetKeyState(int virtual_key) {
+  return key_state[virtual_key & 0xFF];
+}
+
+void shim::set_key_state(int virtual_key, SHORT state) {
+  key_state[virtual_key & 0xFF] = state;
+}
+
+void shim::reset_key_state() {
+  key_state.fill(0);
+}
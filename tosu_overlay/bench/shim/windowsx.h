@@ -0,0 +1,10 @@
+#pragma once
+
+// Message cracker macros from <windowsx.h> / <WinUser.h> used by the
+// portable overlay sources.
+
+#include <Windows.h>
+
+#define GET_X_LPARAM(lp) ((int)(short)((uint32_t)(lp) & 0xFFFF))
+#define GET_Y_LPARAM(lp) ((int)(short)(((uint32_t)(lp) >> 16) & 0xFFFF))
+#define GET_WHEEL_DELTA_WPARAM(wp) ((short)(((uint32_t)(wp) >> 16) & 0xFFFF))
@@ -0,0 +1,237 @@
+// tosu's state through shared memory (state_channel.h) against the
+// loopback WebSocket it stands in for: the cost of getting one
+// /websocket/v2-sized message across, and the delay from tosu writing a
+// message to the overlay's feed thread having it with messages every 2 ms.
+// The shared-memory reader waits like the feed does, poll_ms apart, or
+// spins when that's 0. POSIX only, like the stand-in server.
+
+#include <benchmark/benchmark.h>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/state_channel.h>
+#include <tosu_overlay/websocket.h>
+
+#include "stand_in_websocket.h"
+#include "tosu_state_sample.h"
+
+namespace {
+
+// not one tosu would write to
+constexpr char endpoint[] = "/websocket/microbench";
+constexpr size_t capacity = 1 << 20;
+
+constexpr int message_count = 200;
+constexpr auto message_interval = std::chrono::milliseconds(2);
+constexpr int timeout_ms = 5000;
+
+std::vector<std::string> sample_messages() {
+  std::vector<std::string> messages;
+  for (int tick = 0; tick < message_count; ++tick) {
+    messages.push_back(tosu_state_sample(tick).dump());
+  }
+  return messages;
+}
+
+// One upgraded WebSocket connection on loopback, the server end sending
+// frames when asked.
+class Loopback {
+ public:
+  Loopback() {
+    const int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener, 1);
+
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+
+    std::thread server([&] {
+      server_ = accept(listener, nullptr, nullptr);
+      std::string request;
+      char buffer[2048];
+      while (request.find("\r\n\r\n") == std::string::npos) {
+        const auto received = recv(server_, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+          return;
+        }
+        request.append(buffer, static_cast<size_t>(received));
+      }
+      send_all("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+               "Connection: Upgrade\r\n\r\n");
+    });
+
+    client_.connect("127.0.0.1", std::to_string(ntohs(address.sin_port)),
+                    endpoint, timeout_ms);
+    server.join();
+    close(listener);
+  }
+
+  ~Loopback() {
+    client_.close();
+    close(server_);
+  }
+
+  bool send_all(const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+      const auto length = ::send(server_, data.data() + sent,
+                                 data.size() - sent, MSG_NOSIGNAL);
+      if (length <= 0) {
+        return false;
+      }
+      sent += static_cast<size_t>(length);
+    }
+    return true;
+  }
+
+  websocket::Client& client() { return client_; }
+
+ private:
+  int server_ = -1;
+  websocket::Client client_;
+};
+
+void report(benchmark::State& state, const latency::Histogram& histogram) {
+  const auto summary = histogram.summary();
+  state.counters["p50_us"] = benchmark::Counter(summary.p50_us);
+  state.counters["p99_us"] = benchmark::Counter(summary.p99_us);
+  state.counters["max_us"] = benchmark::Counter(summary.max_us);
+}
+
+// One message from the producer to the reader and back to the caller, all
+// on this thread: the CPU it takes per message, framing and parsing aside.
+void BM_ChannelTransfer(benchmark::State& state) {
+  const bool shared = state.range(0);
+  const auto message = tosu_state_sample(100).dump();
+
+  if (shared) {
+    state_channel::Writer writer;
+    state_channel::Reader reader;
+    if (!writer.create(endpoint, capacity) || !reader.open(endpoint)) {
+      state.SkipWithError("shared memory not available");
+      return;
+    }
+
+    for (auto _ : state) {
+      writer.write(message, 0);
+      benchmark::DoNotOptimize(reader.read());
+    }
+    state.SetLabel("shared memory");
+  } else {
+    Loopback loopback;
+    if (!loopback.client().is_open()) {
+      state.SkipWithError("no loopback connection");
+      return;
+    }
+
+    const auto frame = StandInWebSocket::frame(message);
+    for (auto _ : state) {
+      loopback.send_all(frame);
+      benchmark::DoNotOptimize(loopback.client().receive(timeout_ms));
+    }
+    state.SetLabel("websocket");
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+BENCHMARK(BM_ChannelTransfer)->Arg(0)->Arg(1);
+
+// Write to read with a producer thread writing every message_interval.
+void BM_ChannelLatency(benchmark::State& state) {
+  const bool shared = state.range(0);
+  const auto poll = std::chrono::milliseconds(state.range(1));
+  static const auto messages = sample_messages();
+
+  latency::Histogram histogram;
+  uint64_t skipped = 0;
+
+  for (auto _ : state) {
+    std::vector<std::atomic<int64_t>> sent_us(messages.size());
+
+    if (shared) {
+      state_channel::Writer writer;
+      state_channel::Reader reader;
+      if (!writer.create(endpoint, capacity) || !reader.open(endpoint)) {
+        state.SkipWithError("shared memory not available");
+        return;
+      }
+
+      std::thread producer([&] {
+        auto next = std::chrono::steady_clock::now();
+        for (const auto& message : messages) {
+          std::this_thread::sleep_until(next += message_interval);
+          writer.write(message, latency::now_us());
+        }
+      });
+
+      const auto deadline = latency::now_us() + timeout_ms * 1000;
+      size_t received = 0;
+      while (received + reader.skipped() < messages.size() &&
+             latency::now_us() < deadline) {
+        if (reader.read()) {
+          histogram.record(latency::now_us() - reader.written_us());
+          ++received;
+        } else if (poll.count() > 0) {
+          std::this_thread::sleep_for(poll);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      skipped += reader.skipped();
+      producer.join();
+    } else {
+      Loopback loopback;
+      if (!loopback.client().is_open()) {
+        state.SkipWithError("no loopback connection");
+        return;
+      }
+
+      std::thread producer([&] {
+        auto next = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < messages.size(); ++i) {
+          std::this_thread::sleep_until(next += message_interval);
+          const auto frame = StandInWebSocket::frame(messages[i]);
+          sent_us[i].store(latency::now_us(), std::memory_order_release);
+          loopback.send_all(frame);
+        }
+      });
+
+      for (size_t i = 0; i < messages.size(); ++i) {
+        if (!loopback.client().receive(timeout_ms)) {
+          break;
+        }
+        histogram.record(latency::now_us() -
+                         sent_us[i].load(std::memory_order_acquire));
+      }
+      producer.join();
+    }
+  }
+
+  report(state, histogram);
+  state.counters["skipped"] = benchmark::Counter(
+      static_cast<double>(skipped), benchmark::Counter::kAvgIterations);
+  state.SetLabel(shared ? "shared memory" : "websocket");
+}
+BENCHMARK(BM_ChannelLatency)
+    ->ArgNames({"shared", "poll_ms"})
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({1, 1})
+    ->Args({1, 2})
+    ->Iterations(3)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,86 @@
+#pragma once
+
+// A stand-in for tosu's HTTP server on localhost, for kernels that talk to
+// tosu over real sockets. Every connection gets one response from the
+// respond callback and is closed. POSIX only.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+class StandInServer {
+ public:
+  using Respond = std::function<std::string(const std::string& request)>;
+
+  // Answers every request with an empty 200, like tosu's /api/ingame.
+  StandInServer()
+      : StandInServer([](const std::string&) {
+          return std::string(
+              "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n"
+              "Connection: close\r\n\r\n");
+        }) {}
+
+  explicit StandInServer(Respond respond) : respond_(std::move(respond)) {
+    listener_ = socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener_, 16);
+
+    socklen_t length = sizeof(address);
+    getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = std::to_string(ntohs(address.sin_port));
+
+    thread_ = std::thread([this] { serve(); });
+  }
+
+  ~StandInServer() {
+    stop_ = true;
+    shutdown(listener_, SHUT_RDWR);
+    close(listener_);
+    thread_.join();
+  }
+
+  const std::string& port() const { return port_; }
+
+ private:
+  void serve() {
+    while (!stop_) {
+      const int client = accept(listener_, nullptr, nullptr);
+      if (client < 0) {
+        continue;
+      }
+
+      // requests are a few hundred bytes, one read gets all of it
+      char buffer[2048];
+      const auto received = recv(client, buffer, sizeof(buffer), 0);
+      const auto response =
+          respond_(std::string(buffer, received > 0 ? received : 0));
+
+      size_t sent = 0;
+      while (sent < response.size()) {
+        const auto length = send(client, response.data() + sent,
+                                 response.size() - sent, MSG_NOSIGNAL);
+        if (length <= 0) {
+          break;
+        }
+        sent += static_cast<size_t>(length);
+      }
+      close(client);
+    }
+  }
+
+  Respond respond_;
+  int listener_ = -1;
+  std::string port_;
+  std::atomic<bool> stop_ = false;
+  std::thread thread_;
+};
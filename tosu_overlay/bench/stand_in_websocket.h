@@ -0,0 +1,129 @@
+#pragma once
+
+// A stand-in for tosu's WebSocket server on localhost. Every connection is
+// upgraded, gets the same list of text messages as fast as the socket takes
+// them and is held open until the client goes away. POSIX only.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class StandInWebSocket {
+ public:
+  explicit StandInWebSocket(std::vector<std::string> messages) {
+    for (const auto& message : messages) {
+      frames_ += frame(message);
+    }
+
+    listener_ = socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener_, 64);
+
+    socklen_t length = sizeof(address);
+    getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = std::to_string(ntohs(address.sin_port));
+
+    thread_ = std::thread([this] { serve(); });
+  }
+
+  ~StandInWebSocket() {
+    stop_ = true;
+    shutdown(listener_, SHUT_RDWR);
+    close(listener_);
+    thread_.join();
+
+    std::lock_guard lock(lock_);
+    for (auto& client : clients_) {
+      client.join();
+    }
+  }
+
+  const std::string& port() const { return port_; }
+
+  // A final text frame, server frames aren't masked.
+  static std::string frame(const std::string& payload) {
+    std::string result(1, static_cast<char>(0x81));
+    const uint64_t size = payload.size();
+    if (size < 126) {
+      result += static_cast<char>(size);
+    } else if (size <= 0xffff) {
+      result += static_cast<char>(126);
+      result += static_cast<char>(size >> 8);
+      result += static_cast<char>(size);
+    } else {
+      result += static_cast<char>(127);
+      for (int shift = 56; shift >= 0; shift -= 8) {
+        result += static_cast<char>(size >> shift);
+      }
+    }
+    return result + payload;
+  }
+
+ private:
+
+  void serve() {
+    while (!stop_) {
+      const int client = accept(listener_, nullptr, nullptr);
+      if (client < 0) {
+        continue;
+      }
+
+      std::lock_guard lock(lock_);
+      clients_.emplace_back([this, client] { talk(client); });
+    }
+  }
+
+  void talk(int client) {
+    std::string request;
+    char buffer[2048];
+    while (request.find("\r\n\r\n") == std::string::npos) {
+      const auto received = recv(client, buffer, sizeof(buffer), 0);
+      if (received <= 0) {
+        close(client);
+        return;
+      }
+      request.append(buffer, static_cast<size_t>(received));
+    }
+
+    const std::string response =
+        "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+        "Connection: Upgrade\r\n\r\n" +
+        frames_;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+      const auto length = send(client, response.data() + sent,
+                               response.size() - sent, MSG_NOSIGNAL);
+      if (length <= 0) {
+        break;
+      }
+      sent += static_cast<size_t>(length);
+    }
+
+    // until the client closes
+    while (recv(client, buffer, sizeof(buffer), 0) > 0) {
+    }
+    close(client);
+  }
+
+  std::string frames_;
+  int listener_ = -1;
+  std::string port_;
+  std::atomic<bool> stop_ = false;
+  std::thread thread_;
+
+  std::mutex lock_;
+  std::vector<std::thread> clients_;
+};
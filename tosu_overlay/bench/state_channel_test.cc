@@ -0,0 +1,163 @@
+// Unit tests for the shared-memory state channel: what a Reader sees of a
+// Writer's messages, and that a read racing the writer is never torn.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <tosu_overlay/state_channel.h>
+
+namespace {
+
+// Regions are named system-wide, keep concurrent runs apart.
+std::string unique_endpoint() {
+  return "/websocket/test_" + std::to_string(std::random_device()());
+}
+
+// Generation n's payload: its number, then a filler whose length and byte
+// both depend on n, so a mix of two generations never looks like either.
+std::string payload_for(uint64_t generation) {
+  auto payload = std::to_string(generation) + ':';
+  payload.append(1024 + (generation * 997) % 60'000,
+                 static_cast<char>('a' + generation % 26));
+  return payload;
+}
+
+TEST(StateChannelTest, NamesRegionsAfterEndpoints) {
+  EXPECT_EQ(state_channel::region_name("/websocket/v2"), "tosu_state_v2");
+  EXPECT_EQ(state_channel::region_name("/websocket/v2/precise"),
+            "tosu_state_v2_precise");
+  EXPECT_EQ(state_channel::region_name("/websocket/"), "");
+  EXPECT_EQ(state_channel::region_name("/api/ingame"), "");
+  EXPECT_EQ(state_channel::region_name("/websocket/../x"), "");
+}
+
+TEST(StateChannelTest, ReadsTheNewestMessageOnce) {
+  const auto endpoint = unique_endpoint();
+
+  state_channel::Reader reader;
+  EXPECT_FALSE(reader.open(endpoint));
+
+  state_channel::Writer writer;
+  ASSERT_TRUE(writer.create(endpoint, 1024));
+  ASSERT_TRUE(reader.open(endpoint));
+
+  EXPECT_FALSE(reader.read());
+
+  ASSERT_TRUE(writer.write("first", 10));
+  auto message = reader.read();
+  ASSERT_TRUE(message);
+  EXPECT_EQ(*message, "first");
+  EXPECT_EQ(reader.written_us(), 10);
+  EXPECT_FALSE(reader.read());
+
+  // only the newest of several writes, the others count as skipped
+  writer.write("second", 20);
+  writer.write("third", 30);
+  writer.write("fourth", 40);
+  message = reader.read();
+  ASSERT_TRUE(message);
+  EXPECT_EQ(*message, "fourth");
+  EXPECT_EQ(reader.written_us(), 40);
+  EXPECT_EQ(reader.skipped(), 2u);
+
+  // too large for the region, nothing changes
+  EXPECT_FALSE(writer.write(std::string(1025, 'x'), 50));
+  EXPECT_FALSE(reader.read());
+
+  reader.close();
+  writer.close();
+}
+
+// A producer stopped halfway through a write, following the layout in
+// state_channel.h by hand.
+TEST(StateChannelTest, WaitsWhileTheProducerWrites) {
+  const auto endpoint = unique_endpoint();
+  constexpr std::string_view payload = "first";
+
+  state_channel::Region region;
+  ASSERT_TRUE(region.create(state_channel::region_name(endpoint),
+                            sizeof(state_channel::Header) + 1024));
+  auto* header = static_cast<state_channel::Header*>(region.data());
+  header->magic = state_channel::magic;
+  header->version = state_channel::version;
+  header->capacity = 1024;
+
+  state_channel::Reader reader;
+  ASSERT_TRUE(reader.open(endpoint));
+
+  header->sequence.store(1);
+  std::memcpy(header + 1, payload.data(), payload.size());
+  header->length = payload.size();
+  EXPECT_FALSE(reader.read());
+
+  header->sequence.store(2);
+  const auto message = reader.read();
+  ASSERT_TRUE(message);
+  EXPECT_EQ(*message, payload);
+
+  reader.close();
+  region.close();
+}
+
+// Needs more than one core to race for real, a single one only interleaves
+// the two threads at preemption.
+TEST(StateChannelTest, ReaderNeverSeesATornMessage) {
+  const auto endpoint = unique_endpoint();
+
+  state_channel::Writer writer;
+  ASSERT_TRUE(writer.create(endpoint, 64 * 1024));
+
+  state_channel::Reader reader;
+  ASSERT_TRUE(reader.open(endpoint));
+
+  constexpr uint64_t generations = 50'000;
+  std::atomic<bool> done = false;
+
+  std::thread producer([&] {
+    for (uint64_t generation = 1; generation <= generations; ++generation) {
+      writer.write(payload_for(generation), static_cast<int64_t>(generation));
+    }
+    done = true;
+  });
+
+  uint64_t reads = 0;
+  uint64_t last_generation = 0;
+  bool torn = false;
+
+  const auto check = [&](std::string_view message) {
+    const auto generation = std::stoull(std::string(message));
+    torn |= message != payload_for(generation) ||
+            reader.written_us() != static_cast<int64_t>(generation) ||
+            generation <= last_generation;
+    last_generation = generation;
+    ++reads;
+  };
+
+  while (!done && !torn) {
+    if (const auto message = reader.read()) {
+      check(*message);
+    }
+  }
+  producer.join();
+
+  // the last one is always readable once the writer stopped
+  if (const auto message = reader.read()) {
+    check(*message);
+  }
+
+  EXPECT_FALSE(torn) << "generation " << last_generation;
+  EXPECT_GT(reads, 0u);
+  EXPECT_EQ(last_generation, generations);
+  EXPECT_EQ(reads + reader.skipped(), generations);
+
+  reader.close();
+  writer.close();
+}
+
+}  // namespace
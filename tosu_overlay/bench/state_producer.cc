@@ -0,0 +1,127 @@
+// The producer side of state_channel.h for testing the overlay without
+// tosu: writes /websocket/v2-shaped messages (or a recording made through
+// "feed_record_path", in a loop) into shared memory, interval_ms apart,
+// until Ctrl+C:
+//
+//   tosu_state_producer [--interval-ms 16] [recording]
+//
+// Also a reference for tosu's side, see Writer in state_channel.cc.
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/state_channel.h>
+
+#include "tosu_state_sample.h"
+
+namespace {
+
+// Several times tosu's largest messages.
+constexpr size_t capacity = 4 << 20;
+
+volatile std::sig_atomic_t stop = 0;
+
+// tosu_feed::write_record()'s lines: the endpoint, a space, the message.
+std::vector<std::pair<std::string, std::string>> read_records(
+    std::istream& in) {
+  std::vector<std::pair<std::string, std::string>> records;
+  std::string line;
+  while (std::getline(in, line)) {
+    const auto space = line.find(' ');
+    if (space != std::string::npos) {
+      records.emplace_back(line.substr(0, space), line.substr(space + 1));
+    }
+  }
+  return records;
+}
+
+void on_signal(int) {
+  stop = 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int interval_ms = 16;
+  const char* recording = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--interval-ms") == 0 && i + 1 < argc) {
+      interval_ms = std::max(1, std::atoi(argv[++i]));
+    } else if (argv[i][0] != '-' && !recording) {
+      recording = argv[i];
+    } else {
+      std::fprintf(stderr, "usage: %s [--interval-ms 16] [recording]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<std::pair<std::string, std::string>> records;
+  if (recording) {
+    std::ifstream in(recording);
+    if (!in.is_open()) {
+      std::fprintf(stderr, "Could not open %s\n", recording);
+      return 1;
+    }
+    records = read_records(in);
+    if (records.empty()) {
+      std::fprintf(stderr, "%s has no messages\n", recording);
+      return 1;
+    }
+  }
+
+  std::map<std::string, std::unique_ptr<state_channel::Writer>> writers;
+  const auto writer = [&](const std::string& endpoint) {
+    auto& entry = writers[endpoint];
+    if (!entry) {
+      entry = std::make_unique<state_channel::Writer>();
+      if (!entry->create(endpoint, capacity)) {
+        std::fprintf(stderr, "Could not create the region for %s\n",
+                     endpoint.c_str());
+        std::exit(1);
+      }
+      std::printf("Writing %s to %s\n", endpoint.c_str(),
+                  state_channel::region_name(endpoint).c_str());
+    }
+    return entry.get();
+  };
+
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  auto next = std::chrono::steady_clock::now();
+  for (size_t tick = 0; !stop; ++tick) {
+    std::this_thread::sleep_until(next +=
+                                  std::chrono::milliseconds(interval_ms));
+
+    const bool written =
+        recording
+            ? writer(records[tick % records.size()].first)
+                  ->write(records[tick % records.size()].second,
+                          latency::now_us())
+            : writer("/websocket/v2")
+                  ->write(tosu_state_sample(static_cast<int>(tick)).dump(),
+                          latency::now_us());
+    if (!written) {
+      std::fprintf(stderr, "Message %zu is larger than the region\n", tick);
+    }
+  }
+
+  // the writers remove their regions
+  return 0;
+}
@@ -0,0 +1,117 @@
+// Unit tests for tosu_connection::Tracker, when the overlay browser is
+// created and closed from probes of tosu's server.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include <tosu_overlay/tosu_connection.h>
+
+namespace {
+
+using tosu_connection::Action;
+using tosu_connection::Config;
+using tosu_connection::Tracker;
+
+constexpr Config config = {
+    .retry_initial_ms = 100,
+    .retry_max_ms = 800,
+    .check_interval_ms = 1000,
+    .teardown_after_ms = 5000,
+};
+
+// Probe times in microseconds, ms after a clock that started a while ago
+// (0 stands for "never answered").
+constexpr int64_t at(int64_t ms) {
+  return (100'000 + ms) * 1000;
+}
+
+TEST(TosuConnectionTest, BacksOffWhileTosuIsDown) {
+  Tracker tracker(config);
+
+  for (const int64_t expected : {100, 200, 400, 800, 800}) {
+    EXPECT_EQ(tracker.on_probe(false, false, at(0)), Action::none);
+    EXPECT_EQ(tracker.next_probe_ms(), expected);
+  }
+}
+
+TEST(TosuConnectionTest, CreatesTheBrowserOnceTosuAnswers) {
+  Tracker tracker(config);
+  tracker.on_probe(false, false, at(0));
+  tracker.on_probe(false, false, at(100));
+
+  EXPECT_EQ(tracker.on_probe(true, false, at(300)), Action::create_browser);
+  EXPECT_EQ(tracker.next_probe_ms(), config.check_interval_ms);
+
+  EXPECT_EQ(tracker.on_probe(true, true, at(1300)), Action::none);
+  EXPECT_EQ(tracker.next_probe_ms(), config.check_interval_ms);
+}
+
+TEST(TosuConnectionTest, ClosesTheBrowserAfterTeardownDelay) {
+  Tracker tracker(config);
+  tracker.on_probe(true, false, at(0));
+
+  // gone, but not for long enough
+  EXPECT_EQ(tracker.on_probe(false, true, at(1000)), Action::none);
+  EXPECT_EQ(tracker.on_probe(false, true, at(4999)), Action::none);
+  EXPECT_EQ(tracker.next_probe_ms(), config.check_interval_ms);
+
+  EXPECT_EQ(tracker.on_probe(false, true, at(5000)), Action::close_browser);
+  EXPECT_EQ(tracker.next_probe_ms(), config.retry_initial_ms);
+
+  // then backs off from the start again
+  EXPECT_EQ(tracker.on_probe(false, false, at(5100)), Action::none);
+  EXPECT_EQ(tracker.next_probe_ms(), 100);
+  EXPECT_EQ(tracker.on_probe(false, false, at(5200)), Action::none);
+  EXPECT_EQ(tracker.next_probe_ms(), 200);
+}
+
+TEST(TosuConnectionTest, AnsweringAgainRestartsTheTeardownDelay) {
+  Tracker tracker(config);
+  tracker.on_probe(true, false, at(0));
+
+  tracker.on_probe(false, true, at(4000));
+  EXPECT_EQ(tracker.on_probe(true, true, at(4500)), Action::none);
+
+  EXPECT_EQ(tracker.on_probe(false, true, at(9000)), Action::none);
+  EXPECT_EQ(tracker.on_probe(false, true, at(9500)), Action::close_browser);
+}
+
+TEST(TosuConnectionTest, BrowserOpenedElsewhereStartsTheClock) {
+  // the browser exists before any probe answered
+  Tracker tracker(config);
+
+  EXPECT_EQ(tracker.on_probe(false, true, at(0)), Action::none);
+  EXPECT_EQ(tracker.on_probe(false, true, at(4000)), Action::none);
+  EXPECT_EQ(tracker.on_probe(false, true, at(5000)), Action::close_browser);
+}
+
+TEST(TosuConnectionTest, ZeroTeardownNeverCloses) {
+  auto never = config;
+  never.teardown_after_ms = 0;
+
+  Tracker tracker(never);
+  tracker.on_probe(true, false, at(0));
+
+  EXPECT_EQ(tracker.on_probe(false, true, at(3'600'000)), Action::none);
+}
+
+TEST(TosuConnectionTest, ParsesAndClampsConfig) {
+  const auto parsed = tosu_connection::parse_config({
+      {"retry_initial_ms", 10},
+      {"retry_max_ms", 5},
+      {"check_interval_ms", 2000},
+      {"teardown_after_s", 30},
+  });
+
+  EXPECT_EQ(parsed.retry_initial_ms, 50);
+  EXPECT_EQ(parsed.retry_max_ms, 50);
+  EXPECT_EQ(parsed.check_interval_ms, 2000);
+  EXPECT_EQ(parsed.teardown_after_ms, 30000);
+
+  const auto defaults = tosu_connection::parse_config(nlohmann::json::object());
+  EXPECT_EQ(defaults.retry_initial_ms, 500);
+  EXPECT_EQ(defaults.teardown_after_ms, 120000);
+}
+
+}  // namespace
@@ -0,0 +1,131 @@
+// The tosu probe against a stand-in HTTP server on localhost: how long a
+// probe takes when tosu answers and when nothing listens on its port. Then
+// tosu_connection::Tracker over simulated time: probes spent while tosu is
+// down and how long after it comes up the browser gets created. POSIX only,
+// like the stand-in server.
+
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <tosu_overlay/http_probe.h>
+#include <tosu_overlay/tosu_connection.h>
+
+#include "stand_in_server.h"
+
+namespace {
+
+// A port nothing listens on: bound once to pick it, then released.
+std::string closed_port() {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+  socklen_t length = sizeof(address);
+  getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+  close(fd);
+
+  return std::to_string(ntohs(address.sin_port));
+}
+
+constexpr int probe_timeout_ms = 1000;
+
+void BM_ProbeTosu(benchmark::State& state) {
+  const bool answered = state.range(0) != 0;
+
+  StandInServer server;
+  const auto port = answered ? server.port() : closed_port();
+
+  int64_t elapsed_us = 0;
+  int64_t reachable = 0;
+  for (auto _ : state) {
+    const auto result =
+        http_probe::get("127.0.0.1", port, "/api/ingame", probe_timeout_ms);
+    elapsed_us += result.elapsed_us;
+    reachable += result.status == 200;
+  }
+
+  state.SetLabel(answered ? "tosu up" : "port closed");
+  state.counters["probe_us"] = benchmark::Counter(
+      static_cast<double>(elapsed_us), benchmark::Counter::kAvgIterations);
+  state.counters["reachable"] = benchmark::Counter(
+      static_cast<double>(reachable), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ProbeTosu)->Arg(1)->Arg(0)->UseRealTime();
+
+// tosu starts range(0) seconds after the overlay, stays up for ten minutes,
+// goes away for five and comes back. Probes are answered instantly, time is
+// simulated.
+void BM_TosuBackoff(benchmark::State& state) {
+  constexpr int64_t s = 1'000'000;
+  const int64_t up_at = state.range(0) * s;
+  const int64_t down_at = up_at + 600 * s;
+  const int64_t back_at = down_at + 300 * s;
+  const int64_t end = back_at + 60 * s;
+
+  const auto tosu_up = [&](int64_t now) {
+    return (now >= up_at && now < down_at) || now >= back_at;
+  };
+
+  int64_t probes = 0;
+  int64_t probes_while_down = 0;
+  int64_t create_delay_us = 0;
+  int64_t recreate_delay_us = 0;
+  int64_t browser_gone_us = 0;
+
+  for (auto _ : state) {
+    tosu_connection::Tracker tracker{tosu_connection::Config{}};
+    bool browser_open = false;
+    int creates = 0;
+
+    for (int64_t now = 0; now < end;) {
+      const bool reachable = tosu_up(now);
+      ++probes;
+      probes_while_down += !reachable;
+
+      switch (tracker.on_probe(reachable, browser_open, now)) {
+        case tosu_connection::Action::create_browser:
+          browser_open = true;
+          if (creates++ == 0) {
+            create_delay_us += now - up_at;
+          } else {
+            recreate_delay_us += now - back_at;
+          }
+          break;
+
+        case tosu_connection::Action::close_browser:
+          browser_open = false;
+          browser_gone_us += now - down_at;
+          break;
+
+        case tosu_connection::Action::none:
+          break;
+      }
+
+      now += tracker.next_probe_ms() * 1000;
+    }
+
+    benchmark::DoNotOptimize(browser_open);
+  }
+
+  const auto avg = [](int64_t value) {
+    return benchmark::Counter(static_cast<double>(value),
+                              benchmark::Counter::kAvgIterations);
+  };
+  state.counters["probes"] = avg(probes);
+  state.counters["probes_down"] = avg(probes_while_down);
+  state.counters["create_ms"] = avg(create_delay_us / 1000);
+  state.counters["recreate_ms"] = avg(recreate_delay_us / 1000);
+  state.counters["teardown_ms"] = avg(browser_gone_us / 1000);
+}
+BENCHMARK(BM_TosuBackoff)->Arg(0)->Arg(5)->Arg(60);
+
+}  // namespace
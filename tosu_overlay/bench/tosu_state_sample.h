@@ -0,0 +1,146 @@
+#pragma once
+
+// Something shaped like a tosu /websocket/v2 message during gameplay, for
+// kernels that need realistic state without a recording: tick advances the
+// clock, hit counts, pp and the leaderboard like a play in progress.
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+
+inline nlohmann::json tosu_state_sample(int tick) {
+  using nlohmann::json;
+
+  const int hits = tick * 3;
+
+  json leaderboard = json::array();
+  for (int i = 0; i < 50; ++i) {
+    leaderboard.push_back({
+        {"isFailed", false},
+        {"position", i + 1},
+        {"team", 0},
+        {"id", 1000 + i},
+        {"name", "player" + std::to_string(i)},
+        {"score", 1'000'000 - i * 10'000 + (i == 49 ? hits * 300 : 0)},
+        {"accuracy", 98.5 - i * 0.1},
+        {"hits",
+         {{"0", i % 3}, {"50", 0}, {"100", i}, {"300", 900 - i},
+          {"geki", 200}, {"katu", i / 2}}},
+        {"combo", {{"current", i == 49 ? hits : 0}, {"max", 1200 - i}}},
+        {"mods", {{"checksum", ""}, {"number", 0}, {"name", "HD"}}},
+        {"rank", "S"},
+    });
+  }
+
+  return {
+      {"state", {{"number", 2}, {"name", "play"}}},
+      {"session", {{"playTime", 3600 + tick / 60}, {"playCount", 42}}},
+      {"settings",
+       {{"interfaceVisible", true},
+        {"replayUIVisible", false},
+        {"chatVisibilityStatus", {{"number", 0}, {"name", "hidden"}}},
+        {"leaderboard", {{"visible", true}, {"type", {{"number", 1}}}}},
+        {"progressBar", {{"number", 1}, {"name", "pie"}}},
+        {"bassDensity", 0.0},
+        {"resolution",
+         {{"fullscreen", true},
+          {"width", 1920},
+          {"height", 1080},
+          {"widthFullscreen", 1920},
+          {"heightFullscreen", 1080}}},
+        {"client", {{"updateAvailable", false}, {"branch", 0}}},
+        {"scoreMeter", {{"type", {{"number", 2}}}, {"size", 1.0}}},
+        {"cursor", {{"useSkinCursor", true}, {"size", 0.8}}},
+        {"mouse", {{"rawInput", true}, {"sensitivity", 1.0}}},
+        {"audio",
+         {{"ignoreBeatmapSounds", false},
+          {"volume", {{"master", 50}, {"music", 40}, {"effect", 60}}},
+          {"offset", {{"universal", -10}}}}},
+        {"background", {{"dim", 80}, {"video", false}}},
+        {"keybinds", {{"osu", {{"k1", "Z"}, {"k2", "X"}}}}}}},
+      {"profile",
+       {{"userStatus", {{"number", 1}}},
+        {"banchoStatus", {{"number", 2}}},
+        {"id", 123456},
+        {"name", "player"},
+        {"mode", {{"number", 0}, {"name", "osu"}}},
+        {"rankedScore", 12345678901},
+        {"level", 100.5},
+        {"accuracy", 98.76},
+        {"pp", 7654.3},
+        {"playCount", 54321},
+        {"globalRank", 1234},
+        {"countryCode", {{"number", 0}, {"name", "XX"}}},
+        {"backgroundColour", "ffffff"}}},
+      {"beatmap",
+       {{"isConvert", false},
+        {"time",
+         {{"live", tick * 16},
+          {"firstObject", 1000},
+          {"lastObject", 180000},
+          {"mp3Length", 185000}}},
+        {"status", {{"number", 4}, {"name", "ranked"}}},
+        {"checksum", "0123456789abcdef0123456789abcdef"},
+        {"id", 1234567},
+        {"set", 654321},
+        {"mode", {{"number", 0}, {"name", "osu"}}},
+        {"artist", "Artist"},
+        {"artistUnicode", "Artist"},
+        {"title", "Title"},
+        {"titleUnicode", "Title"},
+        {"mapper", "Mapper"},
+        {"version", "Insane"},
+        {"stats",
+         {{"stars", {{"live", 5.4}, {"total", 5.4}}},
+          {"ar", {{"original", 9.0}, {"converted", 9.0}}},
+          {"cs", {{"original", 4.0}, {"converted", 4.0}}},
+          {"od", {{"original", 8.5}, {"converted", 8.5}}},
+          {"hp", {{"original", 6.0}, {"converted", 6.0}}},
+          {"bpm", {{"realtime", 180}, {"common", 180}, {"min", 170},
+                   {"max", 190}}},
+          {"objects",
+           {{"circles", 600}, {"sliders", 400}, {"spinners", 2},
+            {"holds", 0}, {"total", 1002}}},
+          {"maxCombo", 1500}}}}},
+      {"play",
+       {{"playerName", "player"},
+        {"mode", {{"number", 0}, {"name", "osu"}}},
+        {"score", hits * 300},
+        {"accuracy", 99.0 - (tick % 7) * 0.01},
+        {"healthBar", {{"normal", 100.0 - tick % 10}, {"smooth", 99.0}}},
+        {"hits",
+         {{"0", tick / 200}, {"50", 0}, {"100", tick / 50},
+          {"300", hits}, {"geki", hits / 4}, {"katu", tick / 100},
+          {"sliderBreaks", 0}}},
+        {"hitErrorArray", json::array({-3, 5, 12, -8, 0, 4, -1, 7})},
+        {"combo", {{"current", hits}, {"max", hits}}},
+        {"mods", {{"checksum", ""}, {"number", 8}, {"name", "HD"}}},
+        {"rank", {{"current", "SS"}, {"maxThisPlay", "SS"}}},
+        {"pp",
+         {{"current", tick * 0.05},
+          {"fc", 350.5},
+          {"maxAchievedThisPlay", tick * 0.05}}},
+        {"unstableRate", 90.0 + (tick % 13) * 0.3}}},
+      {"leaderboard", leaderboard},
+      {"performance",
+       {{"accuracy", {{"95", 280.1}, {"96", 290.2}, {"97", 300.3},
+                      {"98", 315.4}, {"99", 330.5}, {"100", 350.5}}},
+        {"graph", {{"series", json::array()}, {"xaxis", json::array()}}}}},
+      {"folders",
+       {{"game", "C:/osu!"},
+        {"skin", "C:/osu!/Skins/skin"},
+        {"songs", "C:/osu!/Songs"},
+        {"beatmap", "654321 Artist - Title"}}},
+      {"files",
+       {{"beatmap", "Artist - Title (Mapper) [Insane].osu"},
+        {"background", "bg.jpg"},
+        {"audio", "audio.mp3"}}},
+      {"directPath",
+       {{"beatmapFile", "C:/osu!/Songs/654321 Artist - Title/map.osu"},
+        {"beatmapBackground", "C:/osu!/Songs/654321 Artist - Title/bg.jpg"},
+        {"beatmapAudio", "C:/osu!/Songs/654321 Artist - Title/audio.mp3"},
+        {"beatmapFolder", "C:/osu!/Songs/654321 Artist - Title"},
+        {"skinFolder", "C:/osu!/Skins/skin"}}},
+      {"tourney", nullptr},
+  };
+}
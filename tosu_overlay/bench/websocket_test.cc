@@ -0,0 +1,190 @@
+// Unit tests for the WebSocket client's framing: websocket::Decoder on
+// masked, fragmented and control frames, and the client against the
+// stand-in tosu server where there is one.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <tosu_overlay/websocket.h>
+
+#ifndef _WIN32
+#include "stand_in_websocket.h"
+#endif
+
+namespace {
+
+using websocket::Decoder;
+using websocket::Opcode;
+
+// A frame the way a server sends it (unmasked), fin unset for fragments.
+std::string server_frame(Opcode opcode,
+                         const std::string& payload,
+                         bool fin = true) {
+  std::string frame(1, static_cast<char>((fin ? 0x80 : 0) |
+                                         static_cast<uint8_t>(opcode)));
+  const uint64_t size = payload.size();
+  if (size < 126) {
+    frame += static_cast<char>(size);
+  } else if (size <= 0xffff) {
+    frame += static_cast<char>(126);
+    frame += static_cast<char>(size >> 8);
+    frame += static_cast<char>(size);
+  } else {
+    frame += static_cast<char>(127);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      frame += static_cast<char>(size >> shift);
+    }
+  }
+  return frame + payload;
+}
+
+std::vector<websocket::Message> decode_all(Decoder& decoder) {
+  std::vector<websocket::Message> messages;
+  while (auto message = decoder.next()) {
+    messages.push_back(std::move(*message));
+  }
+  return messages;
+}
+
+TEST(WebSocketTest, DecodesMaskedFrames) {
+  // RFC 6455 section 5.7: a masked "Hello"
+  const std::string frame = {'\x81', '\x85', '\x37', '\xfa', '\x21', '\x3d',
+                             '\x7f', '\x9f', '\x4d', '\x51', '\x58'};
+  EXPECT_EQ(websocket::encode_frame(Opcode::text, "Hello", 0x37fa213d), frame);
+
+  Decoder decoder;
+  decoder.feed(frame);
+
+  const auto message = decoder.next();
+  ASSERT_TRUE(message);
+  EXPECT_EQ(message->opcode, Opcode::text);
+  EXPECT_EQ(message->payload, "Hello");
+  EXPECT_FALSE(decoder.next());
+  EXPECT_FALSE(decoder.failed());
+}
+
+TEST(WebSocketTest, DecodesExtendedLengths) {
+  const std::string medium(300, 'm');
+  const std::string large(70'000, 'l');
+
+  Decoder decoder;
+  decoder.feed(server_frame(Opcode::binary, medium));
+  decoder.feed(websocket::encode_frame(Opcode::text, large, 0x01020304));
+
+  const auto messages = decode_all(decoder);
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0].opcode, Opcode::binary);
+  EXPECT_EQ(messages[0].payload, medium);
+  EXPECT_EQ(messages[1].payload, large);
+}
+
+TEST(WebSocketTest, WaitsForFramesSplitAcrossReads) {
+  const auto bytes = server_frame(Opcode::text, std::string(200, 'x')) +
+                     server_frame(Opcode::text, "second");
+
+  Decoder decoder;
+  std::vector<websocket::Message> messages;
+  for (const char byte : bytes) {
+    decoder.feed(std::string_view(&byte, 1));
+    auto decoded = decode_all(decoder);
+    messages.insert(messages.end(), decoded.begin(), decoded.end());
+  }
+
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0].payload, std::string(200, 'x'));
+  EXPECT_EQ(messages[1].payload, "second");
+  EXPECT_FALSE(decoder.failed());
+}
+
+TEST(WebSocketTest, ReassemblesFragmentsAroundControlFrames) {
+  Decoder decoder;
+  decoder.feed(server_frame(Opcode::text, "{\"play\":", false));
+  decoder.feed(server_frame(Opcode::ping, "are you there"));
+  decoder.feed(server_frame(Opcode::continuation, "{\"pp\":", false));
+  decoder.feed(server_frame(Opcode::continuation, "1}}"));
+
+  const auto messages = decode_all(decoder);
+  ASSERT_EQ(messages.size(), 2u);
+  // control frames come out as they arrive
+  EXPECT_EQ(messages[0].opcode, Opcode::ping);
+  EXPECT_EQ(messages[0].payload, "are you there");
+  EXPECT_EQ(messages[1].opcode, Opcode::text);
+  EXPECT_EQ(messages[1].payload, "{\"play\":{\"pp\":1}}");
+  EXPECT_FALSE(decoder.failed());
+}
+
+TEST(WebSocketTest, DecodesCloseFrames) {
+  Decoder decoder;
+  decoder.feed(server_frame(Opcode::pong, ""));
+  decoder.feed(server_frame(Opcode::close, std::string("\x03\xe8going away")));
+
+  const auto messages = decode_all(decoder);
+  ASSERT_EQ(messages.size(), 2u);
+  EXPECT_EQ(messages[0].opcode, Opcode::pong);
+  EXPECT_EQ(messages[1].opcode, Opcode::close);
+  // status 1000 then the reason
+  EXPECT_EQ(messages[1].payload, std::string("\x03\xe8going away"));
+}
+
+TEST(WebSocketTest, FailsOnProtocolErrors) {
+  const std::vector<std::string> broken = {
+      // fragmented control frame
+      server_frame(Opcode::ping, "x", false),
+      // control frame over 125 bytes
+      server_frame(Opcode::close, std::string(126, 'x')),
+      // continuation with nothing to continue
+      server_frame(Opcode::continuation, "x"),
+      // a new message before the fragmented one finished
+      server_frame(Opcode::text, "a", false) + server_frame(Opcode::text, "b"),
+  };
+
+  for (const auto& bytes : broken) {
+    Decoder decoder;
+    decoder.feed(bytes);
+    decoder.feed(server_frame(Opcode::text, "after"));
+
+    EXPECT_TRUE(decode_all(decoder).empty());
+    EXPECT_TRUE(decoder.failed());
+  }
+}
+
+TEST(WebSocketTest, ChecksTheHandshake) {
+  EXPECT_TRUE(websocket::handshake_accepted(
+      "HTTP/1.1 101 Switching Protocols\r\nUpgrade: WebSocket\r\n"
+      "Connection: Upgrade\r\n\r\n"));
+  EXPECT_FALSE(websocket::handshake_accepted(
+      "HTTP/1.1 200 OK\r\nUpgrade: websocket\r\n\r\n"));
+  EXPECT_FALSE(websocket::handshake_accepted(
+      "HTTP/1.1 101 Switching Protocols\r\nUpgrade: h2c\r\n\r\n"));
+}
+
+#ifndef _WIN32
+
+TEST(WebSocketTest, ReceivesFromTheStandInServer) {
+  const std::vector<std::string> sent = {"{\"a\":1}", std::string(70'000, 'x'),
+                                         "{\"a\":2}"};
+  StandInWebSocket server(sent);
+
+  websocket::Client client;
+  ASSERT_TRUE(client.connect("127.0.0.1", server.port(), "/websocket/v2",
+                             1000));
+
+  for (const auto& expected : sent) {
+    const auto message = client.receive(1000);
+    ASSERT_TRUE(message);
+    EXPECT_EQ(message->opcode, Opcode::text);
+    EXPECT_EQ(message->payload, expected);
+  }
+
+  // nothing more, still open
+  EXPECT_FALSE(client.receive(50));
+  EXPECT_TRUE(client.is_open());
+  client.close();
+}
+
+#endif
+
+}  // namespace
@@ -1,6 +1,12 @@
+#include <tosu_overlay/alpha_mask.h>
 #include <tosu_overlay/canvas.h>
 #include <tosu_overlay/input.h>
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/overlay_stats.h>
+#include <tosu_overlay/region.h>
+#include <tosu_overlay/startup.h>
 #include <tosu_overlay/tosu_overlay_handler.h>
+#include <atomic>
 #include <mutex>
 
 #include <glad/glad.h>
@@ -101,7 +107,18 @@ POINT render_size;
 
 std::mutex mutex;
 
-bool update_pending = true;
+// Several OnPaint calls can land between two swaps, so the texture tracks
+// its age against the CEF frames in render_data. PBOs only ever carry the
+// rects uploaded from them in the same swap, so they need no history.
+constexpr size_t texture_slot = 0;
+region::DamageHistory damage_history(1, 8);
+
+// Past this many rects, or this much coverage of the bounding box, a single
+// bounding-box upload is cheaper than many small glTexSubImage2D calls.
+constexpr size_t upload_rect_limit = 8;
+constexpr float upload_coverage = 0.6f;
+
+std::atomic<bool> visible = true;
 
 GLuint vao = 0;
 GLuint vbo = 0;
@@ -131,31 +148,62 @@ void create_pbos() {
 void try_update_texture() {
   std::lock_guard<std::mutex> lock(mutex);
 
-  if (!update_pending) {
+  if (!damage_history.pending(texture_slot)) {
     return;
   }
 
-  update_pending = false;
+  auto upload = damage_history.collect(texture_slot)
+                    .upload_rects(upload_rect_limit, upload_coverage);
+  for (auto& rect : upload) {
+    rect = frame::clip(rect, render_size.x, render_size.y);
+  }
 
   // Double-buffered PBO: bind the current PBO for asynchronous update
   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIds[currentPBO]);
 
-  // Map the PBO so we can write data to it
+  // Map the PBO so we can write data to it, only the damaged rects are
+  // copied and read back below so the rest may stay stale
   void* pboMemory = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
   if (pboMemory) {
-    memcpy(pboMemory, render_data,
-           render_size.x * render_size.y * 4);  // Copy render data to PBO
-    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);      // Unmap buffer after copying
+    frame::copy_rects(static_cast<uint8_t*>(pboMemory), render_data,
+                      render_size.x, render_size.y, upload);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);  // Unmap buffer after copying
   }
 
-  // Bind the texture and perform the texture update using the PBO
+  GLint row_length = 0;
+  glGetIntegerv(GL_UNPACK_ROW_LENGTH, &row_length);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, render_size.x);
+
+  // Bind the texture and update the damaged rects from the PBO
   glBindTexture(GL_TEXTURE_2D, texture);
-  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, render_size.x, render_size.y, GL_BGRA,
-                  GL_UNSIGNED_BYTE, 0);
+  uint64_t upload_bytes = 0;
+  for (const auto& rect : upload) {
+    if (rect.empty()) {
+      continue;
+    }
+
+    upload_bytes += static_cast<uint64_t>(rect.area()) * frame::bytes_per_pixel;
+
+    const auto offset =
+        (static_cast<size_t>(rect.y) * render_size.x + rect.x) *
+        frame::bytes_per_pixel;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height,
+                    GL_BGRA, GL_UNSIGNED_BYTE,
+                    reinterpret_cast<const void*>(offset));
+  }
+
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+
+  // hit-test data for edit mode, from the same rects while they are hot
+  alpha_mask::update(render_data, render_size.x, render_size.y, upload);
 
   // Switch to the other PBO for the next frame
   currentPBO = (currentPBO + 1) % 4;
 
+  latency::uploaded();
+  overlay_stats::uploaded(upload_bytes);
+  startup::mark(startup::Step::first_upload);
+
   // Unbind PBO and texture after the update
   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
   glBindTexture(GL_TEXTURE_2D, 0);
@@ -224,16 +272,25 @@ POINT canvas::get_render_size() {
   return render_size;
 }
 
-void canvas::set_data(const void* data) {
+void canvas::set_visible(bool value) {
+  visible = value;
+}
+
+bool canvas::is_visible() {
+  return visible;
+}
+
+void canvas::set_data(const void* data, const frame::RectList& dirty_rects) {
   std::lock_guard<std::mutex> lock(mutex);
 
   if (!render_data) {
     return;
   }
 
-  memcpy(render_data, data, render_size.x * render_size.y * 4);
+  frame::copy_rects(render_data, data, render_size.x, render_size.y,
+                    dirty_rects);
 
-  update_pending = true;
+  damage_history.push(dirty_rects);
 }
 
 void canvas::create(int32_t width, int32_t height) {
@@ -245,6 +302,9 @@ void canvas::create(int32_t width, int32_t height) {
   render_data = new uint8_t[width * height * 4];
   ZeroMemory(render_data, width * height * 4);
 
+  damage_history.reset({0, 0, width, height});
+  alpha_mask::resize(width, height);
+
   GLint texture2d;
   glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture2d);
 
@@ -295,6 +355,10 @@ void canvas::create(int32_t width, int32_t height) {
 }
 
 void canvas::draw(HDC hdc) {
+  if (!visible) {
+    return;
+  }
+
   auto window_size = get_window_size(hdc);
   if (window_size.x == 0 || window_size.y == 0) {
     return;
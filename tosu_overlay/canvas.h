@@ -3,12 +3,19 @@
 #include <Windows.h>
 #include <cstdint>
 
+#include <tosu_overlay/frame.h>
+
 namespace canvas {
 
 void create(int32_t width, int32_t height);
-void set_data(const void* data);
+// Copies the damaged parts of a full BGRA frame into the staging buffer.
+void set_data(const void* data, const frame::RectList& dirty_rects);
 void draw(HDC hdc);
 
 POINT get_render_size();
 
+// Hidden overlays skip drawing, frames keep being accepted meanwhile.
+void set_visible(bool visible);
+bool is_visible();
+
 }  // namespace canvas
\ No newline at end of file
@@ -56,7 +56,66 @@ void ConfigManager::save_config(const std::string& filePath) {
 void ConfigManager::write_default_config(const std::string& filePath) {
     nlohmann::json defaultConfig = {
         {"cef_debugging_enabled", false},
-        {"cef_fps", 60}
+        {"cef_fps", 60},
+        {"edit_mode_passthrough", true},
+        {"pointer_input", true},
+        {"prefault_resources", true},
+        {"disk_cache", false},
+        {"switches", {
+            {"profile", "default"},
+            {"add", nlohmann::json::object()},
+            {"remove", nlohmann::json::array()}
+        }},
+        {"raster", {
+            {"preset", "default"}
+        }},
+        {"memory", {
+            {"js_heap_mb", 0},
+            {"disk_cache_mb", 0},
+            {"sample_seconds", 60},
+            {"growth_warning_mb", 128},
+            {"recycle_mb", 0}
+        }},
+        {"scheduling", {
+            {"subprocess_priority", "below_normal"},
+            {"cef_thread_priority", "normal"},
+            {"background_thread_priority", "idle"},
+            {"avoid_cores", nlohmann::json::array()}
+        }},
+        {"message_loop", {
+            {"mode", "dedicated"},
+            {"slice_budget_ms", 4},
+            {"max_delay_ms", 33}
+        }},
+        {"asset_cache", {
+            {"enabled", true},
+            {"max_mb", 64}
+        }},
+        {"beatmap_images", {
+            {"enabled", true},
+            {"cache_mb", 64}
+        }},
+        {"tosu_feed", {
+            {"enabled", true},
+            {"reconnect_ms", 1000},
+            {"shared_memory", false},
+            {"poll_ms", 2}
+        }},
+        {"performance_mode", {
+            {"enabled", false},
+            {"allow", nlohmann::json::array()}
+        }},
+        {"tosu_connection", {
+            {"retry_initial_ms", 500},
+            {"retry_max_ms", 30000},
+            {"check_interval_ms", 5000},
+            {"teardown_after_s", 120}
+        }},
+        {"hotkeys", {
+            {"edit_mode", "LCtrl+LShift+Space"},
+            {"toggle_overlay", ""},
+            {"reload", ""}
+        }}
     };
 
     std::ofstream configFile(filePath);
@@ -0,0 +1,222 @@
+#include "tosu_overlay/feed_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "include/cef_values.h"
+#include "include/wrapper/cef_helpers.h"
+#include "tosu_overlay/logger.h"
+#include "tosu_overlay/state.h"
+
+namespace {
+
+CefRefPtr<CefValue> to_cef_value(const nlohmann::json& json) {
+  auto value = CefValue::Create();
+
+  switch (json.type()) {
+    case nlohmann::json::value_t::object: {
+      auto dictionary = CefDictionaryValue::Create();
+      for (const auto& [key, item] : json.items()) {
+        dictionary->SetValue(key, to_cef_value(item));
+      }
+      value->SetDictionary(dictionary);
+      break;
+    }
+    case nlohmann::json::value_t::array: {
+      auto list = CefListValue::Create();
+      list->SetSize(json.size());
+      for (size_t i = 0; i < json.size(); ++i) {
+        list->SetValue(i, to_cef_value(json[i]));
+      }
+      value->SetList(list);
+      break;
+    }
+    case nlohmann::json::value_t::string:
+      value->SetString(json.get_ref<const std::string&>());
+      break;
+    case nlohmann::json::value_t::boolean:
+      value->SetBool(json.get<bool>());
+      break;
+    case nlohmann::json::value_t::number_integer:
+    case nlohmann::json::value_t::number_unsigned: {
+      // CefValue ints are 32 bits
+      const auto number = json.get<double>();
+      if (number >= std::numeric_limits<int>::min() &&
+          number <= std::numeric_limits<int>::max()) {
+        value->SetInt(json.get<int>());
+      } else {
+        value->SetDouble(number);
+      }
+      break;
+    }
+    case nlohmann::json::value_t::number_float:
+      value->SetDouble(json.get<double>());
+      break;
+    default:
+      value->SetNull();
+      break;
+  }
+
+  return value;
+}
+
+CefRefPtr<CefValue> encode(const nlohmann::json& json,
+                           tosu_feed::Format format) {
+  if (format == tosu_feed::Format::object) {
+    return to_cef_value(json);
+  }
+
+  const auto packed = nlohmann::json::to_msgpack(json);
+  auto value = CefValue::Create();
+  value->SetBinary(CefBinaryValue::Create(packed.data(), packed.size()));
+  return value;
+}
+
+}  // namespace
+
+FeedRouter::FeedRouter(const tosu_feed::Config& config,
+                       tosu_feed::Deliver deliver)
+    : config_(config), deliver_(std::move(deliver)) {}
+
+bool FeedRouter::OnProcessMessage(CefRefPtr<CefBrowser> browser,
+                                  CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefProcessMessage> message) {
+  CEF_REQUIRE_UI_THREAD();
+
+  const auto name = message->GetName().ToString();
+  const bool subscribe = name == tosu_feed::subscribe_message;
+  if (!subscribe && name != tosu_feed::unsubscribe_message) {
+    return false;
+  }
+
+  const auto args = message->GetArgumentList();
+  const auto endpoint = args->GetString(0).ToString();
+  const auto format = tosu_feed::parse_format(args->GetString(1).ToString());
+  if (!format || !tosu_feed::valid_endpoint(endpoint)) {
+    logger::log("tosu feed: ignoring subscription to \"%s\"",
+                endpoint.c_str());
+    return true;
+  }
+
+  const auto frame_id = frame->GetIdentifier();
+  const auto subscriber = std::find_if(
+      subscribers_.begin(), subscribers_.end(), [&](const Subscriber& entry) {
+        return entry.browser->IsSame(browser) && entry.frame_id == frame_id &&
+               entry.endpoint == endpoint && entry.format == *format;
+      });
+
+  if (!subscribe) {
+    if (subscriber != subscribers_.end()) {
+      Unsubscribe(subscriber);
+    }
+    return true;
+  }
+
+  // the renderer subscribes once per frame, endpoint and format
+  if (subscriber != subscribers_.end()) {
+    return true;
+  }
+
+  if (!feed_) {
+    feed_ = std::make_unique<tosu_feed::Feed>(state::host, state::port,
+                                              config_, deliver_);
+  }
+
+  subscribers_.push_back({browser, frame_id, endpoint, *format,
+                          *format == tosu_feed::Format::patch});
+  feed_->subscribe(endpoint, *format);
+  return true;
+}
+
+void FeedRouter::Deliver(const std::string& endpoint,
+                         tosu_feed::Update update) {
+  CEF_REQUIRE_UI_THREAD();
+
+  // what a subscriber gets out of this update
+  enum Payload { object_state, msgpack_state, patch, none };
+  const auto payload_for = [&](const Subscriber& subscriber) {
+    switch (subscriber.format) {
+      case tosu_feed::Format::object:
+        return update.state ? object_state : none;
+      case tosu_feed::Format::msgpack:
+        return update.state ? msgpack_state : none;
+      default:
+        if (subscriber.needs_state) {
+          return update.state ? object_state : none;
+        }
+        return update.patch ? patch : none;
+    }
+  };
+
+  // built once each, copied for every frame but the last
+  CefRefPtr<CefValue> encoded[none];
+  size_t left[none] = {0, 0, 0};
+  for (const auto& subscriber : subscribers_) {
+    if (subscriber.endpoint == endpoint) {
+      const auto payload = payload_for(subscriber);
+      if (payload != none) {
+        ++left[payload];
+      }
+    }
+  }
+
+  for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+    const auto payload = it->endpoint == endpoint ? payload_for(*it) : none;
+    if (payload == none) {
+      ++it;
+      continue;
+    }
+
+    auto frame = it->browser->GetFrameByIdentifier(it->frame_id);
+    if (!frame || !frame->IsValid()) {
+      --left[payload];
+      it = Unsubscribe(it);
+      continue;
+    }
+
+    if (!encoded[payload]) {
+      encoded[payload] =
+          payload == patch
+              ? to_cef_value(*update.patch)
+              : encode(*update.state, payload == msgpack_state
+                                          ? tosu_feed::Format::msgpack
+                                          : tosu_feed::Format::object);
+    }
+
+    auto message = CefProcessMessage::Create(tosu_feed::update_message);
+    auto args = message->GetArgumentList();
+    args->SetString(0, endpoint);
+    args->SetString(1, tosu_feed::format_name(it->format));
+    args->SetValue(2, --left[payload] > 0 ? encoded[payload]->Copy()
+                                          : encoded[payload]);
+    args->SetString(3, payload == patch ? tosu_feed::update_patch
+                                        : tosu_feed::update_state);
+    frame->SendProcessMessage(PID_RENDERER, message);
+
+    it->needs_state = false;
+    ++it;
+  }
+}
+
+void FeedRouter::OnBrowserClosed(CefRefPtr<CefBrowser> browser) {
+  CEF_REQUIRE_UI_THREAD();
+
+  for (auto it = subscribers_.begin(); it != subscribers_.end();) {
+    if (it->browser->IsSame(browser)) {
+      it = Unsubscribe(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+tosu_feed::Stats FeedRouter::GetStats() const {
+  return feed_ ? feed_->stats() : tosu_feed::Stats{};
+}
+
+std::vector<FeedRouter::Subscriber>::iterator FeedRouter::Unsubscribe(
+    std::vector<Subscriber>::iterator subscriber) {
+  feed_->unsubscribe(subscriber->endpoint, subscriber->format);
+  return subscribers_.erase(subscriber);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "include/cef_browser.h"
+#include "include/cef_process_message.h"
+#include "tosu_overlay/tosu_feed.h"
+
+// The browser process side of window.tosuOverlay.subscribe(): keeps track
+// of which frames want which endpoint in which format, and sends each tosu
+// message to them, converted once per format. Patch subscribers get the
+// whole state first and patches after that. CEF UI thread only.
+class FeedRouter {
+ public:
+  // deliver is handed to the tosu_feed::Feed created on the first
+  // subscription, it should post the message to the UI thread's Deliver().
+  FeedRouter(const tosu_feed::Config& config, tosu_feed::Deliver deliver);
+
+  // Handles subscribe and unsubscribe messages, false for anything else.
+  bool OnProcessMessage(CefRefPtr<CefBrowser> browser,
+                        CefRefPtr<CefFrame> frame,
+                        CefRefPtr<CefProcessMessage> message);
+
+  void Deliver(const std::string& endpoint, tosu_feed::Update update);
+
+  // Drops the browser's subscriptions.
+  void OnBrowserClosed(CefRefPtr<CefBrowser> browser);
+
+  // Zeroes before the first subscription.
+  tosu_feed::Stats GetStats() const;
+
+ private:
+  struct Subscriber {
+    CefRefPtr<CefBrowser> browser;
+    CefString frame_id;
+    std::string endpoint;
+    tosu_feed::Format format;
+    // patch subscribers until they got the whole state
+    bool needs_state;
+  };
+
+  // Returns the subscriber after it.
+  std::vector<Subscriber>::iterator Unsubscribe(
+      std::vector<Subscriber>::iterator subscriber);
+
+  tosu_feed::Config config_;
+  tosu_feed::Deliver deliver_;
+
+  std::unique_ptr<tosu_feed::Feed> feed_;
+  std::vector<Subscriber> subscribers_;
+};
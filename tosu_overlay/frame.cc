@@ -0,0 +1,115 @@
+#include <tosu_overlay/frame.h>
+
+#include <algorithm>
+#include <cstring>
+
+frame::Rect frame::clip(const Rect& r, int32_t width, int32_t height) {
+  const auto left = std::max(r.x, 0);
+  const auto top = std::max(r.y, 0);
+  const auto right = std::min(r.x + r.width, width);
+  const auto bottom = std::min(r.y + r.height, height);
+
+  return {left, top, right - left, bottom - top};
+}
+
+void frame::copy_full(uint8_t* dst,
+                      const void* src,
+                      int32_t width,
+                      int32_t height) {
+  std::memcpy(dst, src,
+              static_cast<size_t>(width) * height * frame::bytes_per_pixel);
+}
+
+void frame::copy_rects(uint8_t* dst,
+                       const void* src,
+                       int32_t width,
+                       int32_t height,
+                       const RectList& rects) {
+  const auto source = static_cast<const uint8_t*>(src);
+  const size_t stride = static_cast<size_t>(width) * frame::bytes_per_pixel;
+
+  for (const auto& dirty : rects) {
+    const auto r = frame::clip(dirty, width, height);
+    if (r.empty()) {
+      continue;
+    }
+
+    // full-width damage is one contiguous block, no need to go row by row
+    if (r.x == 0 && r.width == width) {
+      std::memcpy(dst + r.y * stride, source + r.y * stride,
+                  r.height * stride);
+      continue;
+    }
+
+    const size_t offset = static_cast<size_t>(r.x) * frame::bytes_per_pixel;
+    const size_t row_bytes =
+        static_cast<size_t>(r.width) * frame::bytes_per_pixel;
+
+    for (int32_t y = r.y; y < r.y + r.height; ++y) {
+      std::memcpy(dst + y * stride + offset, source + y * stride + offset,
+                  row_bytes);
+    }
+  }
+}
+
+frame::Rect frame::union_rects(const RectList& rects) {
+  Rect result{0, 0, 0, 0};
+
+  for (const auto& r : rects) {
+    if (r.empty()) {
+      continue;
+    }
+
+    if (result.empty()) {
+      result = r;
+      continue;
+    }
+
+    const auto right = std::max(result.x + result.width, r.x + r.width);
+    const auto bottom = std::max(result.y + result.height, r.y + r.height);
+    result.x = std::min(result.x, r.x);
+    result.y = std::min(result.y, r.y);
+    result.width = right - result.x;
+    result.height = bottom - result.y;
+  }
+
+  return result;
+}
+
+size_t frame::diff_tiles(const uint8_t* previous,
+                         const uint8_t* current,
+                         int32_t width,
+                         int32_t height,
+                         int32_t tile_size,
+                         std::vector<uint8_t>& changed) {
+  const auto tiles_x = (width + tile_size - 1) / tile_size;
+  const auto tiles_y = (height + tile_size - 1) / tile_size;
+  const size_t stride = static_cast<size_t>(width) * frame::bytes_per_pixel;
+
+  changed.assign(static_cast<size_t>(tiles_x) * tiles_y, 0);
+
+  size_t changed_count = 0;
+
+  for (int32_t ty = 0; ty < tiles_y; ++ty) {
+    const auto top = ty * tile_size;
+    const auto bottom = std::min(top + tile_size, height);
+
+    for (int32_t tx = 0; tx < tiles_x; ++tx) {
+      const auto left = tx * tile_size;
+      const auto row_bytes = static_cast<size_t>(
+          std::min(tile_size, width - left) * frame::bytes_per_pixel);
+      const size_t offset = static_cast<size_t>(left) * frame::bytes_per_pixel;
+
+      for (int32_t y = top; y < bottom; ++y) {
+        if (std::memcmp(previous + y * stride + offset,
+                        current + y * stride + offset, row_bytes) != 0) {
+          changed[ty * tiles_x + tx] = 1;
+          ++changed_count;
+          break;
+        }
+      }
+    }
+  }
+
+  return changed_count;
+}
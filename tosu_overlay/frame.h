@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU-side helpers for BGRA frames handed to us by CefRenderHandler::OnPaint.
+namespace frame {
+
+constexpr int32_t bytes_per_pixel = 4;
+
+struct Rect {
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+
+  int64_t area() const { return static_cast<int64_t>(width) * height; }
+  bool empty() const { return width <= 0 || height <= 0; }
+};
+
+using RectList = std::vector<Rect>;
+
+// |r| clipped to a |width| x |height| frame, may come back empty.
+Rect clip(const Rect& r, int32_t width, int32_t height);
+
+// Copies the whole frame.
+void copy_full(uint8_t* dst, const void* src, int32_t width, int32_t height);
+
+// Copies only the rows covered by |rects|. Rects are clipped to the frame.
+void copy_rects(uint8_t* dst,
+                const void* src,
+                int32_t width,
+                int32_t height,
+                const RectList& rects);
+
+// Bounding box of |rects|, empty rect if there is nothing to union.
+Rect union_rects(const RectList& rects);
+
+// Compares two frames in |tile_size| x |tile_size| blocks. |changed| receives
+// one entry per tile (row-major), non-zero where the tile differs. Returns the
+// number of changed tiles.
+size_t diff_tiles(const uint8_t* previous,
+                  const uint8_t* current,
+                  int32_t width,
+                  int32_t height,
+                  int32_t tile_size,
+                  std::vector<uint8_t>& changed);
+
+}  // namespace frame
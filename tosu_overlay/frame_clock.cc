@@ -0,0 +1,86 @@
+#include <tosu_overlay/frame_clock.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+// Written by the render thread only; the reader catches up from its own
+// count and loses the oldest presents if it falls a whole ring behind.
+constexpr size_t ring_size = 256;
+std::array<std::atomic<int64_t>, ring_size> ring;
+std::atomic<uint64_t> written = 0;
+
+// After a pause longer than this many intervals (loading, minimized), the
+// next present is unknown.
+constexpr int64_t stale_intervals = 8;
+
+std::mutex reader_lock;
+uint64_t taken = 0;
+frame_clock::Estimator estimator;
+
+}  // namespace
+
+void frame_clock::presented(int64_t us) {
+  const auto index = written.load(std::memory_order_relaxed);
+  ring[index % ring_size].store(us, std::memory_order_relaxed);
+  written.store(index + 1, std::memory_order_release);
+}
+
+void frame_clock::Estimator::add(int64_t present_us) {
+  if (last_present_us_ != 0 && present_us > last_present_us_) {
+    intervals_[interval_count_++ % history] = present_us - last_present_us_;
+  }
+  last_present_us_ = present_us;
+
+  pending_.push_back(present_us);
+  if (pending_.size() > max_presents) {
+    pending_.erase(pending_.begin());
+  }
+}
+
+frame_clock::Snapshot frame_clock::Estimator::snapshot(int64_t now_us) {
+  Snapshot snapshot{std::move(pending_), 0, 0.0, 0};
+  pending_.clear();
+
+  const auto count = std::min(interval_count_, history);
+  if (count == 0) {
+    return snapshot;
+  }
+
+  // the median shrugs off the odd hitch that an average would smear over
+  // the next few estimates
+  int64_t sorted[history];
+  std::copy(intervals_, intervals_ + count, sorted);
+  std::nth_element(sorted, sorted + count / 2, sorted + count);
+  const auto interval = std::max<int64_t>(sorted[count / 2], 1);
+
+  snapshot.interval_us = interval;
+  snapshot.fps = 1e6 / static_cast<double>(interval);
+
+  const auto since = now_us - last_present_us_;
+  if (since < 0) {
+    snapshot.next_present_us = last_present_us_ + interval;
+  } else if (since <= interval * stale_intervals) {
+    snapshot.next_present_us =
+        last_present_us_ + (since / interval + 1) * interval;
+  }
+  return snapshot;
+}
+
+frame_clock::Snapshot frame_clock::take(int64_t now_us) {
+  std::lock_guard lock(reader_lock);
+
+  const auto end = written.load(std::memory_order_acquire);
+  if (end - taken > ring_size) {
+    taken = end - ring_size;
+  }
+  for (; taken < end; ++taken) {
+    estimator.add(ring[taken % ring_size].load(std::memory_order_relaxed));
+  }
+
+  return estimator.snapshot(now_us);
+}
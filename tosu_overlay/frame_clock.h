@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The game's present clock for counter pages. Chromium's
+// requestAnimationFrame ticks on its own timer, but an overlay frame only
+// shows at the game's next SwapBuffers after it's uploaded. Pages watching
+// the clock (tosuOverlay.frameClock(), see overlay_api.h) get the recent
+// present timestamps, the game's frame rate and when the next present is
+// due, so they can interpolate to the moment a frame is actually shown and
+// skip frames that would be replaced before it.
+//
+// Timestamps are latency::now_us() (QueryPerformanceCounter), the renderer
+// converts them to the page's performance.now().
+namespace frame_clock {
+
+// Renderer -> browser, no arguments: start and stop updates for the frame.
+constexpr char watch_message[] = "tosu_overlay.frame_clock_watch";
+constexpr char unwatch_message[] = "tosu_overlay.frame_clock_unwatch";
+// Browser -> renderer, arguments the presents since the last update (a
+// list), the frame interval and the next present, all in microseconds as
+// doubles.
+constexpr char update_message[] = "tosu_overlay.frame_clock";
+
+// How many presents an update carries at most.
+constexpr size_t max_presents = 32;
+
+struct Snapshot {
+  // oldest first
+  std::vector<int64_t> presents_us;
+  // the median of the recent intervals, 0 before there were two presents
+  int64_t interval_us;
+  double fps;
+  // the first present after now, 0 while unknown
+  int64_t next_present_us;
+};
+
+// Game render thread, after SwapBuffers returned. Lock-free.
+void presented(int64_t us);
+
+// Keeps the recent presents and estimates the frame interval from them.
+class Estimator {
+ public:
+  void add(int64_t present_us);
+
+  // The presents added since the last snapshot (up to max_presents) and the
+  // estimates as of now_us.
+  Snapshot snapshot(int64_t now_us);
+
+ private:
+  static constexpr size_t history = 64;
+
+  int64_t intervals_[history] = {};
+  size_t interval_count_ = 0;
+  int64_t last_present_us_ = 0;
+  std::vector<int64_t> pending_;
+};
+
+// CEF UI thread: the presents recorded by presented() since the last call
+// and the estimates as of now_us.
+Snapshot take(int64_t now_us);
+
+}  // namespace frame_clock
@@ -0,0 +1,69 @@
+#include "tosu_overlay/frame_watchers.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "include/wrapper/cef_helpers.h"
+
+FrameWatchers::FrameWatchers(std::string watch_message,
+                             std::string unwatch_message)
+    : watch_message_(std::move(watch_message)),
+      unwatch_message_(std::move(unwatch_message)) {}
+
+bool FrameWatchers::OnProcessMessage(CefRefPtr<CefBrowser> browser,
+                                     CefRefPtr<CefFrame> frame,
+                                     CefRefPtr<CefProcessMessage> message) {
+  CEF_REQUIRE_UI_THREAD();
+
+  const auto name = message->GetName().ToString();
+  const bool watch = name == watch_message_;
+  if (!watch && name != unwatch_message_) {
+    return false;
+  }
+
+  const auto frame_id = frame->GetIdentifier();
+  const auto watcher = std::find_if(
+      watchers_.begin(), watchers_.end(), [&](const Watcher& entry) {
+        return entry.browser->IsSame(browser) && entry.frame_id == frame_id;
+      });
+
+  if (!watch) {
+    if (watcher != watchers_.end()) {
+      watchers_.erase(watcher);
+    }
+  } else if (watcher == watchers_.end()) {
+    watchers_.push_back({browser, frame_id});
+  }
+  return true;
+}
+
+void FrameWatchers::Send(const std::string& name,
+                         CefRefPtr<CefListValue> args) {
+  CEF_REQUIRE_UI_THREAD();
+
+  for (auto it = watchers_.begin(); it != watchers_.end();) {
+    auto frame = it->browser->GetFrameByIdentifier(it->frame_id);
+    if (!frame || !frame->IsValid()) {
+      it = watchers_.erase(it);
+      continue;
+    }
+
+    auto message = CefProcessMessage::Create(name);
+    auto message_args = message->GetArgumentList();
+    for (size_t i = 0; i < args->GetSize(); ++i) {
+      message_args->SetValue(i, args->GetValue(i)->Copy());
+    }
+    frame->SendProcessMessage(PID_RENDERER, message);
+    ++it;
+  }
+}
+
+void FrameWatchers::OnBrowserClosed(CefRefPtr<CefBrowser> browser) {
+  CEF_REQUIRE_UI_THREAD();
+
+  watchers_.erase(std::remove_if(watchers_.begin(), watchers_.end(),
+                                 [&](const Watcher& watcher) {
+                                   return watcher.browser->IsSame(browser);
+                                 }),
+                  watchers_.end());
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "include/cef_browser.h"
+#include "include/cef_process_message.h"
+#include "include/cef_values.h"
+
+// Frames that asked the browser process for periodic updates, such as
+// tosuOverlay.frameClock() and tosuOverlay.stats() (see overlay_api.h). The
+// renderer's watch and unwatch messages keep the list, and Send() delivers
+// an update to every frame on it. CEF UI thread only.
+class FrameWatchers {
+ public:
+  FrameWatchers(std::string watch_message, std::string unwatch_message);
+
+  // Handles the watch and unwatch messages, false for anything else.
+  bool OnProcessMessage(CefRefPtr<CefBrowser> browser,
+                        CefRefPtr<CefFrame> frame,
+                        CefRefPtr<CefProcessMessage> message);
+
+  // A process message named name with args to every watcher.
+  void Send(const std::string& name, CefRefPtr<CefListValue> args);
+
+  // Drops the browser's watchers.
+  void OnBrowserClosed(CefRefPtr<CefBrowser> browser);
+
+  bool empty() const { return watchers_.empty(); }
+
+ private:
+  struct Watcher {
+    CefRefPtr<CefBrowser> browser;
+    CefString frame_id;
+  };
+
+  const std::string watch_message_;
+  const std::string unwatch_message_;
+  std::vector<Watcher> watchers_;
+};
@@ -0,0 +1,89 @@
+#include <tosu_overlay/game_state.h>
+#include <tosu_overlay/state.h>
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <utility>
+
+#include "include/cef_request.h"
+#include "include/cef_urlrequest.h"
+#include "include/wrapper/cef_helpers.h"
+
+namespace {
+
+// Collects the /json/v2 body and hands the parsed state to the callback.
+class StateRequestClient : public CefURLRequestClient {
+ public:
+  explicit StateRequestClient(
+      std::function<void(std::optional<bool>)> callback)
+      : callback_(std::move(callback)) {}
+
+  void OnRequestComplete(CefRefPtr<CefURLRequest> request) override {
+    std::optional<bool> gameplay;
+    if (request->GetRequestStatus() == UR_SUCCESS &&
+        request->GetResponse()->GetStatus() == 200) {
+      gameplay = game_state::is_gameplay(body_);
+    }
+
+    callback_(gameplay);
+  }
+
+  void OnUploadProgress(CefRefPtr<CefURLRequest> request,
+                        int64_t current,
+                        int64_t total) override {}
+
+  void OnDownloadProgress(CefRefPtr<CefURLRequest> request,
+                          int64_t current,
+                          int64_t total) override {}
+
+  void OnDownloadData(CefRefPtr<CefURLRequest> request,
+                      const void* data,
+                      size_t data_length) override {
+    body_.append(static_cast<const char*>(data), data_length);
+  }
+
+  bool GetAuthCredentials(bool isProxy,
+                          const CefString& host,
+                          int port,
+                          const CefString& realm,
+                          const CefString& scheme,
+                          CefRefPtr<CefAuthCallback> callback) override {
+    return false;
+  }
+
+ private:
+  std::function<void(std::optional<bool>)> callback_;
+  std::string body_;
+
+  IMPLEMENT_REFCOUNTING(StateRequestClient);
+};
+
+}  // namespace
+
+std::optional<bool> game_state::is_gameplay(std::string_view v2_response) {
+  const auto json = nlohmann::json::parse(v2_response, nullptr, false);
+  if (!json.is_object()) {
+    return std::nullopt;
+  }
+
+  const auto state = json.value("state", nlohmann::json::object());
+  if (!state.is_object() || !state.contains("number")) {
+    return std::nullopt;
+  }
+
+  return state.value("number", -1) == play;
+}
+
+void game_state::request_is_gameplay(
+    std::function<void(std::optional<bool>)> callback) {
+  CEF_REQUIRE_UI_THREAD();
+
+  auto request = CefRequest::Create();
+  request->SetURL("http://" + state::host + ":" + state::port + "/json/v2");
+  request->SetMethod("GET");
+  request->SetFlags(UR_FLAG_SKIP_CACHE);
+
+  CefURLRequest::Create(request, new StateRequestClient(std::move(callback)),
+                        nullptr);
+}
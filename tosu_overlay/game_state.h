@@ -0,0 +1,22 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string_view>
+
+// What osu! is doing, as reported by tosu's /json/v2 endpoint. Used to put
+// off disruptive work (renderer recycling) until the player isn't playing.
+namespace game_state {
+
+// osu!'s GameState value for gameplay, including multiplayer.
+constexpr int play = 2;
+
+// Whether a /json/v2 response says osu! is in gameplay, nullopt when the
+// response doesn't carry a state.
+std::optional<bool> is_gameplay(std::string_view v2_response);
+
+// Asks tosu, the callback runs on the CEF UI thread with nullopt when tosu
+// couldn't be reached. CEF UI thread only.
+void request_is_gameplay(std::function<void(std::optional<bool>)> callback);
+
+}  // namespace game_state
@@ -0,0 +1,150 @@
+#include <tosu_overlay/hotkeys.h>
+#include <tosu_overlay/modifiers.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+struct KeyName {
+  std::string_view name;
+  uint8_t key;
+};
+
+constexpr KeyName key_names[] = {
+    {"ctrl", VK_CONTROL},     {"control", VK_CONTROL},
+    {"lctrl", VK_LCONTROL},   {"rctrl", VK_RCONTROL},
+    {"shift", VK_SHIFT},      {"lshift", VK_LSHIFT},
+    {"rshift", VK_RSHIFT},    {"alt", VK_MENU},
+    {"lalt", VK_LMENU},       {"ralt", VK_RMENU},
+    {"win", VK_LWIN},         {"lwin", VK_LWIN},
+    {"rwin", VK_RWIN},        {"space", VK_SPACE},
+    {"tab", VK_TAB},          {"enter", VK_RETURN},
+    {"esc", VK_ESCAPE},       {"escape", VK_ESCAPE},
+    {"backspace", VK_BACK},   {"insert", VK_INSERT},
+    {"delete", VK_DELETE},    {"home", VK_HOME},
+    {"end", VK_END},          {"pageup", VK_PRIOR},
+    {"pagedown", VK_NEXT},    {"up", VK_UP},
+    {"down", VK_DOWN},        {"left", VK_LEFT},
+    {"right", VK_RIGHT},      {"pause", VK_PAUSE},
+};
+
+std::string to_lower(std::string_view text) {
+  std::string result(text);
+  std::transform(result.begin(), result.end(), result.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+bool is_space(char c) {
+  return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && is_space(text.front()))
+    text.remove_prefix(1);
+  while (!text.empty() && is_space(text.back()))
+    text.remove_suffix(1);
+  return text;
+}
+
+std::optional<uint8_t> parse_key(std::string_view text) {
+  const auto name = to_lower(trim(text));
+
+  for (const auto& entry : key_names) {
+    if (entry.name == name) {
+      return entry.key;
+    }
+  }
+
+  // single letters and digits map onto their ASCII virtual-key codes
+  if (name.size() == 1 && std::isalnum(static_cast<unsigned char>(name[0]))) {
+    return static_cast<uint8_t>(std::toupper(name[0]));
+  }
+
+  if (name.size() >= 2 && name[0] == 'f') {
+    const auto number = std::atoi(name.c_str() + 1);
+    if (number >= 1 && number <= 24) {
+      return static_cast<uint8_t>(VK_F1 + number - 1);
+    }
+  }
+
+  if (name.size() == 7 && name.rfind("numpad", 0) == 0 &&
+      std::isdigit(static_cast<unsigned char>(name[6]))) {
+    return static_cast<uint8_t>(VK_NUMPAD0 + (name[6] - '0'));
+  }
+
+  return std::nullopt;
+}
+
+}  // namespace
+
+std::optional<hotkeys::Chord> hotkeys::parse_chord(std::string_view text) {
+  Chord chord;
+
+  while (!text.empty()) {
+    const auto separator = text.find('+');
+    const auto part = text.substr(0, separator);
+
+    const auto key = parse_key(part);
+    if (!key) {
+      return std::nullopt;
+    }
+
+    chord.keys.push_back(*key);
+
+    if (separator == std::string_view::npos) {
+      break;
+    }
+
+    text.remove_prefix(separator + 1);
+  }
+
+  if (chord.keys.empty()) {
+    return std::nullopt;
+  }
+
+  return chord;
+}
+
+void hotkeys::Bindings::bind(Action action, Chord chord) {
+  bindings_.push_back({action, std::move(chord)});
+}
+
+void hotkeys::Bindings::clear() {
+  bindings_.clear();
+}
+
+std::optional<hotkeys::Action> hotkeys::Bindings::on_key_message(
+    UINT msg,
+    WPARAM wparam,
+    LPARAM lparam) const {
+  // bit 30 is the previous key state, set for auto-repeat
+  const bool repeat = ((lparam >> 30) & 1) != 0;
+  if ((msg != WM_KEYDOWN && msg != WM_SYSKEYDOWN) || repeat || wparam > 0xFF) {
+    return std::nullopt;
+  }
+
+  const auto key = static_cast<uint8_t>(wparam);
+  const auto sided_key = modifiers::side_specific_key(wparam, lparam);
+
+  for (const auto& binding : bindings_) {
+    const auto& keys = binding.chord.keys;
+    const bool completes =
+        std::find(keys.begin(), keys.end(), key) != keys.end() ||
+        std::find(keys.begin(), keys.end(), sided_key) != keys.end();
+
+    if (completes && is_held(binding.chord)) {
+      return binding.action;
+    }
+  }
+
+  return std::nullopt;
+}
+
+bool hotkeys::Bindings::is_held(const Chord& chord) const {
+  return std::all_of(chord.keys.begin(), chord.keys.end(),
+                     [this](uint8_t key) { return keys_->down(key); });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace modifiers {
+class Tracker;
+}
+
+// Hotkey chords detected from the keyboard messages the input hooks already
+// see, so nothing has to poll GetAsyncKeyState.
+namespace hotkeys {
+
+enum class Action {
+  toggle_edit_mode,
+  toggle_visibility,
+  reload,
+};
+
+// Virtual keys that all have to be held. Side-specific keys (VK_LSHIFT, ...)
+// only match that side, generic ones (VK_SHIFT, ...) match either.
+struct Chord {
+  std::vector<uint8_t> keys;
+};
+
+// Parses "LCtrl+LShift+Space" style chords, case-insensitive. Returns nullopt
+// for empty or unknown key names.
+std::optional<Chord> parse_chord(std::string_view text);
+
+// Which keys are held comes from the modifiers::Tracker the hooks already
+// keep, so the two never disagree.
+class Bindings {
+ public:
+  explicit Bindings(const modifiers::Tracker* keys) : keys_(keys) {}
+
+  void bind(Action action, Chord chord);
+  void clear();
+
+  // Feeds a WM_(SYS)KEYDOWN / WM_(SYS)KEYUP message the tracker has already
+  // seen. Returns the action whose chord this key press just completed,
+  // auto-repeat never triggers.
+  std::optional<Action> on_key_message(UINT msg,
+                                       WPARAM wparam,
+                                       LPARAM lparam) const;
+
+ private:
+  struct Binding {
+    Action action;
+    Chord chord;
+  };
+
+  bool is_held(const Chord& chord) const;
+
+  const modifiers::Tracker* keys_;
+  std::vector<Binding> bindings_;
+};
+
+}  // namespace hotkeys
@@ -0,0 +1,247 @@
+#include <tosu_overlay/http_probe.h>
+#include <tosu_overlay/latency.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+std::string request_for(const std::string& host,
+                        const std::string& port,
+                        const std::string& path,
+                        const http_probe::Headers& headers) {
+  auto request = "GET " + path + " HTTP/1.1\r\nHost: " + host + ":" + port +
+                 "\r\nConnection: close\r\n";
+  for (const auto& [name, value] : headers) {
+    request += name + ": " + value + "\r\n";
+  }
+  return request + "\r\n";
+}
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+std::string lower(std::string_view text) {
+  std::string result(text);
+  std::transform(result.begin(), result.end(), result.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+// Appends the decoded chunks to body, false while the last chunk is missing.
+bool dechunk(std::string_view raw, std::string& body) {
+  while (true) {
+    const auto line_end = raw.find("\r\n");
+    if (line_end == std::string_view::npos) {
+      return false;
+    }
+
+    const auto size_text = std::string(raw.substr(0, line_end));
+    const auto size = std::strtoull(size_text.c_str(), nullptr, 16);
+    raw.remove_prefix(line_end + 2);
+
+    if (size == 0) {
+      return true;
+    }
+    if (raw.size() < size + 2) {
+      return false;
+    }
+
+    body.append(raw.substr(0, size));
+    raw.remove_prefix(size + 2);
+  }
+}
+
+// Status and headers, and where the body starts.
+std::optional<std::pair<http_probe::Response, size_t>> parse_head(
+    std::string_view raw) {
+  const auto head_end = raw.find("\r\n\r\n");
+  if (head_end == std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  http_probe::Response response;
+
+  auto head = raw.substr(0, head_end + 2);
+  const auto status_end = head.find("\r\n");
+  response.status = http_probe::parse_status_line(head.substr(0, status_end));
+  if (response.status == 0) {
+    return std::nullopt;
+  }
+  head.remove_prefix(status_end + 2);
+
+  while (!head.empty()) {
+    const auto line_end = head.find("\r\n");
+    const auto line = head.substr(0, line_end);
+    head.remove_prefix(line_end + 2);
+
+    const auto colon = line.find(':');
+    if (colon != std::string_view::npos) {
+      response.headers[lower(trim(line.substr(0, colon)))] =
+          std::string(trim(line.substr(colon + 1)));
+    }
+  }
+
+  return std::make_pair(std::move(response), head_end + 4);
+}
+
+enum class BodyKind {
+  none,
+  chunked,
+  sized,
+  until_close,
+};
+
+BodyKind body_kind(const http_probe::Response& response) {
+  if (response.status < 200 || response.status == 204 ||
+      response.status == 304) {
+    return BodyKind::none;
+  }
+  if (lower(response.header("transfer-encoding")) == "chunked") {
+    return BodyKind::chunked;
+  }
+  if (!response.header("content-length").empty()) {
+    return BodyKind::sized;
+  }
+  return BodyKind::until_close;
+}
+
+// Whether all of the response arrived, without decoding the body.
+bool response_complete(std::string_view raw) {
+  const auto head = parse_head(raw);
+  if (!head) {
+    return false;
+  }
+
+  const auto& [response, body_offset] = *head;
+  switch (body_kind(response)) {
+    case BodyKind::none:
+      return true;
+
+    case BodyKind::chunked: {
+      constexpr std::string_view last_chunk = "0\r\n\r\n";
+      return raw.size() >= body_offset + last_chunk.size() &&
+             raw.substr(raw.size() - last_chunk.size()) == last_chunk;
+    }
+
+    case BodyKind::sized:
+      return raw.size() - body_offset >=
+             std::strtoull(response.header("content-length").c_str(), nullptr,
+                           10);
+
+    case BodyKind::until_close:
+      return false;
+  }
+
+  return false;
+}
+
+}  // namespace
+
+std::string http_probe::Response::header(const std::string& name) const {
+  const auto it = headers.find(name);
+  return it == headers.end() ? std::string() : it->second;
+}
+
+http_probe::Result http_probe::get(const std::string& host,
+                                   const std::string& port,
+                                   const std::string& path,
+                                   int timeout_ms) {
+  const auto start = latency::now_us();
+
+  const auto received =
+      exchange(host, port, request_for(host, port, path, {}), timeout_ms,
+               [](const std::string& received) {
+                 return received.find("\r\n") != std::string::npos;
+               });
+  const auto line = std::string_view(received).substr(0, received.find("\r\n"));
+
+  return {parse_status_line(line), latency::now_us() - start};
+}
+
+http_probe::Response http_probe::fetch(const std::string& host,
+                                       const std::string& port,
+                                       const std::string& path,
+                                       const Headers& headers,
+                                       int timeout_ms) {
+  const auto received =
+      exchange(host, port, request_for(host, port, path, headers), timeout_ms,
+               [](const std::string& received) {
+                 return response_complete(received);
+               });
+
+  return parse_response(received, true).value_or(Response{});
+}
+
+int http_probe::parse_status_line(std::string_view line) {
+  constexpr std::string_view prefix = "HTTP/";
+  if (line.substr(0, prefix.size()) != prefix) {
+    return 0;
+  }
+
+  const auto space = line.find(' ');
+  if (space == std::string_view::npos || line.size() < space + 4) {
+    return 0;
+  }
+
+  int status = 0;
+  for (size_t i = space + 1; i < space + 4; ++i) {
+    if (line[i] < '0' || line[i] > '9') {
+      return 0;
+    }
+    status = status * 10 + (line[i] - '0');
+  }
+
+  return status;
+}
+
+std::optional<http_probe::Response> http_probe::parse_response(
+    std::string_view raw,
+    bool closed) {
+  auto head = parse_head(raw);
+  if (!head) {
+    return std::nullopt;
+  }
+
+  auto& [response, body_offset] = *head;
+  const auto body = raw.substr(body_offset);
+
+  switch (body_kind(response)) {
+    case BodyKind::none:
+      return response;
+
+    case BodyKind::chunked:
+      if (!dechunk(body, response.body)) {
+        return std::nullopt;
+      }
+      return response;
+
+    case BodyKind::sized: {
+      const auto size =
+          std::strtoull(response.header("content-length").c_str(), nullptr, 10);
+      if (body.size() < size) {
+        return std::nullopt;
+      }
+      response.body = body.substr(0, size);
+      return response;
+    }
+
+    case BodyKind::until_close:
+      break;
+  }
+
+  if (!closed) {
+    return std::nullopt;
+  }
+
+  response.body = body;
+  return response;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Blocking HTTP/1.1 GETs against tosu's server, for work that has to happen
+// without (or before) CEF: checking whether tosu answers before creating a
+// browser for it, revalidating cached assets while CEF initializes. Call
+// these from a thread that may block (TID_FILE_USER_VISIBLE or a worker),
+// never the UI thread.
+namespace http_probe {
+
+struct Result {
+  // 0 when the server couldn't be reached or didn't answer HTTP
+  int status;
+  int64_t elapsed_us;
+};
+
+// Only reads the status line.
+Result get(const std::string& host,
+           const std::string& port,
+           const std::string& path,
+           int timeout_ms);
+
+struct Response {
+  // 0 when the server couldn't be reached or didn't answer HTTP
+  int status = 0;
+  // names lower-cased
+  std::map<std::string, std::string> headers;
+  // decoded when chunked
+  std::string body;
+
+  std::string header(const std::string& name) const;
+};
+
+using Headers = std::vector<std::pair<std::string, std::string>>;
+
+// Reads the whole response, headers are added to the request.
+Response fetch(const std::string& host,
+               const std::string& port,
+               const std::string& path,
+               const Headers& headers,
+               int timeout_ms);
+
+// "HTTP/1.1 200 OK" -> 200, 0 when it isn't a status line.
+int parse_status_line(std::string_view line);
+
+// The response in raw once all of it arrived (Content-Length, chunked, or
+// no body for 1xx/204/304), nullopt before. A response without a length
+// ends when the connection closes, closed says whether it did.
+std::optional<Response> parse_response(std::string_view raw, bool closed);
+
+// Platform layer, http_probe_win.cc and http_probe_posix.cc: connects,
+// sends request and collects what comes back until complete says it's
+// enough, the server closes the connection or nothing arrives for
+// timeout_ms. Empty when the connection failed.
+using Complete = std::function<bool(const std::string& received)>;
+std::string exchange(const std::string& host,
+                     const std::string& port,
+                     const std::string& request,
+                     int timeout_ms,
+                     const Complete& complete);
+
+}  // namespace http_probe
@@ -0,0 +1,79 @@
+#include <tosu_overlay/http_probe.h>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace {
+
+bool wait_for(int socket, short events, int timeout_ms) {
+  pollfd fd{socket, events, 0};
+  return poll(&fd, 1, timeout_ms) == 1 && (fd.revents & events);
+}
+
+bool connect_with_timeout(int socket,
+                          const addrinfo* address,
+                          int timeout_ms) {
+  fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+
+  if (connect(socket, address->ai_addr, address->ai_addrlen) == 0) {
+    return true;
+  }
+  if (errno != EINPROGRESS || !wait_for(socket, POLLOUT, timeout_ms)) {
+    return false;
+  }
+
+  int error = 0;
+  socklen_t length = sizeof(error);
+  return getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) == 0 &&
+         error == 0;
+}
+
+}  // namespace
+
+std::string http_probe::exchange(const std::string& host,
+                                 const std::string& port,
+                                 const std::string& request,
+                                 int timeout_ms,
+                                 const Complete& complete) {
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return {};
+  }
+
+  std::string received;
+  for (auto address = addresses; address && received.empty();
+       address = address->ai_next) {
+    const int fd =
+        socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+
+    if (connect_with_timeout(fd, address, timeout_ms) &&
+        send(fd, request.data(), request.size(), MSG_NOSIGNAL) ==
+            static_cast<ssize_t>(request.size())) {
+      char buffer[4096];
+      while (!complete(received) && wait_for(fd, POLLIN, timeout_ms)) {
+        const auto length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+          break;
+        }
+        received.append(buffer, static_cast<size_t>(length));
+      }
+    }
+
+    close(fd);
+  }
+
+  freeaddrinfo(addresses);
+  return received;
+}
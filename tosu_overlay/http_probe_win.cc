@@ -0,0 +1,89 @@
+#include <tosu_overlay/http_probe.h>
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <mutex>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace {
+
+std::once_flag winsock_flag;
+
+bool wait_for(SOCKET socket, short events, int timeout_ms) {
+  WSAPOLLFD fd{socket, events, 0};
+  return WSAPoll(&fd, 1, timeout_ms) == 1 && (fd.revents & events);
+}
+
+bool connect_with_timeout(SOCKET socket,
+                          const addrinfo* address,
+                          int timeout_ms) {
+  u_long non_blocking = 1;
+  ioctlsocket(socket, FIONBIO, &non_blocking);
+
+  if (connect(socket, address->ai_addr,
+              static_cast<int>(address->ai_addrlen)) == 0) {
+    return true;
+  }
+  if (WSAGetLastError() != WSAEWOULDBLOCK ||
+      !wait_for(socket, POLLWRNORM, timeout_ms)) {
+    return false;
+  }
+
+  int error = 0;
+  int length = sizeof(error);
+  return getsockopt(socket, SOL_SOCKET, SO_ERROR,
+                    reinterpret_cast<char*>(&error), &length) == 0 &&
+         error == 0;
+}
+
+}  // namespace
+
+std::string http_probe::exchange(const std::string& host,
+                                 const std::string& port,
+                                 const std::string& request,
+                                 int timeout_ms,
+                                 const Complete& complete) {
+  std::call_once(winsock_flag, [] {
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+  });
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return {};
+  }
+
+  std::string received;
+  for (auto address = addresses; address && received.empty();
+       address = address->ai_next) {
+    const auto fd =
+        socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd == INVALID_SOCKET) {
+      continue;
+    }
+
+    if (connect_with_timeout(fd, address, timeout_ms) &&
+        send(fd, request.data(), static_cast<int>(request.size()), 0) ==
+            static_cast<int>(request.size())) {
+      char buffer[4096];
+      while (!complete(received) && wait_for(fd, POLLRDNORM, timeout_ms)) {
+        const auto length = recv(fd, buffer, sizeof(buffer), 0);
+        if (length <= 0) {
+          break;
+        }
+        received.append(buffer, static_cast<size_t>(length));
+      }
+    }
+
+    closesocket(fd);
+  }
+
+  freeaddrinfo(addresses);
+  return received;
+}
@@ -1,9 +1,28 @@
 #include <Windows.h>
+#include <tosu_overlay/alpha_mask.h>
+#include <tosu_overlay/canvas.h>
+#include <tosu_overlay/config.h>
+#include <tosu_overlay/hotkeys.h>
 #include <tosu_overlay/input.h>
+#include <tosu_overlay/input_dispatcher.h>
+#include <tosu_overlay/input_record.h>
+#include <tosu_overlay/input_translator.h>
+#include <tosu_overlay/latency.h>
 #include <tosu_overlay/logger.h>
+#include <tosu_overlay/modifiers.h>
+#include <tosu_overlay/pointer_win.h>
 #include <tosu_overlay/tosu_overlay_handler.h>
 #include <windowsx.h>
-#include <thread>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "include/base/cef_callback.h"
+#include "include/wrapper/cef_closure_task.h"
 
 // Thanks !!! :D
 // https://github.com/ONLYOFFICE/desktop-sdk/blob/master/ChromiumBasedEditors/lib/src/cef/windows/tests/cefclient/browser/osr_window_win.cc
@@ -13,291 +32,547 @@ namespace {
 bool edit_mode = false;
 uint32_t main_thread;
 
-int last_click_x_;
-int last_click_y_;
-CefBrowserHost::MouseButtonType last_click_button_;
-int last_click_count_;
-double last_click_time_;
-float device_scale_factor_ = 1.0f;
-
 HWND window_handle = 0;
 
+// Swapped by input::set_browser on the UI thread when the renderer is
+// recycled, read from both threads.
+std::mutex browser_lock;
 CefRefPtr<CefBrowser> cef_browser;
 
-int DeviceToLogical(int value, float device_scale_factor) {
-  float scaled_val = static_cast<float>(value) / device_scale_factor;
-  return static_cast<int>(std::floor(scaled_val));
+CefRefPtr<CefBrowser> current_browser() {
+  std::lock_guard lock(browser_lock);
+  return cef_browser;
 }
 
-void DeviceToLogical(CefMouseEvent& value, float device_scale_factor) {
-  value.x = DeviceToLogical(value.x, device_scale_factor);
-  value.y = DeviceToLogical(value.y, device_scale_factor);
+// 32-bit builds read input through the WH_GETMESSAGE hook, 64-bit ones
+// through the WndProc, so each only watches for hotkeys on its own path.
+constexpr bool reads_wnd_proc = sizeof(void*) == 8;
+
+// Edit mode only claims mouse input over visible parts of the overlay, the
+// rest goes to the game. Buttons pressed over the overlay keep it claimed
+// until they are released, so drags and releases stay paired.
+bool passthrough_enabled = true;
+int overlay_buttons = 0;
+bool hovering_overlay = false;
+
+// Pen and touch come in as WM_POINTER* messages, see pointer.h. Contacts
+// that go down over the overlay stay claimed until they lift.
+bool pointer_enabled = true;
+std::unique_ptr<pointer::Win32Source> pointer_source;
+pointer::Translator pointer_translator;
+std::vector<uint32_t> claimed_pointers;
+
+// Decision the WH_GETMESSAGE hook made for the message about to be dispatched
+// to wnd_proc_hk on 32-bit builds.
+struct Claim {
+  UINT msg;
+  WPARAM wparam;
+  LPARAM lparam;
+  bool claimed;
+} last_claim = {};
+
+// Where a key message goes besides the hotkey handling.
+enum class KeyRoute {
+  // the usual: the page in edit mode, the game otherwise
+  normal,
+  // part of a hotkey press: the game only
+  game,
+  // part of a hotkey press: nowhere
+  swallow,
+};
+
+// The press that fired a hotkey. Its repeats, characters and release stay
+// away from the page, and reach the game only if edit mode was off when the
+// press started, like any key then, so the game sees whole presses.
+struct HotkeyPress {
+  WPARAM vkey;
+  UINT scan_code;
+  KeyRoute route;
+};
+std::optional<HotkeyPress> hotkey_press;
+
+// KeyRoute the WH_GETMESSAGE hook picked for the message about to be
+// dispatched to wnd_proc_hk on 32-bit builds.
+struct KeyClaim {
+  UINT msg;
+  WPARAM wparam;
+  LPARAM lparam;
+  KeyRoute route;
+} last_key_route = {};
+
+// Edit-mode keyboard and mouse messages, written when "input_record_path"
+// is set so the session can be replayed by the bench.
+std::ofstream input_record;
+
+void record_message(UINT msg, WPARAM wparam, LPARAM lparam, LONG time) {
+  if (input_record.is_open() && input::is_recorded_message(msg)) {
+    input::write_record(input_record, {msg, wparam, lparam, time});
+  }
 }
 
-bool IsKeyDown(WPARAM wparam) {
-  return (GetKeyState(wparam) & 0x8000) != 0;
+// Modifiers come from the key messages the hooks see instead of a
+// GetKeyState call per event. Game message thread only.
+modifiers::Tracker modifier_state;
+
+// Only touched from the game's message thread (wnd_proc_hk / get_message).
+hotkeys::Bindings bindings(&modifier_state);
+
+// Clicks, key presses and touch presses are what edit-mode latency is
+// measured on, moves and releases would mostly measure the coalescing.
+bool is_latency_probe(const input::Event& event) {
+  switch (event.type) {
+    case input::Event::Type::mouse_click:
+      return !event.mouse_up;
+    case input::Event::Type::key:
+      return event.key_type == KEYEVENT_RAWKEYDOWN;
+    case input::Event::Type::touch:
+      return event.touch_type == CEF_TET_PRESSED;
+    default:
+      return false;
+  }
 }
 
-int GetCefMouseModifiers(WPARAM wparam) {
-  int modifiers = 0;
-  if (wparam & MK_CONTROL)
-    modifiers |= EVENTFLAG_CONTROL_DOWN;
-  if (wparam & MK_SHIFT)
-    modifiers |= EVENTFLAG_SHIFT_DOWN;
-  if (IsKeyDown(VK_MENU))
-    modifiers |= EVENTFLAG_ALT_DOWN;
-  if (wparam & MK_LBUTTON)
-    modifiers |= EVENTFLAG_LEFT_MOUSE_BUTTON;
-  if (wparam & MK_MBUTTON)
-    modifiers |= EVENTFLAG_MIDDLE_MOUSE_BUTTON;
-  if (wparam & MK_RBUTTON)
-    modifiers |= EVENTFLAG_RIGHT_MOUSE_BUTTON;
-
-  // Low bit set from GetKeyState indicates "toggled".
-  if (::GetKeyState(VK_NUMLOCK) & 1)
-    modifiers |= EVENTFLAG_NUM_LOCK_ON;
-  if (::GetKeyState(VK_CAPITAL) & 1)
-    modifiers |= EVENTFLAG_CAPS_LOCK_ON;
-  return modifiers;
+// Hands dispatched events to the browser, runs on the CEF UI thread.
+class BrowserSink : public input::EventSink {
+ public:
+  void send(const input::Event& event) override {
+    const auto browser = current_browser();
+    if (!browser) {
+      return;
+    }
+
+    forward(browser->GetHost(), event);
+
+    if (is_latency_probe(event)) {
+      latency::dispatched(event.timestamp_us);
+    }
+  }
+
+ private:
+  void forward(CefRefPtr<CefBrowserHost> browser_host,
+               const input::Event& event) {
+
+    if (event.type == input::Event::Type::touch) {
+      CefTouchEvent touch_event;
+      touch_event.id = event.touch_id;
+      touch_event.x = static_cast<float>(event.x);
+      touch_event.y = static_cast<float>(event.y);
+      touch_event.radius_x = event.radius_x;
+      touch_event.radius_y = event.radius_y;
+      touch_event.rotation_angle = 0;
+      touch_event.pressure = event.pressure;
+      touch_event.type = static_cast<cef_touch_event_type_t>(event.touch_type);
+      touch_event.modifiers = event.modifiers;
+      touch_event.pointer_type =
+          static_cast<cef_pointer_type_t>(event.pointer_type);
+      browser_host->SendTouchEvent(touch_event);
+      return;
+    }
+
+    if (event.type == input::Event::Type::key) {
+      CefKeyEvent key_event;
+      key_event.type = static_cast<cef_key_event_type_t>(event.key_type);
+      key_event.windows_key_code = event.windows_key_code;
+      key_event.native_key_code = event.native_key_code;
+      key_event.is_system_key = event.is_system_key;
+      key_event.modifiers = event.modifiers;
+      browser_host->SendKeyEvent(key_event);
+      return;
+    }
+
+    CefMouseEvent mouse_event;
+    mouse_event.x = event.x;
+    mouse_event.y = event.y;
+    mouse_event.modifiers = event.modifiers;
+
+    switch (event.type) {
+      case input::Event::Type::mouse_move:
+      case input::Event::Type::mouse_leave:
+        browser_host->SendMouseMoveEvent(
+            mouse_event, event.type == input::Event::Type::mouse_leave);
+        break;
+      case input::Event::Type::mouse_click:
+        browser_host->SendMouseClickEvent(
+            mouse_event,
+            static_cast<CefBrowserHost::MouseButtonType>(event.button),
+            event.mouse_up, event.click_count);
+        break;
+      case input::Event::Type::mouse_wheel:
+        browser_host->SendMouseWheelEvent(mouse_event, event.delta_x,
+                                          event.delta_y);
+        break;
+      default:
+        break;
+    }
+  }
+};
+
+// The hooks only translate and push, everything that talks to CEF happens
+// in batches on the CEF UI thread.
+BrowserSink browser_sink;
+input::Dispatcher dispatcher(&browser_sink);
+
+// CEF UI thread only.
+bool motion_flush_scheduled = false;
+int64_t last_motion_flush_us = 0;
+int64_t motion_flush_interval_us = 16666;
+int64_t last_stats_us = 0;
+constexpr int64_t stats_interval_us = 10'000'000;
+
+void log_dispatch_stats(int64_t now) {
+  if (now - last_stats_us < stats_interval_us) {
+    return;
+  }
+
+  last_stats_us = now;
+
+  const auto stats = dispatcher.take_stats();
+  if (stats.pushed == 0) {
+    return;
+  }
+
+  logger::log(
+      "Input: %llu events (%llu dropped) in %llu batches, %llu sent, max "
+      "depth %zu, latency avg %lld us max %lld us",
+      stats.pushed, stats.dropped, stats.batches, stats.dispatched,
+      stats.max_depth,
+      stats.latency_total_us /
+          static_cast<int64_t>(std::max<uint64_t>(stats.latency_samples, 1)),
+      stats.latency_max_us);
+
+  const auto report = latency::take_report();
+  if (!report.empty()) {
+    logger::log("Input to screen latency:\n%s", report.c_str());
+  }
 }
 
-int GetCefKeyboardModifiers(WPARAM wparam, LPARAM lparam) {
-  int modifiers = 0;
-  if (IsKeyDown(VK_SHIFT))
-    modifiers |= EVENTFLAG_SHIFT_DOWN;
-  if (IsKeyDown(VK_CONTROL))
-    modifiers |= EVENTFLAG_CONTROL_DOWN;
-  if (IsKeyDown(VK_MENU))
-    modifiers |= EVENTFLAG_ALT_DOWN;
-
-  // Low bit set from GetKeyState indicates "toggled".
-  if (::GetKeyState(VK_NUMLOCK) & 1)
-    modifiers |= EVENTFLAG_NUM_LOCK_ON;
-  if (::GetKeyState(VK_CAPITAL) & 1)
-    modifiers |= EVENTFLAG_CAPS_LOCK_ON;
-
-  switch (wparam) {
-    case VK_RETURN:
-      if ((lparam >> 16) & KF_EXTENDED)
-        modifiers |= EVENTFLAG_IS_KEY_PAD;
-      break;
-    case VK_INSERT:
-    case VK_DELETE:
-    case VK_HOME:
-    case VK_END:
-    case VK_PRIOR:
-    case VK_NEXT:
-    case VK_UP:
-    case VK_DOWN:
-    case VK_LEFT:
-    case VK_RIGHT:
-      if (!((lparam >> 16) & KF_EXTENDED))
-        modifiers |= EVENTFLAG_IS_KEY_PAD;
-      break;
-    case VK_NUMLOCK:
-    case VK_NUMPAD0:
-    case VK_NUMPAD1:
-    case VK_NUMPAD2:
-    case VK_NUMPAD3:
-    case VK_NUMPAD4:
-    case VK_NUMPAD5:
-    case VK_NUMPAD6:
-    case VK_NUMPAD7:
-    case VK_NUMPAD8:
-    case VK_NUMPAD9:
-    case VK_DIVIDE:
-    case VK_MULTIPLY:
-    case VK_SUBTRACT:
-    case VK_ADD:
-    case VK_DECIMAL:
-    case VK_CLEAR:
-      modifiers |= EVENTFLAG_IS_KEY_PAD;
-      break;
-    case VK_SHIFT:
-      if (IsKeyDown(VK_LSHIFT))
-        modifiers |= EVENTFLAG_IS_LEFT;
-      else if (IsKeyDown(VK_RSHIFT))
-        modifiers |= EVENTFLAG_IS_RIGHT;
-      break;
-    case VK_CONTROL:
-      if (IsKeyDown(VK_LCONTROL))
-        modifiers |= EVENTFLAG_IS_LEFT;
-      else if (IsKeyDown(VK_RCONTROL))
-        modifiers |= EVENTFLAG_IS_RIGHT;
-      break;
-    case VK_MENU:
-      if (IsKeyDown(VK_LMENU))
-        modifiers |= EVENTFLAG_IS_LEFT;
-      else if (IsKeyDown(VK_RMENU))
-        modifiers |= EVENTFLAG_IS_RIGHT;
-      break;
-    case VK_LWIN:
-      modifiers |= EVENTFLAG_IS_LEFT;
-      break;
-    case VK_RWIN:
-      modifiers |= EVENTFLAG_IS_RIGHT;
-      break;
+void flush_motion() {
+  motion_flush_scheduled = false;
+
+  const auto now = latency::now_us();
+  dispatcher.flush_motion(now);
+  last_motion_flush_us = now;
+}
+
+void drain_input() {
+  const auto now = latency::now_us();
+  dispatcher.drain(now);
+
+  // moves and wheel deltas go out at most once per CEF frame
+  if (dispatcher.has_pending_motion() && !motion_flush_scheduled) {
+    motion_flush_scheduled = true;
+
+    const auto next_flush_us = last_motion_flush_us + motion_flush_interval_us;
+    const auto delay_ms = std::max<int64_t>(next_flush_us - now, 0) / 1000;
+    CefPostDelayedTask(TID_UI, base::BindOnce(&flush_motion), delay_ms);
   }
-  return modifiers;
+
+  log_dispatch_stats(now);
 }
 
-void on_mouse_event(UINT code, WPARAM wparam, LPARAM lparam) {
-  auto browser_host = cef_browser->GetHost();
-
-  LONG currentTime = 0;
-  bool cancelPreviousClick = false;
-
-  if (code == WM_LBUTTONDOWN || code == WM_RBUTTONDOWN ||
-      code == WM_MBUTTONDOWN || code == WM_MOUSEMOVE || code == WM_MOUSELEAVE) {
-    currentTime = GetMessageTime();
-    int x = GET_X_LPARAM(lparam);
-    int y = GET_Y_LPARAM(lparam);
-    cancelPreviousClick =
-        (abs(last_click_x_ - x) > (GetSystemMetrics(SM_CXDOUBLECLK) / 2)) ||
-        (abs(last_click_y_ - y) > (GetSystemMetrics(SM_CYDOUBLECLK) / 2)) ||
-        ((currentTime - last_click_time_) > GetDoubleClickTime());
-    if (cancelPreviousClick &&
-        (code == WM_MOUSEMOVE || code == WM_MOUSELEAVE)) {
-      last_click_count_ = 1;
-      last_click_x_ = 0;
-      last_click_y_ = 0;
-      last_click_time_ = 0;
-    }
+void push_event(input::Event event) {
+  event.timestamp_us = latency::now_us();
+
+  if (dispatcher.push(event)) {
+    CefPostTask(TID_UI, base::BindOnce(&drain_input));
+  }
+}
+
+class Win32System : public input::System {
+ public:
+  POINT screen_to_client(POINT point) override {
+    ScreenToClient(window_handle, &point);
+    return point;
   }
 
+  POINT cursor_position() override {
+    POINT point;
+    ::GetCursorPos(&point);
+    ::ScreenToClient(window_handle, &point);
+    return point;
+  }
+
+  bool is_window_at(POINT point) override {
+    return ::WindowFromPoint(point) == window_handle;
+  }
+
+  bool is_altgr_char(WPARAM character) override {
+    HKL current_layout = ::GetKeyboardLayout(0);
+
+    SHORT scan_res = ::VkKeyScanExW(character, current_layout);
+    constexpr auto ctrlAlt = (2 | 4);
+    return ((scan_res >> 8) & ctrlAlt) == ctrlAlt;  // ctrl-alt pressed
+  }
+};
+
+Win32System win32_system;
+input::Translator translator(&win32_system, &modifier_state);
+
+// Double-click metrics are cached since they are needed per mouse message.
+void refresh_system_metrics() {
+  translator.set_double_click(GetSystemMetrics(SM_CXDOUBLECLK),
+                              GetSystemMetrics(SM_CYDOUBLECLK),
+                              GetDoubleClickTime());
+}
+
+void on_mouse_event(UINT code, WPARAM wparam, LPARAM lparam) {
   switch (code) {
     case WM_LBUTTONDOWN:
     case WM_RBUTTONDOWN:
-    case WM_MBUTTONDOWN: {
+    case WM_MBUTTONDOWN:
       ::SetCapture(window_handle);
       ::SetFocus(window_handle);
-      int x = GET_X_LPARAM(lparam);
-      int y = GET_Y_LPARAM(lparam);
-
-      CefBrowserHost::MouseButtonType btnType =
-          (code == WM_LBUTTONDOWN
-               ? MBT_LEFT
-               : (code == WM_RBUTTONDOWN ? MBT_RIGHT : MBT_MIDDLE));
-      if (!cancelPreviousClick && (btnType == last_click_button_)) {
-        ++last_click_count_;
-      } else {
-        last_click_count_ = 1;
-        last_click_x_ = x;
-        last_click_y_ = y;
-      }
-      last_click_time_ = currentTime;
-      last_click_button_ = btnType;
-
-      CefMouseEvent mouse_event;
-      mouse_event.x = x;
-      mouse_event.y = y;
-      DeviceToLogical(mouse_event, device_scale_factor_);
-      mouse_event.modifiers = GetCefMouseModifiers(wparam);
-      browser_host->SendMouseClickEvent(mouse_event, btnType, false,
-                                        last_click_count_);
-    } break;
+      break;
 
     case WM_LBUTTONUP:
     case WM_RBUTTONUP:
-    case WM_MBUTTONUP: {
+    case WM_MBUTTONUP:
       if (GetCapture() == window_handle) {
         ReleaseCapture();
       }
-      int x = GET_X_LPARAM(lparam);
-      int y = GET_Y_LPARAM(lparam);
-      CefBrowserHost::MouseButtonType btnType =
-          (code == WM_LBUTTONUP
-               ? MBT_LEFT
-               : (code == WM_RBUTTONUP ? MBT_RIGHT : MBT_MIDDLE));
-      CefMouseEvent mouse_event;
-      mouse_event.x = x;
-      mouse_event.y = y;
-
-      DeviceToLogical(mouse_event, device_scale_factor_);
-      mouse_event.modifiers = GetCefMouseModifiers(wparam);
-      browser_host->SendMouseClickEvent(mouse_event, btnType, true,
-                                        last_click_count_);
+      break;
+  }
+
+  input::Event event;
+  if (translator.mouse(code, wparam, lparam, GetMessageTime(), event)) {
+    push_event(event);
+  }
+}
+
+int button_bit(UINT msg) {
+  switch (msg) {
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+      return 1;
+    case WM_RBUTTONDOWN:
+    case WM_RBUTTONUP:
+      return 2;
+    case WM_MBUTTONDOWN:
+    case WM_MBUTTONUP:
+      return 4;
+  }
+
+  return 0;
+}
+
+bool is_button_up(UINT msg) {
+  return msg == WM_LBUTTONUP || msg == WM_RBUTTONUP || msg == WM_MBUTTONUP;
+}
+
+// The mask keeps the last frame's tiles while the overlay is hidden, none
+// of them is there to click on then.
+bool overlay_at(POINT point) {
+  return canvas::is_visible() && alpha_mask::hit(point.x, point.y);
+}
+
+bool hits_overlay(UINT msg, LPARAM lparam) {
+  POINT point = {GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam)};
+
+  // wheel messages carry screen coordinates
+  if (msg == WM_MOUSEWHEEL) {
+    ScreenToClient(window_handle, &point);
+  }
+
+  return overlay_at(point);
+}
+
+// Decides whether a mouse message belongs to the overlay and updates the
+// hover/button state. Called once per message on the input reading path.
+bool claim_mouse_message(UINT msg, LPARAM lparam) {
+  if (!passthrough_enabled) {
+    return true;
+  }
+
+  const auto button = button_bit(msg);
+
+  if (is_button_up(msg) && (overlay_buttons & button)) {
+    overlay_buttons &= ~button;
+    return true;
+  }
+
+  if (msg == WM_MOUSELEAVE) {
+    const auto was_hovering = hovering_overlay;
+    hovering_overlay = false;
+    return was_hovering;
+  }
+
+  if (overlay_buttons != 0) {
+    return true;
+  }
+
+  const auto over_overlay = hits_overlay(msg, lparam);
+
+  if (over_overlay) {
+    hovering_overlay = true;
+    if (!is_button_up(msg)) {
+      overlay_buttons |= button;
     }
+  } else if (hovering_overlay && msg == WM_MOUSEMOVE) {
+    // moved onto a transparent area, let the page drop its hover state
+    hovering_overlay = false;
+    on_mouse_event(WM_MOUSELEAVE, 0, 0);
+  }
 
-    break;
+  return over_overlay;
+}
 
-    case WM_MOUSEMOVE: {
-      int x = GET_X_LPARAM(lparam);
-      int y = GET_Y_LPARAM(lparam);
+// Pointer messages carry screen coordinates.
+bool claim_pointer_message(UINT msg, WPARAM wparam, LPARAM lparam) {
+  const auto id = GET_POINTERID_WPARAM(wparam);
+  const auto held =
+      std::find(claimed_pointers.begin(), claimed_pointers.end(), id);
 
-      CefMouseEvent mouse_event;
-      mouse_event.x = x;
-      mouse_event.y = y;
+  if (held != claimed_pointers.end()) {
+    if (msg == WM_POINTERUP) {
+      claimed_pointers.erase(held);
+    }
+    return true;
+  }
 
-      DeviceToLogical(mouse_event, device_scale_factor_);
-      mouse_event.modifiers = GetCefMouseModifiers(wparam);
-      browser_host->SendMouseMoveEvent(mouse_event, false);
-    } break;
+  POINT point = {GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam)};
+  ScreenToClient(window_handle, &point);
 
-    case WM_MOUSELEAVE: {
-      POINT p;
-      ::GetCursorPos(&p);
-      ::ScreenToClient(window_handle, &p);
-
-      CefMouseEvent mouse_event;
-      mouse_event.x = p.x;
-      mouse_event.y = p.y;
-      DeviceToLogical(mouse_event, device_scale_factor_);
-      mouse_event.modifiers = GetCefMouseModifiers(wparam);
-      browser_host->SendMouseMoveEvent(mouse_event, true);
-    } break;
+  const auto over_overlay = !passthrough_enabled || overlay_at(point);
+  if (over_overlay && msg == WM_POINTERDOWN) {
+    claimed_pointers.push_back(id);
+  }
 
-    case WM_MOUSEWHEEL:
-      POINT screen_point = {GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam)};
-      HWND scrolled_wnd = ::WindowFromPoint(screen_point);
-      if (scrolled_wnd != window_handle) {
-        break;
-      }
+  return over_overlay;
+}
+
+void on_pointer_event(UINT msg, WPARAM wparam) {
+  if (msg == WM_POINTERDOWN) {
+    ::SetFocus(window_handle);
+  }
+
+  // pointer messages don't carry MK_* flags
+  WPARAM keys = 0;
+  if (modifier_state.down(VK_CONTROL))
+    keys |= MK_CONTROL;
+  if (modifier_state.down(VK_SHIFT))
+    keys |= MK_SHIFT;
+
+  pointer_translator.translate(
+      *pointer_source, GET_POINTERID_WPARAM(wparam),
+      translator.device_scale_factor(), modifier_state.mouse(keys),
+      [](const input::Event& event) { push_event(event); });
+}
 
-      ScreenToClient(window_handle, &screen_point);
-      int delta = GET_WHEEL_DELTA_WPARAM(wparam);
+void on_key_event(UINT code, WPARAM wparam, LPARAM lparam) {
+  input::Event event;
+  if (translator.key(code, wparam, lparam, event)) {
+    push_event(event);
+  }
+}
 
-      CefMouseEvent mouse_event;
-      mouse_event.x = screen_point.x;
-      mouse_event.y = screen_point.y;
+// Hotkeys fire on the game's message thread, what they do to the browser
+// runs on the CEF UI thread like the rest of the input, against whichever
+// browser is current by then. None while tosu is away.
+void post_edit_mode_message(bool started) {
+  if (const auto browser = current_browser()) {
+    browser->GetMainFrame()->ExecuteJavaScript(
+        started ? "window.postMessage('editingStarted')"
+                : "window.postMessage('editingEnded')",
+        "", 0);
+  }
+}
 
-      DeviceToLogical(mouse_event, device_scale_factor_);
-      mouse_event.modifiers = GetCefMouseModifiers(wparam);
-      browser_host->SendMouseWheelEvent(mouse_event,
-                                        IsKeyDown(VK_SHIFT) ? delta : 0,
-                                        !IsKeyDown(VK_SHIFT) ? delta : 0);
+void reload_browser() {
+  if (const auto browser = current_browser()) {
+    browser->ReloadIgnoreCache();
+  }
+}
+
+void on_hotkey(hotkeys::Action action) {
+  switch (action) {
+    case hotkeys::Action::toggle_edit_mode:
+      edit_mode = !edit_mode;
+      overlay_buttons = 0;
+      hovering_overlay = false;
+      claimed_pointers.clear();
+
+      CefPostTask(TID_UI, base::BindOnce(&post_edit_mode_message, edit_mode));
+      break;
+
+    case hotkeys::Action::toggle_visibility:
+      canvas::set_visible(!canvas::is_visible());
+      break;
+
+    case hotkeys::Action::reload:
+      CefPostTask(TID_UI, base::BindOnce(&reload_browser));
       break;
   }
 }
 
-void on_key_event(UINT code, WPARAM wparam, LPARAM lparam) {
-  CefKeyEvent event;
-  event.windows_key_code = wparam;
-  event.native_key_code = lparam;
-  event.is_system_key =
-      code == WM_SYSCHAR || code == WM_SYSKEYDOWN || code == WM_SYSKEYUP;
-
-  if (code == WM_KEYDOWN || code == WM_SYSKEYDOWN)
-    event.type = KEYEVENT_RAWKEYDOWN;
-  else if (code == WM_KEYUP || code == WM_SYSKEYUP)
-    event.type = KEYEVENT_KEYUP;
-  else
-    event.type = KEYEVENT_CHAR;
-
-  event.modifiers = GetCefKeyboardModifiers(wparam, lparam);
-
-  if ((event.type == KEYEVENT_CHAR) && IsKeyDown(VK_RMENU)) {
-    HKL current_layout = ::GetKeyboardLayout(0);
+// Keeps modifier state current and watches for hotkeys, for every key
+// message on the reading path whether or not edit mode is on. Messages that
+// belong to a press that triggered a hotkey are kept away from the page.
+KeyRoute observe_key_message(UINT msg, WPARAM wparam, LPARAM lparam) {
+  const auto scan_code = static_cast<UINT>((lparam >> 16) & 0xFF);
 
-    SHORT scan_res = ::VkKeyScanExW(wparam, current_layout);
-    constexpr auto ctrlAlt = (2 | 4);
-    if (((scan_res >> 8) & ctrlAlt) == ctrlAlt) {  // ctrl-alt pressed
-      event.modifiers &= ~(EVENTFLAG_CONTROL_DOWN | EVENTFLAG_ALT_DOWN);
-      event.modifiers |= EVENTFLAG_ALTGR_DOWN;
-    }
+  switch (msg) {
+    case WM_KEYDOWN:
+    case WM_KEYUP:
+    case WM_SYSKEYDOWN:
+    case WM_SYSKEYUP: {
+      modifier_state.on_key_message(msg, wparam, lparam);
+
+      const bool was_edit_mode = edit_mode;
+      if (auto action = bindings.on_key_message(msg, wparam, lparam)) {
+        on_hotkey(*action);
+        hotkey_press = HotkeyPress{
+            wparam, scan_code,
+            was_edit_mode ? KeyRoute::swallow : KeyRoute::game};
+        return hotkey_press->route;
+      }
+
+      if (hotkey_press && hotkey_press->vkey == wparam) {
+        const auto route = hotkey_press->route;
+        if (msg == WM_KEYUP || msg == WM_SYSKEYUP) {
+          hotkey_press.reset();
+        }
+        return route;
+      }
+    } break;
+
+    case WM_CHAR:
+    case WM_SYSCHAR:
+      if (hotkey_press && hotkey_press->scan_code == scan_code) {
+        return hotkey_press->route;
+      }
+      break;
   }
 
-  cef_browser->GetHost()->SendKeyEvent(event);
+  return KeyRoute::normal;
+}
+
+void load_bindings() {
+  const auto& json_data = ConfigManager::get_instance()->get_json_data();
+  const auto config = json_data.value("hotkeys", nlohmann::json::object());
+
+  const std::pair<const char*, hotkeys::Action> names[] = {
+      {"edit_mode", hotkeys::Action::toggle_edit_mode},
+      {"toggle_overlay", hotkeys::Action::toggle_visibility},
+      {"reload", hotkeys::Action::reload},
+  };
+
+  for (const auto& [name, action] : names) {
+    // edit mode keeps the old hard-coded chord when config.json predates it
+    const auto fallback = action == hotkeys::Action::toggle_edit_mode
+                              ? "LCtrl+LShift+Space"
+                              : "";
+    const auto text = config.value(name, std::string(fallback));
+    if (text.empty()) {
+      continue;
+    }
+
+    if (auto chord = hotkeys::parse_chord(text)) {
+      bindings.bind(action, *chord);
+      logger::log("Hotkey %s bound to %s", name, text.c_str());
+    } else {
+      logger::log("Unable to parse hotkey %s (%s)", name, text.c_str());
+    }
+  }
 }
 
 LONG_PTR original_wnd_proc = 0;
@@ -306,11 +581,40 @@ LRESULT __stdcall wnd_proc_hk(HWND hWnd,
                               UINT uMsg,
                               WPARAM wParam,
                               LPARAM lParam) {
-  if (!edit_mode) {
+  switch (uMsg) {
+    case WM_KILLFOCUS:
+      modifier_state.release_all();
+      hotkey_press.reset();
+      break;
+    case WM_SETFOCUS:
+      modifier_state.sync();
+      break;
+    case WM_SETTINGCHANGE:
+      refresh_system_metrics();
+      break;
+  }
+
+  auto key_route = KeyRoute::normal;
+  if constexpr (reads_wnd_proc) {
+    key_route = observe_key_message(uMsg, wParam, lParam);
+  } else if (last_key_route.msg == uMsg && last_key_route.wparam == wParam &&
+             last_key_route.lparam == lParam) {
+    key_route = last_key_route.route;
+  }
+
+  if (key_route == KeyRoute::swallow) {
+    return 0;
+  }
+
+  if (!edit_mode || key_route == KeyRoute::game) {
     return CallWindowProcW(reinterpret_cast<WNDPROC>(original_wnd_proc), hWnd,
                            uMsg, wParam, lParam);
   }
 
+  if constexpr (reads_wnd_proc) {
+    record_message(uMsg, wParam, lParam, GetMessageTime());
+  }
+
   switch (uMsg) {
     case WM_LBUTTONDOWN:
     case WM_RBUTTONDOWN:
@@ -320,18 +624,56 @@ LRESULT __stdcall wnd_proc_hk(HWND hWnd,
     case WM_MBUTTONUP:
     case WM_MOUSEMOVE:
     case WM_MOUSELEAVE:
-    case WM_MOUSEWHEEL:
-      if constexpr (sizeof(void*) == 8) {
-        on_mouse_event(uMsg, wParam, lParam);
+    case WM_MOUSEWHEEL: {
+      bool claimed = false;
+      if constexpr (reads_wnd_proc) {
+        claimed = claim_mouse_message(uMsg, lParam);
+        if (claimed) {
+          on_mouse_event(uMsg, wParam, lParam);
+        }
+      } else if (last_claim.msg == uMsg && last_claim.wparam == wParam &&
+                 last_claim.lparam == lParam) {
+        claimed = last_claim.claimed;
+      } else {
+        claimed = !passthrough_enabled || hits_overlay(uMsg, lParam);
       }
-      return 0;
+
+      if (claimed) {
+        return 0;
+      }
+    } break;
+    case WM_POINTERDOWN:
+    case WM_POINTERUP:
+    case WM_POINTERUPDATE:
+    case WM_POINTERLEAVE: {
+      if (!pointer_enabled) {
+        break;
+      }
+
+      // claimed messages never reach DefWindowProc, so Windows doesn't
+      // promote them to mouse messages for the game either
+      bool claimed = false;
+      if constexpr (reads_wnd_proc) {
+        claimed = claim_pointer_message(uMsg, wParam, lParam);
+        if (claimed) {
+          on_pointer_event(uMsg, wParam);
+        }
+      } else if (last_claim.msg == uMsg && last_claim.wparam == wParam &&
+                 last_claim.lparam == lParam) {
+        claimed = last_claim.claimed;
+      }
+
+      if (claimed) {
+        return 0;
+      }
+    } break;
     case WM_SYSCHAR:
     case WM_SYSKEYDOWN:
     case WM_SYSKEYUP:
     case WM_KEYDOWN:
     case WM_KEYUP:
     case WM_CHAR:
-      if constexpr (sizeof(void*) == 8) {
+      if constexpr (reads_wnd_proc) {
         on_key_event(uMsg, wParam, lParam);
       }
       return 0;
@@ -344,17 +686,27 @@ LRESULT __stdcall wnd_proc_hk(HWND hWnd,
 HHOOK original_get_message;
 
 LRESULT __stdcall get_message(int code, WPARAM wparam, LPARAM lparam) {
-  if (!edit_mode) {
+  if (code < 0 || wparam != PM_REMOVE) {
     return CallNextHookEx(original_get_message, code, wparam, lparam);
   }
 
-  if (wparam == PM_REMOVE) {
-    const auto msg_raw = reinterpret_cast<MSG*>(lparam);
+  const auto msg_raw = reinterpret_cast<MSG*>(lparam);
+
+  auto key_route = KeyRoute::normal;
+  if constexpr (!reads_wnd_proc) {
+    key_route =
+        observe_key_message(msg_raw->message, msg_raw->wParam, msg_raw->lParam);
+    last_key_route = {msg_raw->message, msg_raw->wParam, msg_raw->lParam,
+                      key_route};
+  }
 
+  if (edit_mode && key_route == KeyRoute::normal) {
     const auto msg = msg_raw->message;
     const auto w_param = msg_raw->wParam;
     const auto l_param = msg_raw->lParam;
 
+    record_message(msg, w_param, l_param, static_cast<LONG>(msg_raw->time));
+
     switch (msg) {
       case WM_LBUTTONDOWN:
       case WM_RBUTTONDOWN:
@@ -364,8 +716,24 @@ LRESULT __stdcall get_message(int code, WPARAM wparam, LPARAM lparam) {
       case WM_MBUTTONUP:
       case WM_MOUSEMOVE:
       case WM_MOUSELEAVE:
-      case WM_MOUSEWHEEL:
-        on_mouse_event(msg, w_param, l_param);
+      case WM_MOUSEWHEEL: {
+        const auto claimed = claim_mouse_message(msg, l_param);
+        last_claim = {msg, w_param, l_param, claimed};
+        if (claimed) {
+          on_mouse_event(msg, w_param, l_param);
+        }
+      } break;
+      case WM_POINTERDOWN:
+      case WM_POINTERUP:
+      case WM_POINTERUPDATE:
+      case WM_POINTERLEAVE:
+        if (pointer_enabled) {
+          const auto claimed = claim_pointer_message(msg, w_param, l_param);
+          last_claim = {msg, w_param, l_param, claimed};
+          if (claimed) {
+            on_pointer_event(msg, w_param);
+          }
+        }
         break;
       case WM_SYSCHAR:
       case WM_SYSKEYDOWN:
@@ -381,50 +749,34 @@ LRESULT __stdcall get_message(int code, WPARAM wparam, LPARAM lparam) {
   return CallNextHookEx(original_get_message, code, wparam, lparam);
 }
 
-void bindings_thread() {
-  bool last_states[3];
-
-  while (true) {
-    // ghetto way but whatever
-    const auto is_ctrl_down = GetAsyncKeyState(VK_LCONTROL) != 0;
-    const auto is_shift_down = GetAsyncKeyState(VK_LSHIFT) != 0;
-    const auto is_space_down = GetAsyncKeyState(VK_SPACE) != 0;
+}  // namespace
 
-    auto current_state = is_ctrl_down && is_shift_down && is_space_down;
-    auto last_state = last_states[0] && last_states[1] && last_states[2];
+void input::initialize(HWND hwnd, uint32_t main_thread_id) {
+  logger::log("Input parameters: %x %x", hwnd, main_thread_id);
 
-    if (current_state != last_state) {
-      if (current_state) {
-        auto script = edit_mode ? "window.postMessage('editingEnded')"
-                                : "window.postMessage('editingStarted')";
+  main_thread = main_thread_id;
+  window_handle = hwnd;
 
-        cef_browser->GetMainFrame()->ExecuteJavaScript(script, "", 0);
+  // coalesced motion goes out once per CEF frame
+  const auto& json_data = ConfigManager::get_instance()->get_json_data();
+  const auto fps = std::clamp<int64_t>(json_data.value("cef_fps", 60), 10, 120);
+  motion_flush_interval_us = 1'000'000 / fps;
 
-        edit_mode = !edit_mode;
-      }
-    }
+  modifier_state.sync();
+  refresh_system_metrics();
 
-    last_states[0] = is_ctrl_down;
-    last_states[1] = is_shift_down;
-    last_states[2] = is_space_down;
+  passthrough_enabled = json_data.value("edit_mode_passthrough", true);
 
-    Sleep(1);
+  const auto input_record_path =
+      json_data.value("input_record_path", std::string());
+  if (!input_record_path.empty()) {
+    input_record.open(input_record_path, std::ios_base::trunc);
   }
-}
-
-}  // namespace
-
-void input::initialize(HWND hwnd,
-                       uint32_t main_thread_id,
-                       CefRefPtr<CefBrowser> browser) {
-  logger::log("Input parameters: %x %x %x", hwnd, main_thread_id,
-              browser.get());
 
-  main_thread = main_thread_id;
-  window_handle = hwnd;
-  cef_browser = browser;
+  pointer_enabled = json_data.value("pointer_input", true);
+  pointer_source = std::make_unique<pointer::Win32Source>(hwnd);
 
-  if constexpr (sizeof(void*) == 4) {
+  if constexpr (!reads_wnd_proc) {
     logger::log("Initializing input data reading");
 
     // used for reading input data
@@ -446,5 +798,10 @@ void input::initialize(HWND hwnd,
 
   logger::log("WndProc set successfully");
 
-  std::thread(bindings_thread).detach();
+  load_bindings();
+}
+
+void input::set_browser(CefRefPtr<CefBrowser> browser) {
+  std::lock_guard lock(browser_lock);
+  cef_browser = browser;
 }
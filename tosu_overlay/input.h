@@ -4,8 +4,11 @@
 
 namespace input {
 
-void initialize(HWND hwnd,
-                uint32_t main_thread_id,
-                CefRefPtr<CefBrowser> browser);
+void initialize(HWND hwnd, uint32_t main_thread_id);
+
+// Points input at the overlay browser, set by SimpleHandler as browsers come
+// and go (tosu reconnecting, renderer recycling). Null drops input meant for
+// the overlay.
+void set_browser(CefRefPtr<CefBrowser> browser);
 
 }  // namespace input
@@ -0,0 +1,120 @@
+#include <tosu_overlay/input_dispatcher.h>
+
+#include <algorithm>
+
+#include "include/internal/cef_types.h"
+
+bool input::Dispatcher::push(const Event& event) {
+  if (!queue_.push(event)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  pushed_.fetch_add(1, std::memory_order_relaxed);
+
+  return !wake_pending_.exchange(true, std::memory_order_acq_rel);
+}
+
+void input::Dispatcher::drain(int64_t now_us) {
+  // cleared before popping, so a push racing with this drain wakes us again
+  wake_pending_.store(false, std::memory_order_release);
+
+  stats_.max_depth = std::max(stats_.max_depth, queue_.size());
+  ++stats_.batches;
+
+  Event event;
+  while (queue_.pop(event)) {
+    dispatch(event, now_us);
+  }
+}
+
+void input::Dispatcher::flush_motion(int64_t now_us) {
+  if (!has_pending_motion()) {
+    return;
+  }
+
+  record_latency(motion_since_us_, now_us);
+
+  coalescer_.flush(
+      [this](const motion::Move& move) {
+        Event event{};
+        event.type = Event::Type::mouse_move;
+        event.x = move.x;
+        event.y = move.y;
+        event.modifiers = move.modifiers;
+        send(event);
+      },
+      [this](const motion::Wheel& wheel) {
+        Event event{};
+        event.type = Event::Type::mouse_wheel;
+        event.x = wheel.x;
+        event.y = wheel.y;
+        event.modifiers = wheel.modifiers;
+        event.delta_x = wheel.delta_x;
+        event.delta_y = wheel.delta_y;
+        send(event);
+      });
+
+  touch_coalescer_.flush([this](const Event& event) { send(event); });
+}
+
+input::DispatchStats input::Dispatcher::take_stats() {
+  auto result = stats_;
+  result.pushed = pushed_.exchange(0, std::memory_order_relaxed);
+  result.dropped = dropped_.exchange(0, std::memory_order_relaxed);
+
+  stats_ = {};
+
+  return result;
+}
+
+void input::Dispatcher::dispatch(const Event& event, int64_t now_us) {
+  switch (event.type) {
+    case Event::Type::mouse_move:
+      if (!has_pending_motion()) {
+        motion_since_us_ = event.timestamp_us;
+      }
+      coalescer_.move({event.x, event.y, event.modifiers});
+      return;
+
+    case Event::Type::mouse_wheel:
+      if (!has_pending_motion()) {
+        motion_since_us_ = event.timestamp_us;
+      }
+      coalescer_.wheel(
+          {event.x, event.y, event.modifiers, event.delta_x, event.delta_y});
+      return;
+
+    case Event::Type::touch:
+      if (event.touch_type == CEF_TET_MOVED) {
+        if (!has_pending_motion()) {
+          motion_since_us_ = event.timestamp_us;
+        }
+        if (touch_coalescer_.move(event)) {
+          return;
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  // everything else is ordered against the motion before it
+  flush_motion(now_us);
+  record_latency(event.timestamp_us, now_us);
+  send(event);
+}
+
+void input::Dispatcher::send(const Event& event) {
+  sink_->send(event);
+  ++stats_.dispatched;
+}
+
+void input::Dispatcher::record_latency(int64_t since_us, int64_t now_us) {
+  const auto latency = std::max<int64_t>(now_us - since_us, 0);
+
+  ++stats_.latency_samples;
+  stats_.latency_total_us += latency;
+  stats_.latency_max_us = std::max(stats_.latency_max_us, latency);
+}
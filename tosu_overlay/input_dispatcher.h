@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <tosu_overlay/input_event.h>
+#include <tosu_overlay/motion.h>
+#include <tosu_overlay/pointer.h>
+#include <tosu_overlay/spsc_queue.h>
+
+namespace input {
+
+struct DispatchStats {
+  uint64_t pushed = 0;
+  uint64_t dropped = 0;
+  uint64_t dispatched = 0;
+  uint64_t batches = 0;
+  size_t max_depth = 0;
+  // hook -> sink, coalesced motion counts from its oldest event
+  uint64_t latency_samples = 0;
+  int64_t latency_total_us = 0;
+  int64_t latency_max_us = 0;
+};
+
+// Moves events from the game's message thread to the thread that talks to
+// CEF. The hooks only push(), the consumer drains in batches and forwards
+// to the sink in order, with moves, wheel deltas and touch moves held back
+// for flush_motion() so they go out at most once per frame.
+class Dispatcher {
+ public:
+  static constexpr size_t capacity = 4096;
+
+  explicit Dispatcher(EventSink* sink) : sink_(sink) {}
+
+  // Producer side. Returns true when the consumer has to be woken up, false
+  // when a drain is already pending (or the event was dropped).
+  bool push(const Event& event);
+
+  // Consumer side from here on.
+  void drain(int64_t now_us);
+
+  bool has_pending_motion() const {
+    return coalescer_.has_pending() || touch_coalescer_.has_pending();
+  }
+  void flush_motion(int64_t now_us);
+
+  // Counters since the previous call.
+  DispatchStats take_stats();
+
+  const motion::Stats& motion_stats() const { return coalescer_.stats(); }
+  const pointer::Stats& touch_stats() const {
+    return touch_coalescer_.stats();
+  }
+
+ private:
+  void dispatch(const Event& event, int64_t now_us);
+  void record_latency(int64_t since_us, int64_t now_us);
+  void send(const Event& event);
+
+  EventSink* sink_;
+  SpscQueue<Event, capacity> queue_;
+
+  // producer-written
+  std::atomic<bool> wake_pending_ = false;
+  std::atomic<uint64_t> pushed_ = 0;
+  std::atomic<uint64_t> dropped_ = 0;
+
+  // consumer-only
+  motion::Coalescer coalescer_;
+  pointer::Coalescer touch_coalescer_;
+  int64_t motion_since_us_ = 0;
+  DispatchStats stats_;
+};
+
+}  // namespace input
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace input {
+
+// Translated input on its way from the game's message thread to CEF. Plain
+// data so it can sit in a lock-free queue; field meanings follow
+// CefMouseEvent / CefKeyEvent / CefTouchEvent.
+struct Event {
+  enum class Type : uint8_t {
+    mouse_move,
+    mouse_leave,
+    mouse_click,
+    mouse_wheel,
+    key,
+    touch,
+  };
+
+  Type type;
+
+  // mouse position in logical pixels
+  int32_t x;
+  int32_t y;
+  uint32_t modifiers;
+
+  // mouse_click, cef_mouse_button_type_t
+  int32_t button;
+  bool mouse_up;
+  int32_t click_count;
+
+  // mouse_wheel
+  int32_t delta_x;
+  int32_t delta_y;
+
+  // key, cef_key_event_type_t
+  int32_t key_type;
+  int32_t windows_key_code;
+  int32_t native_key_code;
+  bool is_system_key;
+
+  // touch, cef_touch_event_type_t / cef_pointer_type_t, position in x/y
+  int32_t touch_id;
+  int32_t touch_type;
+  int32_t pointer_type;
+  float pressure;
+  float radius_x;
+  float radius_y;
+
+  // when the hook saw the message, microseconds on the steady clock
+  int64_t timestamp_us;
+};
+
+// Where dispatched events end up, the browser host in the overlay.
+class EventSink {
+ public:
+  virtual ~EventSink() = default;
+
+  virtual void send(const Event& event) = 0;
+};
+
+}  // namespace input
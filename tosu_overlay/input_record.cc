@@ -0,0 +1,39 @@
+#include <tosu_overlay/input_record.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+bool input::is_recorded_message(UINT msg) {
+  return (msg >= WM_KEYDOWN && msg <= WM_SYSCHAR) ||
+         (msg >= WM_MOUSEMOVE && msg <= WM_MOUSEHWHEEL) ||
+         msg == WM_MOUSELEAVE;
+}
+
+void input::write_record(std::ostream& out, const RawMessage& message) {
+  // through uint64_t so 32- and 64-bit records read back the same
+  out << std::hex << message.msg << ' '
+      << static_cast<uint64_t>(message.wparam) << ' '
+      << static_cast<uint64_t>(message.lparam) << ' ' << std::dec
+      << message.time << '\n';
+}
+
+std::vector<input::RawMessage> input::read_records(std::istream& in) {
+  std::vector<RawMessage> messages;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream values(line);
+
+    UINT msg;
+    uint64_t wparam;
+    uint64_t lparam;
+    LONG time;
+    if (values >> std::hex >> msg >> wparam >> lparam >> std::dec >> time) {
+      messages.push_back({msg, static_cast<WPARAM>(wparam),
+                          static_cast<LPARAM>(lparam), time});
+    }
+  }
+
+  return messages;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <istream>
+#include <ostream>
+#include <vector>
+
+// Raw input messages as the hooks saw them, so an edit-mode session can be
+// replayed through input::Translator off Windows (see bench/). One message
+// per line: "msg wparam lparam time", the first three in hex.
+namespace input {
+
+struct RawMessage {
+  UINT msg;
+  WPARAM wparam;
+  LPARAM lparam;
+  // GetMessageTime, milliseconds
+  LONG time;
+};
+
+// Keyboard and mouse messages, the ones Translator understands.
+bool is_recorded_message(UINT msg);
+
+void write_record(std::ostream& out, const RawMessage& message);
+std::vector<RawMessage> read_records(std::istream& in);
+
+}  // namespace input
@@ -0,0 +1,175 @@
+#include <tosu_overlay/input_translator.h>
+#include <windowsx.h>
+
+#include <cmath>
+#include <cstdlib>
+
+#include "include/internal/cef_types.h"
+
+// Thanks !!! :D
+// https://github.com/ONLYOFFICE/desktop-sdk/blob/master/ChromiumBasedEditors/lib/src/cef/windows/tests/cefclient/browser/osr_window_win.cc
+
+namespace {
+
+int DeviceToLogical(int value, float device_scale_factor) {
+  float scaled_val = static_cast<float>(value) / device_scale_factor;
+  return static_cast<int>(std::floor(scaled_val));
+}
+
+}  // namespace
+
+void input::Translator::set_double_click(int width,
+                                         int height,
+                                         uint32_t time_ms) {
+  double_click_width_ = width;
+  double_click_height_ = height;
+  double_click_time_ = time_ms;
+}
+
+input::Event input::Translator::mouse_event(Event::Type type,
+                                            int x,
+                                            int y,
+                                            WPARAM wparam) const {
+  Event event{};
+  event.type = type;
+  event.x = DeviceToLogical(x, device_scale_factor_);
+  event.y = DeviceToLogical(y, device_scale_factor_);
+  event.modifiers = modifiers_->mouse(wparam);
+  return event;
+}
+
+bool input::Translator::mouse(UINT code,
+                              WPARAM wparam,
+                              LPARAM lparam,
+                              LONG time,
+                              Event& out) {
+  bool cancelPreviousClick = false;
+
+  if (code == WM_LBUTTONDOWN || code == WM_RBUTTONDOWN ||
+      code == WM_MBUTTONDOWN || code == WM_MOUSEMOVE || code == WM_MOUSELEAVE) {
+    int x = GET_X_LPARAM(lparam);
+    int y = GET_Y_LPARAM(lparam);
+    cancelPreviousClick =
+        (std::abs(last_click_x_ - x) > (double_click_width_ / 2)) ||
+        (std::abs(last_click_y_ - y) > (double_click_height_ / 2)) ||
+        ((time - last_click_time_) > static_cast<LONG>(double_click_time_));
+    if (cancelPreviousClick &&
+        (code == WM_MOUSEMOVE || code == WM_MOUSELEAVE)) {
+      last_click_count_ = 1;
+      last_click_x_ = 0;
+      last_click_y_ = 0;
+      last_click_time_ = 0;
+    }
+  }
+
+  switch (code) {
+    case WM_LBUTTONDOWN:
+    case WM_RBUTTONDOWN:
+    case WM_MBUTTONDOWN: {
+      int x = GET_X_LPARAM(lparam);
+      int y = GET_Y_LPARAM(lparam);
+
+      int32_t btnType =
+          (code == WM_LBUTTONDOWN
+               ? MBT_LEFT
+               : (code == WM_RBUTTONDOWN ? MBT_RIGHT : MBT_MIDDLE));
+      if (!cancelPreviousClick && (btnType == last_click_button_)) {
+        ++last_click_count_;
+      } else {
+        last_click_count_ = 1;
+        last_click_x_ = x;
+        last_click_y_ = y;
+      }
+      last_click_time_ = time;
+      last_click_button_ = btnType;
+
+      out = mouse_event(Event::Type::mouse_click, x, y, wparam);
+      out.button = btnType;
+      out.mouse_up = false;
+      out.click_count = last_click_count_;
+      return true;
+    }
+
+    case WM_LBUTTONUP:
+    case WM_RBUTTONUP:
+    case WM_MBUTTONUP: {
+      int x = GET_X_LPARAM(lparam);
+      int y = GET_Y_LPARAM(lparam);
+      int32_t btnType =
+          (code == WM_LBUTTONUP
+               ? MBT_LEFT
+               : (code == WM_RBUTTONUP ? MBT_RIGHT : MBT_MIDDLE));
+
+      out = mouse_event(Event::Type::mouse_click, x, y, wparam);
+      out.button = btnType;
+      out.mouse_up = true;
+      out.click_count = last_click_count_;
+      return true;
+    }
+
+    case WM_MOUSEMOVE: {
+      int x = GET_X_LPARAM(lparam);
+      int y = GET_Y_LPARAM(lparam);
+
+      out = mouse_event(Event::Type::mouse_move, x, y, wparam);
+      return true;
+    }
+
+    case WM_MOUSELEAVE: {
+      const auto p = system_->cursor_position();
+
+      out = mouse_event(Event::Type::mouse_leave, p.x, p.y, wparam);
+      return true;
+    }
+
+    case WM_MOUSEWHEEL: {
+      POINT screen_point = {GET_X_LPARAM(lparam), GET_Y_LPARAM(lparam)};
+      if (!system_->is_window_at(screen_point)) {
+        return false;
+      }
+
+      const auto client_point = system_->screen_to_client(screen_point);
+      int delta = GET_WHEEL_DELTA_WPARAM(wparam);
+      const bool horizontal = modifiers_->down(VK_SHIFT);
+
+      out = mouse_event(Event::Type::mouse_wheel, client_point.x,
+                        client_point.y, wparam);
+      out.delta_x = horizontal ? delta : 0;
+      out.delta_y = !horizontal ? delta : 0;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool input::Translator::key(UINT code,
+                            WPARAM wparam,
+                            LPARAM lparam,
+                            Event& out) {
+  out = {};
+  out.type = Event::Type::key;
+  out.windows_key_code = static_cast<int32_t>(wparam);
+  out.native_key_code = static_cast<int32_t>(lparam);
+  out.is_system_key =
+      code == WM_SYSCHAR || code == WM_SYSKEYDOWN || code == WM_SYSKEYUP;
+
+  if (code == WM_KEYDOWN || code == WM_SYSKEYDOWN)
+    out.key_type = KEYEVENT_RAWKEYDOWN;
+  else if (code == WM_KEYUP || code == WM_SYSKEYUP)
+    out.key_type = KEYEVENT_KEYUP;
+  else if (code == WM_CHAR || code == WM_SYSCHAR)
+    out.key_type = KEYEVENT_CHAR;
+  else
+    return false;
+
+  out.modifiers = modifiers_->keyboard(wparam, lparam);
+
+  if ((out.key_type == KEYEVENT_CHAR) && modifiers_->down(VK_RMENU) &&
+      system_->is_altgr_char(wparam)) {
+    out.modifiers &= ~(EVENTFLAG_CONTROL_DOWN | EVENTFLAG_ALT_DOWN);
+    out.modifiers |= EVENTFLAG_ALTGR_DOWN;
+  }
+
+  return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <Windows.h>
+#include <tosu_overlay/input_event.h>
+#include <tosu_overlay/modifiers.h>
+
+#include <cstdint>
+
+namespace input {
+
+// The window lookups translating a message needs, so the translation can be
+// replayed off Windows.
+class System {
+ public:
+  virtual ~System() = default;
+
+  virtual POINT screen_to_client(POINT point) = 0;
+
+  // Cursor position in client coordinates.
+  virtual POINT cursor_position() = 0;
+
+  // Whether the overlay's window is the one under the point (screen
+  // coordinates).
+  virtual bool is_window_at(POINT point) = 0;
+
+  // Whether the layout types the character with Ctrl+Alt, i.e. AltGr.
+  virtual bool is_altgr_char(WPARAM character) = 0;
+};
+
+// Turns the game window's mouse and keyboard messages into input::Events,
+// including double-click counting. Window side effects (capture, focus) are
+// left to the caller. Game message thread only.
+class Translator {
+ public:
+  Translator(System* system, const modifiers::Tracker* modifiers)
+      : system_(system), modifiers_(modifiers) {}
+
+  void set_device_scale_factor(float scale) { device_scale_factor_ = scale; }
+  float device_scale_factor() const { return device_scale_factor_; }
+
+  void set_double_click(int width, int height, uint32_t time_ms);
+
+  // Returns false when the message doesn't translate to an event. time is
+  // the message time (GetMessageTime), used for double clicks.
+  bool mouse(UINT msg, WPARAM wparam, LPARAM lparam, LONG time, Event& out);
+  bool key(UINT msg, WPARAM wparam, LPARAM lparam, Event& out);
+
+ private:
+  Event mouse_event(Event::Type type, int x, int y, WPARAM wparam) const;
+
+  System* system_;
+  const modifiers::Tracker* modifiers_;
+
+  float device_scale_factor_ = 1.0f;
+
+  int double_click_width_ = 4;
+  int double_click_height_ = 4;
+  uint32_t double_click_time_ = 500;
+
+  int last_click_x_ = 0;
+  int last_click_y_ = 0;
+  int32_t last_click_button_ = 0;
+  int last_click_count_ = 1;
+  LONG last_click_time_ = 0;
+};
+
+}  // namespace input
@@ -0,0 +1,253 @@
+#include <tosu_overlay/json_diff.h>
+
+#include <algorithm>
+#include <utility>
+
+using nlohmann::json;
+
+namespace {
+
+void append_escaped(std::string& path, std::string_view key) {
+  for (const char c : key) {
+    if (c == '~') {
+      path += "~0";
+    } else if (c == '/') {
+      path += "~1";
+    } else {
+      path += c;
+    }
+  }
+}
+
+// Whether pointer is prefix or below it.
+bool under(std::string_view pointer, std::string_view prefix) {
+  return pointer.substr(0, prefix.size()) == prefix &&
+         (pointer.size() == prefix.size() || pointer[prefix.size()] == '/');
+}
+
+}  // namespace
+
+// Receives the parser's events, see nlohmann::json_sax.
+class json_diff::Differ::Handler {
+ public:
+  explicit Handler(Differ& differ) : differ_(differ) {}
+
+  bool null() { return scalar(nullptr); }
+  bool boolean(bool value) { return scalar(value); }
+  bool number_integer(json::number_integer_t value) { return scalar(value); }
+  bool number_unsigned(json::number_unsigned_t value) {
+    return scalar(value);
+  }
+  bool number_float(json::number_float_t value, const json::string_t&) {
+    return scalar(value);
+  }
+  bool string(json::string_t& value) { return scalar(std::move(value)); }
+  bool binary(json::binary_t& value) {
+    return scalar(json::binary(std::move(value)));
+  }
+
+  bool start_object(size_t) { return open(false); }
+  bool start_array(size_t) { return open(true); }
+  bool end_object() { return close(); }
+  bool end_array() { return close(); }
+
+  bool key(json::string_t& key) {
+    auto& level = differ_.levels_[differ_.depth_ - 1];
+    differ_.path_.resize(level.path_size);
+    differ_.path_ += '/';
+    append_escaped(differ_.path_, key);
+    level.key = std::move(key);
+    return true;
+  }
+
+  bool parse_error(size_t,
+                   const std::string&,
+                   const nlohmann::detail::exception&) {
+    return false;
+  }
+
+ private:
+  struct Slot {
+    json* target;
+    bool existed;
+    bool fresh;
+  };
+
+  // Where the next value goes, path_ pointing at it.
+  Slot slot() {
+    if (differ_.depth_ == 0) {
+      differ_.path_.clear();
+      return {&differ_.state_, differ_.has_state_, false};
+    }
+
+    auto& level = differ_.levels_[differ_.depth_ - 1];
+    auto& node = *level.node;
+
+    if (level.array) {
+      differ_.path_.resize(level.path_size);
+      differ_.path_ += '/';
+      differ_.path_ += std::to_string(level.index);
+
+      const bool existed = level.index < node.size();
+      if (!existed) {
+        node.push_back(nullptr);
+      }
+      return {&node[level.index++], existed, level.fresh};
+    }
+
+    if (!level.fresh) {
+      level.keys.push_back(level.key);
+    }
+    const auto it = node.find(level.key);
+    if (it != node.end()) {
+      return {&*it, true, level.fresh};
+    }
+    return {&node[level.key], false, level.fresh};
+  }
+
+  bool scalar(json value) {
+    const auto slot = this->slot();
+    if (!slot.fresh && (!slot.existed || *slot.target != value)) {
+      differ_.set_[differ_.path_] = value;
+    }
+    *slot.target = std::move(value);
+    return true;
+  }
+
+  bool open(bool array) {
+    const auto slot = this->slot();
+    const auto type = array ? json::value_t::array : json::value_t::object;
+
+    const bool fresh_root = !slot.fresh && (!slot.existed ||
+                                            slot.target->type() != type);
+    if (slot.fresh || fresh_root) {
+      *slot.target = array ? json::array() : json::object();
+    }
+
+    if (differ_.levels_.size() == differ_.depth_) {
+      differ_.levels_.emplace_back();
+    }
+    auto& level = differ_.levels_[differ_.depth_++];
+    level.node = slot.target;
+    level.path_size = differ_.path_.size();
+    level.array = array;
+    level.fresh = slot.fresh || fresh_root;
+    level.fresh_root = fresh_root;
+    level.index = 0;
+    level.old_size = slot.target->size();
+    level.keys.clear();
+    return true;
+  }
+
+  bool close() {
+    auto& level = differ_.levels_[differ_.depth_ - 1];
+    auto& node = *level.node;
+    auto& path = differ_.path_;
+    path.resize(level.path_size);
+
+    if (level.fresh_root) {
+      differ_.set_[path] = node;
+    } else if (level.fresh) {
+      // set whole with its fresh root
+    } else if (level.array) {
+      if (level.index < node.size()) {
+        node.erase(node.begin() + static_cast<std::ptrdiff_t>(level.index),
+                   node.end());
+      }
+      if (level.index != level.old_size) {
+        replace_whole(path, node);
+      }
+    } else if (node.size() != level.keys.size()) {
+      for (auto it = node.begin(); it != node.end();) {
+        if (std::find(level.keys.begin(), level.keys.end(), it.key()) !=
+            level.keys.end()) {
+          ++it;
+          continue;
+        }
+
+        auto removed = path;
+        removed += '/';
+        append_escaped(removed, it.key());
+        differ_.remove_.push_back(std::move(removed));
+        it = node.erase(it);
+      }
+    }
+
+    --differ_.depth_;
+    return true;
+  }
+
+  // Drops what was recorded below path for a set of all of it.
+  void replace_whole(const std::string& path, const json& value) {
+    auto& set = differ_.set_.get_ref<json::object_t&>();
+    const auto below = path + '/';
+    for (auto it = set.lower_bound(below);
+         it != set.end() && under(it->first, path);) {
+      it = set.erase(it);
+    }
+
+    auto& remove = differ_.remove_.get_ref<json::array_t&>();
+    remove.erase(std::remove_if(remove.begin(), remove.end(),
+                                [&](const json& pointer) {
+                                  return under(
+                                      pointer.get_ref<const std::string&>(),
+                                      path);
+                                }),
+                 remove.end());
+
+    differ_.set_[path] = value;
+  }
+
+  Differ& differ_;
+};
+
+std::optional<json> json_diff::Differ::update(std::string_view text) {
+  set_ = json::object();
+  remove_ = json::array();
+  depth_ = 0;
+
+  Handler handler(*this);
+  if (!json::sax_parse(text, &handler) || depth_ != 0) {
+    reset();
+    return std::nullopt;
+  }
+  has_state_ = true;
+
+  json patch = json::object();
+  patch["set"] = std::move(set_);
+  patch["remove"] = std::move(remove_);
+  return patch;
+}
+
+void json_diff::Differ::reset() {
+  state_ = nullptr;
+  has_state_ = false;
+  depth_ = 0;
+}
+
+bool json_diff::empty(const json& patch) {
+  return patch.at("set").empty() && patch.at("remove").empty();
+}
+
+std::vector<std::string> json_diff::split_pointer(std::string_view pointer) {
+  std::vector<std::string> segments;
+
+  while (!pointer.empty() && pointer.front() == '/') {
+    pointer.remove_prefix(1);
+    const auto end = pointer.find('/');
+    const auto segment = pointer.substr(0, end);
+    pointer = end == std::string_view::npos ? std::string_view()
+                                            : pointer.substr(end);
+
+    auto& unescaped = segments.emplace_back();
+    for (size_t i = 0; i < segment.size(); ++i) {
+      if (segment[i] == '~' && i + 1 < segment.size()) {
+        unescaped += segment[++i] == '1' ? '/' : '~';
+      } else {
+        unescaped += segment[i];
+      }
+    }
+  }
+
+  return segments;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Field-level changes between consecutive tosu messages. tosu sends the
+// whole state every tick while a few numbers move, so instead of a parsed
+// copy of every message, the text is streamed (nlohmann's SAX interface)
+// against the last state, which is updated in place. Only what differs is
+// copied out:
+//
+//   {
+//     "set": {"/play/pp/current": 212.5, "/play/hits/300": 411},
+//     "remove": ["/tourney"]
+//   }
+//
+// Keys are JSON Pointers, "" standing for the whole state (the first
+// message, or the next one after a broken message). An array whose length
+// changed is set whole instead of element by element.
+namespace json_diff {
+
+class Differ {
+ public:
+  // Applies text to the state and returns the patch, nullopt (and the state
+  // is dropped) when text isn't JSON.
+  std::optional<nlohmann::json> update(std::string_view text);
+
+  const nlohmann::json& state() const { return state_; }
+  void reset();
+
+ private:
+  class Handler;
+
+  // A container being walked.
+  struct Level {
+    nlohmann::json* node;
+    // length of path_ for this container
+    size_t path_size;
+    bool array;
+    // the whole container is new, nothing below it is compared
+    bool fresh;
+    // and this is the top of it, set whole once closed
+    bool fresh_root;
+    // arrays: the next element, and the length before this message
+    size_t index;
+    size_t old_size;
+    // objects: the current key and the ones seen so far
+    std::string key;
+    std::vector<std::string> keys;
+  };
+
+  nlohmann::json state_;
+  bool has_state_ = false;
+
+  // per update, kept for their capacity
+  std::vector<Level> levels_;
+  size_t depth_ = 0;
+  std::string path_;
+  nlohmann::json set_;
+  nlohmann::json remove_;
+};
+
+// Whether a patch changes nothing.
+bool empty(const nlohmann::json& patch);
+
+// "/play/hits/300" -> {"play", "hits", "300"}, ~1 and ~0 unescaped.
+std::vector<std::string> split_pointer(std::string_view pointer);
+
+}  // namespace json_diff
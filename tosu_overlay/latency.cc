@@ -0,0 +1,240 @@
+#include <tosu_overlay/latency.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+constexpr int64_t linear_limit = 16;
+constexpr int first_octave = 4;
+constexpr int64_t max_recorded_us = (int64_t{1} << 24) - 1;
+
+// A probe that can't finish (nothing repainted, overlay hidden) is dropped
+// after this long so the next event can be followed.
+constexpr int64_t abandon_after_us = 1'000'000;
+
+enum class Probe {
+  idle,
+  dispatched,
+  painted,
+  uploaded,
+};
+
+std::array<latency::Histogram, latency::stage_count> histograms;
+
+// Written by whichever thread owns the current state, published through it.
+std::atomic<Probe> probe = Probe::idle;
+int64_t hook_us = 0;
+int64_t dispatch_us = 0;
+int64_t paint_us = 0;
+int64_t upload_us = 0;
+
+latency::Histogram& at(latency::Stage stage) {
+  return histograms[static_cast<size_t>(stage)];
+}
+
+int octave_of(int64_t us) {
+  int octave = 0;
+  while (us >>= 1) {
+    ++octave;
+  }
+  return octave;
+}
+
+}  // namespace
+
+const char* latency::stage_name(Stage stage) {
+  switch (stage) {
+    case Stage::dispatch:
+      return "hook->dispatch";
+    case Stage::paint:
+      return "dispatch->paint";
+    case Stage::upload:
+      return "paint->upload";
+    case Stage::present:
+      return "upload->present";
+    case Stage::total:
+      return "hook->present";
+  }
+
+  return "";
+}
+
+int64_t latency::now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t latency::Histogram::bucket_of(int64_t us) {
+  us = std::clamp<int64_t>(us, 0, max_recorded_us);
+  if (us < linear_limit) {
+    return static_cast<size_t>(us);
+  }
+
+  const auto octave = octave_of(us);
+  const auto sub = (us >> (octave - 2)) & 3;
+  return linear_limit + (octave - first_octave) * 4 + sub;
+}
+
+int64_t latency::Histogram::bucket_floor(size_t bucket) {
+  if (bucket < linear_limit) {
+    return static_cast<int64_t>(bucket);
+  }
+
+  const auto index = static_cast<int>(bucket - linear_limit);
+  const auto octave = first_octave + index / 4;
+  const auto sub = static_cast<int64_t>(index % 4);
+  return (int64_t{1} << octave) + sub * (int64_t{1} << (octave - 2));
+}
+
+void latency::Histogram::record(int64_t us) {
+  us = std::max<int64_t>(us, 0);
+
+  buckets_[bucket_of(us)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_us_.fetch_add(us, std::memory_order_relaxed);
+  if (us > max_us_.load(std::memory_order_relaxed)) {
+    max_us_.store(us, std::memory_order_relaxed);
+  }
+}
+
+void latency::Histogram::reset() {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  total_us_.store(0, std::memory_order_relaxed);
+  max_us_.store(0, std::memory_order_relaxed);
+}
+
+latency::Histogram::Summary latency::Histogram::summary() const {
+  Summary result{};
+  result.count = count_.load(std::memory_order_relaxed);
+  if (result.count == 0) {
+    return result;
+  }
+
+  result.max_us = max_us_.load(std::memory_order_relaxed);
+  result.mean_us = total_us_.load(std::memory_order_relaxed) /
+                   static_cast<int64_t>(result.count);
+
+  // middle of the bucket the percentile falls into, capped by the max
+  const auto percentile = [&](uint64_t per_mille) {
+    const auto rank = std::max<uint64_t>(
+        (result.count * per_mille + 999) / 1000, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; ++i) {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen >= rank) {
+        const auto low = bucket_floor(i);
+        const auto high = i + 1 < bucket_count ? bucket_floor(i + 1) : low;
+        return std::min((low + high) / 2, result.max_us);
+      }
+    }
+
+    return result.max_us;
+  };
+
+  result.p50_us = percentile(500);
+  result.p95_us = percentile(950);
+  result.p99_us = percentile(990);
+  return result;
+}
+
+void latency::dispatched(int64_t hook) {
+  const auto now = now_us();
+
+  // the UI thread owns dispatched and may give up on painted, the render
+  // thread wins if it picks the probe up first
+  auto current = probe.load(std::memory_order_acquire);
+  if (current != Probe::idle && now - hook_us > abandon_after_us &&
+      (current == Probe::dispatched || current == Probe::painted)) {
+    if (probe.compare_exchange_strong(current, Probe::idle,
+                                      std::memory_order_acq_rel)) {
+      current = Probe::idle;
+    }
+  }
+
+  if (current != Probe::idle) {
+    return;
+  }
+
+  hook_us = hook;
+  dispatch_us = now;
+  at(Stage::dispatch).record(dispatch_us - hook_us);
+
+  probe.store(Probe::dispatched, std::memory_order_release);
+}
+
+void latency::painted() {
+  if (probe.load(std::memory_order_acquire) != Probe::dispatched) {
+    return;
+  }
+
+  paint_us = now_us();
+  at(Stage::paint).record(paint_us - dispatch_us);
+
+  probe.store(Probe::painted, std::memory_order_release);
+}
+
+void latency::uploaded() {
+  if (probe.load(std::memory_order_acquire) != Probe::painted) {
+    return;
+  }
+
+  const auto now = now_us();
+
+  auto expected = Probe::painted;
+  if (!probe.compare_exchange_strong(expected, Probe::uploaded,
+                                     std::memory_order_acq_rel)) {
+    return;
+  }
+
+  upload_us = now;
+  at(Stage::upload).record(upload_us - paint_us);
+}
+
+void latency::presented() {
+  if (probe.load(std::memory_order_acquire) != Probe::uploaded) {
+    return;
+  }
+
+  const auto now = now_us();
+  at(Stage::present).record(now - upload_us);
+  at(Stage::total).record(now - hook_us);
+
+  probe.store(Probe::idle, std::memory_order_release);
+}
+
+const latency::Histogram& latency::histogram(Stage stage) {
+  return at(stage);
+}
+
+std::string latency::take_report() {
+  std::string report;
+
+  for (size_t i = 0; i < stage_count; ++i) {
+    const auto stage = static_cast<Stage>(i);
+    const auto summary = at(stage).summary();
+    if (summary.count == 0) {
+      continue;
+    }
+
+    char line[160];
+    std::snprintf(line, sizeof(line),
+                  "%s%s: n=%" PRIu64 " mean=%" PRId64 " p50=%" PRId64
+                  " p95=%" PRId64 " p99=%" PRId64 " max=%" PRId64 " us",
+                  report.empty() ? "" : "\n", stage_name(stage),
+                  summary.count, summary.mean_us, summary.p50_us,
+                  summary.p95_us, summary.p99_us, summary.max_us);
+    report += line;
+
+    at(stage).reset();
+  }
+
+  return report;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// How long edit-mode input takes to show up on screen. One discrete event
+// (click, key press, touch press) at a time is followed from the input hook
+// to the first OnPaint after it was dispatched, the texture upload carrying
+// that paint and the SwapBuffers presenting it.
+namespace latency {
+
+enum class Stage : uint8_t {
+  dispatch,  // hook -> CefBrowserHost::Send*Event
+  paint,     // dispatch -> OnPaint
+  upload,    // OnPaint -> texture upload
+  present,   // upload -> SwapBuffers
+  total,     // hook -> SwapBuffers
+};
+
+constexpr size_t stage_count = 5;
+
+const char* stage_name(Stage stage);
+
+// Microseconds on the steady clock (QueryPerformanceCounter on Windows), the
+// time base for every timestamp here and on input::Event.
+int64_t now_us();
+
+// Log-linear buckets, 4 per power of two above 16 us, so percentiles are
+// within ~12%. Single writer, any number of readers.
+class Histogram {
+ public:
+  static constexpr size_t bucket_count = 96;
+
+  struct Summary {
+    uint64_t count;
+    int64_t mean_us;
+    int64_t p50_us;
+    int64_t p95_us;
+    int64_t p99_us;
+    int64_t max_us;
+  };
+
+  void record(int64_t us);
+  void reset();
+
+  Summary summary() const;
+
+  static size_t bucket_of(int64_t us);
+  static int64_t bucket_floor(size_t bucket);
+
+ private:
+  std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+  std::atomic<uint64_t> count_ = 0;
+  std::atomic<int64_t> total_us_ = 0;
+  std::atomic<int64_t> max_us_ = 0;
+};
+
+// Probe hand-offs, each from the thread that owns the stage: dispatched()
+// and painted() on the CEF UI thread, uploaded() and presented() on the
+// game's render thread. Events dispatched while one is in flight aren't
+// followed.
+void dispatched(int64_t hook_us);
+void painted();
+void uploaded();
+void presented();
+
+const Histogram& histogram(Stage stage);
+
+// One line per stage with samples, then clears the histograms.
+std::string take_report();
+
+}  // namespace latency
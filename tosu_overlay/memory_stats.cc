@@ -0,0 +1,79 @@
+#include <tosu_overlay/memory_stats.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+constexpr uint64_t mib = 1 << 20;
+
+long long to_mib(uint64_t bytes) {
+  return static_cast<long long>(bytes / mib);
+}
+
+long long growth_mib(uint64_t now, uint64_t baseline) {
+  return (static_cast<long long>(now) - static_cast<long long>(baseline)) /
+         static_cast<long long>(mib);
+}
+
+uint64_t growth_steps(uint64_t now, uint64_t baseline, uint64_t step) {
+  if (step == 0 || now <= baseline) {
+    return 0;
+  }
+
+  return (now - baseline) / step;
+}
+
+}  // namespace
+
+bool memory_stats::Monitor::record(const Sample& sample) {
+  if (count_++ == 0) {
+    baseline_ = sample;
+  }
+  latest_ = sample;
+
+  // the JS heap baseline is taken once the page has a context
+  if (baseline_.js_heap_used == 0) {
+    baseline_.js_heap_used = sample.js_heap_used;
+  }
+
+  const auto rss_steps = growth_steps(sample.working_set,
+                                      baseline_.working_set, growth_warning_);
+  const auto js_steps = growth_steps(sample.js_heap_used,
+                                     baseline_.js_heap_used, growth_warning_);
+
+  const bool warn = rss_steps > rss_warned_ || js_steps > js_warned_;
+  rss_warned_ = std::max(rss_warned_, rss_steps);
+  js_warned_ = std::max(js_warned_, js_steps);
+  return warn;
+}
+
+void memory_stats::Monitor::reset() {
+  count_ = 0;
+  baseline_ = {};
+  latest_ = {};
+  rss_warned_ = 0;
+  js_warned_ = 0;
+}
+
+std::string memory_stats::Monitor::describe() const {
+  if (count_ == 0) {
+    return {};
+  }
+
+  char text[256];
+  std::snprintf(
+      text, sizeof(text),
+      "rss=%lld MiB (%+lld) private=%lld MiB (%+lld) js=%lld/%lld MiB (%+lld) "
+      "limit=%lld MiB over %lld min",
+      to_mib(latest_.working_set),
+      growth_mib(latest_.working_set, baseline_.working_set),
+      to_mib(latest_.private_bytes),
+      growth_mib(latest_.private_bytes, baseline_.private_bytes),
+      to_mib(latest_.js_heap_used), to_mib(latest_.js_heap_total),
+      growth_mib(latest_.js_heap_used, baseline_.js_heap_used),
+      to_mib(latest_.js_heap_limit),
+      static_cast<long long>((latest_.time_us - baseline_.time_us) /
+                             60'000'000));
+  return text;
+}
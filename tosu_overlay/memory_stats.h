@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Renderer memory telemetry. The browser process asks the render process for
+// a sample with a process message every "sample_seconds", the renderer
+// answers with its own working set and V8's performance.memory numbers.
+//
+//   "memory": {
+//     "js_heap_mb": 512,         // V8 old space cap, 0 for Chromium's
+//     "disk_cache_mb": 64,       // HTTP cache cap, 0 for Chromium's
+//     "sample_seconds": 60,      // 0 turns sampling off
+//     "growth_warning_mb": 128,  // warn every time growth passes a multiple
+//     "recycle_mb": 1024         // swap in a fresh renderer past this, 0 off
+//   }
+namespace memory_stats {
+
+// Process message name for both the request and the reply. The reply's
+// arguments are the Sample fields after time_us in order, as doubles
+// (bytes). time_us is stamped when the reply arrives.
+constexpr char sample_message[] = "tosu_overlay.memory_sample";
+
+struct Sample {
+  int64_t time_us;
+  uint64_t working_set;
+  uint64_t private_bytes;
+  // 0 when the page has no V8 context yet
+  uint64_t js_heap_used;
+  uint64_t js_heap_total;
+  uint64_t js_heap_limit;
+};
+
+// Platform layer, memory_stats_win.cc: the calling process's working set and
+// private bytes into sample, the rest untouched.
+void sample_process(Sample& sample);
+
+// Follows one renderer's samples against the first, so leaks show up as
+// growth over the session. UI thread only.
+class Monitor {
+ public:
+  explicit Monitor(uint64_t growth_warning) : growth_warning_(growth_warning) {}
+
+  // Returns true when the working set or the JS heap grew past another
+  // multiple of growth_warning since the first sample.
+  bool record(const Sample& sample);
+
+  // Starts over, e.g. when the renderer was replaced.
+  void reset();
+
+  bool has_samples() const { return count_ != 0; }
+  const Sample& baseline() const { return baseline_; }
+  const Sample& latest() const { return latest_; }
+
+  // "rss=182 MiB (+40) private=150 MiB (+38) js=34/48 MiB (+12) limit=4096
+  // MiB over 95 min"
+  std::string describe() const;
+
+ private:
+  uint64_t growth_warning_;
+
+  uint64_t count_ = 0;
+  Sample baseline_{};
+  Sample latest_{};
+
+  // growth multiples already warned about
+  uint64_t rss_warned_ = 0;
+  uint64_t js_warned_ = 0;
+};
+
+}  // namespace memory_stats
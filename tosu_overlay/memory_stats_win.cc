@@ -0,0 +1,16 @@
+#include <tosu_overlay/memory_stats.h>
+
+#include <windows.h>
+
+#include <psapi.h>
+
+void memory_stats::sample_process(Sample& sample) {
+  PROCESS_MEMORY_COUNTERS_EX counters{};
+  if (GetProcessMemoryInfo(
+          GetCurrentProcess(),
+          reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+          sizeof(counters))) {
+    sample.working_set = counters.WorkingSetSize;
+    sample.private_bytes = counters.PrivateUsage;
+  }
+}
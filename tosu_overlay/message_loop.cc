@@ -0,0 +1,159 @@
+#include <tosu_overlay/message_loop.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+message_loop::ExternalPump pump;
+message_loop::Mode current_mode = message_loop::Mode::dedicated;
+
+std::chrono::steady_clock::time_point to_time_point(int64_t us) {
+  return std::chrono::steady_clock::time_point(std::chrono::microseconds(us));
+}
+
+}  // namespace
+
+std::optional<message_loop::Mode> message_loop::parse_mode(
+    std::string_view name) {
+  if (name == "dedicated")
+    return Mode::dedicated;
+  if (name == "multi_threaded")
+    return Mode::multi_threaded;
+  if (name == "external_pump")
+    return Mode::external_pump;
+
+  return std::nullopt;
+}
+
+const char* message_loop::mode_name(Mode mode) {
+  switch (mode) {
+    case Mode::dedicated:
+      return "dedicated";
+    case Mode::multi_threaded:
+      return "multi_threaded";
+    case Mode::external_pump:
+      return "external_pump";
+  }
+
+  return "";
+}
+
+message_loop::Config message_loop::parse_config(const nlohmann::json& config) {
+  Config result;
+  result.mode = parse_mode(config.value("mode", std::string("dedicated")))
+                    .value_or(Mode::dedicated);
+  result.slice_budget_us =
+      std::clamp<int64_t>(config.value("slice_budget_ms", 4), 1, 50) * 1000;
+  result.max_delay_us =
+      std::clamp<int64_t>(config.value("max_delay_ms", 33), 1, 1000) * 1000;
+  return result;
+}
+
+void message_loop::ExternalPump::configure(int64_t slice_budget_us,
+                                           int64_t max_delay_us) {
+  std::lock_guard lock(lock_);
+  slice_budget_us_ = slice_budget_us;
+  max_delay_us_ = max_delay_us;
+}
+
+void message_loop::ExternalPump::schedule(int64_t delay_ms) {
+  const auto at = latency::now_us() + std::max<int64_t>(delay_ms, 0) * 1000;
+
+  {
+    std::lock_guard lock(lock_);
+    if (at >= next_us_) {
+      return;
+    }
+    next_us_ = at;
+  }
+
+  wake_.notify_one();
+}
+
+void message_loop::ExternalPump::run(const std::function<void()>& do_work) {
+  std::unique_lock lock(lock_);
+
+  while (!quit_) {
+    // CEF only asks for work it knows about, the timer catches the rest
+    const auto deadline =
+        std::min(next_us_, latency::now_us() + max_delay_us_);
+    wake_.wait_until(lock, to_time_point(deadline), [&] {
+      return quit_ || next_us_ <= latency::now_us();
+    });
+    if (quit_) {
+      break;
+    }
+
+    next_us_ = INT64_MAX;
+    ++stats_.wakeups;
+
+    const auto slice_start = latency::now_us();
+    bool more = false;
+    do {
+      lock.unlock();
+      do_work();
+      lock.lock();
+
+      ++stats_.work_calls;
+
+      // work scheduled for now while this slice ran
+      const auto now = latency::now_us();
+      more = next_us_ <= now;
+      if (more && now - slice_start < slice_budget_us_) {
+        next_us_ = INT64_MAX;
+      } else {
+        break;
+      }
+    } while (!quit_);
+
+    if (more) {
+      ++stats_.exhausted_slices;
+
+      // rest as long as the slice ran before going on
+      const auto rest_until = latency::now_us() + slice_budget_us_;
+      wake_.wait_until(lock, to_time_point(rest_until), [&] { return quit_; });
+    }
+  }
+}
+
+void message_loop::ExternalPump::quit() {
+  {
+    std::lock_guard lock(lock_);
+    quit_ = true;
+  }
+
+  wake_.notify_one();
+}
+
+message_loop::ExternalPump::Stats message_loop::ExternalPump::take_stats() {
+  std::lock_guard lock(lock_);
+  const auto stats = stats_;
+  stats_ = {};
+  return stats;
+}
+
+message_loop::ExternalPump& message_loop::external_pump() {
+  return pump;
+}
+
+void message_loop::set_mode(Mode mode) {
+  current_mode = mode;
+}
+
+message_loop::Mode message_loop::mode() {
+  return current_mode;
+}
+
+void message_loop::PaintJitter::record(int64_t now_us) {
+  const auto interval = now_us - last_us_;
+  last_us_ = now_us;
+
+  if (interval <= 0 || interval > 4 * period_us_) {
+    return;
+  }
+
+  histogram_.record(std::abs(interval - period_us_));
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <tosu_overlay/latency.h>
+
+#include <nlohmann/json.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string_view>
+
+// How CEF's browser-side message loop runs inside osu!:
+//
+//   "message_loop": {
+//     "mode": "dedicated" | "multi_threaded" | "external_pump",
+//     "slice_budget_ms": 4,   // external_pump: longest run of work
+//     "max_delay_ms": 33      // external_pump: longest sleep
+//   }
+//
+// dedicated runs CefRunMessageLoop on the thread that called CefInitialize,
+// multi_threaded lets CEF own its UI thread, external_pump calls
+// CefDoMessageLoopWork when OnScheduleMessagePumpWork asks for it.
+namespace message_loop {
+
+enum class Mode {
+  dedicated,
+  multi_threaded,
+  external_pump,
+};
+
+std::optional<Mode> parse_mode(std::string_view name);
+const char* mode_name(Mode mode);
+
+struct Config {
+  Mode mode = Mode::dedicated;
+  int64_t slice_budget_us = 4000;
+  int64_t max_delay_us = 33000;
+};
+
+Config parse_config(const nlohmann::json& config);
+
+// Runs do_work when asked to, in slices of at most slice_budget_us. A slice
+// that uses up its budget is followed by a rest as long as the budget, so
+// a flood of work can't take more than about half a core from the game.
+class ExternalPump {
+ public:
+  struct Stats {
+    uint64_t wakeups;
+    uint64_t work_calls;
+    uint64_t exhausted_slices;
+  };
+
+  void configure(int64_t slice_budget_us, int64_t max_delay_us);
+
+  // OnScheduleMessagePumpWork, any thread. delay_ms <= 0 asks for work as
+  // soon as possible.
+  void schedule(int64_t delay_ms);
+
+  // Pumps until quit(), on the thread that called CefInitialize.
+  void run(const std::function<void()>& do_work);
+  void quit();
+
+  Stats take_stats();
+
+ private:
+  std::mutex lock_;
+  std::condition_variable wake_;
+
+  int64_t slice_budget_us_ = 4000;
+  int64_t max_delay_us_ = 33000;
+
+  // when work was asked for, INT64_MAX when it wasn't
+  int64_t next_us_ = INT64_MAX;
+  bool quit_ = false;
+
+  Stats stats_{};
+};
+
+ExternalPump& external_pump();
+
+// The mode CEF was initialized with, set before CefInitialize.
+void set_mode(Mode mode);
+Mode mode();
+
+// Delivery jitter of OnPaint against the frame rate while the page animates:
+// how far each interval between consecutive paints is off the frame period.
+// Intervals over 4 frame periods (the page stopped changing) are skipped.
+// UI thread only.
+class PaintJitter {
+ public:
+  void set_frame_rate(int fps) { period_us_ = 1'000'000 / fps; }
+
+  void record(int64_t now_us);
+
+  const latency::Histogram& histogram() const { return histogram_; }
+  void reset() { histogram_.reset(); }
+
+ private:
+  int64_t period_us_ = 1'000'000 / 60;
+  int64_t last_us_ = 0;
+  latency::Histogram histogram_;
+};
+
+}  // namespace message_loop
@@ -0,0 +1,215 @@
+#include <tosu_overlay/modifiers.h>
+
+#include "include/internal/cef_types.h"
+
+// Thanks !!! :D
+// https://github.com/ONLYOFFICE/desktop-sdk/blob/master/ChromiumBasedEditors/lib/src/cef/windows/tests/cefclient/browser/osr_window_win.cc
+
+namespace {
+
+constexpr uint8_t right_shift_scan_code = 0x36;
+
+// Reads the thread's keyboard state, one GetKeyState call per key.
+struct SystemKeyState {
+  bool down(int key) const { return modifiers::IsKeyDown(key); }
+
+  // Low bit set from GetKeyState indicates "toggled".
+  bool toggled(int key) const { return (::GetKeyState(key) & 1) != 0; }
+};
+
+template <typename KeyState>
+int mouse_modifiers(const KeyState& keys, WPARAM wparam) {
+  int modifiers = 0;
+  if (wparam & MK_CONTROL)
+    modifiers |= EVENTFLAG_CONTROL_DOWN;
+  if (wparam & MK_SHIFT)
+    modifiers |= EVENTFLAG_SHIFT_DOWN;
+  if (keys.down(VK_MENU))
+    modifiers |= EVENTFLAG_ALT_DOWN;
+  if (wparam & MK_LBUTTON)
+    modifiers |= EVENTFLAG_LEFT_MOUSE_BUTTON;
+  if (wparam & MK_MBUTTON)
+    modifiers |= EVENTFLAG_MIDDLE_MOUSE_BUTTON;
+  if (wparam & MK_RBUTTON)
+    modifiers |= EVENTFLAG_RIGHT_MOUSE_BUTTON;
+
+  if (keys.toggled(VK_NUMLOCK))
+    modifiers |= EVENTFLAG_NUM_LOCK_ON;
+  if (keys.toggled(VK_CAPITAL))
+    modifiers |= EVENTFLAG_CAPS_LOCK_ON;
+  return modifiers;
+}
+
+template <typename KeyState>
+int keyboard_modifiers(const KeyState& keys, WPARAM wparam, LPARAM lparam) {
+  int modifiers = 0;
+  if (keys.down(VK_SHIFT))
+    modifiers |= EVENTFLAG_SHIFT_DOWN;
+  if (keys.down(VK_CONTROL))
+    modifiers |= EVENTFLAG_CONTROL_DOWN;
+  if (keys.down(VK_MENU))
+    modifiers |= EVENTFLAG_ALT_DOWN;
+
+  if (keys.toggled(VK_NUMLOCK))
+    modifiers |= EVENTFLAG_NUM_LOCK_ON;
+  if (keys.toggled(VK_CAPITAL))
+    modifiers |= EVENTFLAG_CAPS_LOCK_ON;
+
+  switch (wparam) {
+    case VK_RETURN:
+      if ((lparam >> 16) & KF_EXTENDED)
+        modifiers |= EVENTFLAG_IS_KEY_PAD;
+      break;
+    case VK_INSERT:
+    case VK_DELETE:
+    case VK_HOME:
+    case VK_END:
+    case VK_PRIOR:
+    case VK_NEXT:
+    case VK_UP:
+    case VK_DOWN:
+    case VK_LEFT:
+    case VK_RIGHT:
+      if (!((lparam >> 16) & KF_EXTENDED))
+        modifiers |= EVENTFLAG_IS_KEY_PAD;
+      break;
+    case VK_NUMLOCK:
+    case VK_NUMPAD0:
+    case VK_NUMPAD1:
+    case VK_NUMPAD2:
+    case VK_NUMPAD3:
+    case VK_NUMPAD4:
+    case VK_NUMPAD5:
+    case VK_NUMPAD6:
+    case VK_NUMPAD7:
+    case VK_NUMPAD8:
+    case VK_NUMPAD9:
+    case VK_DIVIDE:
+    case VK_MULTIPLY:
+    case VK_SUBTRACT:
+    case VK_ADD:
+    case VK_DECIMAL:
+    case VK_CLEAR:
+      modifiers |= EVENTFLAG_IS_KEY_PAD;
+      break;
+    case VK_SHIFT:
+      if (keys.down(VK_LSHIFT))
+        modifiers |= EVENTFLAG_IS_LEFT;
+      else if (keys.down(VK_RSHIFT))
+        modifiers |= EVENTFLAG_IS_RIGHT;
+      break;
+    case VK_CONTROL:
+      if (keys.down(VK_LCONTROL))
+        modifiers |= EVENTFLAG_IS_LEFT;
+      else if (keys.down(VK_RCONTROL))
+        modifiers |= EVENTFLAG_IS_RIGHT;
+      break;
+    case VK_MENU:
+      if (keys.down(VK_LMENU))
+        modifiers |= EVENTFLAG_IS_LEFT;
+      else if (keys.down(VK_RMENU))
+        modifiers |= EVENTFLAG_IS_RIGHT;
+      break;
+    case VK_LWIN:
+      modifiers |= EVENTFLAG_IS_LEFT;
+      break;
+    case VK_RWIN:
+      modifiers |= EVENTFLAG_IS_RIGHT;
+      break;
+  }
+  return modifiers;
+}
+
+}  // namespace
+
+bool modifiers::IsKeyDown(WPARAM wparam) {
+  return (GetKeyState(static_cast<int>(wparam)) & 0x8000) != 0;
+}
+
+int modifiers::GetCefMouseModifiers(WPARAM wparam) {
+  return mouse_modifiers(SystemKeyState(), wparam);
+}
+
+int modifiers::GetCefKeyboardModifiers(WPARAM wparam, LPARAM lparam) {
+  return keyboard_modifiers(SystemKeyState(), wparam, lparam);
+}
+
+uint8_t modifiers::side_specific_key(WPARAM wparam, LPARAM lparam) {
+  const bool extended = ((lparam >> 16) & KF_EXTENDED) != 0;
+
+  switch (wparam) {
+    case VK_SHIFT:
+      return ((lparam >> 16) & 0xFF) == right_shift_scan_code ? VK_RSHIFT
+                                                              : VK_LSHIFT;
+    case VK_CONTROL:
+      return extended ? VK_RCONTROL : VK_LCONTROL;
+    case VK_MENU:
+      return extended ? VK_RMENU : VK_LMENU;
+  }
+
+  return static_cast<uint8_t>(wparam);
+}
+
+void modifiers::Tracker::sync() {
+  held_.reset();
+  toggled_.reset();
+
+  for (int key : {VK_SHIFT, VK_LSHIFT, VK_RSHIFT, VK_CONTROL, VK_LCONTROL,
+                  VK_RCONTROL, VK_MENU, VK_LMENU, VK_RMENU}) {
+    held_[key] = IsKeyDown(key);
+  }
+
+  for (int key : {VK_NUMLOCK, VK_CAPITAL}) {
+    toggled_[key] = (::GetKeyState(key) & 1) != 0;
+  }
+}
+
+void modifiers::Tracker::release_all() {
+  held_.reset();
+}
+
+void modifiers::Tracker::on_key_message(UINT msg,
+                                        WPARAM wparam,
+                                        LPARAM lparam) {
+  const bool is_down = msg == WM_KEYDOWN || msg == WM_SYSKEYDOWN;
+  const bool is_up = msg == WM_KEYUP || msg == WM_SYSKEYUP;
+  if ((!is_down && !is_up) || wparam > 0xFF) {
+    return;
+  }
+
+  const auto key = static_cast<uint8_t>(wparam);
+  const auto sided_key = side_specific_key(wparam, lparam);
+
+  if (is_up) {
+    held_.reset(sided_key);
+
+    // the generic key stays held while the other side still is
+    const bool other_side_held =
+        sided_key != key &&
+        ((key == VK_SHIFT && (held_[VK_LSHIFT] || held_[VK_RSHIFT])) ||
+         (key == VK_CONTROL && (held_[VK_LCONTROL] || held_[VK_RCONTROL])) ||
+         (key == VK_MENU && (held_[VK_LMENU] || held_[VK_RMENU])));
+    if (!other_side_held) {
+      held_.reset(key);
+    }
+
+    return;
+  }
+
+  // bit 30 is the previous key state, set for auto-repeat
+  const bool repeat = ((lparam >> 30) & 1) != 0;
+  if (!repeat && (key == VK_NUMLOCK || key == VK_CAPITAL)) {
+    toggled_.flip(key);
+  }
+
+  held_.set(key);
+  held_.set(sided_key);
+}
+
+int modifiers::Tracker::mouse(WPARAM wparam) const {
+  return mouse_modifiers(*this, wparam);
+}
+
+int modifiers::Tracker::keyboard(WPARAM wparam, LPARAM lparam) const {
+  return keyboard_modifiers(*this, wparam, lparam);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <bitset>
+#include <cstdint>
+
+namespace modifiers {
+
+bool IsKeyDown(WPARAM wparam);
+
+// Query the thread's key state with GetKeyState on every call.
+int GetCefMouseModifiers(WPARAM wparam);
+int GetCefKeyboardModifiers(WPARAM wparam, LPARAM lparam);
+
+// Key messages only carry the generic VK_SHIFT/VK_CONTROL/VK_MENU, the side
+// comes from the scan code or the extended-key flag.
+uint8_t side_specific_key(WPARAM wparam, LPARAM lparam);
+
+// Modifier state kept up to date from the key messages the hooks already see,
+// so translating an event costs no GetKeyState calls. Same flags as the
+// GetCef*Modifiers functions.
+class Tracker {
+ public:
+  // Seeds held modifiers and lock toggles from GetKeyState, call once at
+  // startup and whenever focus comes back.
+  void sync();
+
+  // Held keys are unreliable once focus is gone.
+  void release_all();
+
+  void on_key_message(UINT msg, WPARAM wparam, LPARAM lparam);
+
+  int mouse(WPARAM wparam) const;
+  int keyboard(WPARAM wparam, LPARAM lparam) const;
+
+  bool down(int key) const { return held_[key & 0xFF]; }
+  bool toggled(int key) const { return toggled_[key & 0xFF]; }
+
+ private:
+  std::bitset<256> held_;
+  std::bitset<256> toggled_;
+};
+
+}  // namespace modifiers
@@ -0,0 +1,25 @@
+#include <tosu_overlay/motion.h>
+
+void motion::Coalescer::move(const Move& event) {
+  ++stats_.moves_in;
+
+  move_ = event;
+  has_move_ = true;
+}
+
+void motion::Coalescer::wheel(const Wheel& event) {
+  ++stats_.wheels_in;
+
+  if (!has_wheel_) {
+    wheel_first_ = !has_move_;
+    wheel_ = event;
+    has_wheel_ = true;
+    return;
+  }
+
+  wheel_.x = event.x;
+  wheel_.y = event.y;
+  wheel_.modifiers = event.modifiers;
+  wheel_.delta_x += event.delta_x;
+  wheel_.delta_y += event.delta_y;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+// Coalesces high-rate pointer motion so CEF sees at most one move and one
+// wheel event per flush. Button transitions are not handled here, callers
+// flush before forwarding them to keep the order intact.
+namespace motion {
+
+struct Move {
+  int x;
+  int y;
+  uint32_t modifiers;
+};
+
+struct Wheel {
+  int x;
+  int y;
+  uint32_t modifiers;
+  int delta_x;
+  int delta_y;
+};
+
+struct Stats {
+  uint64_t moves_in = 0;
+  uint64_t moves_out = 0;
+  uint64_t wheels_in = 0;
+  uint64_t wheels_out = 0;
+};
+
+class Coalescer {
+ public:
+  // Keeps only the latest position.
+  void move(const Move& event);
+
+  // Accumulates deltas, position and modifiers follow the latest event.
+  void wheel(const Wheel& event);
+
+  bool has_pending() const { return has_move_ || has_wheel_; }
+
+  // Emits what is pending in arrival order of the first event of each kind,
+  // then clears it.
+  template <typename OnMove, typename OnWheel>
+  void flush(OnMove&& on_move, OnWheel&& on_wheel) {
+    if (has_wheel_ && wheel_first_) {
+      emit_wheel(on_wheel);
+    }
+
+    if (has_move_) {
+      has_move_ = false;
+      ++stats_.moves_out;
+      on_move(move_);
+    }
+
+    if (has_wheel_) {
+      emit_wheel(on_wheel);
+    }
+  }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  template <typename OnWheel>
+  void emit_wheel(OnWheel& on_wheel) {
+    has_wheel_ = false;
+    ++stats_.wheels_out;
+    on_wheel(wheel_);
+  }
+
+  Move move_{};
+  Wheel wheel_{};
+  bool has_move_ = false;
+  bool has_wheel_ = false;
+  bool wheel_first_ = false;
+  Stats stats_;
+};
+
+}  // namespace motion
@@ -0,0 +1,595 @@
+#include "tosu_overlay/overlay_api.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "include/cef_values.h"
+#include "tosu_overlay/frame_clock.h"
+#include "tosu_overlay/json_diff.h"
+#include "tosu_overlay/latency.h"
+#include "tosu_overlay/memory_stats.h"
+#include "tosu_overlay/overlay_stats.h"
+
+namespace {
+
+// Frees an ArrayBuffer's copy of a binary value once V8 lets go of it.
+class ReleaseBuffer : public CefV8ArrayBufferReleaseCallback {
+ public:
+  void ReleaseBuffer(void* buffer) override {
+    delete[] static_cast<char*>(buffer);
+  }
+
+ private:
+  IMPLEMENT_REFCOUNTING(ReleaseBuffer);
+};
+
+CefRefPtr<CefV8Value> to_v8_value(CefRefPtr<CefValue> value) {
+  switch (value->GetType()) {
+    case VTYPE_DICTIONARY: {
+      const auto dictionary = value->GetDictionary();
+      CefDictionaryValue::KeyList keys;
+      dictionary->GetKeys(keys);
+
+      auto object = CefV8Value::CreateObject(nullptr, nullptr);
+      for (const auto& key : keys) {
+        object->SetValue(key, to_v8_value(dictionary->GetValue(key)),
+                         V8_PROPERTY_ATTRIBUTE_NONE);
+      }
+      return object;
+    }
+    case VTYPE_LIST: {
+      const auto list = value->GetList();
+      const auto size = static_cast<int>(list->GetSize());
+
+      auto array = CefV8Value::CreateArray(size);
+      for (int i = 0; i < size; ++i) {
+        array->SetValue(i, to_v8_value(list->GetValue(i)));
+      }
+      return array;
+    }
+    case VTYPE_BINARY: {
+      const auto binary = value->GetBinary();
+      const auto size = binary->GetSize();
+
+      auto* buffer = new char[std::max<size_t>(size, 1)];
+      binary->GetData(buffer, size, 0);
+      return CefV8Value::CreateArrayBuffer(buffer, size, new ReleaseBuffer);
+    }
+    case VTYPE_STRING:
+      return CefV8Value::CreateString(value->GetString());
+    case VTYPE_INT:
+      return CefV8Value::CreateInt(value->GetInt());
+    case VTYPE_DOUBLE:
+      return CefV8Value::CreateDouble(value->GetDouble());
+    case VTYPE_BOOL:
+      return CefV8Value::CreateBool(value->GetBool());
+    default:
+      return CefV8Value::CreateNull();
+  }
+}
+
+CefRefPtr<CefV8Value> child(CefRefPtr<CefV8Value> node,
+                            const std::string& name) {
+  if (node->IsArray()) {
+    return node->GetValue(std::atoi(name.c_str()));
+  }
+  return node->GetValue(name);
+}
+
+void set_child(CefRefPtr<CefV8Value> node,
+               const std::string& name,
+               CefRefPtr<CefV8Value> value) {
+  if (node->IsArray()) {
+    node->SetValue(std::atoi(name.c_str()), value);
+  } else {
+    node->SetValue(name, value, V8_PROPERTY_ATTRIBUTE_NONE);
+  }
+}
+
+// Applies a json_diff patch to state in place, returns state (or what
+// replaced it).
+CefRefPtr<CefV8Value> apply_patch(CefRefPtr<CefV8Value> state,
+                                  CefRefPtr<CefDictionaryValue> patch) {
+  const auto set = patch->GetDictionary("set");
+  CefDictionaryValue::KeyList pointers;
+  set->GetKeys(pointers);
+
+  for (const auto& pointer : pointers) {
+    const auto value = to_v8_value(set->GetValue(pointer));
+    const auto path = json_diff::split_pointer(pointer.ToString());
+    if (path.empty()) {
+      state = value;
+      continue;
+    }
+
+    auto node = state;
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+      auto next = child(node, path[i]);
+      if (!next || !next->IsObject()) {
+        next = CefV8Value::CreateObject(nullptr, nullptr);
+        set_child(node, path[i], next);
+      }
+      node = next;
+    }
+    set_child(node, path.back(), value);
+  }
+
+  const auto remove = patch->GetList("remove");
+  for (size_t i = 0; i < remove->GetSize(); ++i) {
+    const auto path =
+        json_diff::split_pointer(remove->GetString(i).ToString());
+    if (path.empty()) {
+      continue;
+    }
+
+    auto node = state;
+    for (size_t j = 0; node && j + 1 < path.size(); ++j) {
+      node = child(node, path[j]);
+    }
+    if (node && node->IsObject() && !node->IsArray()) {
+      node->DeleteValue(path.back());
+    }
+  }
+
+  return state;
+}
+
+// The page's performance.now() in microseconds, 0 if it has none.
+int64_t page_now_us(CefRefPtr<CefV8Context> context) {
+  const auto performance = context->GetGlobal()->GetValue("performance");
+  const auto now = performance ? performance->GetValue("now") : nullptr;
+  if (!now || !now->IsFunction()) {
+    return 0;
+  }
+
+  const auto result = now->ExecuteFunction(performance, {});
+  if (!result || !(result->IsDouble() || result->IsInt())) {
+    return 0;
+  }
+  return static_cast<int64_t>(result->GetDoubleValue() * 1000.0);
+}
+
+// performance.memory.usedJSHeapSize, 0 if the page has none.
+double js_heap_used(CefRefPtr<CefV8Context> context) {
+  const auto performance = context->GetGlobal()->GetValue("performance");
+  const auto memory = performance ? performance->GetValue("memory") : nullptr;
+  const auto used =
+      memory && memory->IsObject() ? memory->GetValue("usedJSHeapSize")
+                                   : nullptr;
+  // numbers that fit 32 bits come back as ints
+  if (!used || !(used->IsDouble() || used->IsInt() || used->IsUInt())) {
+    return 0.0;
+  }
+  return used->GetDoubleValue();
+}
+
+}  // namespace
+
+void OverlayApi::OnContextCreated(CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefV8Context> context) {
+  frames_[frame->GetIdentifier().ToString()] = {context, {}};
+
+  auto api = CefV8Value::CreateObject(nullptr, nullptr);
+  for (const char* name :
+       {"subscribe", "unsubscribe", "frameClock", "stats", "setBudget"}) {
+    api->SetValue(name, CefV8Value::CreateFunction(name, this),
+                  V8_PROPERTY_ATTRIBUTE_READONLY);
+  }
+
+  context->GetGlobal()->SetValue("tosuOverlay", api,
+                                 V8_PROPERTY_ATTRIBUTE_READONLY);
+}
+
+void OverlayApi::OnContextReleased(CefRefPtr<CefFrame> frame,
+                                   CefRefPtr<CefV8Context> context) {
+  const auto it = frames_.find(frame->GetIdentifier().ToString());
+  if (it == frames_.end() || !it->second.context->IsSame(context)) {
+    return;
+  }
+
+  auto subscriptions = std::move(it->second.subscriptions);
+  const bool clock_watched = it->second.clock.watched;
+  const bool stats_watched = it->second.stats.watched;
+  frames_.erase(it);
+
+  if (clock_watched) {
+    frame->SendProcessMessage(
+        PID_BROWSER,
+        CefProcessMessage::Create(frame_clock::unwatch_message));
+  }
+  if (stats_watched) {
+    frame->SendProcessMessage(
+        PID_BROWSER,
+        CefProcessMessage::Create(overlay_stats::unwatch_message));
+  }
+
+  for (size_t i = 0; i < subscriptions.size(); ++i) {
+    const auto& subscription = subscriptions[i];
+    const bool first = std::none_of(
+        subscriptions.begin(), subscriptions.begin() + i,
+        [&](const Subscription& other) {
+          return other.endpoint == subscription.endpoint &&
+                 other.format == subscription.format;
+        });
+    if (first) {
+      SendSubscription(frame, tosu_feed::unsubscribe_message,
+                       subscription.endpoint, subscription.format);
+    }
+  }
+}
+
+bool OverlayApi::OnProcessMessage(CefRefPtr<CefFrame> frame,
+                                  CefRefPtr<CefProcessMessage> message) {
+  if (message->GetName() == frame_clock::update_message) {
+    const auto it = frames_.find(frame->GetIdentifier().ToString());
+    if (it != frames_.end()) {
+      OnFrameClock(it->second, message->GetArgumentList());
+    }
+    return true;
+  }
+
+  if (message->GetName() == overlay_stats::update_message) {
+    const auto it = frames_.find(frame->GetIdentifier().ToString());
+    if (it != frames_.end()) {
+      OnStats(it->second, message->GetArgumentList());
+    }
+    return true;
+  }
+
+  if (message->GetName() != tosu_feed::update_message) {
+    return false;
+  }
+
+  const auto it = frames_.find(frame->GetIdentifier().ToString());
+  if (it == frames_.end()) {
+    return true;
+  }
+
+  const auto args = message->GetArgumentList();
+  const auto endpoint = args->GetString(0).ToString();
+  const auto format = tosu_feed::parse_format(args->GetString(1).ToString());
+  const bool is_patch = args->GetString(3) == tosu_feed::update_patch;
+  if (!format) {
+    return true;
+  }
+
+  // callbacks may unsubscribe while this runs
+  std::vector<CefRefPtr<CefV8Value>> callbacks;
+  for (const auto& subscription : it->second.subscriptions) {
+    if (subscription.endpoint == endpoint && subscription.format == *format) {
+      callbacks.push_back(subscription.callback);
+    }
+  }
+  if (callbacks.empty()) {
+    return true;
+  }
+
+  auto context = it->second.context;
+  if (!context->Enter()) {
+    return true;
+  }
+
+  CefV8ValueList arguments;
+  if (*format == tosu_feed::Format::patch) {
+    auto& state = it->second.states[endpoint];
+    if (is_patch && state) {
+      state = apply_patch(state, args->GetDictionary(2));
+      arguments = {state, to_v8_value(args->GetValue(2))};
+    } else if (!is_patch) {
+      state = to_v8_value(args->GetValue(2));
+      arguments = {state, CefV8Value::CreateNull()};
+    } else {
+      // a patch without the state it goes on, can't be used
+      context->Exit();
+      return true;
+    }
+  } else {
+    arguments = {to_v8_value(args->GetValue(2))};
+  }
+
+  for (const auto& callback : callbacks) {
+    callback->ExecuteFunction(nullptr, arguments);
+    // one page's broken callback shouldn't starve the others
+    if (callback->HasException()) {
+      callback->ClearException();
+    }
+  }
+
+  context->Exit();
+  return true;
+}
+
+bool OverlayApi::Execute(const CefString& name,
+                         CefRefPtr<CefV8Value> object,
+                         const CefV8ValueList& arguments,
+                         CefRefPtr<CefV8Value>& retval,
+                         CefString& exception) {
+  if (name == "subscribe") {
+    return Subscribe(arguments, retval, exception);
+  }
+  if (name == "unsubscribe") {
+    return Unsubscribe(arguments);
+  }
+  if (name == "frameClock") {
+    return FrameClock(retval);
+  }
+  if (name == "stats") {
+    return GetStats(retval);
+  }
+  if (name == "setBudget") {
+    return SetBudget(arguments, exception);
+  }
+  return false;
+}
+
+bool OverlayApi::Subscribe(const CefV8ValueList& arguments,
+                           CefRefPtr<CefV8Value>& retval,
+                           CefString& exception) {
+  if (arguments.size() < 2 || !arguments[0]->IsString() ||
+      !arguments[1]->IsFunction()) {
+    exception = "subscribe(endpoint, callback, options) needs a string and "
+                "a function";
+    return true;
+  }
+
+  const auto endpoint = arguments[0]->GetStringValue().ToString();
+  if (!tosu_feed::valid_endpoint(endpoint)) {
+    exception = "subscribe(): not a tosu /websocket/ endpoint";
+    return true;
+  }
+
+  std::string format_name;
+  if (arguments.size() > 2 && arguments[2]->IsObject()) {
+    const auto option = arguments[2]->GetValue("format");
+    if (option && option->IsString()) {
+      format_name = option->GetStringValue().ToString();
+    }
+  }
+  const auto format = tosu_feed::parse_format(format_name);
+  if (!format) {
+    exception =
+        "subscribe(): format is \"object\", \"msgpack\" or \"patch\"";
+    return true;
+  }
+
+  const auto frame = CefV8Context::GetCurrentContext()->GetFrame();
+  auto& state = frames_[frame->GetIdentifier().ToString()];
+
+  if (!Subscribed(state, endpoint, *format)) {
+    SendSubscription(frame, tosu_feed::subscribe_message, endpoint, *format);
+  }
+
+  const int id = next_id_++;
+  state.subscriptions.push_back({id, endpoint, *format, arguments[1]});
+  retval = CefV8Value::CreateInt(id);
+  return true;
+}
+
+bool OverlayApi::Unsubscribe(const CefV8ValueList& arguments) {
+  if (arguments.empty() || !arguments[0]->IsInt()) {
+    return true;
+  }
+
+  const auto frame = CefV8Context::GetCurrentContext()->GetFrame();
+  const auto it = frames_.find(frame->GetIdentifier().ToString());
+  if (it == frames_.end()) {
+    return true;
+  }
+
+  auto& subscriptions = it->second.subscriptions;
+  const int id = arguments[0]->GetIntValue();
+  const auto subscription =
+      std::find_if(subscriptions.begin(), subscriptions.end(),
+                   [&](const Subscription& entry) { return entry.id == id; });
+  if (subscription == subscriptions.end()) {
+    return true;
+  }
+
+  const auto endpoint = subscription->endpoint;
+  const auto format = subscription->format;
+  subscriptions.erase(subscription);
+
+  if (!Subscribed(it->second, endpoint, format)) {
+    SendSubscription(frame, tosu_feed::unsubscribe_message, endpoint, format);
+    if (format == tosu_feed::Format::patch) {
+      it->second.states.erase(endpoint);
+    }
+  }
+  return true;
+}
+
+bool OverlayApi::FrameClock(CefRefPtr<CefV8Value>& retval) {
+  const auto context = CefV8Context::GetCurrentContext();
+  const auto frame = context->GetFrame();
+  auto& clock = frames_[frame->GetIdentifier().ToString()].clock;
+
+  if (!clock.watched) {
+    clock.watched = true;
+    clock.offset_us = latency::now_us() - page_now_us(context);
+    frame->SendProcessMessage(
+        PID_BROWSER, CefProcessMessage::Create(frame_clock::watch_message));
+  }
+
+  if (clock.presents_us.empty()) {
+    retval = CefV8Value::CreateNull();
+    return true;
+  }
+
+  const auto page_ms = [&](int64_t us) {
+    return CefV8Value::CreateDouble(
+        static_cast<double>(us - clock.offset_us) / 1000.0);
+  };
+
+  auto presents =
+      CefV8Value::CreateArray(static_cast<int>(clock.presents_us.size()));
+  for (size_t i = 0; i < clock.presents_us.size(); ++i) {
+    presents->SetValue(static_cast<int>(i), page_ms(clock.presents_us[i]));
+  }
+
+  // the update is up to an overlay frame old, roll the next present on
+  auto next_us = clock.next_present_us;
+  const auto now_us = latency::now_us();
+  if (next_us != 0 && clock.interval_us > 0 && next_us <= now_us) {
+    next_us += ((now_us - next_us) / clock.interval_us + 1) *
+               clock.interval_us;
+  }
+
+  const auto interval_us = clock.interval_us;
+  auto result = CefV8Value::CreateObject(nullptr, nullptr);
+  result->SetValue("presents", presents, V8_PROPERTY_ATTRIBUTE_NONE);
+  result->SetValue("lastPresent", page_ms(clock.presents_us.back()),
+                   V8_PROPERTY_ATTRIBUTE_NONE);
+  result->SetValue(
+      "frameInterval",
+      CefV8Value::CreateDouble(static_cast<double>(interval_us) / 1000.0),
+      V8_PROPERTY_ATTRIBUTE_NONE);
+  result->SetValue(
+      "fps",
+      CefV8Value::CreateDouble(
+          interval_us > 0 ? 1e6 / static_cast<double>(interval_us) : 0.0),
+      V8_PROPERTY_ATTRIBUTE_NONE);
+  result->SetValue("nextPresent",
+                   next_us != 0 ? page_ms(next_us) : CefV8Value::CreateNull(),
+                   V8_PROPERTY_ATTRIBUTE_NONE);
+
+  retval = result;
+  return true;
+}
+
+void OverlayApi::OnFrameClock(FrameState& state,
+                              CefRefPtr<CefListValue> args) {
+  auto& clock = state.clock;
+
+  const auto presents = args->GetList(0);
+  for (size_t i = 0; presents && i < presents->GetSize(); ++i) {
+    clock.presents_us.push_back(
+        static_cast<int64_t>(presents->GetDouble(i)));
+  }
+  while (clock.presents_us.size() > frame_clock::max_presents) {
+    clock.presents_us.pop_front();
+  }
+
+  clock.interval_us = static_cast<int64_t>(args->GetDouble(1));
+  clock.next_present_us = static_cast<int64_t>(args->GetDouble(2));
+}
+
+bool OverlayApi::GetStats(CefRefPtr<CefV8Value>& retval) {
+  const auto frame = CefV8Context::GetCurrentContext()->GetFrame();
+  auto& state = frames_[frame->GetIdentifier().ToString()];
+  WatchStats(frame, state);
+
+  retval = state.stats.latest ? state.stats.latest : CefV8Value::CreateNull();
+  return true;
+}
+
+bool OverlayApi::SetBudget(const CefV8ValueList& arguments,
+                           CefString& exception) {
+  const auto frame = CefV8Context::GetCurrentContext()->GetFrame();
+  auto& state = frames_[frame->GetIdentifier().ToString()];
+
+  if (arguments.empty() || arguments[0]->IsNull() ||
+      arguments[0]->IsUndefined()) {
+    state.stats.budget = nullptr;
+    state.stats.on_violation = nullptr;
+    return true;
+  }
+
+  if (arguments.size() < 2 || !arguments[0]->IsObject() ||
+      !arguments[1]->IsFunction()) {
+    exception = "setBudget(limits, callback) needs an object and a function";
+    return true;
+  }
+
+  state.stats.budget = arguments[0];
+  state.stats.on_violation = arguments[1];
+  WatchStats(frame, state);
+  return true;
+}
+
+void OverlayApi::OnStats(FrameState& state, CefRefPtr<CefListValue> args) {
+  auto context = state.context;
+  if (!context->Enter()) {
+    return;
+  }
+
+  // the renderer's own numbers, read here where they are
+  memory_stats::Sample memory{};
+  memory_stats::sample_process(memory);
+
+  auto stats = to_v8_value(args->GetValue(0));
+  const auto set = [&](const char* key, double value) {
+    stats->SetValue(key, CefV8Value::CreateDouble(value),
+                    V8_PROPERTY_ATTRIBUTE_NONE);
+  };
+  set("workingSet", static_cast<double>(memory.working_set));
+  set("privateBytes", static_cast<double>(memory.private_bytes));
+  set("jsHeapUsed", js_heap_used(context));
+  state.stats.latest = stats;
+
+  // the callback may change or clear the budget
+  const auto budget = state.stats.budget;
+  const auto callback = state.stats.on_violation;
+  std::vector<CefString> violations;
+  if (budget && callback) {
+    std::vector<CefString> keys;
+    budget->GetKeys(keys);
+    for (const auto& key : keys) {
+      const auto limit = budget->GetValue(key);
+      const auto value = stats->GetValue(key);
+      if (limit && value && (limit->IsDouble() || limit->IsInt()) &&
+          value->GetDoubleValue() > limit->GetDoubleValue()) {
+        violations.push_back(key);
+      }
+    }
+  }
+
+  if (!violations.empty()) {
+    auto names = CefV8Value::CreateArray(static_cast<int>(violations.size()));
+    for (size_t i = 0; i < violations.size(); ++i) {
+      names->SetValue(static_cast<int>(i),
+                      CefV8Value::CreateString(violations[i]));
+    }
+
+    callback->ExecuteFunction(nullptr, {names, stats});
+    if (callback->HasException()) {
+      callback->ClearException();
+    }
+  }
+
+  context->Exit();
+}
+
+// static
+void OverlayApi::WatchStats(CefRefPtr<CefFrame> frame, FrameState& state) {
+  if (state.stats.watched) {
+    return;
+  }
+
+  state.stats.watched = true;
+  frame->SendProcessMessage(
+      PID_BROWSER, CefProcessMessage::Create(overlay_stats::watch_message));
+}
+
+// static
+bool OverlayApi::Subscribed(const FrameState& state,
+                            const std::string& endpoint,
+                            tosu_feed::Format format) {
+  return std::any_of(state.subscriptions.begin(), state.subscriptions.end(),
+                     [&](const Subscription& subscription) {
+                       return subscription.endpoint == endpoint &&
+                              subscription.format == format;
+                     });
+}
+
+// static
+void OverlayApi::SendSubscription(CefRefPtr<CefFrame> frame,
+                                  const char* message_name,
+                                  const std::string& endpoint,
+                                  tosu_feed::Format format) {
+  auto message = CefProcessMessage::Create(message_name);
+  auto args = message->GetArgumentList();
+  args->SetString(0, endpoint);
+  args->SetString(1, tosu_feed::format_name(format));
+  frame->SendProcessMessage(PID_BROWSER, message);
+}
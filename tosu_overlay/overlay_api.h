@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "include/cef_v8.h"
+#include "tosu_overlay/tosu_feed.h"
+
+// window.tosuOverlay, installed into every frame by the render process:
+//
+//   const id = tosuOverlay.subscribe("/websocket/v2", state => { ... });
+//   tosuOverlay.subscribe("/websocket/v2/precise", onPrecise,
+//                         {format: "msgpack"});  // ArrayBuffer
+//   tosuOverlay.subscribe("/websocket/v2", (state, changes) => { ... },
+//                         {format: "patch"});
+//   tosuOverlay.unsubscribe(id);
+//
+//   const clock = tosuOverlay.frameClock();
+//   // {presents, lastPresent, frameInterval, fps, nextPresent} or null
+//
+//   const stats = tosuOverlay.stats();  // see below, or null
+//   tosuOverlay.setBudget({paintRate: 30, hookP99: 0.5},
+//                         (violations, stats) => { ... });
+//   tosuOverlay.setBudget(null);
+//
+// Callbacks get tosu's messages already parsed (see tosu_feed.h), the same
+// object for every callback of a frame. With "patch", state is one live
+// object updated in place and changes the json_diff patch that was applied
+// (null for the first call).
+//
+// frameClock() returns the game's recent presents (see frame_clock.h) in
+// performance.now() milliseconds, like requestAnimationFrame's timestamps.
+// The first call starts the updates and returns null until one arrived.
+//
+// stats() returns what the overlay cost over the last second (see
+// overlay_stats.h), updated once a second: paintRate (paints with damage per
+// second), dirtyArea (pixels per paint) and dirtyFraction (of the view),
+// uploadBytesPerSecond (texture uploads), gameFps, hookP50 and hookP99 (the
+// SwapBuffers hook's own time per game frame, in milliseconds),
+// droppedFrames (paints replaced before they were uploaded) and the
+// renderer's memory in bytes: workingSet, privateBytes and jsHeapUsed. Like
+// frameClock(), the first call starts the updates. setBudget() starts them
+// too and calls back with the names of the stats over their limit after
+// every update that has any.
+// Render process main thread only.
+class OverlayApi : public CefV8Handler {
+ public:
+  void OnContextCreated(CefRefPtr<CefFrame> frame,
+                        CefRefPtr<CefV8Context> context);
+  void OnContextReleased(CefRefPtr<CefFrame> frame,
+                         CefRefPtr<CefV8Context> context);
+
+  // Feed updates from the browser process, false for other messages.
+  bool OnProcessMessage(CefRefPtr<CefFrame> frame,
+                        CefRefPtr<CefProcessMessage> message);
+
+  // CefV8Handler methods:
+  bool Execute(const CefString& name,
+               CefRefPtr<CefV8Value> object,
+               const CefV8ValueList& arguments,
+               CefRefPtr<CefV8Value>& retval,
+               CefString& exception) override;
+
+ private:
+  struct Subscription {
+    int id;
+    std::string endpoint;
+    tosu_feed::Format format;
+    CefRefPtr<CefV8Value> callback;
+  };
+
+  struct Clock {
+    bool watched = false;
+    // latency::now_us() minus the page's performance.now() in microseconds
+    int64_t offset_us = 0;
+    // oldest first, in latency::now_us() time
+    std::deque<int64_t> presents_us;
+    int64_t interval_us = 0;
+    int64_t next_present_us = 0;
+  };
+
+  struct Stats {
+    bool watched = false;
+    // null before the first update
+    CefRefPtr<CefV8Value> latest;
+    // setBudget()'s limits and callback, null without one
+    CefRefPtr<CefV8Value> budget;
+    CefRefPtr<CefV8Value> on_violation;
+  };
+
+  struct FrameState {
+    CefRefPtr<CefV8Context> context;
+    std::vector<Subscription> subscriptions;
+    // "patch" subscriptions' live state by endpoint
+    std::map<std::string, CefRefPtr<CefV8Value>> states;
+    Clock clock;
+    Stats stats;
+  };
+
+  bool Subscribe(const CefV8ValueList& arguments,
+                 CefRefPtr<CefV8Value>& retval,
+                 CefString& exception);
+  bool Unsubscribe(const CefV8ValueList& arguments);
+  bool FrameClock(CefRefPtr<CefV8Value>& retval);
+  bool GetStats(CefRefPtr<CefV8Value>& retval);
+  bool SetBudget(const CefV8ValueList& arguments, CefString& exception);
+
+  // A frame_clock update from the browser process.
+  void OnFrameClock(FrameState& state, CefRefPtr<CefListValue> args);
+  // An overlay_stats update from the browser process.
+  void OnStats(FrameState& state, CefRefPtr<CefListValue> args);
+
+  // Starts the frame's stats updates unless they run already.
+  static void WatchStats(CefRefPtr<CefFrame> frame, FrameState& state);
+
+  // Whether frame's subscriptions include endpoint in format.
+  static bool Subscribed(const FrameState& state,
+                         const std::string& endpoint,
+                         tosu_feed::Format format);
+  static void SendSubscription(CefRefPtr<CefFrame> frame,
+                               const char* message_name,
+                               const std::string& endpoint,
+                               tosu_feed::Format format);
+
+  // by frame identifier
+  std::map<std::string, FrameState> frames_;
+  int next_id_ = 1;
+
+  IMPLEMENT_REFCOUNTING(OverlayApi);
+};
@@ -0,0 +1,116 @@
+#include <tosu_overlay/overlay_stats.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+
+std::atomic<uint64_t> paints = 0;
+std::atomic<uint64_t> dirty_area = 0;
+// paints since the last upload, all but the newest were never shown
+std::atomic<uint64_t> unuploaded = 0;
+
+// render thread only, so plain stores instead of read-modify-writes
+std::atomic<uint64_t> uploads = 0;
+std::atomic<uint64_t> upload_bytes = 0;
+std::atomic<uint64_t> dropped = 0;
+std::array<std::atomic<uint64_t>, latency::Histogram::bucket_count>
+    hook_buckets{};
+
+void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+  counter.store(counter.load(std::memory_order_relaxed) + by,
+                std::memory_order_relaxed);
+}
+
+// Middle of the bucket the percentile of the window's hook times falls into.
+int64_t percentile(const overlay_stats::Totals& now,
+                   const overlay_stats::Totals& before,
+                   uint64_t count,
+                   uint64_t per_mille) {
+  using latency::Histogram;
+
+  const auto rank = std::max<uint64_t>((count * per_mille + 999) / 1000, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < Histogram::bucket_count; ++i) {
+    seen += now.hook_buckets[i] - before.hook_buckets[i];
+    if (seen >= rank) {
+      const auto low = Histogram::bucket_floor(i);
+      const auto high = i + 1 < Histogram::bucket_count
+                            ? Histogram::bucket_floor(i + 1)
+                            : low;
+      return (low + high) / 2;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+void overlay_stats::painted(int64_t area) {
+  paints.fetch_add(1, std::memory_order_relaxed);
+  dirty_area.fetch_add(static_cast<uint64_t>(std::max<int64_t>(area, 0)),
+                       std::memory_order_relaxed);
+  unuploaded.fetch_add(1, std::memory_order_relaxed);
+}
+
+void overlay_stats::uploaded(uint64_t bytes) {
+  bump(uploads, 1);
+  bump(upload_bytes, bytes);
+
+  const auto pending = unuploaded.exchange(0, std::memory_order_relaxed);
+  if (pending > 1) {
+    bump(dropped, pending - 1);
+  }
+}
+
+void overlay_stats::hooked(int64_t us) {
+  bump(hook_buckets[latency::Histogram::bucket_of(us)], 1);
+}
+
+overlay_stats::Totals overlay_stats::totals() {
+  Totals result{};
+  result.paints = paints.load(std::memory_order_relaxed);
+  result.dirty_area = dirty_area.load(std::memory_order_relaxed);
+  result.uploads = uploads.load(std::memory_order_relaxed);
+  result.upload_bytes = upload_bytes.load(std::memory_order_relaxed);
+  result.dropped = dropped.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < hook_buckets.size(); ++i) {
+    result.hook_buckets[i] = hook_buckets[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+overlay_stats::Sampler::Sampler()
+    : last_(totals()), last_us_(latency::now_us()) {}
+
+overlay_stats::Window overlay_stats::Sampler::take(int64_t now_us) {
+  const auto now = totals();
+
+  Window window{};
+  window.duration_us = std::max<int64_t>(now_us - last_us_, 1);
+  const auto seconds = static_cast<double>(window.duration_us) / 1e6;
+
+  const auto paint_count = now.paints - last_.paints;
+  window.paint_rate = static_cast<double>(paint_count) / seconds;
+  if (paint_count > 0) {
+    window.dirty_area =
+        static_cast<int64_t>((now.dirty_area - last_.dirty_area) / paint_count);
+  }
+  window.upload_bytes_per_second =
+      static_cast<double>(now.upload_bytes - last_.upload_bytes) / seconds;
+  window.dropped_frames = now.dropped - last_.dropped;
+
+  uint64_t hooked_frames = 0;
+  for (size_t i = 0; i < now.hook_buckets.size(); ++i) {
+    hooked_frames += now.hook_buckets[i] - last_.hook_buckets[i];
+  }
+  window.game_fps = static_cast<double>(hooked_frames) / seconds;
+  if (hooked_frames > 0) {
+    window.hook_p50_us = percentile(now, last_, hooked_frames, 500);
+    window.hook_p99_us = percentile(now, last_, hooked_frames, 990);
+  }
+
+  last_ = now;
+  last_us_ = now_us;
+  return window;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <tosu_overlay/latency.h>
+
+// What the overlay costs per frame, for the log and for counter authors
+// (tosuOverlay.stats(), see overlay_api.h). The threads that do the work
+// bump running totals without locks; readers keep their own previous
+// totals and turn the difference into rates over their window.
+namespace overlay_stats {
+
+// Renderer -> browser, no arguments: start and stop updates for the frame.
+constexpr char watch_message[] = "tosu_overlay.stats_watch";
+constexpr char unwatch_message[] = "tosu_overlay.stats_unwatch";
+// Browser -> renderer about once a second, one argument: the Window fields
+// as a dictionary under their JavaScript names (SimpleHandler::SendStats()).
+constexpr char update_message[] = "tosu_overlay.stats";
+
+// CEF UI thread, per OnPaint with damage that reached the canvas.
+void painted(int64_t dirty_area);
+// Game render thread, per texture update, the bytes sent to the GPU.
+void uploaded(uint64_t bytes);
+// Game render thread, per SwapBuffers: the hook's own time, without the
+// original SwapBuffers.
+void hooked(int64_t us);
+
+struct Totals {
+  uint64_t paints;
+  uint64_t dirty_area;
+  uint64_t uploads;
+  uint64_t upload_bytes;
+  // paints replaced by a newer one before they were uploaded
+  uint64_t dropped;
+  // per game frame
+  std::array<uint64_t, latency::Histogram::bucket_count> hook_buckets;
+};
+
+Totals totals();
+
+struct Window {
+  int64_t duration_us;
+  double paint_rate;
+  // pixels per paint
+  int64_t dirty_area;
+  double upload_bytes_per_second;
+  double game_fps;
+  int64_t hook_p50_us;
+  int64_t hook_p99_us;
+  uint64_t dropped_frames;
+};
+
+// The totals' difference since the previous take() (or construction).
+class Sampler {
+ public:
+  Sampler();
+
+  Window take(int64_t now_us);
+
+ private:
+  Totals last_;
+  int64_t last_us_;
+};
+
+}  // namespace overlay_stats
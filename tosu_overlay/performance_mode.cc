@@ -0,0 +1,115 @@
+#include <tosu_overlay/performance_mode.h>
+
+#include <algorithm>
+
+namespace {
+
+// !important, but between !important author rules specificity decides
+// before order does, so a page rule like .bg { filter: blur(8px)
+// !important } would beat a bare *. Every :not(#\0) (an id no element has)
+// adds an id's worth of specificity, three of them outrank any page rule
+// with fewer than three ids. Inline !important styles still win, and
+// animations driven from JS (requestAnimationFrame, the Web Animations API)
+// aren't touched. filter goes entirely, blur() and drop-shadow() being what
+// it's mostly used for. Infinite animations can't be told apart from finite
+// ones in CSS, so every animation runs once, then the element keeps its own
+// style.
+constexpr char stylesheet[] = R"css(
+*:not(#\0):not(#\0):not(#\0),
+*:not(#\0):not(#\0):not(#\0)::before,
+*:not(#\0):not(#\0):not(#\0)::after {
+  backdrop-filter: none !important;
+  -webkit-backdrop-filter: none !important;
+  filter: none !important;
+  box-shadow: none !important;
+  animation-iteration-count: 1 !important;
+}
+)css";
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+std::string unescape(std::string_view text) {
+  std::string result;
+  result.reserve(text.size());
+
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '%' && i + 2 < text.size() &&
+        hex_value(text[i + 1]) >= 0 && hex_value(text[i + 2]) >= 0) {
+      result += static_cast<char>(hex_value(text[i + 1]) * 16 +
+                                  hex_value(text[i + 2]));
+      i += 2;
+    } else {
+      result += text[i];
+    }
+  }
+
+  return result;
+}
+
+}  // namespace
+
+performance_mode::Config performance_mode::parse_config(
+    const nlohmann::json& config) {
+  Config result;
+  result.enabled = config.value("enabled", result.enabled);
+
+  const auto allow = config.value("allow", nlohmann::json::array());
+  for (const auto& counter : allow) {
+    if (counter.is_string()) {
+      result.allow.push_back(counter.get<std::string>());
+    }
+  }
+
+  return result;
+}
+
+std::string performance_mode::counter_of(std::string_view url) {
+  const auto scheme = url.find("://");
+  if (scheme == std::string_view::npos) {
+    return {};
+  }
+
+  const auto path = url.find('/', scheme + 3);
+  if (path == std::string_view::npos) {
+    return {};
+  }
+
+  auto segment = url.substr(path + 1);
+  segment = segment.substr(0, segment.find_first_of("/?#"));
+  return unescape(segment);
+}
+
+bool performance_mode::applies(const Config& config, std::string_view url) {
+  if (!config.enabled) {
+    return false;
+  }
+
+  const auto counter = counter_of(url);
+  return std::find(config.allow.begin(), config.allow.end(), counter) ==
+         config.allow.end();
+}
+
+const std::string& performance_mode::script() {
+  // the sheet as a JSON string is a valid JS string literal
+  static const std::string script =
+      "(() => {"
+      "const sheet = new CSSStyleSheet();"
+      "sheet.replaceSync(" +
+      nlohmann::json(stylesheet).dump() +
+      ");"
+      "document.adoptedStyleSheets = "
+      "[...document.adoptedStyleSheets, sheet];"
+      "})();";
+  return script;
+}
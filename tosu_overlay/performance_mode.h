@@ -0,0 +1,44 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A stylesheet that takes the costliest effects off counters. With the GPU
+// disabled, Chromium rasterizes every pixel on the CPU, and backdrop
+// filters, blurs, large shadows and endless animations re-raster big areas
+// every frame. With "performance_mode" enabled, the render process adopts
+// the stylesheet into every frame as its document is created, before the
+// page's own styles load, except for counters on the allowlist:
+//
+//   "performance_mode": {
+//     "enabled": false,
+//     "allow": ["my-counter"]  // counter folders keeping their effects
+//   }
+namespace performance_mode {
+
+// CreateBrowser() extra_info key carrying the config to the render process
+// as JSON.
+constexpr char extra_info_key[] = "performance_mode";
+
+struct Config {
+  bool enabled = false;
+  std::vector<std::string> allow;
+};
+
+Config parse_config(const nlohmann::json& config);
+
+// The counter a tosu URL belongs to, its folder: the first path segment,
+// unescaped. "http://127.0.0.1:24050/My%20Counter/index.html" ->
+// "My Counter". Empty without a path.
+std::string counter_of(std::string_view url);
+
+// Whether the stylesheet goes into a frame showing url.
+bool applies(const Config& config, std::string_view url);
+
+// Script adopting the stylesheet into the current document.
+const std::string& script();
+
+}  // namespace performance_mode
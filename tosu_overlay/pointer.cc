@@ -0,0 +1,75 @@
+#include <tosu_overlay/pointer.h>
+
+#include <cmath>
+
+#include "include/internal/cef_types.h"
+
+namespace {
+
+int32_t to_logical(int32_t value, float device_scale_factor) {
+  return static_cast<int32_t>(
+      std::floor(static_cast<float>(value) / device_scale_factor));
+}
+
+}  // namespace
+
+bool pointer::to_event(const Sample& sample,
+                       float device_scale_factor,
+                       uint32_t modifiers,
+                       input::Event& out) {
+  out = {};
+  out.x = to_logical(sample.x, device_scale_factor);
+  out.y = to_logical(sample.y, device_scale_factor);
+  out.modifiers = modifiers;
+
+  const auto flags = sample.flags;
+  const bool is_pen = sample.kind == Kind::pen;
+
+  if (flags & (canceled | down | up | in_contact)) {
+    out.type = input::Event::Type::touch;
+    out.touch_id = static_cast<int32_t>(sample.id);
+    out.pointer_type = is_pen ? CEF_POINTER_TYPE_PEN : CEF_POINTER_TYPE_TOUCH;
+    out.pressure = sample.pressure;
+    out.radius_x = static_cast<float>(sample.width) / 2 / device_scale_factor;
+    out.radius_y = static_cast<float>(sample.height) / 2 / device_scale_factor;
+
+    if (flags & canceled)
+      out.touch_type = CEF_TET_CANCELLED;
+    else if (flags & down)
+      out.touch_type = CEF_TET_PRESSED;
+    else if (flags & up)
+      out.touch_type = CEF_TET_RELEASED;
+    else
+      out.touch_type = CEF_TET_MOVED;
+
+    return true;
+  }
+
+  // a pen above the tablet drives hover like a mouse, fingers can't hover
+  if (!is_pen) {
+    return false;
+  }
+
+  out.type = (flags & in_range) ? input::Event::Type::mouse_move
+                                : input::Event::Type::mouse_leave;
+  return true;
+}
+
+bool pointer::Coalescer::move(const input::Event& event) {
+  ++stats_.moves_in;
+
+  for (size_t i = 0; i < pending_count_; ++i) {
+    if (pending_[i].touch_id == event.touch_id) {
+      pending_[i] = event;
+      return true;
+    }
+  }
+
+  if (pending_count_ == max_contacts) {
+    ++stats_.moves_out;
+    return false;
+  }
+
+  pending_[pending_count_++] = event;
+  return true;
+}
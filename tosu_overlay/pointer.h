@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <tosu_overlay/input_event.h>
+
+// Pen and touch input from WM_POINTER* messages. Everything here is plain
+// data so it can be exercised without the Windows pointer API, which sits
+// behind Source (see pointer_win.h).
+namespace pointer {
+
+enum class Kind : uint8_t {
+  touch,
+  pen,
+};
+
+// Subset of POINTER_FLAG_*.
+enum Flags : uint32_t {
+  in_range = 1 << 0,
+  in_contact = 1 << 1,
+  down = 1 << 2,
+  up = 1 << 3,
+  canceled = 1 << 4,
+};
+
+// One pointer frame, position in client pixels.
+struct Sample {
+  uint32_t id;
+  Kind kind;
+  uint32_t flags;
+  int32_t x;
+  int32_t y;
+  // 0..1, 0 when the device doesn't report it
+  float pressure;
+  // touch contact size, 0 when unknown
+  int32_t width;
+  int32_t height;
+};
+
+// Most pointer messages carry a single frame, but a 1 kHz tablet outruns the
+// message loop and Windows folds the frames in between into the next
+// message's history.
+constexpr size_t max_history = 64;
+
+// Fingers tracked at once, extra contacts are sent without coalescing.
+constexpr size_t max_contacts = 10;
+
+class Source {
+ public:
+  virtual ~Source() = default;
+
+  // Reads the frames of the pointer message being processed into out, newest
+  // first, in one batch. Returns how many were written, 0 for pointers that
+  // aren't pens or touch contacts.
+  virtual size_t read(uint32_t pointer_id, Sample* out, size_t max) = 0;
+};
+
+// Converts a frame to the event the page should see. Contacts become touch
+// events, a hovering pen moves the mouse. Returns false when the frame
+// carries nothing to send.
+bool to_event(const Sample& sample,
+              float device_scale_factor,
+              uint32_t modifiers,
+              input::Event& out);
+
+class Translator {
+ public:
+  // Reads one pointer message and calls emit(const input::Event&) for its
+  // frames, oldest first.
+  template <typename Emit>
+  size_t translate(Source& source,
+                   uint32_t pointer_id,
+                   float device_scale_factor,
+                   uint32_t modifiers,
+                   Emit&& emit) {
+    const auto count = source.read(pointer_id, history_.data(), max_history);
+
+    input::Event event;
+    for (size_t i = count; i-- > 0;) {
+      if (to_event(history_[i], device_scale_factor, modifiers, event)) {
+        emit(event);
+      }
+    }
+
+    return count;
+  }
+
+ private:
+  std::array<Sample, max_history> history_;
+};
+
+struct Stats {
+  uint64_t moves_in = 0;
+  uint64_t moves_out = 0;
+};
+
+// Keeps the newest touch move per contact between frames, the touch
+// counterpart of motion::Coalescer. Presses and releases are never held
+// back, whoever sends them flushes first to keep the order.
+class Coalescer {
+ public:
+  // Returns false when every contact slot is taken, the caller sends the
+  // event as is.
+  bool move(const input::Event& event);
+
+  bool has_pending() const { return pending_count_ != 0; }
+
+  // Calls send(const input::Event&) for each contact with a pending move, in
+  // the order they first moved since the previous flush.
+  template <typename Send>
+  void flush(Send&& send) {
+    for (size_t i = 0; i < pending_count_; ++i) {
+      send(pending_[i]);
+    }
+
+    stats_.moves_out += pending_count_;
+    pending_count_ = 0;
+  }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  std::array<input::Event, max_contacts> pending_;
+  size_t pending_count_ = 0;
+  Stats stats_;
+};
+
+}  // namespace pointer
@@ -0,0 +1,97 @@
+#include <tosu_overlay/pointer_win.h>
+
+#include <algorithm>
+
+namespace {
+
+// Both report pressure as 0..1024.
+constexpr float max_pressure = 1024.0f;
+
+uint32_t to_flags(POINTER_FLAGS flags) {
+  uint32_t result = 0;
+  if (flags & POINTER_FLAG_INRANGE)
+    result |= pointer::in_range;
+  if (flags & POINTER_FLAG_INCONTACT)
+    result |= pointer::in_contact;
+  if (flags & POINTER_FLAG_DOWN)
+    result |= pointer::down;
+  if (flags & POINTER_FLAG_UP)
+    result |= pointer::up;
+  if (flags & POINTER_FLAG_CANCELED)
+    result |= pointer::canceled;
+  return result;
+}
+
+pointer::Sample to_sample(HWND window,
+                          const POINTER_INFO& info,
+                          pointer::Kind kind) {
+  POINT point = info.ptPixelLocation;
+  ScreenToClient(window, &point);
+
+  pointer::Sample sample{};
+  sample.id = info.pointerId;
+  sample.kind = kind;
+  sample.flags = to_flags(info.pointerFlags);
+  sample.x = point.x;
+  sample.y = point.y;
+  return sample;
+}
+
+}  // namespace
+
+size_t pointer::Win32Source::read(uint32_t pointer_id,
+                                  Sample* out,
+                                  size_t max) {
+  POINTER_INPUT_TYPE type;
+  if (!GetPointerType(pointer_id, &type)) {
+    return 0;
+  }
+
+  // on return count holds how many frames were available, the newest ones
+  // that fit are in the buffer
+  const auto capacity = static_cast<UINT32>(std::min(max, max_history));
+  UINT32 count = capacity;
+
+  switch (type) {
+    case PT_PEN: {
+      if (!GetPointerPenInfoHistory(pointer_id, &count, pen_history_.data())) {
+        return 0;
+      }
+
+      count = std::min(count, capacity);
+      for (UINT32 i = 0; i < count; ++i) {
+        const auto& pen = pen_history_[i];
+        out[i] = to_sample(window_, pen.pointerInfo, Kind::pen);
+        if (pen.penMask & PEN_MASK_PRESSURE) {
+          out[i].pressure = static_cast<float>(pen.pressure) / max_pressure;
+        }
+      }
+    } break;
+
+    case PT_TOUCH: {
+      if (!GetPointerTouchInfoHistory(pointer_id, &count,
+                                      touch_history_.data())) {
+        return 0;
+      }
+
+      count = std::min(count, capacity);
+      for (UINT32 i = 0; i < count; ++i) {
+        const auto& touch = touch_history_[i];
+        out[i] = to_sample(window_, touch.pointerInfo, Kind::touch);
+        if (touch.touchMask & TOUCH_MASK_PRESSURE) {
+          out[i].pressure = static_cast<float>(touch.pressure) / max_pressure;
+        }
+        if (touch.touchMask & TOUCH_MASK_CONTACTAREA) {
+          out[i].width = touch.rcContact.right - touch.rcContact.left;
+          out[i].height = touch.rcContact.bottom - touch.rcContact.top;
+        }
+      }
+    } break;
+
+    default:
+      // mice and touchpads keep coming through the legacy mouse messages
+      return 0;
+  }
+
+  return count;
+}
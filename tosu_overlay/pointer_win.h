@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Windows.h>
+#include <tosu_overlay/pointer.h>
+
+#include <array>
+
+namespace pointer {
+
+// Reads pen and touch frames with GetPointer{Pen,Touch}InfoHistory, one call
+// per message. Positions are converted to the window's client area.
+class Win32Source : public Source {
+ public:
+  explicit Win32Source(HWND window) : window_(window) {}
+
+  size_t read(uint32_t pointer_id, Sample* out, size_t max) override;
+
+ private:
+  HWND window_;
+  std::array<POINTER_PEN_INFO, max_history> pen_history_;
+  std::array<POINTER_TOUCH_INFO, max_history> touch_history_;
+};
+
+}  // namespace pointer
@@ -0,0 +1,187 @@
+#include <tosu_overlay/region.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace {
+
+constexpr uint64_t never_written = std::numeric_limits<uint64_t>::max();
+
+// Bounding box may waste at most this share of the merged area.
+constexpr int64_t merge_waste_percent = 25;
+
+frame::Rect bounding_box(const frame::Rect& a, const frame::Rect& b) {
+  return frame::union_rects({a, b});
+}
+
+bool contains(const frame::Rect& outer, const frame::Rect& inner) {
+  return inner.x >= outer.x && inner.y >= outer.y &&
+         inner.x + inner.width <= outer.x + outer.width &&
+         inner.y + inner.height <= outer.y + outer.height;
+}
+
+bool cheap_to_merge(const frame::Rect& a, const frame::Rect& b) {
+  const auto box = bounding_box(a, b).area();
+  return (box - a.area() - b.area()) * 100 <= box * merge_waste_percent;
+}
+
+}  // namespace
+
+void region::Region::add(const frame::Rect& rect) {
+  if (rect.empty()) {
+    return;
+  }
+
+  auto pending = rect;
+
+  // merging can make the result overlap other rects, so keep going until
+  // nothing else folds into it
+  for (bool merged = true; merged;) {
+    merged = false;
+
+    for (auto it = rects_.begin(); it != rects_.end(); ++it) {
+      if (contains(*it, pending)) {
+        return;
+      }
+
+      if (contains(pending, *it) || cheap_to_merge(*it, pending)) {
+        pending = bounding_box(*it, pending);
+        rects_.erase(it);
+        merged = true;
+        break;
+      }
+    }
+  }
+
+  rects_.push_back(pending);
+
+  if (rects_.size() > max_rects) {
+    const auto box = bounds();
+    rects_.assign(1, box);
+  }
+}
+
+void region::Region::add(const frame::RectList& rects) {
+  for (const auto& rect : rects) {
+    add(rect);
+  }
+}
+
+void region::Region::add(const Region& other) {
+  add(other.rects_);
+}
+
+void region::Region::clear() {
+  rects_.clear();
+}
+
+frame::Rect region::Region::bounds() const {
+  return frame::union_rects(rects_);
+}
+
+int64_t region::Region::area() const {
+  int64_t total = 0;
+  for (const auto& rect : rects_) {
+    total += rect.area();
+  }
+
+  return total;
+}
+
+frame::RectList region::Region::upload_rects(size_t rect_limit,
+                                             float coverage) const {
+  if (rects_.size() <= 1) {
+    return rects_;
+  }
+
+  const auto box = bounds();
+  if (rects_.size() > rect_limit ||
+      static_cast<float>(area()) >= coverage * static_cast<float>(box.area())) {
+    return {box};
+  }
+
+  return rects_;
+}
+
+region::DamageHistory::DamageHistory(size_t slots, size_t depth)
+    : depth_(depth), slot_sequence_(slots, never_written) {}
+
+void region::DamageHistory::reset(const frame::Rect& bounds) {
+  bounds_ = bounds;
+  history_.clear();
+  std::fill(slot_sequence_.begin(), slot_sequence_.end(), never_written);
+}
+
+void region::DamageHistory::push(const frame::RectList& damage) {
+  history_.push_back(damage);
+  if (history_.size() > depth_) {
+    history_.pop_front();
+  }
+
+  ++sequence_;
+}
+
+region::Region region::DamageHistory::collect(size_t slot) {
+  Region result;
+
+  const auto frames_behind = age(slot);
+  if (frames_behind > history_.size()) {
+    // never written, or further behind than we remember
+    result.add(bounds_);
+  } else {
+    for (auto it = history_.end() - frames_behind; it != history_.end();
+         ++it) {
+      result.add(*it);
+    }
+  }
+
+  slot_sequence_[slot] = sequence_;
+
+  return result;
+}
+
+uint64_t region::DamageHistory::age(size_t slot) const {
+  const auto written = slot_sequence_[slot];
+  if (written == never_written) {
+    return never_written;
+  }
+
+  return sequence_ - written;
+}
+
+void region::write_stream_frame(std::ostream& out,
+                                const frame::RectList& damage) {
+  for (const auto& rect : damage) {
+    out << rect.x << ',' << rect.y << ',' << rect.width << ',' << rect.height
+        << ';';
+  }
+
+  out << '\n';
+}
+
+std::vector<frame::RectList> region::read_stream(std::istream& in) {
+  std::vector<frame::RectList> frames;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    frame::RectList damage;
+
+    std::istringstream rects(line);
+    std::string entry;
+    while (std::getline(rects, entry, ';')) {
+      frame::Rect rect{};
+      char sep;
+      std::istringstream values(entry);
+      if (values >> rect.x >> sep >> rect.y >> sep >> rect.width >> sep >>
+          rect.height) {
+        damage.push_back(rect);
+      }
+    }
+
+    frames.push_back(std::move(damage));
+  }
+
+  return frames;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+#include <tosu_overlay/frame.h>
+
+namespace region {
+
+// Short list of damaged rects. Rects that are cheap to merge (their bounding
+// box wastes little area) are coalesced on insert, so the list stays small.
+class Region {
+ public:
+  // Hard cap on the list length, past it everything collapses into the
+  // bounding box.
+  static constexpr size_t max_rects = 16;
+
+  void add(const frame::Rect& rect);
+  void add(const frame::RectList& rects);
+  void add(const Region& other);
+
+  void clear();
+
+  bool empty() const { return rects_.empty(); }
+  const frame::RectList& rects() const { return rects_; }
+
+  frame::Rect bounds() const;
+
+  // Sum of the rect areas.
+  int64_t area() const;
+
+  // Rects to upload. Falls back to the bounding box when the region is too
+  // fragmented (more than |rect_limit| rects) or already covers at least
+  // |coverage| of its bounding box, since one large upload beats many small.
+  frame::RectList upload_rects(size_t rect_limit, float coverage) const;
+
+ private:
+  frame::RectList rects_;
+};
+
+// Buffer-age tracking for a ring of buffered copies of the frame (texture or
+// PBO slots). Every CEF frame pushes its damage, and a slot that is about to
+// be written asks for the union of all damage since it was last written.
+class DamageHistory {
+ public:
+  DamageHistory(size_t slots, size_t depth);
+
+  // Forgets all history, every slot is fully damaged on its next collect().
+  void reset(const frame::Rect& bounds);
+
+  // Records the damage of one CEF frame.
+  void push(const frame::RectList& damage);
+
+  // Damage |slot| has to catch up on, the slot is marked current afterwards.
+  Region collect(size_t slot);
+
+  // Number of frames |slot| is behind, 0 means up to date.
+  uint64_t age(size_t slot) const;
+
+  // True once a slot has fallen behind since its last collect().
+  bool pending(size_t slot) const { return age(slot) != 0; }
+
+ private:
+  frame::Rect bounds_{0, 0, 0, 0};
+  size_t depth_;
+  std::deque<frame::RectList> history_;
+  uint64_t sequence_ = 0;
+  // sequence each slot was last written at, UINT64_MAX when never written
+  std::vector<uint64_t> slot_sequence_;
+};
+
+// Plain-text damage streams, one frame per line: "x,y,w,h;x,y,w,h;...".
+// Used to record real OnPaint damage and replay it in the benchmarks.
+void write_stream_frame(std::ostream& out, const frame::RectList& damage);
+std::vector<frame::RectList> read_stream(std::istream& in);
+
+}  // namespace region
@@ -0,0 +1,112 @@
+#include "tosu_overlay/renderer_app.h"
+
+#include "include/cef_v8.h"
+#include "tosu_overlay/memory_stats.h"
+
+namespace {
+
+uint64_t heap_value(CefRefPtr<CefV8Value> memory, const char* key) {
+  const auto value = memory->GetValue(key);
+  // numbers that fit 32 bits come back as ints
+  if (!value || !(value->IsDouble() || value->IsInt() || value->IsUInt())) {
+    return 0;
+  }
+
+  return static_cast<uint64_t>(value->GetDoubleValue());
+}
+
+memory_stats::Sample take_sample(CefRefPtr<CefFrame> frame) {
+  memory_stats::Sample sample{};
+  memory_stats::sample_process(sample);
+
+  const auto context = frame->GetV8Context();
+  if (!context || !context->Enter()) {
+    return sample;
+  }
+
+  CefRefPtr<CefV8Value> memory;
+  CefRefPtr<CefV8Exception> exception;
+  if (context->Eval("performance.memory", CefString(), 0, memory,
+                    exception) &&
+      memory && memory->IsObject()) {
+    sample.js_heap_used = heap_value(memory, "usedJSHeapSize");
+    sample.js_heap_total = heap_value(memory, "totalJSHeapSize");
+    sample.js_heap_limit = heap_value(memory, "jsHeapSizeLimit");
+  }
+
+  context->Exit();
+  return sample;
+}
+
+}  // namespace
+
+void RendererApp::OnBrowserCreated(CefRefPtr<CefBrowser> browser,
+                                   CefRefPtr<CefDictionaryValue> extra_info) {
+  if (!extra_info || !extra_info->HasKey(performance_mode::extra_info_key)) {
+    return;
+  }
+
+  const auto config = nlohmann::json::parse(
+      extra_info->GetString(performance_mode::extra_info_key).ToString(),
+      nullptr, false);
+  if (config.is_object()) {
+    performance_modes_[browser->GetIdentifier()] =
+        performance_mode::parse_config(config);
+  }
+}
+
+void RendererApp::OnBrowserDestroyed(CefRefPtr<CefBrowser> browser) {
+  performance_modes_.erase(browser->GetIdentifier());
+}
+
+void RendererApp::OnContextCreated(CefRefPtr<CefBrowser> browser,
+                                   CefRefPtr<CefFrame> frame,
+                                   CefRefPtr<CefV8Context> context) {
+  overlay_api_->OnContextCreated(frame, context);
+
+  // before the page's scripts and styles, so effects never get rastered
+  const auto performance = performance_modes_.find(browser->GetIdentifier());
+  if (performance != performance_modes_.end() &&
+      performance_mode::applies(performance->second,
+                                frame->GetURL().ToString()) &&
+      context->Enter()) {
+    CefRefPtr<CefV8Value> result;
+    CefRefPtr<CefV8Exception> exception;
+    context->Eval(performance_mode::script(), CefString(), 0, result,
+                  exception);
+    context->Exit();
+  }
+}
+
+void RendererApp::OnContextReleased(CefRefPtr<CefBrowser> browser,
+                                    CefRefPtr<CefFrame> frame,
+                                    CefRefPtr<CefV8Context> context) {
+  overlay_api_->OnContextReleased(frame, context);
+}
+
+bool RendererApp::OnProcessMessageReceived(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefProcessId source_process,
+    CefRefPtr<CefProcessMessage> message) {
+  if (overlay_api_->OnProcessMessage(frame, message)) {
+    return true;
+  }
+
+  if (message->GetName() != memory_stats::sample_message) {
+    return false;
+  }
+
+  const auto sample = take_sample(frame);
+
+  auto reply = CefProcessMessage::Create(memory_stats::sample_message);
+  auto args = reply->GetArgumentList();
+  args->SetDouble(0, static_cast<double>(sample.working_set));
+  args->SetDouble(1, static_cast<double>(sample.private_bytes));
+  args->SetDouble(2, static_cast<double>(sample.js_heap_used));
+  args->SetDouble(3, static_cast<double>(sample.js_heap_total));
+  args->SetDouble(4, static_cast<double>(sample.js_heap_limit));
+
+  frame->SendProcessMessage(PID_BROWSER, reply);
+  return true;
+}
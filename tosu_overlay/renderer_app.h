@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+
+#include "include/cef_app.h"
+#include "tosu_overlay/overlay_api.h"
+#include "tosu_overlay/performance_mode.h"
+
+// Application-level callbacks for the render process: answers the browser
+// process's memory sample requests (see memory_stats.h), provides
+// window.tosuOverlay (see overlay_api.h) and adopts the performance mode
+// stylesheet (see performance_mode.h).
+class RendererApp : public CefApp, public CefRenderProcessHandler {
+ public:
+  // CefApp methods:
+  CefRefPtr<CefRenderProcessHandler> GetRenderProcessHandler() override {
+    return this;
+  }
+
+  // CefRenderProcessHandler methods:
+  void OnBrowserCreated(CefRefPtr<CefBrowser> browser,
+                        CefRefPtr<CefDictionaryValue> extra_info) override;
+  void OnBrowserDestroyed(CefRefPtr<CefBrowser> browser) override;
+  void OnContextCreated(CefRefPtr<CefBrowser> browser,
+                        CefRefPtr<CefFrame> frame,
+                        CefRefPtr<CefV8Context> context) override;
+  void OnContextReleased(CefRefPtr<CefBrowser> browser,
+                         CefRefPtr<CefFrame> frame,
+                         CefRefPtr<CefV8Context> context) override;
+  bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                CefRefPtr<CefFrame> frame,
+                                CefProcessId source_process,
+                                CefRefPtr<CefProcessMessage> message) override;
+
+ private:
+  CefRefPtr<OverlayApi> overlay_api_ = new OverlayApi;
+
+  // by browser identifier, for browsers with performance mode enabled
+  std::map<int, performance_mode::Config> performance_modes_;
+
+  IMPLEMENT_REFCOUNTING(RendererApp);
+};
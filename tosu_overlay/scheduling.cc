@@ -0,0 +1,86 @@
+#include <tosu_overlay/scheduling.h>
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+constexpr unsigned max_cores = 64;
+
+}  // namespace
+
+std::optional<scheduling::Priority> scheduling::parse_priority(
+    std::string_view name) {
+  if (name == "idle")
+    return Priority::idle;
+  if (name == "below_normal")
+    return Priority::below_normal;
+  if (name == "normal")
+    return Priority::normal;
+  if (name == "above_normal")
+    return Priority::above_normal;
+
+  return std::nullopt;
+}
+
+const char* scheduling::priority_name(Priority priority) {
+  switch (priority) {
+    case Priority::idle:
+      return "idle";
+    case Priority::below_normal:
+      return "below_normal";
+    case Priority::normal:
+      return "normal";
+    case Priority::above_normal:
+      return "above_normal";
+  }
+
+  return "";
+}
+
+scheduling::Policy scheduling::parse_policy(const nlohmann::json& config,
+                                            unsigned core_count) {
+  Policy policy;
+
+  const auto priority = [&](const char* key, Priority fallback) {
+    return parse_priority(config.value(key, std::string()))
+        .value_or(fallback);
+  };
+
+  policy.subprocess_priority =
+      priority("subprocess_priority", policy.subprocess_priority);
+  policy.cef_thread_priority =
+      priority("cef_thread_priority", policy.cef_thread_priority);
+  policy.background_thread_priority =
+      priority("background_thread_priority", policy.background_thread_priority);
+
+  const auto cores = std::min(core_count, max_cores);
+  const auto all = cores == max_cores ? ~uint64_t{0}
+                                      : (uint64_t{1} << cores) - 1;
+
+  uint64_t avoided = 0;
+  const auto avoid = config.value("avoid_cores", nlohmann::json::array());
+  for (const auto& core : avoid) {
+    if (!core.is_number_integer()) {
+      continue;
+    }
+
+    const auto index = core.get<int64_t>();
+    if (index >= 0 && index < static_cast<int64_t>(cores)) {
+      avoided |= uint64_t{1} << index;
+    }
+  }
+
+  if (avoided != 0 && (all & ~avoided) != 0) {
+    policy.affinity = all & ~avoided;
+  }
+
+  return policy;
+}
+
+void scheduling::apply_to_thread(Priority priority, uint64_t affinity) {
+  set_thread_priority(priority);
+  if (affinity != 0) {
+    set_thread_affinity(affinity);
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Where CEF runs next to osu!: priority for the subprocesses (renderer,
+// utility) and for CEF's threads inside the game, and an affinity mask that
+// keeps them off the cores osu! leans on.
+//
+//   "scheduling": {
+//     "subprocess_priority": "below_normal",
+//     "cef_thread_priority": "normal",
+//     "background_thread_priority": "idle",
+//     "avoid_cores": [0, 1]
+//   }
+//
+// Priorities are "idle", "below_normal", "normal" or "above_normal".
+namespace scheduling {
+
+enum class Priority {
+  idle,
+  below_normal,
+  normal,
+  above_normal,
+};
+
+std::optional<Priority> parse_priority(std::string_view name);
+const char* priority_name(Priority priority);
+
+struct Policy {
+  Priority subprocess_priority = Priority::below_normal;
+  // the in-process thread running CefInitialize and the message loop
+  Priority cef_thread_priority = Priority::normal;
+  // the overlay's own helper threads (resource prefaulting)
+  Priority background_thread_priority = Priority::idle;
+  // 0 leaves affinity alone
+  uint64_t affinity = 0;
+};
+
+// Unknown priorities keep the defaults above. avoid_cores is turned into a
+// mask of the remaining cores, left at 0 when it would exclude all of them.
+Policy parse_policy(const nlohmann::json& config, unsigned core_count);
+
+// How subprocesses get the policy, the browser process adds these to their
+// command lines in OnBeforeChildProcessLaunch.
+constexpr char priority_switch[] = "tosu-priority";
+constexpr char affinity_switch[] = "tosu-affinity";
+
+// Platform layer, scheduling_win.cc and scheduling_linux.cc. On Windows the
+// process calls cover every thread of the process and the thread calls only
+// the calling thread, threads started afterwards get the process's mask and
+// normal priority. On Linux nice and affinity are per thread, so the process
+// calls only change the calling thread and threads started afterwards
+// inherit them.
+unsigned core_count();
+bool set_process_priority(Priority priority);
+bool set_process_affinity(uint64_t mask);
+bool set_thread_priority(Priority priority);
+bool set_thread_affinity(uint64_t mask);
+// Cores the calling thread may run on, 0 when unknown.
+uint64_t thread_affinity();
+// CPU time the calling thread has used (user + kernel), in microseconds.
+int64_t thread_cpu_us();
+
+// Priority and, when set, affinity for the calling thread.
+void apply_to_thread(Priority priority, uint64_t affinity);
+
+}  // namespace scheduling
@@ -0,0 +1,92 @@
+#include <tosu_overlay/scheduling.h>
+
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <thread>
+
+namespace {
+
+int nice_value(scheduling::Priority priority) {
+  switch (priority) {
+    case scheduling::Priority::idle:
+      return 19;
+    case scheduling::Priority::below_normal:
+      return 10;
+    case scheduling::Priority::normal:
+      return 0;
+    case scheduling::Priority::above_normal:
+      return -5;
+  }
+
+  return 0;
+}
+
+bool set_nice(scheduling::Priority priority) {
+  // per thread on Linux, the tid addresses just the calling one
+  const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+  return setpriority(PRIO_PROCESS, tid, nice_value(priority)) == 0;
+}
+
+bool set_affinity(uint64_t mask) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int core = 0; core < 64; ++core) {
+    if (mask & (uint64_t{1} << core)) {
+      CPU_SET(core, &set);
+    }
+  }
+
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+}  // namespace
+
+unsigned scheduling::core_count() {
+  return std::thread::hardware_concurrency();
+}
+
+bool scheduling::set_process_priority(Priority priority) {
+  return set_nice(priority);
+}
+
+bool scheduling::set_process_affinity(uint64_t mask) {
+  return set_affinity(mask);
+}
+
+bool scheduling::set_thread_priority(Priority priority) {
+  return set_nice(priority);
+}
+
+bool scheduling::set_thread_affinity(uint64_t mask) {
+  return set_affinity(mask);
+}
+
+uint64_t scheduling::thread_affinity() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    return 0;
+  }
+
+  uint64_t mask = 0;
+  for (int core = 0; core < 64; ++core) {
+    if (CPU_ISSET(core, &set)) {
+      mask |= uint64_t{1} << core;
+    }
+  }
+
+  return mask;
+}
+
+int64_t scheduling::thread_cpu_us() {
+  timespec time{};
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+    return 0;
+  }
+
+  return static_cast<int64_t>(time.tv_sec) * 1'000'000 + time.tv_nsec / 1000;
+}
@@ -0,0 +1,90 @@
+#include <tosu_overlay/scheduling.h>
+
+#include <windows.h>
+
+namespace {
+
+int thread_priority(scheduling::Priority priority) {
+  switch (priority) {
+    case scheduling::Priority::idle:
+      return THREAD_PRIORITY_IDLE;
+    case scheduling::Priority::below_normal:
+      return THREAD_PRIORITY_BELOW_NORMAL;
+    case scheduling::Priority::normal:
+      return THREAD_PRIORITY_NORMAL;
+    case scheduling::Priority::above_normal:
+      return THREAD_PRIORITY_ABOVE_NORMAL;
+  }
+
+  return THREAD_PRIORITY_NORMAL;
+}
+
+DWORD priority_class(scheduling::Priority priority) {
+  switch (priority) {
+    case scheduling::Priority::idle:
+      return IDLE_PRIORITY_CLASS;
+    case scheduling::Priority::below_normal:
+      return BELOW_NORMAL_PRIORITY_CLASS;
+    case scheduling::Priority::normal:
+      return NORMAL_PRIORITY_CLASS;
+    case scheduling::Priority::above_normal:
+      return ABOVE_NORMAL_PRIORITY_CLASS;
+  }
+
+  return NORMAL_PRIORITY_CLASS;
+}
+
+}  // namespace
+
+unsigned scheduling::core_count() {
+  return GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+}
+
+bool scheduling::set_process_priority(Priority priority) {
+  return SetPriorityClass(GetCurrentProcess(), priority_class(priority));
+}
+
+bool scheduling::set_process_affinity(uint64_t mask) {
+  return SetProcessAffinityMask(GetCurrentProcess(),
+                                static_cast<DWORD_PTR>(mask));
+}
+
+bool scheduling::set_thread_priority(Priority priority) {
+  return SetThreadPriority(GetCurrentThread(), thread_priority(priority));
+}
+
+bool scheduling::set_thread_affinity(uint64_t mask) {
+  return SetThreadAffinityMask(GetCurrentThread(),
+                               static_cast<DWORD_PTR>(mask)) != 0;
+}
+
+uint64_t scheduling::thread_affinity() {
+  // SetThreadAffinityMask is the only way to read it, put it straight back
+  DWORD_PTR process_mask = 0;
+  DWORD_PTR system_mask = 0;
+  if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask,
+                              &system_mask)) {
+    return 0;
+  }
+
+  const auto previous = SetThreadAffinityMask(GetCurrentThread(), process_mask);
+  if (previous != 0) {
+    SetThreadAffinityMask(GetCurrentThread(), previous);
+  }
+
+  return previous;
+}
+
+int64_t scheduling::thread_cpu_us() {
+  FILETIME creation, exit, kernel, user;
+  if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+    return 0;
+  }
+
+  const auto to_100ns = [](const FILETIME& time) {
+    return (static_cast<int64_t>(time.dwHighDateTime) << 32) |
+           time.dwLowDateTime;
+  };
+
+  return (to_100ns(kernel) + to_100ns(user)) / 10;
+}
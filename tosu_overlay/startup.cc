@@ -0,0 +1,157 @@
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/startup.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+constexpr size_t prefault_chunk = 1 << 20;
+
+// 0 until reached
+std::array<std::atomic<int64_t>, startup::step_count> reached_at = {};
+
+std::atomic<int64_t>& at(startup::Step step) {
+  return reached_at[static_cast<size_t>(step)];
+}
+
+uint64_t prefault_file(const std::filesystem::path& path,
+                       std::vector<char>& buffer,
+                       uint64_t budget) {
+  std::ifstream in(path, std::ios::binary);
+
+  uint64_t read = 0;
+  while (in && read < budget) {
+    const auto want = std::min<uint64_t>(buffer.size(), budget - read);
+    in.read(buffer.data(), static_cast<std::streamsize>(want));
+    read += static_cast<uint64_t>(in.gcount());
+  }
+
+  return read;
+}
+
+}  // namespace
+
+const char* startup::step_name(Step step) {
+  switch (step) {
+    case Step::injected:
+      return "injected";
+    case Step::logger_ready:
+      return "logger_ready";
+    case Step::config_loaded:
+      return "config_loaded";
+    case Step::hooks_installed:
+      return "hooks_installed";
+    case Step::libcef_loaded:
+      return "libcef_loaded";
+    case Step::resources_prefaulted:
+      return "resources_prefaulted";
+    case Step::cef_initialized:
+      return "cef_initialized";
+    case Step::context_initialized:
+      return "context_initialized";
+    case Step::browser_created:
+      return "browser_created";
+    case Step::first_paint:
+      return "first_paint";
+    case Step::first_upload:
+      return "first_upload";
+    case Step::first_present:
+      return "first_present";
+  }
+
+  return "";
+}
+
+bool startup::mark(Step step) {
+  auto& time = at(step);
+  if (time.load(std::memory_order_relaxed) != 0) {
+    return false;
+  }
+
+  // release, so whatever the step set up is visible to reached()
+  int64_t expected = 0;
+  return time.compare_exchange_strong(expected,
+                                      std::max<int64_t>(latency::now_us(), 1),
+                                      std::memory_order_acq_rel);
+}
+
+bool startup::reached(Step step) {
+  return at(step).load(std::memory_order_acquire) != 0;
+}
+
+int64_t startup::elapsed_us(Step from, Step to) {
+  const auto begin = at(from).load(std::memory_order_relaxed);
+  const auto end = at(to).load(std::memory_order_relaxed);
+  if (begin == 0 || end == 0) {
+    return 0;
+  }
+
+  return end - begin;
+}
+
+std::string startup::timeline() {
+  std::vector<std::pair<int64_t, Step>> steps;
+  for (size_t i = 0; i < step_count; ++i) {
+    const auto time = reached_at[i].load(std::memory_order_relaxed);
+    if (time != 0) {
+      steps.emplace_back(time, static_cast<Step>(i));
+    }
+  }
+
+  if (steps.empty()) {
+    return {};
+  }
+
+  std::sort(steps.begin(), steps.end());
+
+  const auto origin = reached(Step::injected)
+                          ? at(Step::injected).load(std::memory_order_relaxed)
+                          : steps.front().first;
+
+  std::string result;
+  for (const auto& [time, step] : steps) {
+    char item[64];
+    std::snprintf(item, sizeof(item), "%s%s +%lld ms",
+                  result.empty() ? "" : ", ", step_name(step),
+                  static_cast<long long>((time - origin) / 1000));
+    result += item;
+  }
+
+  return result;
+}
+
+uint64_t startup::prefault(const std::vector<std::filesystem::path>& paths,
+                           uint64_t byte_limit) {
+  std::vector<char> buffer(prefault_chunk);
+  uint64_t total = 0;
+
+  for (const auto& path : paths) {
+    std::error_code error;
+    if (std::filesystem::is_directory(path, error)) {
+      for (auto it = std::filesystem::recursive_directory_iterator(
+               path,
+               std::filesystem::directory_options::skip_permission_denied,
+               error);
+           !error && it != std::filesystem::recursive_directory_iterator();
+           it.increment(error)) {
+        if (total >= byte_limit) {
+          return total;
+        }
+
+        if (it->is_regular_file(error)) {
+          total += prefault_file(it->path(), buffer, byte_limit - total);
+        }
+      }
+    } else if (total < byte_limit) {
+      total += prefault_file(path, buffer, byte_limit - total);
+    }
+  }
+
+  return total;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// When each step between injection and the first frame showing the overlay
+// was reached, on the latency::now_us() clock. Steps on different threads
+// overlap, so the timeline lists them in the order they were reached.
+namespace startup {
+
+enum class Step : uint8_t {
+  injected,
+  logger_ready,
+  config_loaded,
+  hooks_installed,
+  libcef_loaded,
+  resources_prefaulted,
+  cef_initialized,
+  context_initialized,
+  browser_created,
+  first_paint,
+  first_upload,
+  first_present,
+};
+
+constexpr size_t step_count = 12;
+
+const char* step_name(Step step);
+
+// Records the first time a step is reached and returns true, later calls
+// return false. Any thread, writes made before mark() are visible to a
+// thread that sees reached() return true.
+bool mark(Step step);
+bool reached(Step step);
+
+// Microseconds from one reached step to another, 0 if either wasn't.
+int64_t elapsed_us(Step from, Step to);
+
+// "logger_ready +2 ms, config_loaded +3 ms, ..." relative to injection.
+std::string timeline();
+
+// Reads files (and everything under directories) once so their pages are in
+// the OS file cache when they are mapped or opened later. Stops after
+// byte_limit bytes, returns how many were read.
+uint64_t prefault(const std::vector<std::filesystem::path>& paths,
+                  uint64_t byte_limit);
+
+}  // namespace startup
@@ -0,0 +1,131 @@
+#include <tosu_overlay/state_channel.h>
+
+#include <cstring>
+
+namespace {
+
+constexpr std::string_view endpoint_prefix = "/websocket/";
+
+bool name_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '/';
+}
+
+}  // namespace
+
+std::string state_channel::region_name(std::string_view endpoint) {
+  if (endpoint.size() <= endpoint_prefix.size() ||
+      endpoint.substr(0, endpoint_prefix.size()) != endpoint_prefix) {
+    return {};
+  }
+
+  std::string name = "tosu_state_";
+  for (const char c : endpoint.substr(endpoint_prefix.size())) {
+    if (!name_char(c)) {
+      return {};
+    }
+    name += c == '/' ? '_' : c;
+  }
+  return name;
+}
+
+bool state_channel::Writer::create(std::string_view endpoint,
+                                   size_t capacity) {
+  const auto name = region_name(endpoint);
+  if (name.empty() || !region_.create(name, sizeof(Header) + capacity)) {
+    return false;
+  }
+
+  auto* header = static_cast<Header*>(region_.data());
+  header->magic = magic;
+  header->version = version;
+  header->capacity = capacity;
+  return true;
+}
+
+bool state_channel::Writer::write(std::string_view payload,
+                                  int64_t written_us) {
+  auto* header = static_cast<Header*>(region_.data());
+  if (!header || payload.size() > header->capacity) {
+    return false;
+  }
+
+  const auto sequence = header->sequence.load(std::memory_order_relaxed);
+  header->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  std::memcpy(reinterpret_cast<char*>(header + 1), payload.data(),
+              payload.size());
+  header->length = payload.size();
+  header->written_us = written_us;
+
+  header->sequence.store(sequence + 2, std::memory_order_release);
+  return true;
+}
+
+bool state_channel::Reader::open(std::string_view endpoint) {
+  close();
+
+  const auto name = region_name(endpoint);
+  if (name.empty() || !region_.open(name) ||
+      region_.size() < sizeof(Header)) {
+    region_.close();
+    return false;
+  }
+
+  const auto* header = static_cast<const Header*>(region_.data());
+  if (header->magic != magic || header->version != version ||
+      header->capacity > region_.size() - sizeof(Header)) {
+    region_.close();
+    return false;
+  }
+
+  header_ = header;
+  payload_ = reinterpret_cast<const char*>(header + 1);
+  capacity_ = header->capacity;
+  buffer_.reserve(capacity_);
+
+  // what was written before may be long stale, a write in progress is new
+  const auto sequence = header->sequence.load(std::memory_order_acquire);
+  sequence_ = sequence & ~uint64_t{1};
+  return true;
+}
+
+void state_channel::Reader::close() {
+  region_.close();
+  header_ = nullptr;
+  payload_ = nullptr;
+  capacity_ = 0;
+  sequence_ = 0;
+  written_us_ = 0;
+  skipped_ = 0;
+}
+
+std::optional<std::string_view> state_channel::Reader::read() {
+  if (!header_) {
+    return std::nullopt;
+  }
+
+  const auto before = header_->sequence.load(std::memory_order_acquire);
+  if (before == sequence_ || (before & 1)) {
+    return std::nullopt;
+  }
+
+  // may be torn, checked against the sequence below
+  const auto length = header_->length;
+  const auto written_us = header_->written_us;
+  if (length > capacity_) {
+    return std::nullopt;
+  }
+  buffer_.assign(payload_, length);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header_->sequence.load(std::memory_order_relaxed) != before) {
+    return std::nullopt;
+  }
+
+  skipped_ += (before - sequence_) / 2 - 1;
+  sequence_ = before;
+  written_us_ = written_us;
+  return std::string_view(buffer_);
+}
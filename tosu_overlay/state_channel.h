@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// tosu's state through shared memory instead of the loopback WebSocket.
+// tosu (the producer) creates one named region per endpoint and overwrites
+// the latest message in it; the overlay maps it and reads the newest one
+// without a syscall, skipping the socket, the frames and a copy in each
+// direction. Optional, see "shared_memory" in tosu_feed.h.
+//
+// Region name: "tosu_state" plus the endpoint after /websocket/, slashes as
+// underscores, e.g. /websocket/v2/precise -> "tosu_state_v2_precise".
+// Windows: a pagefile-backed file mapping "Local\<name>" (CreateFileMapping,
+// same session as osu!). Elsewhere: POSIX shared memory "/<name>"
+// (shm_open), unlinked by the producer when it quits.
+//
+// Layout, little endian, the payload right after a 64-byte header:
+//
+//   offset size
+//   0      4    magic, 0x55534f54 ("TOSU")
+//   4      4    layout version, 1
+//   8      8    capacity: payload bytes after the header
+//   16     8    sequence, a seqlock: odd while the producer writes
+//   24     8    payload length
+//   32     8    when the payload was written, microseconds on the system's
+//               monotonic clock (QueryPerformanceCounter on Windows,
+//               process.hrtime.bigint() / 1000n in Node), 0 if unknown
+//   40     24   reserved, zero
+//   64     capacity
+//               the payload: the message exactly as the endpoint sends it
+//               over the WebSocket (UTF-8 JSON text), so the schema is
+//               tosu's own
+//
+// Producer, per message (one producer per region):
+//
+//   sequence += 1 (now odd), release fence
+//   write payload, length and written_us
+//   sequence += 1 (now even), release store
+//
+// A message larger than capacity isn't written; the producer should make the
+// region large enough (a few times the largest message) up front. Readers
+// copy the payload out and keep the copy only if sequence was the same even
+// number before and after.
+namespace state_channel {
+
+constexpr uint32_t magic = 0x55534f54;
+constexpr uint32_t version = 1;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity;
+  std::atomic<uint64_t> sequence;
+  uint64_t length;
+  int64_t written_us;
+  uint8_t reserved[24];
+};
+
+static_assert(sizeof(Header) == 64);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+// "/websocket/v2" -> "tosu_state_v2", empty for other paths.
+std::string region_name(std::string_view endpoint);
+
+// Platform layer, state_channel_win.cc and state_channel_posix.cc: a named
+// shared-memory mapping.
+class Region {
+ public:
+  Region() = default;
+  ~Region() { close(); }
+
+  Region(const Region&) = delete;
+  Region& operator=(const Region&) = delete;
+
+  // Producer side, a new region of size bytes (zeroed).
+  bool create(const std::string& name, size_t size);
+  // Consumer side, false while nobody created it.
+  bool open(const std::string& name);
+  void close();
+
+  void* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  intptr_t handle_ = -1;
+  // POSIX: to unlink the region the producer created
+  std::string unlink_name_;
+};
+
+// The producer side, for tosu to copy and for testing without it.
+class Writer {
+ public:
+  bool create(std::string_view endpoint, size_t capacity);
+  // false when payload is larger than the region.
+  bool write(std::string_view payload, int64_t written_us);
+  void close() { region_.close(); }
+
+ private:
+  Region region_;
+};
+
+class Reader {
+ public:
+  // Maps the endpoint's region, false while tosu hasn't created one or it
+  // has an unknown layout.
+  bool open(std::string_view endpoint);
+  bool is_open() const { return header_ != nullptr; }
+  void close();
+
+  // The newest payload if one was written since the last call (or since
+  // open()), nullopt otherwise or while the producer is writing. Valid until
+  // the next call.
+  std::optional<std::string_view> read();
+
+  // written_us of the last payload read().
+  int64_t written_us() const { return written_us_; }
+  // Producer writes since open() that read() never saw.
+  uint64_t skipped() const { return skipped_; }
+
+ private:
+  Region region_;
+  const Header* header_ = nullptr;
+  const char* payload_ = nullptr;
+  uint64_t capacity_ = 0;
+
+  uint64_t sequence_ = 0;
+  int64_t written_us_ = 0;
+  uint64_t skipped_ = 0;
+  std::string buffer_;
+};
+
+}  // namespace state_channel
@@ -0,0 +1,81 @@
+#include <tosu_overlay/state_channel.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool state_channel::Region::create(const std::string& name, size_t size) {
+  close();
+
+  const auto path = "/" + name;
+  // a region left behind by a producer that crashed
+  shm_unlink(path.c_str());
+
+  const int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    shm_unlink(path.c_str());
+    return false;
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    shm_unlink(path.c_str());
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  handle_ = fd;
+  unlink_name_ = path;
+  return true;
+}
+
+bool state_channel::Region::open(const std::string& name) {
+  close();
+
+  const int fd = shm_open(("/" + name).c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat status {};
+  if (fstat(fd, &status) != 0 || status.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size = static_cast<size_t>(status.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  handle_ = fd;
+  return true;
+}
+
+void state_channel::Region::close() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+  if (handle_ >= 0) {
+    ::close(static_cast<int>(handle_));
+  }
+  if (!unlink_name_.empty()) {
+    shm_unlink(unlink_name_.c_str());
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  handle_ = -1;
+  unlink_name_.clear();
+}
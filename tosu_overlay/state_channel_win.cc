@@ -0,0 +1,81 @@
+#include <tosu_overlay/state_channel.h>
+
+#include <windows.h>
+
+namespace {
+
+std::wstring mapping_name(const std::string& name) {
+  // region names are ASCII
+  return L"Local\\" + std::wstring(name.begin(), name.end());
+}
+
+}  // namespace
+
+bool state_channel::Region::create(const std::string& name, size_t size) {
+  close();
+
+  const auto large = static_cast<uint64_t>(size);
+  HANDLE mapping = CreateFileMappingW(
+      INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+      static_cast<DWORD>(large >> 32), static_cast<DWORD>(large),
+      mapping_name(name).c_str());
+  if (!mapping) {
+    return false;
+  }
+  if (GetLastError() == ERROR_ALREADY_EXISTS) {
+    // another producer
+    CloseHandle(mapping);
+    return false;
+  }
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (!data) {
+    CloseHandle(mapping);
+    return false;
+  }
+
+  data_ = data;
+  size_ = size;
+  handle_ = reinterpret_cast<intptr_t>(mapping);
+  return true;
+}
+
+bool state_channel::Region::open(const std::string& name) {
+  close();
+
+  HANDLE mapping =
+      OpenFileMappingW(FILE_MAP_READ, FALSE, mapping_name(name).c_str());
+  if (!mapping) {
+    return false;
+  }
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  MEMORY_BASIC_INFORMATION info{};
+  if (!data || !VirtualQuery(data, &info, sizeof(info))) {
+    if (data) {
+      UnmapViewOfFile(data);
+    }
+    CloseHandle(mapping);
+    return false;
+  }
+
+  data_ = data;
+  // rounded up to pages, the header's capacity says how much is used
+  size_ = info.RegionSize;
+  handle_ = reinterpret_cast<intptr_t>(mapping);
+  return true;
+}
+
+void state_channel::Region::close() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (handle_ != -1) {
+    CloseHandle(reinterpret_cast<HANDLE>(handle_));
+  }
+
+  data_ = nullptr;
+  size_ = 0;
+  handle_ = -1;
+  unlink_name_.clear();
+}
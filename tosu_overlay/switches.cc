@@ -0,0 +1,242 @@
+#include <tosu_overlay/switches.h>
+
+#include <algorithm>
+
+namespace {
+
+// Needed by every profile: software rendering for the off-screen browser and
+// access to the local tosu server.
+const switches::Switch overlay_switches[] = {
+    {"disable-gpu", ""},
+    {"disable-gpu-compositing", ""},
+    {"in-process-gpu", ""},
+    {"disable-web-security", ""},
+    {"ignore-certificate-errors", ""},
+    {"remote-allow-origins", "*"},
+    {"default-encoding", "utf-8"},
+};
+
+const switches::Switch experimental_switches[] = {
+    {"enable-experimental-web-platform-features", ""},
+};
+
+const switches::Switch media_switches[] = {
+    {"enable-media-stream", ""},
+    {"use-fake-ui-for-media-stream", ""},
+    {"enable-speech-input", ""},
+    {"ignore-gpu-blacklist", ""},
+    {"enable-usermedia-screen-capture", ""},
+};
+
+// Services a counter page never uses.
+const switches::Switch lean_switches[] = {
+    {"disable-extensions", ""},
+    {"disable-spell-checking", ""},
+    {"disable-background-networking", ""},
+    {"disable-component-update", ""},
+    {"disable-default-apps", ""},
+    {"disable-sync", ""},
+    {"no-pings", ""},
+    {"disable-features",
+     "Translate,OptimizationHints,MediaRouter,DialMediaRouteProvider,"
+     "AutofillServerCommunication,CalculateNativeWinOcclusion"},
+    {"renderer-process-limit", "1"},
+};
+
+// Raster settings, unset fields leave Chromium's default alone.
+struct RasterPreset {
+  std::optional<int> threads;
+  std::optional<int> tile_size;
+  std::optional<bool> partial_raster;
+  std::optional<bool> low_res_tiling;
+};
+
+std::optional<RasterPreset> raster_preset(std::string_view name) {
+  // Chromium decides, the same as before raster settings existed
+  if (name == "default")
+    return RasterPreset{};
+  // one raster thread competing with the game, small tiles so animated
+  // counters re-raster as little as possible
+  if (name == "game_first")
+    return RasterPreset{1, 256, true, false};
+  // heavy pages with lots of animated content, on CPUs with cores to spare
+  if (name == "smooth")
+    return RasterPreset{3, 512, true, false};
+  return std::nullopt;
+}
+
+template <size_t N>
+void append(switches::SwitchList& list, const switches::Switch (&items)[N]) {
+  list.insert(list.end(), std::begin(items), std::end(items));
+}
+
+void set_switch(switches::SwitchList& list,
+                std::string name,
+                std::string value) {
+  auto it = std::find_if(list.begin(), list.end(),
+                         [&](const auto& item) { return item.name == name; });
+  if (it != list.end()) {
+    it->value = std::move(value);
+  } else {
+    list.push_back({std::move(name), std::move(value)});
+  }
+}
+
+}  // namespace
+
+std::optional<switches::Profile> switches::parse_profile(
+    std::string_view name) {
+  if (name == "lean")
+    return Profile::lean;
+  if (name == "default")
+    return Profile::standard;
+  if (name == "full")
+    return Profile::full;
+  return std::nullopt;
+}
+
+const char* switches::profile_name(Profile profile) {
+  switch (profile) {
+    case Profile::lean:
+      return "lean";
+    case Profile::standard:
+      return "default";
+    case Profile::full:
+      return "full";
+  }
+
+  return "";
+}
+
+switches::SwitchList switches::profile_switches(Profile profile) {
+  SwitchList list;
+  append(list, overlay_switches);
+
+  switch (profile) {
+    case Profile::lean:
+      append(list, lean_switches);
+      break;
+    case Profile::standard:
+      append(list, experimental_switches);
+      break;
+    case Profile::full:
+      append(list, experimental_switches);
+      append(list, media_switches);
+      break;
+  }
+
+  return list;
+}
+
+switches::SwitchList switches::raster_switches(const nlohmann::json& config) {
+  const auto name = config.value("preset", std::string("default"));
+  auto preset = raster_preset(name).value_or(RasterPreset{});
+
+  if (config.contains("threads"))
+    preset.threads = config.value("threads", 0);
+  if (config.contains("tile_size"))
+    preset.tile_size = config.value("tile_size", 0);
+  if (config.contains("partial_raster"))
+    preset.partial_raster = config.value("partial_raster", true);
+  if (config.contains("low_res_tiling"))
+    preset.low_res_tiling = config.value("low_res_tiling", false);
+
+  SwitchList list;
+
+  // cc only accepts 1..4 raster threads
+  if (preset.threads && *preset.threads > 0) {
+    const auto threads = std::to_string(std::clamp(*preset.threads, 1, 4));
+    list.push_back({"num-raster-threads", threads});
+  }
+
+  if (preset.tile_size && *preset.tile_size > 0) {
+    const auto size = std::to_string(std::clamp(*preset.tile_size, 64, 2048));
+    list.push_back({"default-tile-width", size});
+    list.push_back({"default-tile-height", size});
+  }
+
+  if (preset.partial_raster) {
+    list.push_back({*preset.partial_raster ? "enable-partial-raster"
+                                           : "disable-partial-raster",
+                    ""});
+  }
+
+  if (preset.low_res_tiling) {
+    list.push_back({*preset.low_res_tiling ? "enable-low-res-tiling"
+                                           : "disable-low-res-tiling",
+                    ""});
+  }
+
+  return list;
+}
+
+switches::SwitchList switches::memory_switches(const nlohmann::json& config) {
+  SwitchList list;
+
+  const auto js_heap_mb = config.value("js_heap_mb", 0);
+  if (js_heap_mb > 0) {
+    list.push_back(
+        {"js-flags", "--max-old-space-size=" + std::to_string(js_heap_mb)});
+  }
+
+  const auto disk_cache_mb = config.value("disk_cache_mb", 0);
+  if (disk_cache_mb > 0) {
+    list.push_back({"disk-cache-size",
+                    std::to_string(static_cast<int64_t>(disk_cache_mb) << 20)});
+  }
+
+  // performance.memory is bucketed to hide cross-origin sizes otherwise
+  if (config.value("sample_seconds", 60) > 0) {
+    list.push_back({"enable-precise-memory-info", ""});
+  }
+
+  return list;
+}
+
+switches::SwitchList switches::resolve(const nlohmann::json& config,
+                                       const nlohmann::json& raster_config,
+                                       const nlohmann::json& memory_config) {
+  const auto name = config.value("profile", std::string("default"));
+  auto list = profile_switches(parse_profile(name).value_or(Profile::standard));
+
+  for (auto& item : raster_switches(raster_config)) {
+    set_switch(list, std::move(item.name), std::move(item.value));
+  }
+
+  for (auto& item : memory_switches(memory_config)) {
+    set_switch(list, std::move(item.name), std::move(item.value));
+  }
+
+  const auto add = config.value("add", nlohmann::json::object());
+  for (const auto& [switch_name, value] : add.items()) {
+    set_switch(list, switch_name,
+               value.is_string() ? value.get<std::string>() : value.dump());
+  }
+
+  const auto remove = config.value("remove", nlohmann::json::array());
+  for (const auto& entry : remove) {
+    if (!entry.is_string()) {
+      continue;
+    }
+
+    const auto switch_name = entry.get<std::string>();
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const auto& item) {
+                                return item.name == switch_name;
+                              }),
+               list.end());
+  }
+
+  return list;
+}
+
+std::optional<std::string> switches::find(const SwitchList& list,
+                                          std::string_view name) {
+  const auto it = std::find_if(list.begin(), list.end(), [&](const auto& item) {
+    return item.name == name;
+  });
+  if (it == list.end()) {
+    return std::nullopt;
+  }
+  return it->value;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Chromium command-line switches for the browser, picked by a named profile
+// in config.json and adjusted per switch:
+//
+//   "switches": {
+//     "profile": "lean" | "default" | "full",
+//     "add": {"renderer-process-limit": "2", "enable-logging": ""},
+//     "remove": ["disable-extensions"]
+//   }
+namespace switches {
+
+struct Switch {
+  std::string name;
+  // empty for plain flags
+  std::string value;
+};
+
+using SwitchList = std::vector<Switch>;
+
+enum class Profile {
+  // only what the overlay needs, background services off, one renderer
+  lean,
+  // the overlay's needs plus experimental web platform features
+  standard,
+  // everything the overlay used to enable, media and speech included
+  full,
+};
+
+std::optional<Profile> parse_profile(std::string_view name);
+const char* profile_name(Profile profile);
+
+SwitchList profile_switches(Profile profile);
+
+// Software raster tuning from the "raster" config object:
+//
+//   "raster": {
+//     "preset": "default" | "game_first" | "smooth",
+//     "threads": 2,              // raster worker threads, 1..4
+//     "tile_size": 256,          // square tiles in px, 0 for Chromium's
+//     "partial_raster": true,    // re-raster only the invalidated part
+//     "low_res_tiling": false    // blurry placeholder tiles while scrolling
+//   }
+//
+// Keys next to "preset" override it. Returns only the switches to set.
+SwitchList raster_switches(const nlohmann::json& config);
+
+// Memory caps from the "memory" config object (see memory_stats.h): the V8
+// old space size, the HTTP cache size, and precise performance.memory
+// numbers while renderer memory is sampled.
+SwitchList memory_switches(const nlohmann::json& config);
+
+// Profile from the "switches" config object, then the raster and memory
+// switches, then "add" and "remove" applied. Unknown profiles fall back to
+// standard.
+SwitchList resolve(const nlohmann::json& config,
+                   const nlohmann::json& raster_config,
+                   const nlohmann::json& memory_config);
+
+// The switch's value in list, nullopt when it isn't set.
+std::optional<std::string> find(const SwitchList& list, std::string_view name);
+
+}  // namespace switches
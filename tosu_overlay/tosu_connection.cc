@@ -0,0 +1,52 @@
+#include <tosu_overlay/tosu_connection.h>
+
+#include <algorithm>
+
+tosu_connection::Config tosu_connection::parse_config(
+    const nlohmann::json& config) {
+  Config result;
+  result.retry_initial_ms = std::clamp<int64_t>(
+      config.value("retry_initial_ms", result.retry_initial_ms), 50, 60000);
+  result.retry_max_ms = std::clamp<int64_t>(
+      config.value("retry_max_ms", result.retry_max_ms),
+      result.retry_initial_ms, 600000);
+  result.check_interval_ms = std::clamp<int64_t>(
+      config.value("check_interval_ms", result.check_interval_ms), 500,
+      600000);
+  result.teardown_after_ms =
+      std::max<int64_t>(config.value("teardown_after_s", 120), 0) * 1000;
+  return result;
+}
+
+tosu_connection::Action tosu_connection::Tracker::on_probe(bool reachable,
+                                                           bool browser_open,
+                                                           int64_t now_us) {
+  if (!browser_open) {
+    if (reachable) {
+      retry_ms_ = config_.retry_initial_ms;
+      last_reachable_us_ = now_us;
+      next_probe_ms_ = config_.check_interval_ms;
+      return Action::create_browser;
+    }
+
+    next_probe_ms_ = retry_ms_;
+    retry_ms_ = std::min(retry_ms_ * 2, config_.retry_max_ms);
+    return Action::none;
+  }
+
+  next_probe_ms_ = config_.check_interval_ms;
+
+  if (reachable || last_reachable_us_ == 0) {
+    last_reachable_us_ = now_us;
+    return Action::none;
+  }
+
+  if (config_.teardown_after_ms != 0 &&
+      now_us - last_reachable_us_ >= config_.teardown_after_ms * 1000) {
+    retry_ms_ = config_.retry_initial_ms;
+    next_probe_ms_ = retry_ms_;
+    return Action::close_browser;
+  }
+
+  return Action::none;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+
+// When to create the overlay browser and when to let it go, from probes of
+// tosu's server:
+//
+//   "tosu_connection": {
+//     "retry_initial_ms": 500,    // first retry while tosu is down
+//     "retry_max_ms": 30000,      // retries double up to this
+//     "check_interval_ms": 5000,  // probes while the browser is up
+//     "teardown_after_s": 120     // close the browser after tosu has been
+//                                 // gone this long, 0 never
+//   }
+namespace tosu_connection {
+
+struct Config {
+  int64_t retry_initial_ms = 500;
+  int64_t retry_max_ms = 30000;
+  int64_t check_interval_ms = 5000;
+  int64_t teardown_after_ms = 120000;
+};
+
+Config parse_config(const nlohmann::json& config);
+
+enum class Action {
+  none,
+  create_browser,
+  close_browser,
+};
+
+class Tracker {
+ public:
+  explicit Tracker(const Config& config)
+      : config_(config), retry_ms_(config.retry_initial_ms) {}
+
+  // What to do about a probe that finished at now_us, browser_open being
+  // whether the overlay browser exists (or is being created).
+  Action on_probe(bool reachable, bool browser_open, int64_t now_us);
+
+  // When to probe next, after on_probe.
+  int64_t next_probe_ms() const { return next_probe_ms_; }
+
+ private:
+  Config config_;
+
+  int64_t retry_ms_;
+  int64_t next_probe_ms_ = 0;
+  // last time tosu answered while the browser was up, 0 before that
+  int64_t last_reachable_us_ = 0;
+};
+
+}  // namespace tosu_connection
@@ -0,0 +1,298 @@
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/tosu_feed.h>
+#include <tosu_overlay/websocket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace {
+
+constexpr int connect_timeout_ms = 1000;
+
+// How long a receive waits before the thread checks whether it's still
+// wanted.
+constexpr int receive_timeout_ms = 100;
+
+constexpr std::string_view endpoint_prefix = "/websocket/";
+
+// Nothing new in the shared-memory region for this long, tosu may be gone.
+constexpr int64_t region_stale_us = 3'000'000;
+
+}  // namespace
+
+std::optional<tosu_feed::Format> tosu_feed::parse_format(
+    std::string_view name) {
+  if (name.empty() || name == "object") {
+    return Format::object;
+  }
+  if (name == "msgpack") {
+    return Format::msgpack;
+  }
+  if (name == "patch") {
+    return Format::patch;
+  }
+  return std::nullopt;
+}
+
+const char* tosu_feed::format_name(Format format) {
+  switch (format) {
+    case Format::msgpack:
+      return "msgpack";
+    case Format::patch:
+      return "patch";
+    default:
+      return "object";
+  }
+}
+
+bool tosu_feed::valid_endpoint(std::string_view path) {
+  return path.size() > endpoint_prefix.size() &&
+         path.substr(0, endpoint_prefix.size()) == endpoint_prefix &&
+         path.find_first_of(" \r\n") == std::string_view::npos;
+}
+
+tosu_feed::Config tosu_feed::parse_config(const nlohmann::json& config) {
+  Config result;
+  result.enabled = config.value("enabled", result.enabled);
+  result.reconnect_ms = std::clamp<int64_t>(
+      config.value("reconnect_ms", result.reconnect_ms), 100, 60000);
+  result.shared_memory = config.value("shared_memory", result.shared_memory);
+  result.poll_ms =
+      std::clamp<int64_t>(config.value("poll_ms", result.poll_ms), 1, 100);
+  return result;
+}
+
+void tosu_feed::write_record(std::ostream& out,
+                             const std::string& endpoint,
+                             std::string_view message) {
+  out << endpoint << ' ';
+  // newlines can only be whitespace between tokens in JSON
+  for (const char c : message) {
+    out.put(c == '\n' || c == '\r' ? ' ' : c);
+  }
+  out << '\n';
+}
+
+std::vector<std::pair<std::string, std::string>> tosu_feed::read_records(
+    std::istream& in) {
+  std::vector<std::pair<std::string, std::string>> records;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    const auto space = line.find(' ');
+    if (space == std::string::npos) {
+      continue;
+    }
+    records.emplace_back(line.substr(0, space), line.substr(space + 1));
+  }
+
+  return records;
+}
+
+tosu_feed::Feed::Feed(std::string host,
+                      std::string port,
+                      const Config& config,
+                      Deliver deliver)
+    : host_(std::move(host)),
+      port_(std::move(port)),
+      config_(config),
+      deliver_(std::move(deliver)) {
+  if (!config_.record_path.empty()) {
+    record_.open(config_.record_path, std::ios_base::trunc);
+  }
+}
+
+tosu_feed::Feed::~Feed() {
+  {
+    std::lock_guard lock(lock_);
+    stopping_ = true;
+  }
+
+  for (auto& [path, endpoint] : endpoints_) {
+    endpoint->wake.notify_all();
+  }
+  for (auto& [path, endpoint] : endpoints_) {
+    endpoint->thread.join();
+  }
+}
+
+void tosu_feed::Feed::subscribe(const std::string& endpoint, Format format) {
+  std::lock_guard lock(lock_);
+
+  auto& entry = endpoints_[endpoint];
+  if (!entry) {
+    entry = std::make_unique<Endpoint>();
+    entry->path = endpoint;
+    entry->thread = std::thread([this, &endpoint = *entry] { run(endpoint); });
+  }
+
+  if (format == Format::patch) {
+    ++entry->patch_subscribers;
+    entry->state_wanted = true;
+  }
+  ++entry->subscribers;
+  entry->wake.notify_all();
+}
+
+void tosu_feed::Feed::unsubscribe(const std::string& endpoint,
+                                  Format format) {
+  std::lock_guard lock(lock_);
+
+  const auto it = endpoints_.find(endpoint);
+  if (it == endpoints_.end() || it->second->subscribers == 0) {
+    return;
+  }
+
+  if (format == Format::patch && it->second->patch_subscribers > 0) {
+    --it->second->patch_subscribers;
+  }
+  --it->second->subscribers;
+}
+
+tosu_feed::Stats tosu_feed::Feed::stats() const {
+  return {messages_,       bytes_,    parse_errors_, connects_,
+          shared_messages_, parse_us_, changes_};
+}
+
+void tosu_feed::Feed::record(const std::string& endpoint,
+                             std::string_view message) {
+  std::lock_guard lock(record_lock_);
+  write_record(record_, endpoint, message);
+}
+
+bool tosu_feed::Feed::idle(Endpoint& endpoint) {
+  std::unique_lock lock(lock_);
+  endpoint.wake.wait(
+      lock, [&] { return stopping_ || endpoint.subscribers > 0; });
+  return !stopping_;
+}
+
+bool tosu_feed::Feed::pause(Endpoint& endpoint, int64_t timeout_ms) {
+  std::unique_lock lock(lock_);
+  endpoint.wake.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                         [&] { return stopping_.load(); });
+  return !stopping_;
+}
+
+void tosu_feed::Feed::run(Endpoint& endpoint) {
+  websocket::Client client;
+  state_channel::Reader reader;
+  json_diff::Differ differ;
+
+  while (idle(endpoint)) {
+    if (config_.shared_memory &&
+        (reader.is_open() || reader.open(endpoint.path))) {
+      ++connects_;
+      read_shared(endpoint, reader, differ);
+      reader.close();
+      if (endpoint.subscribers == 0 || stopping_) {
+        continue;
+      }
+      // tosu stopped writing, it may still be there on the WebSocket
+    }
+
+    if (!client.connect(host_, port_, endpoint.path, connect_timeout_ms)) {
+      pause(endpoint, config_.reconnect_ms);
+      continue;
+    }
+    ++connects_;
+
+    auto region_check_us = latency::now_us() + config_.reconnect_ms * 1000;
+    while (client.is_open() && endpoint.subscribers > 0 && !stopping_) {
+      // switch over once tosu writes to a region, opened at one check and
+      // written to by the next
+      if (config_.shared_memory && latency::now_us() >= region_check_us) {
+        region_check_us = latency::now_us() + config_.reconnect_ms * 1000;
+        if (!reader.is_open()) {
+          reader.open(endpoint.path);
+        } else if (const auto message = reader.read()) {
+          ++shared_messages_;
+          handle(endpoint, differ, *message);
+          break;
+        }
+      }
+
+      const auto message = client.receive(receive_timeout_ms);
+      if (!message || message->opcode != websocket::Opcode::text) {
+        continue;
+      }
+      handle(endpoint, differ, message->payload);
+    }
+
+    const bool unwanted = client.is_open();
+    client.close();
+    if (!unwanted) {
+      // tosu went away, not the subscribers
+      pause(endpoint, config_.reconnect_ms);
+    }
+  }
+}
+
+void tosu_feed::Feed::read_shared(Endpoint& endpoint,
+                                  state_channel::Reader& reader,
+                                  json_diff::Differ& differ) {
+  auto last_us = latency::now_us();
+
+  // the read itself is a few loads and a copy, no syscall
+  while (endpoint.subscribers > 0 && pause(endpoint, config_.poll_ms)) {
+    const auto message = reader.read();
+    if (!message) {
+      if (latency::now_us() - last_us > region_stale_us) {
+        return;
+      }
+      continue;
+    }
+
+    last_us = latency::now_us();
+    ++shared_messages_;
+    handle(endpoint, differ, *message);
+  }
+}
+
+void tosu_feed::Feed::handle(Endpoint& endpoint,
+                             json_diff::Differ& differ,
+                             std::string_view message) {
+  if (record_.is_open()) {
+    record(endpoint.path, message);
+  }
+
+  const auto start = latency::now_us();
+  Update update;
+
+  if (endpoint.patch_subscribers > 0) {
+    auto patch = differ.update(message);
+    if (!patch) {
+      ++parse_errors_;
+      return;
+    }
+
+    const bool whole = endpoint.subscribers > endpoint.patch_subscribers;
+    if (endpoint.state_wanted.exchange(false) || whole) {
+      update.state = std::make_shared<nlohmann::json>(differ.state());
+    }
+    if (!json_diff::empty(*patch)) {
+      changes_ += patch->at("set").size() + patch->at("remove").size();
+      update.patch = std::make_shared<nlohmann::json>(std::move(*patch));
+    }
+  } else {
+    // behind once nobody follows it, the next patch starts over
+    differ.reset();
+
+    auto json = std::make_shared<nlohmann::json>(
+        nlohmann::json::parse(message, nullptr, false));
+    if (json->is_discarded()) {
+      ++parse_errors_;
+      return;
+    }
+    update.state = std::move(json);
+  }
+
+  parse_us_ += latency::now_us() - start;
+  ++messages_;
+  bytes_ += message.size();
+
+  if (update.state || update.patch) {
+    deliver_(endpoint.path, std::move(update));
+  }
+}
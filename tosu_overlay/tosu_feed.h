@@ -0,0 +1,183 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tosu_overlay/json_diff.h>
+#include <tosu_overlay/state_channel.h>
+
+// One connection to tosu per endpoint, shared by every page of the
+// overlay. Pages subscribe through window.tosuOverlay.subscribe() (see
+// overlay_api.h), the browser process holds the connection, parses each
+// message once and passes it on over process messages (see feed_router.h).
+// Pages that take patches get the changes since the last message (see
+// json_diff.h) instead of the whole state:
+//
+//   "tosu_feed": {
+//     "enabled": true,
+//     "reconnect_ms": 1000,  // wait before connecting again
+//     "shared_memory": false,
+//     "poll_ms": 2
+//   }
+//
+// With shared_memory, an endpoint is read from tosu's shared-memory region
+// (see state_channel.h) whenever one is being written, every poll_ms, and
+// from the WebSocket otherwise.
+//
+// Only tosu's push endpoints (/websocket/v2, /websocket/v2/precise, ...)
+// make sense here, nothing is sent to tosu.
+namespace tosu_feed {
+
+// Renderer -> browser, arguments endpoint and format name.
+constexpr char subscribe_message[] = "tosu_overlay.feed_subscribe";
+constexpr char unsubscribe_message[] = "tosu_overlay.feed_unsubscribe";
+// Browser -> renderer, arguments endpoint, format name, the message (a
+// dictionary or list for "object" and "patch", binary for "msgpack") and
+// what it is, update_state or update_patch.
+constexpr char update_message[] = "tosu_overlay.feed_update";
+constexpr char update_state[] = "state";
+constexpr char update_patch[] = "patch";
+
+enum class Format {
+  // JS objects, built natively in the renderer
+  object,
+  // an ArrayBuffer of MessagePack
+  msgpack,
+  // the whole state once, then json_diff patches applied to it natively
+  patch,
+};
+
+constexpr size_t format_count = 3;
+
+std::optional<Format> parse_format(std::string_view name);
+const char* format_name(Format format);
+
+// Whether a page may subscribe to path.
+bool valid_endpoint(std::string_view path);
+
+struct Config {
+  bool enabled = true;
+  int64_t reconnect_ms = 1000;
+  bool shared_memory = false;
+  int64_t poll_ms = 2;
+  // "feed_record_path", every message received goes there for the bench
+  std::string record_path;
+};
+
+Config parse_config(const nlohmann::json& config);
+
+struct Stats {
+  uint64_t messages;
+  uint64_t bytes;
+  uint64_t parse_errors;
+  uint64_t connects;
+  // of messages, the ones read from shared memory
+  uint64_t shared_messages;
+  // parsing and diffing
+  int64_t parse_us;
+  // pointers set or removed over all patches
+  uint64_t changes;
+};
+
+using Message = std::shared_ptr<const nlohmann::json>;
+
+struct Update {
+  // The whole message, when anyone takes it whole or a patch subscriber
+  // needs a starting point.
+  Message state;
+  // The changes since the last message, when anyone takes patches and
+  // something changed.
+  Message patch;
+};
+
+// Called on the endpoint's thread.
+using Deliver =
+    std::function<void(const std::string& endpoint, Update update)>;
+
+// Recordings for the bench: one message per line, after its endpoint.
+void write_record(std::ostream& out,
+                  const std::string& endpoint,
+                  std::string_view message);
+std::vector<std::pair<std::string, std::string>> read_records(
+    std::istream& in);
+
+class Feed {
+ public:
+  Feed(std::string host, std::string port, const Config& config,
+       Deliver deliver);
+  // Closes the connections and joins their threads.
+  ~Feed();
+
+  Feed(const Feed&) = delete;
+  Feed& operator=(const Feed&) = delete;
+
+  // Counted, the connection stays up while any subscriber is left. The
+  // thread is kept after the last one leaves, so these never block.
+  void subscribe(const std::string& endpoint, Format format);
+  void unsubscribe(const std::string& endpoint, Format format);
+
+  Stats stats() const;
+
+ private:
+  struct Endpoint {
+    std::string path;
+    std::atomic<int> subscribers = 0;
+    std::atomic<int> patch_subscribers = 0;
+    // a patch subscriber joined and needs the whole state
+    std::atomic<bool> state_wanted = false;
+    std::condition_variable wake;
+    std::thread thread;
+  };
+
+  void run(Endpoint& endpoint);
+  // Reads the region until nobody subscribes or tosu stops writing to it.
+  void read_shared(Endpoint& endpoint,
+                   state_channel::Reader& reader,
+                   json_diff::Differ& differ);
+  // Parses or diffs one message and delivers it.
+  void handle(Endpoint& endpoint,
+              json_diff::Differ& differ,
+              std::string_view message);
+  void record(const std::string& endpoint, std::string_view message);
+  // Wait for a subscriber and for timeout_ms respectively, false once
+  // shutting down.
+  bool idle(Endpoint& endpoint);
+  bool pause(Endpoint& endpoint, int64_t timeout_ms);
+
+  const std::string host_;
+  const std::string port_;
+  const Config config_;
+  const Deliver deliver_;
+
+  mutable std::mutex lock_;
+  std::map<std::string, std::unique_ptr<Endpoint>> endpoints_;
+  std::atomic<bool> stopping_ = false;
+
+  std::mutex record_lock_;
+  std::ofstream record_;
+
+  std::atomic<uint64_t> messages_ = 0;
+  std::atomic<uint64_t> bytes_ = 0;
+  std::atomic<uint64_t> parse_errors_ = 0;
+  std::atomic<uint64_t> connects_ = 0;
+  std::atomic<uint64_t> shared_messages_ = 0;
+  std::atomic<int64_t> parse_us_ = 0;
+  std::atomic<uint64_t> changes_ = 0;
+};
+
+}  // namespace tosu_feed
@@ -6,17 +6,66 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdio>
 #include <filesystem>
 #include <string>
 
 #include "config.h"
+#include "include/base/cef_callback.h"
 #include "include/cef_browser.h"
 #include "include/cef_command_line.h"
+#include "include/cef_trace.h"
 #include "include/internal/cef_types_runtime.h"
+#include "include/wrapper/cef_closure_task.h"
 #include "include/wrapper/cef_helpers.h"
+#include "tosu_overlay/asset_cache.h"
+#include "tosu_overlay/http_probe.h"
+#include "tosu_overlay/latency.h"
+#include "tosu_overlay/logger.h"
+#include "tosu_overlay/message_loop.h"
+#include "tosu_overlay/scheduling.h"
+#include "tosu_overlay/startup.h"
 #include "tosu_overlay/state.h"
+#include "tosu_overlay/switches.h"
+#include "tosu_overlay/tosu_connection.h"
 #include "tosu_overlay/tosu_overlay_handler.h"
 
+namespace {
+
+// Short, tosu runs on this machine and answers in a few ms when it's up.
+constexpr int probe_timeout_ms = 1000;
+
+// Raster and compositor events from every process, what
+// bench/raster_report.cc reads.
+constexpr char raster_trace_categories[] = "cc,viz,toplevel";
+
+// Records a Chromium trace for "raster_trace_seconds" after startup when
+// "raster_trace_path" is set, for comparing raster settings.
+void start_raster_trace(const nlohmann::json& json_data) {
+  const auto path = json_data.value("raster_trace_path", std::string());
+  if (path.empty()) {
+    return;
+  }
+
+  if (!CefBeginTracing(raster_trace_categories, nullptr)) {
+    logger::log("Unable to start raster trace");
+    return;
+  }
+
+  const auto seconds =
+      std::clamp<int64_t>(json_data.value("raster_trace_seconds", 30), 1, 600);
+  logger::log("Recording raster trace for %lld s to %s",
+              static_cast<long long>(seconds), path.c_str());
+
+  CefPostDelayedTask(TID_UI,
+                     base::BindOnce(
+                         [](std::string path) { CefEndTracing(path, nullptr); },
+                         path),
+                     seconds * 1000);
+}
+
+}  // namespace
+
 TosuOverlay::TosuOverlay(std::string cef_path) {
   this->cef_path = cef_path;
 };
@@ -24,6 +73,8 @@ TosuOverlay::TosuOverlay(std::string cef_path) {
 void TosuOverlay::OnContextInitialized() {
   CEF_REQUIRE_UI_THREAD();
 
+  startup::mark(startup::Step::context_initialized);
+
   CefRefPtr<CefCommandLine> command_line =
       CefCommandLine::GetGlobalCommandLine();
 
@@ -46,17 +97,17 @@ void TosuOverlay::OnContextInitialized() {
   browser_settings.windowless_frame_rate = std::clamp<uint32_t>(
       static_cast<uint32_t>(json_data["cef_fps"]), 10, 120);
 
-  std::string url;
+  start_raster_trace(json_data);
 
-  url = "http://" + state::host + ":" + state::port + "/api/ingame";
+  handler_ = handler;
+  browser_settings_ = browser_settings;
+  url_ = "http://" + state::host + ":" + state::port + "/api/ingame";
 
-  CefWindowInfo window_info;
-
-  window_info.SetAsWindowless(nullptr);
-  window_info.windowless_rendering_enabled = TRUE;
-  window_info.runtime_style = CEF_RUNTIME_STYLE_ALLOY;
-  CefBrowserHost::CreateBrowserSync(window_info, handler, url, browser_settings,
-                                    nullptr, nullptr);
+  // the browser waits for tosu, a page that failed to load would stay blank
+  connection_ = std::make_unique<tosu_connection::Tracker>(
+      tosu_connection::parse_config(
+          json_data.value("tosu_connection", nlohmann::json::object())));
+  ProbeTosu();
 
   // CefBrowserHost::CreateBrowserSync(window_info, handler,
   // "https://google.com",
@@ -69,6 +120,63 @@ void TosuOverlay::OnContextInitialized() {
   //                                   browser_settings, nullptr, nullptr);
 }
 
+void TosuOverlay::ProbeTosu() {
+  // the probe blocks on connect
+  CefPostTask(TID_FILE_USER_VISIBLE,
+              base::BindOnce(&TosuOverlay::RunProbe, this));
+}
+
+void TosuOverlay::RunProbe() {
+  const auto result = http_probe::get(state::host, state::port,
+                                      "/api/ingame", probe_timeout_ms);
+  const bool reachable = result.status >= 200 && result.status < 400;
+
+  // before the browser exists, so its first requests find them confirmed
+  auto& assets = asset_cache::cache();
+  if (reachable && assets.needs_revalidation()) {
+    assets.revalidate(state::host, state::port, probe_timeout_ms);
+  }
+
+  CefPostTask(TID_UI,
+              base::BindOnce(&TosuOverlay::OnTosuProbed, this, reachable));
+}
+
+void TosuOverlay::OnTosuProbed(bool reachable) {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (handler_->IsClosing()) {
+    return;
+  }
+
+  if (reachable != tosu_reachable_) {
+    tosu_reachable_ = reachable;
+    logger::log(reachable ? "tosu is reachable at %s"
+                          : "tosu is not reachable at %s",
+                url_.c_str());
+  }
+
+  switch (connection_->on_probe(reachable, handler_->HasOverlayBrowser(),
+                                latency::now_us())) {
+    case tosu_connection::Action::create_browser:
+      logger::log("Creating overlay browser");
+      handler_->CreateOverlayBrowser(url_, browser_settings_);
+      break;
+
+    case tosu_connection::Action::close_browser:
+      logger::log("tosu has been gone a while, closing overlay browser");
+      handler_->ParkBrowser();
+      // tosu may come back with other counter files
+      asset_cache::cache().expire();
+      break;
+
+    case tosu_connection::Action::none:
+      break;
+  }
+
+  CefPostDelayedTask(TID_UI, base::BindOnce(&TosuOverlay::ProbeTosu, this),
+                     connection_->next_probe_ms());
+}
+
 CefRefPtr<CefClient> TosuOverlay::GetDefaultClient() {
   // Called when a new browser window is created via the Chrome runtime UI.
   return SimpleHandler::GetInstance();
@@ -77,31 +185,62 @@ CefRefPtr<CefClient> TosuOverlay::GetDefaultClient() {
 void TosuOverlay::OnBeforeCommandLineProcessing(
     const CefString& process_type,
     CefRefPtr<CefCommandLine> command_line) {
-  command_line->AppendSwitch("enable-experimental-web-platform-features");
-  command_line->AppendSwitch("in-process-gpu");
-  command_line->AppendSwitch("enable-media-stream");
-  command_line->AppendSwitch("use-fake-ui-for-media-stream");
-  command_line->AppendSwitch("enable-speech-input");
-  command_line->AppendSwitch("ignore-gpu-blacklist");
-  command_line->AppendSwitch("enable-usermedia-screen-capture");
-
-  command_line->AppendSwitchWithValue("default-encoding", "utf-8");
-
-  command_line->AppendSwitch("disable-gpu");
-  command_line->AppendSwitch("disable-gpu-compositing");
+  ConfigManager* config_manager = ConfigManager::get_instance();
+  const auto& json_data = config_manager->get_json_data();
 
-  command_line->AppendSwitch("disable-web-security");
-  command_line->AppendSwitch("ignore-certificate-errors");
+  const auto switch_config =
+      json_data.value("switches", nlohmann::json::object());
+  const auto profile = switch_config.value("profile", std::string("default"));
+  if (!switches::parse_profile(profile)) {
+    logger::log("Unknown switch profile %s, using default", profile.c_str());
+  }
 
-  command_line->AppendSwitchWithValue("remote-allow-origins", "*");
+  const auto raster_config =
+      json_data.value("raster", nlohmann::json::object());
+  const auto memory_config =
+      json_data.value("memory", nlohmann::json::object());
+  for (const auto& item :
+       switches::resolve(switch_config, raster_config, memory_config)) {
+    if (item.value.empty()) {
+      command_line->AppendSwitch(item.name);
+    } else {
+      command_line->AppendSwitchWithValue(item.name, item.value);
+    }
+  }
 
-  ConfigManager* config_manager = ConfigManager::get_instance();
-  auto json_data = config_manager->get_json_data();
-  if (static_cast<bool>(json_data["cef_debugging_enabled"])) {
+  if (json_data.value("cef_debugging_enabled", false)) {
     command_line->AppendSwitchWithValue("remote-debugging-port", "9222");
   }
 
   auto user_data_dir = std::filesystem::path(this->cef_path) / "userdata";
 
   command_line->AppendSwitchWithValue("user-data-dir", user_data_dir.string());
-}
\ No newline at end of file
+
+  logger::log("Chromium switches: %s",
+              command_line->GetCommandLineString().ToString().c_str());
+}
+
+void TosuOverlay::OnBeforeChildProcessLaunch(
+    CefRefPtr<CefCommandLine> command_line) {
+  const auto& json_data = ConfigManager::get_instance()->get_json_data();
+  const auto policy = scheduling::parse_policy(
+      json_data.value("scheduling", nlohmann::json::object()),
+      scheduling::core_count());
+
+  // applied by the subprocess itself before CefExecuteProcess
+  command_line->AppendSwitchWithValue(
+      scheduling::priority_switch,
+      scheduling::priority_name(policy.subprocess_priority));
+
+  if (policy.affinity != 0) {
+    char mask[24];
+    std::snprintf(mask, sizeof(mask), "%llx",
+                  static_cast<unsigned long long>(policy.affinity));
+    command_line->AppendSwitchWithValue(scheduling::affinity_switch, mask);
+  }
+}
+
+void TosuOverlay::OnScheduleMessagePumpWork(int64_t delay_ms) {
+  // only called with the "external_pump" message loop
+  message_loop::external_pump().schedule(delay_ms);
+}
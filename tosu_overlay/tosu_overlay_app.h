@@ -5,7 +5,12 @@
 #ifndef CEF_TESTS_CEFSIMPLE_SIMPLE_APP_H_
 #define CEF_TESTS_CEFSIMPLE_SIMPLE_APP_H_
 
+#include <memory>
+#include <string>
+
 #include "include/cef_app.h"
+#include "tosu_overlay/tosu_connection.h"
+#include "tosu_overlay/tosu_overlay_handler.h"
 
 // Implement application-level callbacks for the browser process.
 class TosuOverlay : public CefApp, public CefBrowserProcessHandler {
@@ -22,10 +27,24 @@ class TosuOverlay : public CefApp, public CefBrowserProcessHandler {
   CefRefPtr<CefClient> GetDefaultClient() override;
 
   virtual void OnBeforeCommandLineProcessing(const CefString &process_type, CefRefPtr<CefCommandLine> command_line) override;
+  void OnBeforeChildProcessLaunch(
+      CefRefPtr<CefCommandLine> command_line) override;
+  void OnScheduleMessagePumpWork(int64_t delay_ms) override;
 
  private:
+  // Checks tosu off the UI thread and decides about the browser on it.
+  void ProbeTosu();
+  void RunProbe();
+  void OnTosuProbed(bool reachable);
+
   std::string cef_path;
 
+  CefRefPtr<SimpleHandler> handler_;
+  CefBrowserSettings browser_settings_;
+  std::string url_;
+  std::unique_ptr<tosu_connection::Tracker> connection_;
+  bool tosu_reachable_ = false;
+
   // Include the default reference counting implementation.
   IMPLEMENT_REFCOUNTING(TosuOverlay);
 };
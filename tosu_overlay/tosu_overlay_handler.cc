@@ -5,8 +5,12 @@
 #include "tosu_overlay/tosu_overlay_handler.h"
 #include <wingdi.h>
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "canvas.h"
 #include "include/base/cef_callback.h"
@@ -17,7 +21,23 @@
 #include "include/views/cef_window.h"
 #include "include/wrapper/cef_closure_task.h"
 #include "include/wrapper/cef_helpers.h"
+#include "tosu_overlay/asset_cache.h"
+#include "tosu_overlay/asset_request_handler.h"
+#include "tosu_overlay/beatmap_image_handler.h"
+#include "tosu_overlay/beatmap_images.h"
 #include "tosu_overlay/canvas.h"
+#include "tosu_overlay/config.h"
+#include "tosu_overlay/frame_clock.h"
+#include "tosu_overlay/game_state.h"
+#include "tosu_overlay/input.h"
+#include "tosu_overlay/latency.h"
+#include "tosu_overlay/logger.h"
+#include "tosu_overlay/overlay_stats.h"
+#include "tosu_overlay/performance_mode.h"
+#include "tosu_overlay/region.h"
+#include "tosu_overlay/scheduling.h"
+#include "tosu_overlay/startup.h"
+#include "tosu_overlay/switches.h"
 
 namespace {
 
@@ -30,12 +50,93 @@ std::string GetDataURI(const std::string& data, const std::string& mime_type) {
              .ToString();
 }
 
+constexpr int64_t loop_stats_interval_ms = 10000;
+constexpr int64_t stats_interval_ms = 1000;
+
+// How often tosu is asked whether osu! left gameplay while a recycle waits.
+constexpr int64_t recycle_poll_ms = 5000;
+
+// A page whose fresh renderer is already over the limit would otherwise be
+// recycled over and over.
+constexpr int64_t recycle_cooldown_us = 10 * 60 * 1'000'000LL;
+
+long long to_mib(uint64_t bytes) {
+  return static_cast<long long>(bytes >> 20);
+}
+
+nlohmann::json memory_config() {
+  return ConfigManager::get_instance()->get_json_data().value(
+      "memory", nlohmann::json::object());
+}
+
 }  // namespace
 
 SimpleHandler::SimpleHandler(bool is_alloy_style)
-    : is_alloy_style_(is_alloy_style) {
+    : is_alloy_style_(is_alloy_style),
+      memory_monitor_(
+          static_cast<uint64_t>(
+              std::max(memory_config().value("growth_warning_mb", 128), 0))
+          << 20) {
   DCHECK(!g_instance);
   g_instance = this;
+
+  const auto& json_data = ConfigManager::get_instance()->get_json_data();
+
+  memory_sample_ms_ =
+      std::max<int64_t>(memory_config().value("sample_seconds", 60), 0) *
+      1000;
+  recycle_limit_ = static_cast<uint64_t>(
+                       std::max(memory_config().value("recycle_mb", 0), 0))
+                   << 20;
+
+  // the same switches TosuOverlay puts on the command line
+  single_renderer_ =
+      switches::find(
+          switches::resolve(
+              json_data.value("switches", nlohmann::json::object()),
+              json_data.value("raster", nlohmann::json::object()),
+              memory_config()),
+          "renderer-process-limit") == "1";
+
+  const auto image_config =
+      json_data.value("beatmap_images", nlohmann::json::object());
+  beatmap_images_ = image_config.value("enabled", true);
+  beatmap_images::cache().set_budget(
+      static_cast<uint64_t>(
+          std::clamp<int64_t>(image_config.value("cache_mb", 64), 1, 1024))
+      << 20);
+
+  auto feed_config = tosu_feed::parse_config(
+      json_data.value("tosu_feed", nlohmann::json::object()));
+  feed_config.record_path =
+      json_data.value("feed_record_path", std::string());
+  if (feed_config.enabled) {
+    feed_router_ = std::make_unique<FeedRouter>(
+        feed_config,
+        [this](const std::string& endpoint, tosu_feed::Update update) {
+          CefPostTask(TID_UI, base::BindOnce(&SimpleHandler::DeliverFeed,
+                                             this, endpoint,
+                                             std::move(update)));
+        });
+  }
+
+  frame_clock_ms_ =
+      1000 / std::clamp<int64_t>(json_data.value("cef_fps", 60), 10, 120);
+
+  const auto performance_config =
+      json_data.value("performance_mode", nlohmann::json::object());
+  const auto performance = performance_mode::parse_config(performance_config);
+  if (performance.enabled) {
+    performance_mode_ = performance_config.dump();
+    logger::log("Performance mode: effects off except for %zu counters",
+                performance.allow.size());
+  }
+
+  const auto damage_stream_path =
+      json_data.value("damage_stream_path", std::string());
+  if (!damage_stream_path.empty()) {
+    damage_stream_.open(damage_stream_path, std::ios_base::trunc);
+  }
 }
 
 SimpleHandler::~SimpleHandler() {
@@ -67,6 +168,77 @@ void SimpleHandler::OnTitleChange(CefRefPtr<CefBrowser> browser,
   }
 }
 
+void SimpleHandler::CreateOverlayBrowser(
+    const CefString& url,
+    const CefBrowserSettings& browser_settings) {
+  CEF_REQUIRE_UI_THREAD();
+
+  CefWindowInfo window_info;
+  window_info.SetAsWindowless(nullptr);
+  window_info.windowless_rendering_enabled = TRUE;
+  window_info.runtime_style = CEF_RUNTIME_STYLE_ALLOY;
+
+  // Asynchronous, so the UI thread goes back to pumping the renderer launch
+  // and navigation right away. OnAfterCreated picks the browser up.
+  // for the render process, see RendererApp::OnBrowserCreated
+  CefRefPtr<CefDictionaryValue> extra_info;
+  if (!performance_mode_.empty()) {
+    extra_info = CefDictionaryValue::Create();
+    extra_info->SetString(performance_mode::extra_info_key, performance_mode_);
+  }
+
+  creating_ = true;
+  parked_ = false;
+  CefBrowserHost::CreateBrowser(window_info, this, url, browser_settings,
+                                extra_info, nullptr);
+}
+
+bool SimpleHandler::HasOverlayBrowser() const {
+  return creating_ || active_browser_ || pending_browser_ ||
+         recycle_closing_;
+}
+
+void SimpleHandler::ParkBrowser() {
+  CEF_REQUIRE_UI_THREAD();
+
+  // also while a browser is still being created, OnAfterCreated closes it
+  parked_ = true;
+  recycle_wanted_ = false;
+  recycle_creating_ = false;
+
+  // a single-renderer recycle's old browser is closing already, it now goes
+  // without a replacement
+  const bool recycle_closing = recycle_closing_;
+  recycle_closing_ = false;
+
+  if (!active_browser_ && !pending_browser_ && !recycle_closing) {
+    return;
+  }
+
+  parking_ = true;
+  input::set_browser(nullptr);
+
+  // the last frame would otherwise stay on screen
+  const auto render_size = canvas::get_render_size();
+  if (render_size.x > 0 && render_size.y > 0) {
+    std::vector<uint8_t> blank(static_cast<size_t>(render_size.x) *
+                               render_size.y * frame::bytes_per_pixel);
+    canvas::set_data(blank.data(), {{0, 0, render_size.x, render_size.y}});
+  }
+
+  if (active_browser_) {
+    auto browser = active_browser_;
+    active_browser_ = nullptr;
+    browser->GetHost()->CloseBrowser(true);
+  }
+
+  if (pending_browser_) {
+    auto pending = pending_browser_;
+    pending_browser_ = nullptr;
+    pending->GetHost()->CloseBrowser(true);
+  }
+}
+
 void SimpleHandler::OnAfterCreated(CefRefPtr<CefBrowser> browser) {
   CEF_REQUIRE_UI_THREAD();
 
@@ -76,6 +248,320 @@ void SimpleHandler::OnAfterCreated(CefRefPtr<CefBrowser> browser) {
 
   // Add to the list of existing browsers.
   browser_list_.push_back(browser);
+
+  creating_ = false;
+
+  // tosu went away while it was being created
+  if (parked_) {
+    logger::log("tosu is gone, closing the browser that was being created");
+    parking_ = true;
+    browser->GetHost()->CloseBrowser(true);
+    return;
+  }
+
+  if (!active_browser_ && !recycle_creating_) {
+    active_browser_ = browser;
+    parking_ = false;
+    input::set_browser(browser);
+    memory_monitor_.reset();
+  } else {
+    recycle_creating_ = false;
+    pending_browser_ = browser;
+    pending_loaded_ = false;
+  }
+
+  startup::mark(startup::Step::browser_created);
+
+  // once, browsers come and go with tosu and recycling
+  if (timers_started_) {
+    return;
+  }
+  timers_started_ = true;
+
+  {
+    paint_jitter_.set_frame_rate(
+        std::max(browser->GetHost()->GetWindowlessFrameRate(), 1));
+    loop_stats_us_ = latency::now_us();
+    loop_stats_cpu_us_ = scheduling::thread_cpu_us();
+    CefPostDelayedTask(TID_UI,
+                       base::BindOnce(&SimpleHandler::LogLoopStats, this),
+                       loop_stats_interval_ms);
+  }
+
+  if (memory_sample_ms_ > 0) {
+    CefPostDelayedTask(
+        TID_UI, base::BindOnce(&SimpleHandler::RequestMemorySample, this),
+        memory_sample_ms_);
+  }
+}
+
+bool SimpleHandler::OnProcessMessageReceived(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefProcessId source_process,
+    CefRefPtr<CefProcessMessage> message) {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (feed_router_ &&
+      feed_router_->OnProcessMessage(browser, frame, message)) {
+    return true;
+  }
+
+  if (frame_clock_watchers_.OnProcessMessage(browser, frame, message)) {
+    if (!frame_clock_watchers_.empty() && !frame_clock_sending_) {
+      frame_clock_sending_ = true;
+      SendFrameClock();
+    }
+    return true;
+  }
+
+  if (stats_watchers_.OnProcessMessage(browser, frame, message)) {
+    if (!stats_watchers_.empty() && !stats_sending_) {
+      // the first window starts now, not at the previous watcher's last
+      stats_sending_ = true;
+      stats_sampler_ = {};
+      CefPostDelayedTask(TID_UI,
+                         base::BindOnce(&SimpleHandler::SendStats, this),
+                         stats_interval_ms);
+    }
+    return true;
+  }
+
+  if (message->GetName() != memory_stats::sample_message) {
+    return false;
+  }
+
+  const auto args = message->GetArgumentList();
+  const auto field = [&](size_t index) {
+    return static_cast<uint64_t>(std::max(args->GetDouble(index), 0.0));
+  };
+
+  memory_stats::Sample sample{};
+  sample.time_us = latency::now_us();
+  sample.working_set = field(0);
+  sample.private_bytes = field(1);
+  sample.js_heap_used = field(2);
+  sample.js_heap_total = field(3);
+  sample.js_heap_limit = field(4);
+
+  if (memory_monitor_.record(sample)) {
+    logger::log("Renderer memory keeps growing: %s",
+                memory_monitor_.describe().c_str());
+  } else {
+    logger::log("Renderer memory: %s", memory_monitor_.describe().c_str());
+  }
+
+  if (recycled_) {
+    recycled_ = false;
+    logger::log("Recycled renderer: rss %lld -> %lld MiB, js %lld -> %lld MiB",
+                to_mib(recycled_from_.working_set),
+                to_mib(sample.working_set),
+                to_mib(recycled_from_.js_heap_used),
+                to_mib(sample.js_heap_used));
+  }
+
+  if (recycle_limit_ != 0 && sample.working_set > recycle_limit_ &&
+      !recycle_wanted_ && !pending_browser_ &&
+      (last_recycle_us_ == 0 ||
+       sample.time_us - last_recycle_us_ > recycle_cooldown_us)) {
+    recycle_wanted_ = true;
+    logger::log("Renderer passed %lld MiB, recycling outside gameplay",
+                to_mib(recycle_limit_));
+    CheckRecycle();
+  }
+
+  return true;
+}
+
+void SimpleHandler::LogLoopStats() {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (is_closing_) {
+    return;
+  }
+
+  const auto now = latency::now_us();
+  const auto cpu = scheduling::thread_cpu_us();
+  const auto wall = std::max<int64_t>(now - loop_stats_us_, 1);
+  const auto jitter = paint_jitter_.histogram().summary();
+  const auto pump = message_loop::external_pump().take_stats();
+
+  logger::log("Message loop: paint jitter n=%llu p50=%lld p95=%lld p99=%lld "
+              "us, UI thread CPU %.1f%%, pump wakeups=%llu work=%llu "
+              "exhausted=%llu",
+              static_cast<unsigned long long>(jitter.count),
+              static_cast<long long>(jitter.p50_us),
+              static_cast<long long>(jitter.p95_us),
+              static_cast<long long>(jitter.p99_us),
+              100.0 * (cpu - loop_stats_cpu_us_) / wall,
+              static_cast<unsigned long long>(pump.wakeups),
+              static_cast<unsigned long long>(pump.work_calls),
+              static_cast<unsigned long long>(pump.exhausted_slices));
+
+  paint_jitter_.reset();
+  loop_stats_us_ = now;
+  loop_stats_cpu_us_ = cpu;
+
+  // what raster has to redo, for comparing pages and performance_mode
+  const auto view = canvas::get_render_size();
+  const auto view_area = std::max<int64_t>(
+      static_cast<int64_t>(view.x) * static_cast<int64_t>(view.y), 1);
+  const auto frames = log_stats_.take(now);
+  if (frames.paint_rate > 0) {
+    logger::log("Paint area: %.1f paints/s, %lld px (%.1f%% of the view) "
+                "per paint, %.1f MiB/s uploaded, %llu dropped, hook p50=%lld "
+                "p99=%lld us",
+                frames.paint_rate, static_cast<long long>(frames.dirty_area),
+                100.0 * static_cast<double>(frames.dirty_area) / view_area,
+                frames.upload_bytes_per_second / (1 << 20),
+                static_cast<unsigned long long>(frames.dropped_frames),
+                static_cast<long long>(frames.hook_p50_us),
+                static_cast<long long>(frames.hook_p99_us));
+  }
+
+  // only after map changes asked for images
+  const auto images = beatmap_images::cache().stats();
+  if (images.hits + images.misses != beatmap_image_requests_) {
+    beatmap_image_requests_ = images.hits + images.misses;
+    logger::log("Beatmap images: %llu hits, %llu misses, %llu scaled, "
+                "%llu KiB held",
+                static_cast<unsigned long long>(images.hits),
+                static_cast<unsigned long long>(images.misses),
+                static_cast<unsigned long long>(images.scaled),
+                static_cast<unsigned long long>(images.bytes >> 10));
+  }
+
+  const auto feed = feed_router_ ? feed_router_->GetStats()
+                                 : tosu_feed::Stats{};
+  if (feed.messages != feed_messages_) {
+    feed_messages_ = feed.messages;
+    const auto messages = std::max<uint64_t>(feed.messages, 1);
+    logger::log("tosu feed: %llu messages (%llu from shared memory), "
+                "%llu KiB, parse avg %lld us, %.1f changes per message, "
+                "%llu connects, %llu parse errors",
+                static_cast<unsigned long long>(feed.messages),
+                static_cast<unsigned long long>(feed.shared_messages),
+                static_cast<unsigned long long>(feed.bytes >> 10),
+                static_cast<long long>(feed.parse_us / messages),
+                static_cast<double>(feed.changes) / messages,
+                static_cast<unsigned long long>(feed.connects),
+                static_cast<unsigned long long>(feed.parse_errors));
+  }
+
+  CefPostDelayedTask(TID_UI,
+                     base::BindOnce(&SimpleHandler::LogLoopStats, this),
+                     loop_stats_interval_ms);
+}
+
+void SimpleHandler::CheckRecycle() {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (!recycle_wanted_ || is_closing_) {
+    return;
+  }
+
+  CefRefPtr<SimpleHandler> self(this);
+  game_state::request_is_gameplay([self](std::optional<bool> gameplay) {
+    if (gameplay == false) {
+      self->StartRecycle();
+      return;
+    }
+
+    // unknown counts as gameplay, recycling mid-map is what this avoids
+    CefPostDelayedTask(TID_UI,
+                       base::BindOnce(&SimpleHandler::CheckRecycle, self),
+                       recycle_poll_ms);
+  });
+}
+
+void SimpleHandler::StartRecycle() {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (!recycle_wanted_ || !active_browser_ || pending_browser_ ||
+      recycle_closing_) {
+    return;
+  }
+
+  recycle_wanted_ = false;
+  last_recycle_us_ = latency::now_us();
+  recycled_from_ = memory_monitor_.latest();
+
+  logger::log("Recycling renderer: %s", memory_monitor_.describe().c_str());
+
+  CefBrowserSettings browser_settings;
+  browser_settings.windowless_frame_rate =
+      active_browser_->GetHost()->GetWindowlessFrameRate();
+  const auto url = active_browser_->GetMainFrame()->GetURL();
+
+  if (!single_renderer_) {
+    CreateOverlayBrowser(url, browser_settings);
+    return;
+  }
+
+  // OnBeforeClose creates the replacement, in a renderer of its own
+  recycle_closing_ = true;
+  recycle_url_ = url;
+  recycle_settings_ = browser_settings;
+  input::set_browser(nullptr);
+
+  auto browser = active_browser_;
+  active_browser_ = nullptr;
+  browser->GetHost()->CloseBrowser(true);
+}
+
+void SimpleHandler::SwapInPendingBrowser() {
+  CEF_REQUIRE_UI_THREAD();
+
+  auto old_browser = active_browser_;
+  active_browser_ = pending_browser_;
+  pending_browser_ = nullptr;
+
+  input::set_browser(active_browser_);
+  memory_monitor_.reset();
+  recycled_ = true;
+
+  logger::log("Swapped in the recycled renderer after %lld ms",
+              static_cast<long long>(
+                  (latency::now_us() - last_recycle_us_) / 1000));
+
+  // already closed with a single renderer
+  if (old_browser) {
+    old_browser->GetHost()->CloseBrowser(true);
+  }
+}
+
+void SimpleHandler::AbandonRecycle() {
+  CEF_REQUIRE_UI_THREAD();
+
+  // with a single renderer the old page is gone, an error page beats none
+  if (!active_browser_) {
+    logger::log("Recycled renderer failed to load, showing it anyway");
+    SwapInPendingBrowser();
+    return;
+  }
+
+  logger::log("Recycled renderer failed to load, keeping the current one");
+
+  auto pending = pending_browser_;
+  pending_browser_ = nullptr;
+  pending->GetHost()->CloseBrowser(true);
+}
+
+void SimpleHandler::RequestMemorySample() {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (is_closing_) {
+    return;
+  }
+
+  if (active_browser_) {
+    active_browser_->GetMainFrame()->SendProcessMessage(
+        PID_RENDERER, CefProcessMessage::Create(memory_stats::sample_message));
+  }
+
+  CefPostDelayedTask(
+      TID_UI, base::BindOnce(&SimpleHandler::RequestMemorySample, this),
+      memory_sample_ms_);
 }
 
 bool SimpleHandler::DoClose(CefRefPtr<CefBrowser> browser) {
@@ -84,7 +570,7 @@ bool SimpleHandler::DoClose(CefRefPtr<CefBrowser> browser) {
   // Closing the main window requires special handling. See the DoClose()
   // documentation in the CEF header for a detailed destription of this
   // process.
-  if (browser_list_.size() == 1) {
+  if (browser_list_.size() == 1 && !parking_ && !recycle_closing_) {
     // Set a flag to indicate that the window close should be allowed.
     is_closing_ = true;
   }
@@ -97,6 +583,18 @@ bool SimpleHandler::DoClose(CefRefPtr<CefBrowser> browser) {
 void SimpleHandler::OnBeforeClose(CefRefPtr<CefBrowser> browser) {
   CEF_REQUIRE_UI_THREAD();
 
+  if (feed_router_) {
+    feed_router_->OnBrowserClosed(browser);
+  }
+  frame_clock_watchers_.OnBrowserClosed(browser);
+  stats_watchers_.OnBrowserClosed(browser);
+
+  if (active_browser_ && active_browser_->IsSame(browser)) {
+    active_browser_ = nullptr;
+  } else if (pending_browser_ && pending_browser_->IsSame(browser)) {
+    pending_browser_ = nullptr;
+  }
+
   // Remove from the list of existing browsers.
   BrowserList::iterator bit = browser_list_.begin();
   for (; bit != browser_list_.end(); ++bit) {
@@ -106,9 +604,30 @@ void SimpleHandler::OnBeforeClose(CefRefPtr<CefBrowser> browser) {
     }
   }
 
-  if (browser_list_.empty()) {
-    // All browser windows have closed. Quit the application message loop.
-    CefQuitMessageLoop();
+  if (browser_list_.empty() && recycle_closing_) {
+    // its renderer is gone with it, the replacement gets a fresh one
+    recycle_closing_ = false;
+    recycle_creating_ = true;
+    CreateOverlayBrowser(recycle_url_, recycle_settings_);
+  } else if (browser_list_.empty() && (parking_ || creating_)) {
+    // closed while tosu is away, CEF keeps running for the next one
+    parking_ = false;
+  } else if (browser_list_.empty()) {
+    // All browser windows have closed. Leave the message loop the way the
+    // mode runs it, CefQuitMessageLoop is only valid in CefRunMessageLoop.
+    // The feed's threads go first, they post to the UI thread.
+    feed_router_.reset();
+    switch (message_loop::mode()) {
+      case message_loop::Mode::dedicated:
+        CefQuitMessageLoop();
+        break;
+      case message_loop::Mode::external_pump:
+        message_loop::external_pump().quit();
+        break;
+      case message_loop::Mode::multi_threaded:
+        // no loop to leave, CEF lives until osu! exits
+        break;
+    }
   }
 }
 
@@ -119,6 +638,13 @@ void SimpleHandler::OnLoadError(CefRefPtr<CefBrowser> browser,
                                 const CefString& failedUrl) {
   CEF_REQUIRE_UI_THREAD();
 
+  // never swap an error page in for a working overlay
+  if (pending_browser_ && pending_browser_->IsSame(browser) &&
+      frame->IsMain() && errorCode != ERR_ABORTED) {
+    AbandonRecycle();
+    return;
+  }
+
   // Allow Chrome to show the error page.
   if (!is_alloy_style_) {
     return;
@@ -180,16 +706,188 @@ void SimpleHandler::CloseAllBrowsers(bool force_close) {
   }
 }
 
+CefRefPtr<CefResourceRequestHandler> SimpleHandler::GetResourceRequestHandler(
+    CefRefPtr<CefBrowser> browser,
+    CefRefPtr<CefFrame> frame,
+    CefRefPtr<CefRequest> request,
+    bool is_navigation,
+    bool is_download,
+    const CefString& request_initiator,
+    bool& disable_default_handling) {
+  if (beatmap_images_ && BeatmapImageRequestHandler::Handles(request)) {
+    return new BeatmapImageRequestHandler();
+  }
+
+  if (!asset_cache::cache().is_open() ||
+      !AssetRequestHandler::Handles(request)) {
+    return nullptr;
+  }
+
+  return new AssetRequestHandler(request->GetURL().ToString());
+}
+
+void SimpleHandler::LogAssetCache() {
+  const auto stats = asset_cache::cache().stats();
+  logger::log(
+      "Asset cache: %llu hits, %llu misses, %llu KiB served, %llu stored, "
+      "%llu revalidated, %llu replaced",
+      static_cast<unsigned long long>(stats.hits),
+      static_cast<unsigned long long>(stats.misses),
+      static_cast<unsigned long long>(stats.bytes_served >> 10),
+      static_cast<unsigned long long>(stats.stored),
+      static_cast<unsigned long long>(stats.revalidated),
+      static_cast<unsigned long long>(stats.replaced));
+
+  CefPostTask(TID_FILE_BACKGROUND,
+              base::BindOnce([] { asset_cache::cache().save(); }));
+}
+
+void SimpleHandler::DeliverFeed(std::string endpoint,
+                                tosu_feed::Update update) {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (feed_router_) {
+    feed_router_->Deliver(endpoint, std::move(update));
+  }
+}
+
+void SimpleHandler::SendFrameClock() {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (is_closing_ || frame_clock_watchers_.empty()) {
+    frame_clock_sending_ = false;
+    return;
+  }
+
+  const auto snapshot = frame_clock::take(latency::now_us());
+  auto presents = CefListValue::Create();
+  presents->SetSize(snapshot.presents_us.size());
+  for (size_t i = 0; i < snapshot.presents_us.size(); ++i) {
+    presents->SetDouble(i, static_cast<double>(snapshot.presents_us[i]));
+  }
+
+  auto args = CefListValue::Create();
+  args->SetList(0, presents);
+  args->SetDouble(1, static_cast<double>(snapshot.interval_us));
+  args->SetDouble(2, static_cast<double>(snapshot.next_present_us));
+  frame_clock_watchers_.Send(frame_clock::update_message, args);
+
+  CefPostDelayedTask(TID_UI,
+                     base::BindOnce(&SimpleHandler::SendFrameClock, this),
+                     frame_clock_ms_);
+}
+
+void SimpleHandler::SendStats() {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (is_closing_ || stats_watchers_.empty()) {
+    stats_sending_ = false;
+    return;
+  }
+
+  const auto window = stats_sampler_.take(latency::now_us());
+  const auto view = canvas::get_render_size();
+  const auto view_area = std::max<int64_t>(
+      static_cast<int64_t>(view.x) * static_cast<int64_t>(view.y), 1);
+
+  auto stats = CefDictionaryValue::Create();
+  stats->SetDouble("paintRate", window.paint_rate);
+  stats->SetDouble("dirtyArea", static_cast<double>(window.dirty_area));
+  stats->SetDouble("dirtyFraction",
+                   static_cast<double>(window.dirty_area) / view_area);
+  stats->SetDouble("uploadBytesPerSecond", window.upload_bytes_per_second);
+  stats->SetDouble("gameFps", window.game_fps);
+  stats->SetDouble("hookP50", static_cast<double>(window.hook_p50_us) / 1000);
+  stats->SetDouble("hookP99", static_cast<double>(window.hook_p99_us) / 1000);
+  stats->SetDouble("droppedFrames", static_cast<double>(window.dropped_frames));
+
+  auto args = CefListValue::Create();
+  args->SetDictionary(0, stats);
+  stats_watchers_.Send(overlay_stats::update_message, args);
+
+  CefPostDelayedTask(TID_UI, base::BindOnce(&SimpleHandler::SendStats, this),
+                     stats_interval_ms);
+}
+
+void SimpleHandler::OnLoadingStateChange(CefRefPtr<CefBrowser> browser,
+                                         bool isLoading,
+                                         bool canGoBack,
+                                         bool canGoForward) {
+  CEF_REQUIRE_UI_THREAD();
+
+  if (!isLoading && asset_cache::cache().is_open()) {
+    // what the page asked for while loading has been served or stored
+    LogAssetCache();
+  }
+
+  if (isLoading || !pending_browser_ || !pending_browser_->IsSame(browser)) {
+    return;
+  }
+
+  // the next paint has the loaded page, ask for all of it
+  pending_loaded_ = true;
+  browser->GetHost()->Invalidate(PET_VIEW);
+}
+
 void SimpleHandler::OnPaint(CefRefPtr<CefBrowser> browser,
                             PaintElementType type,
                             const RectList& dirty_rects,
                             const void* buffer,
                             int width,
                             int height) {
+  // a recycled renderer's replacement paints in the background, the canvas
+  // keeps the old frame until the new page is loaded
+  bool swapped = false;
+  if (pending_browser_ && pending_browser_->IsSame(browser)) {
+    if (!pending_loaded_) {
+      return;
+    }
+
+    SwapInPendingBrowser();
+    swapped = true;
+  } else if (!active_browser_ || !active_browser_->IsSame(browser)) {
+    return;
+  }
+
+  paint_jitter_.record(latency::now_us());
+
   auto render_size = canvas::get_render_size();
 
   if (render_size.x == width && render_size.y == height) {
-    canvas::set_data(buffer);
+    frame::RectList rects;
+    rects.reserve(dirty_rects.size());
+    for (const auto& dirty : dirty_rects) {
+      rects.push_back({dirty.x, dirty.y, dirty.width, dirty.height});
+    }
+
+    // nothing of the old page may survive the swap
+    if (swapped) {
+      rects.assign(1, {0, 0, width, height});
+    }
+
+    canvas::set_data(buffer, rects);
+
+    if (startup::mark(startup::Step::first_paint)) {
+      logger::log("First paint %lld ms after browser creation",
+                  static_cast<long long>(
+                      startup::elapsed_us(startup::Step::browser_created,
+                                          startup::Step::first_paint) /
+                      1000));
+    }
+
+    if (!rects.empty()) {
+      latency::painted();
+
+      int64_t dirty_area = 0;
+      for (const auto& rect : rects) {
+        dirty_area += rect.area();
+      }
+      overlay_stats::painted(dirty_area);
+    }
+
+    if (damage_stream_.is_open()) {
+      region::write_stream_frame(damage_stream_, rects);
+    }
   } else {
     browser->GetHost()->WasResized();
   }
@@ -5,15 +5,26 @@
 #ifndef CEF_TESTS_CEFSIMPLE_SIMPLE_HANDLER_H_
 #define CEF_TESTS_CEFSIMPLE_SIMPLE_HANDLER_H_
 
+#include <cstdint>
+#include <fstream>
 #include <list>
+#include <memory>
+#include <string>
 
 #include "include/cef_client.h"
+#include "tosu_overlay/feed_router.h"
+#include "tosu_overlay/frame_clock.h"
+#include "tosu_overlay/frame_watchers.h"
+#include "tosu_overlay/memory_stats.h"
+#include "tosu_overlay/message_loop.h"
+#include "tosu_overlay/overlay_stats.h"
 
 class SimpleHandler : public CefClient,
                       public CefDisplayHandler,
                       public CefLifeSpanHandler,
                       public CefRenderHandler,
-                      public CefLoadHandler {
+                      public CefLoadHandler,
+                      public CefRequestHandler {
  public:
   explicit SimpleHandler(bool is_alloy_style);
   ~SimpleHandler() override;
@@ -29,6 +40,11 @@ class SimpleHandler : public CefClient,
   CefRefPtr<CefDisplayHandler> GetDisplayHandler() override { return this; }
   CefRefPtr<CefLifeSpanHandler> GetLifeSpanHandler() override { return this; }
   CefRefPtr<CefLoadHandler> GetLoadHandler() override { return this; }
+  CefRefPtr<CefRequestHandler> GetRequestHandler() override { return this; }
+  bool OnProcessMessageReceived(CefRefPtr<CefBrowser> browser,
+                                CefRefPtr<CefFrame> frame,
+                                CefProcessId source_process,
+                                CefRefPtr<CefProcessMessage> message) override;
 
   // CefDisplayHandler methods:
   void OnTitleChange(CefRefPtr<CefBrowser> browser,
@@ -45,6 +61,20 @@ class SimpleHandler : public CefClient,
                    ErrorCode errorCode,
                    const CefString& errorText,
                    const CefString& failedUrl) override;
+  void OnLoadingStateChange(CefRefPtr<CefBrowser> browser,
+                            bool isLoading,
+                            bool canGoBack,
+                            bool canGoForward) override;
+
+  // CefRequestHandler methods:
+  CefRefPtr<CefResourceRequestHandler> GetResourceRequestHandler(
+      CefRefPtr<CefBrowser> browser,
+      CefRefPtr<CefFrame> frame,
+      CefRefPtr<CefRequest> request,
+      bool is_navigation,
+      bool is_download,
+      const CefString& request_initiator,
+      bool& disable_default_handling) override;
 
   void ShowMainWindow();
 
@@ -64,12 +94,56 @@ class SimpleHandler : public CefClient,
 
   BrowserList GetBrowserList();
 
+  // The overlay page's browser, windowless. Only one is active at a time, a
+  // second one created meanwhile replaces it (see renderer recycling).
+  void CreateOverlayBrowser(const CefString& url,
+                            const CefBrowserSettings& browser_settings);
+  // Whether an overlay browser exists or is being created.
+  bool HasOverlayBrowser() const;
+  // Closes the overlay browser while tosu is unreachable, without quitting
+  // the message loop, and clears the canvas.
+  void ParkBrowser();
+
+  // Renderer memory samples so far. Only accessed on the CEF UI thread.
+  const memory_stats::Monitor& GetMemoryMonitor() const {
+    return memory_monitor_;
+  }
+
  private:
   // Platform-specific implementation.
   void PlatformTitleChange(CefRefPtr<CefBrowser> browser,
                            const CefString& title);
   void PlatformShowWindow(CefRefPtr<CefBrowser> browser);
 
+  // Asks the render process for a memory sample and schedules the next one.
+  void RequestMemorySample();
+
+  // Logs paint delivery jitter, UI thread CPU and external pump wakeups
+  // every 10 s, for comparing "message_loop" modes.
+  void LogLoopStats();
+
+  // Cache counts so far, and writes what the page load added to it.
+  void LogAssetCache();
+
+  // A tosu message for the pages subscribed to its endpoint.
+  void DeliverFeed(std::string endpoint, tosu_feed::Update update);
+
+  // The game's presents for pages watching them, once per overlay frame
+  // until none is left.
+  void SendFrameClock();
+
+  // The overlay's costs over the last second for pages watching them, once
+  // a second until none is left.
+  void SendStats();
+
+  // Renderer recycling: once the working set passes "recycle_mb", a fresh
+  // browser is created outside gameplay and swapped in on its first paint
+  // after loading, while the canvas keeps the old browser's last frame.
+  void CheckRecycle();
+  void StartRecycle();
+  void SwapInPendingBrowser();
+  void AbandonRecycle();
+
   // True if this client is Alloy style, otherwise Chrome style.
   const bool is_alloy_style_;
 
@@ -78,6 +152,73 @@ class SimpleHandler : public CefClient,
 
   bool is_closing_ = false;
 
+  // OnPaint damage recorded for the region benchmarks, see README.
+  std::ofstream damage_stream_;
+
+  // "memory" config, see memory_stats.h.
+  int64_t memory_sample_ms_ = 0;
+  memory_stats::Monitor memory_monitor_;
+
+  message_loop::PaintJitter paint_jitter_;
+  int64_t loop_stats_us_ = 0;
+  int64_t loop_stats_cpu_us_ = 0;
+  uint64_t beatmap_image_requests_ = 0;
+  uint64_t feed_messages_ = 0;
+  overlay_stats::Sampler log_stats_;
+
+  // "performance_mode" as JSON for the render process, empty while it's
+  // disabled.
+  std::string performance_mode_;
+
+  // The browser whose frames reach the canvas and whose renderer is sampled.
+  CefRefPtr<CefBrowser> active_browser_;
+  bool creating_ = false;
+  bool parking_ = false;
+  // tosu is gone: ParkBrowser() was called and no browser was created
+  // since, so one that finishes creating now is closed right away
+  bool parked_ = false;
+  bool timers_started_ = false;
+
+  // The replacement being loaded while recycling.
+  CefRefPtr<CefBrowser> pending_browser_;
+  bool pending_loaded_ = false;
+
+  uint64_t recycle_limit_ = 0;
+  bool recycle_wanted_ = false;
+  int64_t last_recycle_us_ = 0;
+
+  // With "renderer-process-limit" 1 a replacement would share the old
+  // browser's renderer, so the old browser is closed first and the
+  // replacement created once it's gone. The canvas keeps its last frame.
+  bool single_renderer_ = false;
+  bool recycle_closing_ = false;
+  bool recycle_creating_ = false;
+  CefString recycle_url_;
+  CefBrowserSettings recycle_settings_;
+
+  // Logged against the new renderer's first sample.
+  bool recycled_ = false;
+  memory_stats::Sample recycled_from_{};
+
+  // window.tosuOverlay.subscribe(), null when "tosu_feed" is disabled.
+  std::unique_ptr<FeedRouter> feed_router_;
+
+  // tosuOverlay.frameClock()
+  FrameWatchers frame_clock_watchers_{frame_clock::watch_message,
+                                      frame_clock::unwatch_message};
+  bool frame_clock_sending_ = false;
+  int64_t frame_clock_ms_ = 16;
+
+  // tosuOverlay.stats()
+  FrameWatchers stats_watchers_{overlay_stats::watch_message,
+                                overlay_stats::unwatch_message};
+  bool stats_sending_ = false;
+  overlay_stats::Sampler stats_sampler_;
+
+  // "beatmap_images" "enabled", set before any browser exists and only read
+  // on the IO thread after that.
+  bool beatmap_images_ = true;
+
   // Include the default reference counting implementation.
   IMPLEMENT_REFCOUNTING(SimpleHandler);
 };
@@ -2,8 +2,17 @@
 
 #include <include/cef_command_line.h>
 #include <include/cef_sandbox_win.h>
+#include <include/wrapper/cef_closure_task.h>
+#include <tosu_overlay/asset_cache.h>
 #include <tosu_overlay/canvas.h>
 #include <tosu_overlay/config.h>
+#include <tosu_overlay/frame_clock.h>
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/message_loop.h>
+#include <tosu_overlay/overlay_stats.h>
+#include <tosu_overlay/renderer_app.h>
+#include <tosu_overlay/scheduling.h>
+#include <tosu_overlay/startup.h>
 #include <tosu_overlay/state.h>
 #include <tosu_overlay/tools.h>
 #include <tosu_overlay/tosu_overlay_app.h>
@@ -14,10 +23,13 @@
 #include <glad/glad.h>
 #include <wingdi.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <tosu_overlay/input.h>
 
@@ -32,17 +44,60 @@
 
 namespace {
 
-bool is_cef_initialized = false;
+// CEF's own files, read ahead on a separate thread so the loader and the
+// resource bundle find them in the file cache instead of faulting them in
+// from disk one page at a time during CefInitialize.
+const char* const cef_resources[] = {
+    "libcef.dll",
+    "chrome_elf.dll",
+    "icudtl.dat",
+    "v8_context_snapshot.bin",
+    "resources.pak",
+    "chrome_100_percent.pak",
+    "chrome_200_percent.pak",
+    "locales/en-US.pak",
+};
+
+// Upper bound for reading ahead the disk cache ("disk_cache").
+constexpr uint64_t cache_prefault_limit = uint64_t{64} << 20;
+
+constexpr int asset_revalidate_timeout_ms = 1000;
 
 #if DESKTOP
+// Priority and affinity the browser process picked for its subprocesses
+// (see TosuOverlay::OnBeforeChildProcessLaunch).
+void apply_subprocess_scheduling() {
+  CefRefPtr<CefCommandLine> command_line = CefCommandLine::CreateCommandLine();
+  command_line->InitFromString(::GetCommandLineW());
+
+  const auto priority = scheduling::parse_priority(
+      command_line->GetSwitchValue(scheduling::priority_switch).ToString());
+  if (priority) {
+    scheduling::set_process_priority(*priority);
+  }
+
+  const auto affinity = std::strtoull(
+      command_line->GetSwitchValue(scheduling::affinity_switch)
+          .ToString()
+          .c_str(),
+      nullptr, 16);
+  if (affinity != 0) {
+    scheduling::set_process_affinity(affinity);
+  }
+}
+
 void initialize_cef_subprocess(HINSTANCE hInstance) {
+  apply_subprocess_scheduling();
+
   // Provide CEF with command-line arguments.
   CefMainArgs main_args(hInstance);
 
   // CEF applications have multiple sub-processes (render, GPU, etc) that share
   // the same executable. This function checks the command-line and, if this is
   // a sub-process, executes the appropriate logic.
-  auto exit_code = CefExecuteProcess(main_args, nullptr, nullptr);
+  // RendererApp answers the browser process's memory sample requests.
+  CefRefPtr<RendererApp> app(new RendererApp);
+  auto exit_code = CefExecuteProcess(main_args, app.get(), nullptr);
   if (exit_code >= 0) {
     // The sub-process has completed so return here.
     return;
@@ -50,7 +105,73 @@ void initialize_cef_subprocess(HINSTANCE hInstance) {
 }
 #endif
 
-void initialize_cef_dll(HINSTANCE hInstance) {
+void prefault_resources(std::filesystem::path cef_path,
+                        bool disk_cache,
+                        scheduling::Policy policy) {
+  scheduling::apply_to_thread(policy.background_thread_priority,
+                              policy.affinity);
+
+  const auto start_us = latency::now_us();
+
+  std::vector<std::filesystem::path> paths;
+  for (const auto name : cef_resources) {
+    paths.push_back(cef_path / name);
+  }
+
+  auto bytes = startup::prefault(paths, UINT64_MAX);
+  if (disk_cache) {
+    bytes += startup::prefault({cef_path / "userdata" / "cache"},
+                               cache_prefault_limit);
+  }
+
+  startup::mark(startup::Step::resources_prefaulted);
+  logger::log("Prefaulted %llu MiB of CEF resources in %lld ms",
+              static_cast<unsigned long long>(bytes >> 20),
+              static_cast<long long>((latency::now_us() - start_us) / 1000));
+}
+
+// Maps the asset pack and confirms its entries with tosu while CEF is still
+// initializing, so the page's first requests can be served from it.
+void prefetch_assets(std::filesystem::path cef_path,
+                     uint64_t max_bytes,
+                     scheduling::Policy policy) {
+  scheduling::apply_to_thread(policy.background_thread_priority,
+                              policy.affinity);
+
+  const auto start_us = latency::now_us();
+
+  auto& cache = asset_cache::cache();
+  cache.open(cef_path / "userdata" / "asset_cache", max_bytes);
+  startup::prefault({cache.pack_path()}, max_bytes);
+
+  // when tosu isn't up yet this is left to TosuOverlay's probe
+  const bool answered =
+      cache.revalidate(state::host, state::port, asset_revalidate_timeout_ms);
+
+  const auto stats = cache.stats();
+  logger::log("Asset cache %s in %lld ms: %llu revalidated, %llu replaced",
+              answered ? "prefetched" : "opened, tosu not answering,",
+              static_cast<long long>((latency::now_us() - start_us) / 1000),
+              static_cast<unsigned long long>(stats.revalidated),
+              static_cast<unsigned long long>(stats.replaced));
+}
+
+void initialize_cef_dll(HINSTANCE hInstance, scheduling::Policy policy) {
+  // only this thread moves, osu!'s own threads and the process keep theirs.
+  // The threads CefInitialize starts don't inherit it, see below.
+  scheduling::apply_to_thread(policy.cef_thread_priority, policy.affinity);
+
+  std::wstring module_path = tools::get_module_path(hInstance);
+  auto cef_path = std::filesystem::path(module_path).parent_path();
+
+  if (!LoadLibraryEx((cef_path / "libcef.dll").c_str(), nullptr,
+                     LOAD_WITH_ALTERED_SEARCH_PATH)) {
+    logger::log("Unable to load libcef.dll (error code: %d)", GetLastError());
+    return;
+  }
+
+  startup::mark(startup::Step::libcef_loaded);
+
   // Provide CEF with command-line arguments.
   CefMainArgs main_args(hInstance);
 
@@ -75,12 +196,30 @@ void initialize_cef_dll(HINSTANCE hInstance) {
   settings.no_sandbox = true;
 #endif
 
+  // Keeps the HTTP cache between sessions so the overlay page's scripts,
+  // styles and fonts don't have to be fetched from tosu on every start.
+  const auto& json_data = ConfigManager::get_instance()->get_json_data();
+  if (json_data.value("disk_cache", false)) {
+    const auto user_data_dir = cef_path / "userdata";
+    CefString(&settings.root_cache_path) = user_data_dir;
+    CefString(&settings.cache_path) = user_data_dir / "cache";
+  }
+
+  const auto loop = message_loop::parse_config(
+      json_data.value("message_loop", nlohmann::json::object()));
+  settings.multi_threaded_message_loop =
+      loop.mode == message_loop::Mode::multi_threaded;
+  settings.external_message_pump =
+      loop.mode == message_loop::Mode::external_pump;
+  message_loop::external_pump().configure(loop.slice_budget_us,
+                                          loop.max_delay_us);
+  message_loop::set_mode(loop.mode);
+
+  logger::log("Message loop: %s", message_loop::mode_name(loop.mode));
+
   // TosuOverlay implements application-level callbacks for the browser process.
   // It will create the first browser instance in OnContextInitialized() after
   // CEF has initialized.
-  std::wstring module_path = tools::get_module_path(hInstance);
-  auto cef_path = std::filesystem::path(module_path).parent_path();
-
   CefRefPtr<TosuOverlay> app(new TosuOverlay(cef_path.string().c_str()));
 
   auto exe_path = cef_path / "tosu_overlay.exe";
@@ -96,13 +235,39 @@ void initialize_cef_dll(HINSTANCE hInstance) {
     return;
   }
 
-  is_cef_initialized = true;
+  startup::mark(startup::Step::cef_initialized);
 
   logger::log("CEF initialized successfully");
 
-  // Run the CEF message loop. This will block until CefQuitMessageLoop() is
-  // called.
-  CefRunMessageLoop();
+  // Windows threads don't inherit this thread's priority or affinity, so
+  // CEF's dedicated threads get them through a task each. The thread pool's
+  // workers stay out of reach, a process-wide mask would move osu! too.
+  for (const auto thread : {TID_IO, TID_PROCESS_LAUNCHER}) {
+    CefPostTask(thread, base::BindOnce(&scheduling::apply_to_thread,
+                                       policy.cef_thread_priority,
+                                       policy.affinity));
+  }
+
+  switch (loop.mode) {
+    case message_loop::Mode::dedicated:
+      // Run the CEF message loop. This will block until CefQuitMessageLoop()
+      // is called.
+      CefRunMessageLoop();
+      break;
+
+    case message_loop::Mode::multi_threaded:
+      // CEF's own UI thread gets the priority this one would have had. There
+      // is no loop to leave, CEF lives until osu! exits.
+      CefPostTask(TID_UI,
+                  base::BindOnce(&scheduling::apply_to_thread,
+                                 policy.cef_thread_priority, policy.affinity));
+      return;
+
+    case message_loop::Mode::external_pump:
+      // Runs until SimpleHandler quits it with the last browser.
+      message_loop::external_pump().run([] { CefDoMessageLoopWork(); });
+      break;
+  }
 
   // Shut down CEF.
   CefShutdown();
@@ -149,6 +314,8 @@ int APIENTRY wWinMain(HINSTANCE hInstance,
 #else
 
 bool __stdcall swap_buffers_hk(HDC hdc) {
+  const auto entered_us = latency::now_us();
+
   std::call_once(glad_init_flag, []() {
     logger::log("Initializing GL functions");
     if (auto status = gladLoadGL() == 0) {
@@ -156,18 +323,35 @@ bool __stdcall swap_buffers_hk(HDC hdc) {
     }
   });
 
-  if (is_cef_initialized) {
+  // the browser is created asynchronously once CEF's context is ready
+  if (startup::reached(startup::Step::browser_created)) {
     std::call_once(input_init_flag, [hdc]() {
       logger::log("Initializing input");
-      input::initialize(WindowFromDC(hdc), GetCurrentThreadId(),
-                        SimpleHandler::GetInstance()->GetBrowserList().front());
+      input::initialize(WindowFromDC(hdc), GetCurrentThreadId());
       logger::log("Input initialized");
     });
   }
 
   canvas::draw(hdc);
 
-  return reinterpret_cast<decltype(&swap_buffers_hk)>(o_swap_buffers)(hdc);
+  const auto swap_us = latency::now_us();
+  const auto result =
+      reinterpret_cast<decltype(&swap_buffers_hk)>(o_swap_buffers)(hdc);
+  const auto presented_us = latency::now_us();
+
+  latency::presented();
+  frame_clock::presented(presented_us);
+
+  if (startup::reached(startup::Step::first_upload) &&
+      startup::mark(startup::Step::first_present)) {
+    logger::log("Startup timeline: %s", startup::timeline().c_str());
+  }
+
+  // what the overlay adds to the game's frame, the driver's swap aside
+  overlay_stats::hooked((swap_us - entered_us) +
+                        (latency::now_us() - presented_us));
+
+  return result;
 }
 
 void parse_tosu_env(std::filesystem::path overlay_dir) {
@@ -234,6 +418,8 @@ void main_thread(HINSTANCE hInstance) {
   // AllocConsole();
   // freopen_s((FILE**)stdout, "con", "w", (FILE*)stdout);
 
+  startup::mark(startup::Step::injected);
+
   const auto module_path =
       std::filesystem::path(tools::get_module_path(hInstance));
 
@@ -243,23 +429,50 @@ void main_thread(HINSTANCE hInstance) {
 
   logger::log("Logger initialized in %s", parent_path.string().c_str());
 
+  startup::mark(startup::Step::logger_ready);
+
   const auto config_path = parent_path / "config.json";
 
   logger::log("Config file located at %s", config_path.string().c_str());
 
   parse_tosu_env(parent_path);
 
-  ConfigManager::get_instance(config_path.string().c_str());
+  const auto& json_data =
+      ConfigManager::get_instance(config_path.string().c_str())
+          ->get_json_data();
 
-  const auto cef_path = parent_path / "libcef.dll";
+  startup::mark(startup::Step::config_loaded);
 
-  LoadLibraryEx(cef_path.c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH);
-  const auto last_error = GetLastError();
-  if (last_error != 0) {
-    logger::log("Unable to load libcef.dll (error code: %d)", last_error);
-    return;
+  const auto policy = scheduling::parse_policy(
+      json_data.value("scheduling", nlohmann::json::object()),
+      scheduling::core_count());
+  logger::log("Scheduling: subprocesses %s, CEF thread %s, affinity %llx",
+              scheduling::priority_name(policy.subprocess_priority),
+              scheduling::priority_name(policy.cef_thread_priority),
+              static_cast<unsigned long long>(policy.affinity));
+
+  if (json_data.value("prefault_resources", true)) {
+    std::thread{prefault_resources, parent_path,
+                json_data.value("disk_cache", false), policy}
+        .detach();
   }
 
+  const auto asset_config =
+      json_data.value("asset_cache", nlohmann::json::object());
+  if (asset_config.value("enabled", true)) {
+    const auto max_mb =
+        std::clamp<int64_t>(asset_config.value("max_mb", 64), 1, 1024);
+    std::thread{prefetch_assets, parent_path,
+                static_cast<uint64_t>(max_mb) << 20, policy}
+        .detach();
+  }
+
+  // Loading libcef and CefInitialize don't depend on the hooks, and the swap
+  // hook leaves CEF alone until the browser exists.
+  logger::log("Starting CEF initialization");
+
+  std::thread{initialize_cef_dll, hInstance, policy}.detach();
+
   if (const auto status = MH_Initialize() != MH_OK) {
     logger::log("MH_Initialize() failed (status == %d)", status);
 
@@ -281,9 +494,7 @@ void main_thread(HINSTANCE hInstance) {
     return;
   }
 
-  logger::log("Starting CEF initialization");
-
-  std::thread{initialize_cef_dll, hInstance}.detach();
+  startup::mark(startup::Step::hooks_installed);
 }
 
 int32_t __stdcall DllMain(HINSTANCE hInstance, uint32_t reason, uintptr_t) {
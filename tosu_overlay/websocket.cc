@@ -0,0 +1,320 @@
+#include <tosu_overlay/http_probe.h>
+#include <tosu_overlay/latency.h>
+#include <tosu_overlay/websocket.h>
+
+#include <algorithm>
+#include <cctype>
+#include <random>
+
+namespace {
+
+constexpr uint8_t fin_bit = 0x80;
+constexpr uint8_t mask_bit = 0x80;
+
+// Frames past this are taken as a broken stream rather than buffered.
+constexpr uint64_t max_payload = uint64_t{64} << 20;
+
+std::string base64(const uint8_t* data, size_t size) {
+  static constexpr char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  std::string encoded;
+  for (size_t i = 0; i < size; i += 3) {
+    const uint32_t group = (data[i] << 16) |
+                           (i + 1 < size ? data[i + 1] << 8 : 0) |
+                           (i + 2 < size ? data[i + 2] : 0);
+    encoded += alphabet[(group >> 18) & 63];
+    encoded += alphabet[(group >> 12) & 63];
+    encoded += i + 1 < size ? alphabet[(group >> 6) & 63] : '=';
+    encoded += i + 2 < size ? alphabet[group & 63] : '=';
+  }
+  return encoded;
+}
+
+std::string lower(std::string_view text) {
+  std::string result(text);
+  std::transform(result.begin(), result.end(), result.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return result;
+}
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+bool is_control(websocket::Opcode opcode) {
+  return static_cast<uint8_t>(opcode) & 0x8;
+}
+
+uint32_t random_mask() {
+  static thread_local std::mt19937 rng(std::random_device{}());
+  return rng();
+}
+
+}  // namespace
+
+std::string websocket::make_key() {
+  std::random_device device;
+  uint8_t nonce[16];
+  for (auto& byte : nonce) {
+    byte = static_cast<uint8_t>(device());
+  }
+  return base64(nonce, sizeof(nonce));
+}
+
+std::string websocket::handshake_request(const std::string& host,
+                                         const std::string& port,
+                                         const std::string& path,
+                                         const std::string& key) {
+  return "GET " + path + " HTTP/1.1\r\nHost: " + host + ":" + port +
+         "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+         "Sec-WebSocket-Key: " +
+         key + "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+}
+
+bool websocket::handshake_accepted(std::string_view head) {
+  const auto line_end = head.find("\r\n");
+  if (line_end == std::string_view::npos ||
+      http_probe::parse_status_line(head.substr(0, line_end)) != 101) {
+    return false;
+  }
+
+  auto rest = head.substr(line_end + 2);
+  while (!rest.empty()) {
+    const auto end = rest.find("\r\n");
+    const auto line = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view()
+                                         : rest.substr(end + 2);
+
+    const auto colon = line.find(':');
+    if (colon != std::string_view::npos &&
+        lower(trim(line.substr(0, colon))) == "upgrade") {
+      return lower(trim(line.substr(colon + 1))) == "websocket";
+    }
+  }
+  return false;
+}
+
+std::string websocket::encode_frame(Opcode opcode,
+                                    std::string_view payload,
+                                    uint32_t mask) {
+  std::string frame;
+  frame.reserve(payload.size() + 14);
+  frame += static_cast<char>(fin_bit | static_cast<uint8_t>(opcode));
+
+  const uint64_t size = payload.size();
+  if (size < 126) {
+    frame += static_cast<char>(mask_bit | size);
+  } else if (size <= 0xffff) {
+    frame += static_cast<char>(mask_bit | 126);
+    frame += static_cast<char>(size >> 8);
+    frame += static_cast<char>(size);
+  } else {
+    frame += static_cast<char>(mask_bit | 127);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      frame += static_cast<char>(size >> shift);
+    }
+  }
+
+  const uint8_t key[4] = {
+      static_cast<uint8_t>(mask >> 24), static_cast<uint8_t>(mask >> 16),
+      static_cast<uint8_t>(mask >> 8), static_cast<uint8_t>(mask)};
+  frame.append(reinterpret_cast<const char*>(key), 4);
+
+  for (size_t i = 0; i < payload.size(); ++i) {
+    frame += static_cast<char>(payload[i] ^ key[i & 3]);
+  }
+  return frame;
+}
+
+void websocket::Decoder::feed(std::string_view bytes) {
+  // drop what was consumed before it piles up
+  if (offset_ > 0 && offset_ >= buffer_.size() / 2) {
+    buffer_.erase(0, offset_);
+    offset_ = 0;
+  }
+  buffer_.append(bytes);
+}
+
+std::optional<websocket::Message> websocket::Decoder::next() {
+  while (!failed_) {
+    const auto* data =
+        reinterpret_cast<const uint8_t*>(buffer_.data()) + offset_;
+    const size_t available = buffer_.size() - offset_;
+    if (available < 2) {
+      return std::nullopt;
+    }
+
+    const bool fin = data[0] & fin_bit;
+    const auto opcode = static_cast<Opcode>(data[0] & 0x0f);
+    const bool masked = data[1] & mask_bit;
+
+    size_t header = 2;
+    uint64_t size = data[1] & 0x7f;
+    if (size == 126) {
+      header += 2;
+      if (available < header) {
+        return std::nullopt;
+      }
+      size = (data[2] << 8) | data[3];
+    } else if (size == 127) {
+      header += 8;
+      if (available < header) {
+        return std::nullopt;
+      }
+      size = 0;
+      for (int i = 2; i < 10; ++i) {
+        size = (size << 8) | data[i];
+      }
+    }
+
+    const uint8_t* key = data + header;
+    if (masked) {
+      header += 4;
+    }
+
+    if (size > max_payload || (is_control(opcode) && (!fin || size > 125))) {
+      failed_ = true;
+      return std::nullopt;
+    }
+    if (available < header + size) {
+      return std::nullopt;
+    }
+
+    std::string payload(buffer_, offset_ + header, size);
+    if (masked) {
+      for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = static_cast<char>(payload[i] ^ key[i & 3]);
+      }
+    }
+    offset_ += header + size;
+
+    if (is_control(opcode)) {
+      return Message{opcode, std::move(payload)};
+    }
+
+    if (opcode != Opcode::continuation) {
+      if (fragments_opcode_ != Opcode::continuation) {
+        // a new message before the last one finished
+        failed_ = true;
+        return std::nullopt;
+      }
+      if (fin) {
+        return Message{opcode, std::move(payload)};
+      }
+      fragments_opcode_ = opcode;
+      fragments_ = std::move(payload);
+      continue;
+    }
+
+    if (fragments_opcode_ == Opcode::continuation) {
+      failed_ = true;
+      return std::nullopt;
+    }
+    fragments_ += payload;
+    if (fin) {
+      const auto message_opcode = fragments_opcode_;
+      fragments_opcode_ = Opcode::continuation;
+      return Message{message_opcode, std::move(fragments_)};
+    }
+  }
+
+  return std::nullopt;
+}
+
+bool websocket::Client::connect(const std::string& host,
+                                const std::string& port,
+                                const std::string& path,
+                                int timeout_ms) {
+  close();
+  decoder_ = Decoder();
+
+  if (!socket_.connect(host, port, timeout_ms) ||
+      !socket_.send(handshake_request(host, port, path, make_key()))) {
+    socket_.close();
+    return false;
+  }
+
+  // the head, and possibly the first frames right behind it
+  std::string received;
+  char buffer[4096];
+  const auto deadline = latency::now_us() + int64_t{timeout_ms} * 1000;
+  size_t head_end = std::string::npos;
+  while ((head_end = received.find("\r\n\r\n")) == std::string::npos) {
+    const auto left_ms = (deadline - latency::now_us()) / 1000;
+    const int length =
+        left_ms > 0 ? socket_.receive(buffer, sizeof(buffer),
+                                      static_cast<int>(left_ms))
+                    : -1;
+    if (length <= 0) {
+      socket_.close();
+      return false;
+    }
+    received.append(buffer, static_cast<size_t>(length));
+  }
+
+  if (!handshake_accepted(
+          std::string_view(received).substr(0, head_end + 4))) {
+    socket_.close();
+    return false;
+  }
+
+  decoder_.feed(std::string_view(received).substr(head_end + 4));
+  open_ = true;
+  return true;
+}
+
+std::optional<websocket::Message> websocket::Client::receive(int timeout_ms) {
+  char buffer[16384];
+
+  while (open_) {
+    while (auto message = decoder_.next()) {
+      switch (message->opcode) {
+        case Opcode::text:
+        case Opcode::binary:
+          return message;
+        case Opcode::ping:
+          send(Opcode::pong, message->payload);
+          break;
+        case Opcode::close:
+          send(Opcode::close, message->payload.substr(0, 2));
+          close();
+          return std::nullopt;
+        default:
+          break;
+      }
+    }
+
+    if (decoder_.failed()) {
+      close();
+      return std::nullopt;
+    }
+
+    const int length = socket_.receive(buffer, sizeof(buffer), timeout_ms);
+    if (length == 0) {
+      return std::nullopt;
+    }
+    if (length < 0) {
+      close();
+      return std::nullopt;
+    }
+    decoder_.feed(std::string_view(buffer, static_cast<size_t>(length)));
+  }
+
+  return std::nullopt;
+}
+
+bool websocket::Client::send(Opcode opcode, std::string_view payload) {
+  return open_ && socket_.send(encode_frame(opcode, payload, random_mask()));
+}
+
+void websocket::Client::close() {
+  open_ = false;
+  socket_.close();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// A minimal WebSocket client (RFC 6455) for tosu's /websocket/ endpoints on
+// loopback: text and binary messages, fragmentation, ping/pong and close.
+// No extensions and no TLS. The Sec-WebSocket-Accept hash isn't checked,
+// tosu answering 101 with "Upgrade: websocket" is taken as accepted.
+namespace websocket {
+
+enum class Opcode : uint8_t {
+  continuation = 0x0,
+  text = 0x1,
+  binary = 0x2,
+  close = 0x8,
+  ping = 0x9,
+  pong = 0xa,
+};
+
+struct Message {
+  Opcode opcode;
+  std::string payload;
+};
+
+// Random Sec-WebSocket-Key.
+std::string make_key();
+
+std::string handshake_request(const std::string& host,
+                              const std::string& port,
+                              const std::string& path,
+                              const std::string& key);
+
+// Whether a complete response head (up to and including the blank line)
+// accepts the upgrade.
+bool handshake_accepted(std::string_view head);
+
+// One final frame, masked with mask (clients always mask).
+std::string encode_frame(Opcode opcode,
+                         std::string_view payload,
+                         uint32_t mask);
+
+// Splits received bytes into messages. Fragmented messages come out whole,
+// control frames as they arrive (even between fragments).
+class Decoder {
+ public:
+  void feed(std::string_view bytes);
+
+  // The next complete message, nullopt until one arrived or once the stream
+  // broke the protocol.
+  std::optional<Message> next();
+
+  bool failed() const { return failed_; }
+
+ private:
+  std::string buffer_;
+  size_t offset_ = 0;
+
+  // the message being reassembled
+  std::string fragments_;
+  Opcode fragments_opcode_ = Opcode::continuation;
+
+  bool failed_ = false;
+};
+
+// Platform layer, websocket_win.cc and websocket_posix.cc: a blocking TCP
+// connection.
+class Socket {
+ public:
+  Socket() = default;
+  ~Socket() { close(); }
+
+  Socket(const Socket&) = delete;
+  Socket& operator=(const Socket&) = delete;
+
+  bool connect(const std::string& host,
+               const std::string& port,
+               int timeout_ms);
+  bool send(std::string_view data);
+  // Bytes read, 0 when nothing arrived within timeout_ms, -1 once the
+  // connection is closed or broken.
+  int receive(char* buffer, size_t size, int timeout_ms);
+  void close();
+
+ private:
+  intptr_t handle_ = -1;
+};
+
+class Client {
+ public:
+  bool connect(const std::string& host,
+               const std::string& port,
+               const std::string& path,
+               int timeout_ms);
+
+  // The next text or binary message, nullopt when none arrived within
+  // timeout_ms or the connection closed (see is_open). Pings are answered
+  // here.
+  std::optional<Message> receive(int timeout_ms);
+
+  bool send(Opcode opcode, std::string_view payload);
+
+  bool is_open() const { return open_; }
+  void close();
+
+ private:
+  Socket socket_;
+  Decoder decoder_;
+  bool open_ = false;
+};
+
+}  // namespace websocket
@@ -0,0 +1,111 @@
+#include <tosu_overlay/websocket.h>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+namespace {
+
+constexpr int send_timeout_ms = 1000;
+
+bool wait_for(int socket, short events, int timeout_ms) {
+  pollfd fd{socket, events, 0};
+  return poll(&fd, 1, timeout_ms) == 1 && (fd.revents & (events | POLLHUP));
+}
+
+bool connect_with_timeout(int socket,
+                          const addrinfo* address,
+                          int timeout_ms) {
+  fcntl(socket, F_SETFL, fcntl(socket, F_GETFL) | O_NONBLOCK);
+
+  if (connect(socket, address->ai_addr, address->ai_addrlen) == 0) {
+    return true;
+  }
+  if (errno != EINPROGRESS || !wait_for(socket, POLLOUT, timeout_ms)) {
+    return false;
+  }
+
+  int error = 0;
+  socklen_t length = sizeof(error);
+  return getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) == 0 &&
+         error == 0;
+}
+
+}  // namespace
+
+bool websocket::Socket::connect(const std::string& host,
+                                const std::string& port,
+                                int timeout_ms) {
+  close();
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return false;
+  }
+
+  for (auto address = addresses; address && handle_ < 0;
+       address = address->ai_next) {
+    const int fd =
+        socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+
+    if (connect_with_timeout(fd, address, timeout_ms)) {
+      handle_ = fd;
+    } else {
+      ::close(fd);
+    }
+  }
+
+  freeaddrinfo(addresses);
+  return handle_ >= 0;
+}
+
+bool websocket::Socket::send(std::string_view data) {
+  const int fd = static_cast<int>(handle_);
+
+  while (!data.empty()) {
+    const auto length = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+        wait_for(fd, POLLOUT, send_timeout_ms)) {
+      continue;
+    }
+    if (length <= 0) {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(length));
+  }
+  return true;
+}
+
+int websocket::Socket::receive(char* buffer, size_t size, int timeout_ms) {
+  const int fd = static_cast<int>(handle_);
+  if (fd < 0) {
+    return -1;
+  }
+  if (!wait_for(fd, POLLIN, timeout_ms)) {
+    return 0;
+  }
+
+  const auto length = recv(fd, buffer, size, 0);
+  if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    return 0;
+  }
+  return length > 0 ? static_cast<int>(length) : -1;
+}
+
+void websocket::Socket::close() {
+  if (handle_ >= 0) {
+    ::close(static_cast<int>(handle_));
+    handle_ = -1;
+  }
+}
@@ -0,0 +1,124 @@
+#include <tosu_overlay/websocket.h>
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include <mutex>
+
+#pragma comment(lib, "ws2_32.lib")
+
+namespace {
+
+std::once_flag winsock_flag;
+
+constexpr int send_timeout_ms = 1000;
+
+bool wait_for(SOCKET socket, short events, int timeout_ms) {
+  WSAPOLLFD fd{socket, events, 0};
+  return WSAPoll(&fd, 1, timeout_ms) == 1 &&
+         (fd.revents & (events | POLLHUP));
+}
+
+bool connect_with_timeout(SOCKET socket,
+                          const addrinfo* address,
+                          int timeout_ms) {
+  u_long non_blocking = 1;
+  ioctlsocket(socket, FIONBIO, &non_blocking);
+
+  if (connect(socket, address->ai_addr,
+              static_cast<int>(address->ai_addrlen)) == 0) {
+    return true;
+  }
+  if (WSAGetLastError() != WSAEWOULDBLOCK ||
+      !wait_for(socket, POLLWRNORM, timeout_ms)) {
+    return false;
+  }
+
+  int error = 0;
+  int length = sizeof(error);
+  return getsockopt(socket, SOL_SOCKET, SO_ERROR,
+                    reinterpret_cast<char*>(&error), &length) == 0 &&
+         error == 0;
+}
+
+}  // namespace
+
+bool websocket::Socket::connect(const std::string& host,
+                                const std::string& port,
+                                int timeout_ms) {
+  std::call_once(winsock_flag, [] {
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+  });
+
+  close();
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  addrinfo* addresses = nullptr;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+    return false;
+  }
+
+  for (auto address = addresses; address && handle_ < 0;
+       address = address->ai_next) {
+    const auto fd =
+        socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd == INVALID_SOCKET) {
+      continue;
+    }
+
+    if (connect_with_timeout(fd, address, timeout_ms)) {
+      handle_ = static_cast<intptr_t>(fd);
+    } else {
+      closesocket(fd);
+    }
+  }
+
+  freeaddrinfo(addresses);
+  return handle_ >= 0;
+}
+
+bool websocket::Socket::send(std::string_view data) {
+  const auto fd = static_cast<SOCKET>(handle_);
+
+  while (!data.empty()) {
+    const int length =
+        ::send(fd, data.data(), static_cast<int>(data.size()), 0);
+    if (length == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK &&
+        wait_for(fd, POLLWRNORM, send_timeout_ms)) {
+      continue;
+    }
+    if (length <= 0) {
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(length));
+  }
+  return true;
+}
+
+int websocket::Socket::receive(char* buffer, size_t size, int timeout_ms) {
+  if (handle_ < 0) {
+    return -1;
+  }
+
+  const auto fd = static_cast<SOCKET>(handle_);
+  if (!wait_for(fd, POLLRDNORM, timeout_ms)) {
+    return 0;
+  }
+
+  const int length = recv(fd, buffer, static_cast<int>(size), 0);
+  if (length == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) {
+    return 0;
+  }
+  return length > 0 ? length : -1;
+}
+
+void websocket::Socket::close() {
+  if (handle_ >= 0) {
+    closesocket(static_cast<SOCKET>(handle_));
+    handle_ = -1;
+  }
+}